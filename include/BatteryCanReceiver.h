@@ -4,6 +4,7 @@
 #if defined(USE_PYLONTECH_CAN_RECEIVER) || defined(USE_PYTES_CAN_RECEIVER)
 
 #include "Battery.h"
+#include "CanIo.h"
 #include <driver/twai.h>
 //#include <SPI.h>
 //#include <mcp_can.h>
@@ -13,7 +14,7 @@
 
 class BatteryCanReceiver : public BatteryProvider {
 public:
-    bool init(char const* providerName);
+    bool init(char const* providerName, CanIoClass::Filters const& filters);
     void deinit() final;
     void loop() final;
 
@@ -33,6 +34,11 @@ protected:
     bool _initialized = false;
 
 private:
+    bool readFrame(twai_message_t& rx_message);
+
+    // filled by the CAN I/O task, emptied by loop()
+    CanFrameQueue _frames;
+
 #ifdef USE_BATTERY_MCP2515
 //    SPIClass *SPI = nullptr;
 //    MCP_CAN  *_CAN = nullptr;
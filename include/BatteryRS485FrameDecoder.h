@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#if defined(USE_PYLONTECH_RS485_RECEIVER) || defined(USE_GOBEL_RS485_RECEIVER)
+
+#include <cstddef>
+#include <cstdint>
+
+#pragma pack(push, 1)
+typedef struct {
+    uint8_t ver; // HexToByte(construct.Array(2, construct.Byte)),
+    uint8_t adr; // HexToByte(construct.Array(2, construct.Byte)),
+    uint8_t cid1; // HexToByte(construct.Array(2, construct.Byte)),
+    uint8_t cid2; // HexToByte(construct.Array(2, construct.Byte)),
+    uint16_t infolength; // HexToByte(construct.Array(4, construct.Byte)),
+    uint8_t info[256]; // HexToByte(construct.GreedyRange(construct.Byte))
+} format_t;
+#pragma pack(pop)
+
+// decodes the hex-ASCII frames of the Pylontech protocol (SOI 0x7E, header,
+// LENID, INFO, CHKSUM, EOI 0x0D) one character at a time. the binary values
+// are written straight into the format_t, LENID and the frame checksum are
+// validated while the characters arrive.
+class BatteryRS485FrameDecoder {
+public:
+    enum class Result : uint8_t {
+        Ignored,    // character outside of a frame
+        Pending,    // frame not complete yet
+        Complete,   // valid frame available through getFrame()
+        Error       // frame discarded, see getError()
+    };
+
+    void reset();
+    Result feed(char c);
+
+    format_t* getFrame() { return &_frame; }
+    char const* getError() const { return _error; }
+
+    // number of characters of the last frame, SOI and EOI included
+    size_t getLength() const { return _chars + 2; }
+
+private:
+    Result fail(char const* error);
+    Result finish();
+
+    static constexpr size_t _headerBytes = 6; // ver, adr, cid1, cid2, LENID
+    static constexpr size_t _checksumChars = 4;
+
+    format_t _frame;
+    bool _started = false;
+    int8_t _highNibble = -1;    // first character of the current byte
+    size_t _bytes = 0;          // decoded bytes, header included
+    size_t _chars = 0;          // characters between SOI and EOI
+    size_t _expectedChars = 0;  // known once LENID was decoded
+    uint16_t _sum = 0;          // sum of the characters covered by the checksum
+    char const* _error = "";
+};
+
+#endif
@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#if defined(USE_PYLONTECH_RS485_RECEIVER) || defined(USE_GOBEL_RS485_RECEIVER)
+
+#include "BatteryRS485FrameDecoder.h"
+#include <Arduino.h>
+#include <deque>
+#include <functional>
+
+// request/response scheduler for the ASCII framed (SOI 0x7E ... EOI 0x0D)
+// RS485 battery protocols. frames are decoded from the bytes the UART driver
+// received so far and the next request is sent as soon as the previous one
+// was answered or timed out. nothing in here waits for the bus.
+class BatteryRS485Transactions {
+public:
+    struct Request_t {
+        uint8_t module;
+        uint8_t cmd;
+        uint8_t infoCommand;
+        uint8_t retries; // sent again after the response of another module
+    };
+
+    // puts the request on the bus
+    using Sender = std::function<void(Request_t const&)>;
+
+    // called with the decoded frame, or with nullptr if the module did not
+    // answer in time or the response was corrupted. frames of other modules
+    // are never handed over. the frame is reused once the handler returns.
+    using Handler = std::function<void(Request_t const&, format_t* frame)>;
+
+    void begin(char const* tag, HardwareSerial* serial, Sender sender, Handler handler);
+    void end();
+
+    void enqueue(uint8_t module, uint8_t cmd, uint8_t infoCommand);
+    void clear();
+
+    // no request waiting and none in flight
+    bool isIdle() const { return !_inFlight && _requests.empty(); }
+    size_t getQueueSize() const { return _requests.size(); }
+
+    // ms between sending the last request and receiving its response
+    uint32_t getResponseTime() const { return _responseTime; }
+
+    void loop();
+
+private:
+    void receive();
+    void sendNext();
+    void complete(format_t* frame);
+
+    static constexpr uint32_t _responseTimeout = 2000;
+    // bus turnaround, some BMS miss requests sent right after their response
+    static constexpr uint32_t _interFrameDelay = 20;
+    static constexpr uint16_t _spikeWarningThreshold = 100;
+    static constexpr uint8_t _maxRetries = 1;
+
+    char const* _tag = "";
+    HardwareSerial* _serial = nullptr;
+    Sender _sender;
+    Handler _handler;
+
+    std::deque<Request_t> _requests;
+    Request_t _request = {};
+    bool _inFlight = false;
+    bool _foreignFrame = false; // a frame of another module arrived meanwhile
+    uint32_t _sentMillis = 0;
+    uint32_t _completedMillis = 0;
+    uint32_t _responseTime = 0;
+
+    BatteryRS485FrameDecoder _decoder;
+    uint16_t _spikes = 0;
+};
+
+#endif
@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <Arduino.h>
+#include <SpscRingBuffer.h>
+#include <driver/twai.h>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+struct CanFrame_t {
+    twai_message_t message;
+    uint32_t timestamp; // millis() when the frame was taken from the controller
+};
+
+// the CAN I/O task is the only producer, the consumer of the port the only
+// reader. frames are dropped and counted per port if the queue is full.
+using CanFrameQueue = SpscRingBuffer<CanFrame_t, 64>;
+
+// drains the CAN controllers of all consumers from one high priority
+// FreeRTOS task, so frames are not lost while the main loop is busy.
+// the consumers own their controller, the task only calls their reader.
+class CanIoClass {
+public:
+    struct Filter_t {
+        uint32_t id;
+        uint32_t mask; // bits which must match id
+        bool extd;
+    };
+
+    using Filters = std::vector<Filter_t>;
+
+    // reads one frame from the controller without waiting. the reader is
+    // called from the CAN I/O task, the consumer must serialize it with its
+    // own accesses to the controller.
+    using Reader = std::function<bool(twai_message_t&)>;
+
+    // how the CAN I/O task learns that a controller received frames:
+    // Interrupt watches the active low interrupt output of the controller,
+    // Twai waits for the receive alert of the TWAI driver. controllers
+    // without either are polled every tick.
+    enum class Wakeup : uint8_t { Poll, Interrupt, Twai };
+
+    // frames accepted by one of the filters are pushed to the queue. the
+    // task is notified, if given, whenever frames were queued.
+    void attach(char const* name, Reader reader, Filters const& filters,
+            CanFrameQueue& queue, Wakeup wakeup, int8_t interruptPin = -1,
+            TaskHandle_t notify = nullptr);
+    void detach(CanFrameQueue& queue);
+
+    static Filters exactStandardIds(std::initializer_list<uint32_t> ids);
+
+    // merges the filters into the single id/mask pair a controller with one
+    // acceptance filter can be programmed with. the result accepts at least
+    // all frames the filters accept.
+    static void mergeFilters(Filters const& filters, uint32_t& id, uint32_t& mask, bool& extd);
+    static twai_filter_config_t getTwaiFilterConfig(Filters const& filters);
+
+private:
+    struct Port_t {
+        char const* name;
+        Reader reader;
+        Filters filters;
+        CanFrameQueue* queue;
+        TaskHandle_t notify;
+        Wakeup wakeup;
+        int8_t interruptPin;
+        uint32_t dropped;
+    };
+
+    static void taskLoopHelper(void* context);
+    void taskLoop();
+    static void twaiLoopHelper(void* context);
+    void twaiLoop();
+    static void IRAM_ATTR interruptHandler(void* context);
+    static bool matches(Filters const& filters, twai_message_t const& message);
+
+    static constexpr UBaseType_t _taskPriority = 5; // above the Arduino loop and AsyncTCP
+    static constexpr uint32_t _taskStackSize = 3072;
+    static constexpr uint32_t _twaiTaskStackSize = 2048;
+    static constexpr uint8_t _maxFramesPerRead = 16;
+    // bounds the wait if an edge or an alert got lost
+    static constexpr uint32_t _maxWaitMs = 100;
+
+    std::mutex _mutex;
+    std::vector<Port_t> _ports;
+    TaskHandle_t _taskHandle = nullptr;
+    TaskHandle_t _twaiTaskHandle = nullptr;
+};
+
+extern CanIoClass CanIo;
@@ -4,8 +4,10 @@
 #include "PinMapping.h"
 #include <cstdint>
 #include <ArduinoJson.h>
+#include <Stream.h>
 
-#define CONFIG_FILENAME "/config.json"
+#define CONFIG_FILENAME "/config.json" // import and export only
+#define CONFIG_DIRECTORY "/cfg" // binary store, one file per section
 #define CONFIG_VERSION 0x00011c00 // 0.1.28 // make sure to clean all after change
 
 #define WIFI_MAX_SSID_STRLEN 32
@@ -35,6 +37,7 @@
 #define DEV_MAX_MAPPING_NAME_STRLEN 63
 
 #define VICTRON_MAX_COUNT 2
+#define POWERLIMITER_MAX_ADDITIONAL_INVERTERS (INV_MAX_COUNT - 1)
 
 #define HTTP_REQUEST_MAX_URL_STRLEN 256 // 1024
 #define HTTP_REQUEST_MAX_USERNAME_STRLEN 64
@@ -171,6 +174,10 @@ struct Mdns_CONFIG_T {
     bool Enabled;
 };
 
+struct Logging_CONFIG_T {
+    uint8_t Level; // MessageOutputClass::Level
+};
+
 struct Syslog_CONFIG_T {
     bool Enabled;
     char Hostname[SYSLOG_MAX_HOSTNAME_STRLEN + 1];
@@ -221,6 +228,10 @@ struct PowerLimiter_CONFIG_T {
     bool UseOverscalingToCompensateShading;
     uint64_t InverterId;
     uint8_t InverterChannelId;
+    struct {
+        uint64_t Serial;
+        bool IsSolarPowered;
+    } AdditionalInverters[POWERLIMITER_MAX_ADDITIONAL_INVERTERS];
     int32_t TargetPowerConsumption;
     int32_t TargetPowerConsumptionHysteresis;
     int32_t LowerPowerLimit;
@@ -302,6 +313,9 @@ struct Mqtt_CONFIG_T {
     char Topic[MQTT_MAX_TOPIC_STRLEN + 1];
     bool Retain;
     uint32_t PublishInterval;
+    uint32_t RefreshInterval;
+    bool JsonPayload;
+    uint32_t QueueBudget;
     bool CleanSession;
     struct {
         char Topic[MQTT_MAX_TOPIC_STRLEN + 1];
@@ -373,6 +387,7 @@ struct REFUsol_CONFIG_T {
     bool UpdatesOnly;
     uint32_t PollInterval;
     uint8_t USSaddress;
+    uint8_t USSaddressCount; // inverters at USSaddress, USSaddress + 1, ...
     uint16_t Baudrate;
     enum Parity_t { None, Even, Odd } Parity;
     bool VerboseLogging;
@@ -420,6 +435,7 @@ struct CONFIG_T {
 
     WiFi_CONFIG_T WiFi;
     Mdns_CONFIG_T Mdns;
+    Logging_CONFIG_T Logging;
 #ifdef USE_SYSLOG
     Syslog_CONFIG_T Syslog;
 #endif
@@ -479,6 +495,15 @@ public:
     void migrate();
     CONFIG_T& get();
 
+    // the json format is kept for backups and for firmware updates, which
+    // may change the layout of the binary sections
+    bool exportJson(Print& target);
+    bool importJson(Stream& source);
+    bool writeJson();
+
+    // removes the binary store, used by the factory reset
+    void erase();
+
     INVERTER_CONFIG_T* getFreeInverterSlot();
     INVERTER_CONFIG_T* getInverterConfig(uint64_t serial);
     void deleteInverterById(const uint8_t id);
@@ -1,42 +1,33 @@
 #pragma once
 
 #include <Arduino.h>
+#include <array>
+#include <iterator>
 #include <map>
 #include <optional>
 #include <string>
-#include <unordered_map>
+#include <utility>
 #include <variant>
 
 using tCellVoltages = std::map<uint8_t, uint16_t>;
 
+template<typename T> std::string dataPointValueToStr(T const& v);
+
 template<typename... V>
 class DataPoint {
-    template<typename, typename L, template<L> class>
+    template<typename, typename L, template<L> class, L, L>
     friend class DataPointContainer;
 
     public:
         using tValue = std::variant<V...>;
 
-        DataPoint() = delete;
-
-        DataPoint(DataPoint const& other)
-            : _strLabel(other._strLabel)
-            , _strValue(other._strValue)
-            , _strUnit(other._strUnit)
-            , _value(other._value)
-            , _timestamp(other._timestamp) { }
-
-        DataPoint(std::string const& strLabel, std::string const& strValue,
-                std::string const& strUnit, tValue value, uint32_t timestamp)
-            : _strLabel(strLabel)
-            , _strValue(strValue)
-            , _strUnit(strUnit)
-            , _value(std::move(value))
-            , _timestamp(timestamp) { }
-
-        std::string const& getLabelText() const { return _strLabel; }
-        std::string const& getValueText() const { return _strValue; }
-        std::string const& getUnitText() const { return _strUnit; }
+        // label and unit point to the constexpr strings of the label traits,
+        // the value is only formatted when the text is actually requested.
+        char const* getLabelText() const { return _strLabel; }
+        std::string getValueText() const {
+            return std::visit([](auto const& v) { return dataPointValueToStr(v); }, _value);
+        }
+        char const* getUnitText() const { return _strUnit; }
         uint32_t getTimestamp() const { return _timestamp; }
 
         bool operator==(DataPoint const& other) const {
@@ -44,34 +35,39 @@ class DataPoint {
         }
 
     private:
-        std::string _strLabel;
-        std::string _strValue;
-        std::string _strUnit;
+        bool isValid() const { return _strLabel != nullptr; }
+
+        char const* _strLabel = nullptr;
+        char const* _strUnit = nullptr;
         tValue _value;
-        uint32_t _timestamp;
+        uint32_t _timestamp = 0;
 };
 
-template<typename T> std::string dataPointValueToStr(T const& v);
-
-template<typename DataPoint, typename Label, template<Label> class Traits>
+/**
+ * the labels are known at compile time, so each label owns a slot in a fixed
+ * array. First and Last must span all labels of the enum. adding a data point
+ * assigns the value in place, which reuses the storage of strings and cell
+ * voltage maps instead of allocating new nodes for every message.
+ */
+template<typename DataPoint, typename Label, template<Label> class Traits, Label First, Label Last>
 class DataPointContainer {
     public:
-        DataPointContainer() = default;
+        using tEntry = std::pair<Label, DataPoint>;
 
-        //template<Label L> using Traits = LabelTraits<L>;
+        DataPointContainer()
+        {
+            for (size_t i = 0; i < _dataPoints.size(); ++i) {
+                _dataPoints[i].first = static_cast<Label>(static_cast<size_t>(First) + i);
+            }
+        }
 
         template<Label L>
         void add(typename Traits<L>::type val) {
-            _dataPoints.emplace(
-                    L,
-                    DataPoint(
-                        Traits<L>::name,
-                        dataPointValueToStr(val),
-                        Traits<L>::unit,
-                        typename DataPoint::tValue(std::move(val)),
-                        millis()
-                    )
-            );
+            auto& dataPoint = slot<L>().second;
+            dataPoint._strLabel = Traits<L>::name;
+            dataPoint._strUnit = Traits<L>::unit;
+            dataPoint._value = std::move(val);
+            dataPoint._timestamp = millis();
         }
 
         // make sure add() is only called with the type expected for the
@@ -80,40 +76,86 @@ class DataPointContainer {
         void add(T) = delete;
 
         template<Label L>
-        std::optional<DataPoint const> getDataPointFor() const {
-            auto it = _dataPoints.find(L);
-            if (it == _dataPoints.end()) { return std::nullopt; }
-            return it->second;
+        DataPoint const* getDataPointFor() const {
+            auto const& dataPoint = slot<L>().second;
+            if (!dataPoint.isValid()) { return nullptr; }
+            return &dataPoint;
         }
 
         template<Label L>
         std::optional<typename Traits<L>::type> get() const {
-            auto optionalDataPoint = getDataPointFor<L>();
-            if (!optionalDataPoint.has_value()) { return std::nullopt; }
-            return std::get<typename Traits<L>::type>(optionalDataPoint->_value);
+            auto pDataPoint = getDataPointFor<L>();
+            if (pDataPoint == nullptr) { return std::nullopt; }
+            return std::get<typename Traits<L>::type>(pDataPoint->_value);
         }
 
-        using tMap = std::unordered_map<Label, DataPoint const>;
-        typename tMap::const_iterator cbegin() const { return _dataPoints.cbegin(); }
-        typename tMap::const_iterator cend() const { return _dataPoints.cend(); }
+        // iterates the labels that have a value, in enum order
+        class const_iterator {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = tEntry;
+                using difference_type = std::ptrdiff_t;
+                using pointer = tEntry const*;
+                using reference = tEntry const&;
+
+                const_iterator(pointer pos, pointer end)
+                    : _pos(pos), _end(end) { skipInvalid(); }
+
+                reference operator*() const { return *_pos; }
+                pointer operator->() const { return _pos; }
+
+                const_iterator& operator++() {
+                    ++_pos;
+                    skipInvalid();
+                    return *this;
+                }
+
+                bool operator==(const_iterator const& other) const { return _pos == other._pos; }
+                bool operator!=(const_iterator const& other) const { return _pos != other._pos; }
+
+            private:
+                void skipInvalid() {
+                    while (_pos != _end && !_pos->second.isValid()) { ++_pos; }
+                }
+
+                pointer _pos;
+                pointer _end;
+        };
+
+        const_iterator cbegin() const { return const_iterator(_dataPoints.data(), _dataPoints.data() + _dataPoints.size()); }
+        const_iterator cend() const { return const_iterator(_dataPoints.data() + _dataPoints.size(), _dataPoints.data() + _dataPoints.size()); }
 
         // copy all data points from source into this instance, overwriting
         // existing data points in this instance.
         void updateFrom(DataPointContainer const& source)
         {
-            for (auto iter = source.cbegin(); iter != source.cend(); ++iter) {
-                auto pos = _dataPoints.find(iter->first);
+            for (size_t i = 0; i < _dataPoints.size(); ++i) {
+                auto const& src = source._dataPoints[i].second;
+                if (!src.isValid()) { continue; }
 
-                if (pos != _dataPoints.end()) {
-                    // do not update existing data points with the same value
-                    if (pos->second == iter->second) { continue; }
+                auto& dst = _dataPoints[i].second;
 
-                    _dataPoints.erase(pos);
-                }
-                _dataPoints.insert(*iter);
+                // do not update existing data points with the same value
+                if (dst.isValid() && dst == src) { continue; }
+
+                dst = src;
             }
         }
 
     private:
-        tMap _dataPoints;
+        static constexpr size_t _slotCount = static_cast<size_t>(Last) - static_cast<size_t>(First) + 1;
+
+        template<Label L>
+        static constexpr size_t index() {
+            static_assert(L >= First && L <= Last, "data point label out of range");
+            return static_cast<size_t>(L) - static_cast<size_t>(First);
+        }
+
+        template<Label L>
+        tEntry& slot() { return _dataPoints[index<L>()]; }
+
+        template<Label L>
+        tEntry const& slot() const { return _dataPoints[index<L>()]; }
+
+        std::array<tEntry, _slotCount> _dataPoints;
 };
@@ -1,11 +1,15 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 
+#include "Configuration.h"
 #include <TaskSchedulerDeclarations.h>
+#include <atomic>
 #include <mutex>
 // Daten visualisieren #168
 #include <array>
 
+class InverterAbstract;
+
 class DatastoreClass {
 public:
     DatastoreClass();
@@ -65,26 +69,58 @@ public:
 private:
     void loop();
 
+    // Contribution of a single inverter to the totals
+    struct InverterData_t {
+        uint64_t serial = 0; // 0 --> slot not used
+        bool pollEnabled = false;
+        bool producing = false;
+        bool reachable = false;
+        bool yieldEnabled = false;
+        float acYieldTotal = 0;
+        float acYieldDay = 0;
+        uint32_t acYieldTotalDigits = 0;
+        uint32_t acYieldDayDigits = 0;
+        float acPower = 0;
+        uint32_t acPowerDigits = 0;
+        float dcPower = 0;
+        uint32_t dcPowerDigits = 0;
+        float dcPowerIrradiation = 0;
+        float dcIrradiationInstalled = 0;
+    };
+
+    struct Totals_t {
+        float acYieldTotalEnabled = 0;
+        float acYieldDayEnabled = 0;
+        float acPowerEnabled = 0;
+        float dcPowerEnabled = 0;
+        float dcPowerIrradiation = 0;
+        float dcIrradiationInstalled = 0;
+        float dcIrradiation = 0;
+        uint32_t acYieldTotalDigits = 0;
+        uint32_t acYieldDayDigits = 0;
+        uint32_t acPowerDigits = 0;
+        uint32_t dcPowerDigits = 0;
+        bool isAtLeastOneReachable = false;
+        bool isAtLeastOneProducing = false;
+        bool isAllEnabledProducing = true;
+        bool isAllEnabledReachable = true;
+        bool isAtLeastOnePollEnabled = false;
+    };
+
+    void onStatisticsUpdate(InverterAbstract& inv);
+    void updateTotals();
+    Totals_t getTotals() const;
+
     Task _loopTask;
 
+    // Serializes all writers, readers of the totals use the sequence counter
     std::mutex _mutex;
 
-    float _totalAcYieldTotalEnabled = 0;
-    float _totalAcYieldDayEnabled = 0;
-    float _totalAcPowerEnabled = 0;
-    float _totalDcPowerEnabled = 0;
-    float _totalDcPowerIrradiation = 0;
-    float _totalDcIrradiationInstalled = 0;
-    float _totalDcIrradiation = 0;
-    uint32_t _totalAcYieldTotalDigits = 0;
-    uint32_t _totalAcYieldDayDigits = 0;
-    uint32_t _totalAcPowerDigits = 0;
-    uint32_t _totalDcPowerDigits = 0;
-    bool _isAtLeastOneReachable = false;
-    bool _isAtLeastOneProducing = false;
-    bool _isAllEnabledProducing = false;
-    bool _isAllEnabledReachable = false;
-    bool _isAtLeastOnePollEnabled = false;
+    std::array<InverterData_t, INV_MAX_COUNT> _inverterData;
+
+    // Seqlock: odd while _totals is written
+    std::atomic<uint32_t> _totalsSequence = { 0 };
+    Totals_t _totals;
 
     // Daten visualisieren #168
     int8_t _currentDay = -1;
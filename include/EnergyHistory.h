@@ -0,0 +1,157 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <TaskSchedulerDeclarations.h>
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// energy history on LittleFS. the sources are sampled every few seconds and
+// summed up into minute records, which are in turn summed up into hour, day
+// and month records. every tier is an append-only ring of segment files,
+// a new file is started once the current one is full and the oldest file
+// is removed, so the writes move over the whole file system.
+class EnergyHistoryClass {
+public:
+    enum class Tier : uint8_t {
+        Minute,
+        Hour,
+        Day,
+        Month
+    };
+    static constexpr size_t TierCount = 4;
+
+    enum Channel : uint8_t {
+        AcYield,
+        DcYield,
+        MpptYield,
+        GridImport,
+        GridExport
+    };
+    static constexpr size_t ChannelCount = 5;
+
+    // valid bit of the battery values, the channels use bits 0..4
+    static constexpr uint8_t BatteryValid = 1 << ChannelCount;
+    static constexpr uint8_t SocUnknown = 0xff;
+
+    // a period as returned by read()
+    struct Entry_t {
+        uint32_t time; // start of the period, unix time
+        uint8_t valid; // bit per channel and BatteryValid
+        uint8_t soc; // percent at the end of the period
+        int16_t batteryPower; // W, average, positive while charging
+        std::array<uint32_t, ChannelCount> energy; // Wh
+    };
+
+    // position of a range query, read() continues where it stopped
+    struct Cursor_t {
+        Tier tier;
+        uint32_t from; // inclusive
+        uint32_t to; // exclusive
+        uint32_t sequence = 0; // segment of the last entry returned
+        uint16_t index = 0; // record following that entry
+    };
+
+    EnergyHistoryClass();
+    void init(Scheduler& scheduler);
+
+    // reads up to maxCount entries in ascending order, fewer if the end
+    // of the range was reached
+    size_t read(Cursor_t& cursor, std::vector<Entry_t>& entries, size_t maxCount);
+
+    // writes the buffered records, used before a restart
+    void flush();
+
+    // removes all history files
+    void reset();
+
+    static char const* getTierName(Tier tier);
+    static bool getTierByName(char const* name, Tier& tier);
+    static char const* getChannelName(uint8_t channel);
+
+private:
+    // fixed size record of the segment files. the time is stored relative
+    // to the start of the segment, the energy is the delta of the counters
+    // within the period.
+    struct __attribute__((packed)) Record_t {
+        uint16_t offset; // periods since the start of the segment
+        uint8_t valid;
+        uint8_t soc;
+        int16_t batteryPower;
+        uint16_t energy[ChannelCount]; // in units of the tier's scale
+    };
+    static_assert(sizeof(Record_t) == 16, "record size changed");
+
+    struct __attribute__((packed)) SegmentHeader_t {
+        uint32_t magic;
+        uint8_t version;
+        uint8_t tier;
+        uint16_t reserved;
+        uint32_t start; // unix time of the first period
+        uint32_t sequence;
+    };
+    static_assert(sizeof(SegmentHeader_t) == 16, "header size changed");
+
+    struct Segment_t {
+        uint32_t sequence;
+        uint32_t start;
+        uint16_t count;
+        bool sealed; // ends with a partial record, nothing is appended
+    };
+
+    // period which is still being summed up
+    struct Period_t {
+        uint32_t start = 0; // 0: no period started yet
+        uint8_t valid = 0;
+        uint8_t soc = SocUnknown;
+        std::array<float, ChannelCount> energy = {}; // Wh
+        float batteryEnergy = 0; // Wh, charged minus discharged
+        float batterySeconds = 0;
+    };
+
+    struct TierState_t {
+        std::vector<Segment_t> segments; // oldest first
+        std::vector<Entry_t> buffer; // not yet written to a segment
+        Period_t period;
+        std::array<float, ChannelCount> carry = {}; // Wh lost by the scaling
+        uint32_t lastTime = 0; // start of the last period appended
+    };
+
+    void loop();
+    void sample(Period_t& period, float seconds);
+    void closeMinute();
+    void restorePeriods(uint32_t now);
+
+    Entry_t finishPeriod(Tier tier);
+    static void addEntry(Period_t& period, Entry_t const& entry, uint32_t seconds);
+    static void addPeriod(Period_t& period, Period_t const& other);
+
+    void append(Tier tier, Entry_t const& entry);
+    void writeBuffer(Tier tier);
+    bool createSegment(Tier tier, uint32_t start);
+    void removeOldestSegment(Tier tier);
+    void loadSegments();
+    size_t readSegment(Tier tier, Segment_t const& segment, Cursor_t& cursor, std::vector<Entry_t>& entries, size_t maxCount);
+    size_t readLocked(Cursor_t& cursor, std::vector<Entry_t>& entries, size_t maxCount);
+
+    static uint32_t periodStart(Tier tier, uint32_t time);
+    static uint32_t periodOffset(Tier tier, uint32_t start, uint32_t time);
+    static uint32_t periodTime(Tier tier, uint32_t start, uint32_t offset);
+    static void segmentPath(Tier tier, uint32_t sequence, char* path, size_t size);
+
+    TierState_t& state(Tier tier) { return _tiers[static_cast<size_t>(tier)]; }
+
+    Task _loopTask;
+
+    std::mutex _mutex;
+    std::array<TierState_t, TierCount> _tiers;
+    uint32_t _nextSequence = 1;
+    bool _restored = false;
+
+    uint32_t _lastSampleMillis = 0;
+    float _lastAcYieldTotal = 0; // kWh
+    float _lastMpptYieldTotal = 0; // kWh
+};
+
+extern EnergyHistoryClass EnergyHistory;
@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <TaskSchedulerDeclarations.h>
+#include <parser/AlarmLogParser.h>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// keeps the inverter events on LittleFS. the inverter only reports its
+// latest 15 events, so every received event log is merged into a ring
+// file per inverter. an event is identified by its message id and start
+// time, known events only get their end time updated. the inverter reports
+// times of the day only, an event still in its log keeps the date it was
+// archived with.
+class EventArchiveClass {
+public:
+    struct Event_t {
+        uint32_t startTime; // unix time
+        uint32_t endTime; // unix time, 0: still active
+        uint16_t messageId;
+        AlarmMessageType_t messageType;
+    };
+
+    struct Filter_t {
+        uint32_t from = 0;
+        uint32_t to = UINT32_MAX;
+        int32_t messageId = -1; // -1: all messages
+        bool activeOnly = false;
+    };
+
+    EventArchiveClass();
+    void init(Scheduler& scheduler);
+
+    // the events matching the filter, newest first. returns the number of
+    // all matching events, events holds those from offset to offset + limit.
+    size_t query(uint64_t serial, Filter_t const& filter, size_t offset, size_t limit, std::vector<Event_t>& events);
+
+    void remove(uint64_t serial);
+
+    // removes all archive files
+    void reset();
+
+private:
+    static constexpr uint16_t Capacity = 340; // one 4 KiB block per inverter
+    static constexpr size_t RecentCount = 16; // at least the size of the inverter's log
+
+    struct __attribute__((packed)) Record_t {
+        uint32_t startTime;
+        uint32_t endTime;
+        uint16_t messageId;
+        uint8_t messageType;
+        uint8_t reserved;
+    };
+    static_assert(sizeof(Record_t) == 12, "record size changed");
+
+    struct __attribute__((packed)) FileHeader_t {
+        uint32_t magic;
+        uint8_t version;
+        uint8_t reserved;
+        uint16_t capacity;
+        uint16_t count;
+        uint16_t head; // slot of the next record
+        uint32_t reserved2;
+    };
+    static_assert(sizeof(FileHeader_t) == 16, "header size changed");
+
+    // the latest records of an inverter, used to find known events
+    struct Recent_t {
+        Record_t record;
+        uint16_t slot;
+        bool inLog = true; // reported by the last event log of the inverter
+        bool matched = false; // only used by merge()
+    };
+
+    struct Archive_t {
+        uint64_t serial = 0;
+        uint32_t lastUpdate = 0; // of the inverter's event log
+        FileHeader_t header = {};
+        std::vector<Recent_t> recent; // oldest first
+    };
+
+    void loop();
+    void merge(Archive_t& archive, AlarmLogParser& log);
+    void store(Archive_t& archive, Record_t const& record);
+    void load(Archive_t& archive);
+    bool writeRecord(Archive_t& archive, uint16_t slot, Record_t const& record);
+    Archive_t& getArchive(uint64_t serial);
+    Archive_t* findArchive(uint64_t serial);
+
+    static uint32_t toUnixTime(time_t timeOfDay, uint32_t now);
+    static void archivePath(uint64_t serial, char* path, size_t size);
+
+    Task _loopTask;
+
+    std::mutex _mutex;
+    std::vector<Archive_t> _archives;
+};
+
+extern EventArchiveClass EventArchive;
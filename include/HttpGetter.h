@@ -9,23 +9,23 @@
 #include <HTTPClient.h>
 #include <WiFiClient.h>
 
-using up_http_client_t = std::unique_ptr<HTTPClient>;
+using sp_http_client_t = std::shared_ptr<HTTPClient>;
 using sp_wifi_client_t = std::shared_ptr<WiFiClient>;
 
 class HttpRequestResult {
 public:
     HttpRequestResult(bool success,
-            up_http_client_t upHttpClient = nullptr,
+            sp_http_client_t spHttpClient = nullptr,
             sp_wifi_client_t spWiFiClient = nullptr)
         : _success(success)
-        , _upHttpClient(std::move(upHttpClient))
+        , _spHttpClient(std::move(spHttpClient))
         , _spWiFiClient(std::move(spWiFiClient)) { }
 
     ~HttpRequestResult() {
         // the wifi client *must* die *after* the http client, as the http
         // client uses the wifi client in its destructor.
-        if (_upHttpClient) { _upHttpClient->end(); }
-        _upHttpClient = nullptr;
+        if (_spHttpClient) { _spHttpClient->end(); }
+        _spHttpClient = nullptr;
         _spWiFiClient = nullptr;
     }
 
@@ -37,13 +37,21 @@ public:
     operator bool() const { return _success; }
 
     Stream* getStream() {
-        if(!_upHttpClient) { return nullptr; }
-        return _upHttpClient->getStreamPtr();
+        if(!_spHttpClient) { return nullptr; }
+        return _spHttpClient->getStreamPtr();
+    }
+
+    // copies the body to target, also if it uses chunked transfer encoding,
+    // and leaves the connection ready for reuse. returns the number of bytes
+    // or a negative HTTPC_ERROR_* code.
+    int writeToStream(Stream& target) {
+        if (!_spHttpClient) { return HTTPC_ERROR_NOT_CONNECTED; }
+        return _spHttpClient->writeToStream(&target);
     }
 
 private:
     bool _success;
-    up_http_client_t _upHttpClient;
+    sp_http_client_t _spHttpClient;
     sp_wifi_client_t _spWiFiClient;
 };
 
@@ -52,10 +60,22 @@ public:
     explicit HttpGetter(HttpRequestConfig const& cfg)
         : _config(cfg) { }
 
+    // keeps the connection open between requests. must be called before
+    // init(). the response may then use chunked transfer encoding, so it has
+    // to be read using HttpRequestResult::writeToStream().
+    void enableKeepAlive() { _keepAlive = true; }
+
     bool init();
     void addHeader(char const* key, char const* value);
     HttpRequestResult performGetRequest();
 
+    // true if both getters connect to the same scheme, host and port
+    bool sameServer(HttpGetter const& other) const;
+
+    // sends the requests over the other getter's connection. both must be
+    // initialized and must not be used concurrently.
+    void shareConnection(HttpGetter const& other);
+
     char const* getErrorText() const { return _errBuffer; }
 
 private:
@@ -70,8 +90,17 @@ private:
     String _host;
     String _uri;
     uint16_t _port;
+    bool _keepAlive = false;
+
+    // the resolved address is kept while the connection is kept alive
+    IPAddress _address;
+    bool _addressValid = false;
 
     sp_wifi_client_t _spWiFiClient; // reused for multiple HTTP requests
 
+    // only kept in keep-alive mode, as its destructor closes the connection.
+    // declared after the wifi client, which it uses in its destructor.
+    sp_http_client_t _spHttpClient;
+
     std::vector<std::pair<std::string, std::string>> _additionalHeaders;
 };
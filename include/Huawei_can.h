@@ -11,6 +11,7 @@
 #include <Longan_I2C_CAN_Arduino.h>
 #include <mutex>
 #include <TaskSchedulerDeclarations.h>
+#include "CanIo.h"
 #include "PinMapping.h"
 
 #ifndef HUAWEI_PIN_MISO
@@ -98,6 +99,7 @@ typedef struct RectifierParameters {
 class HuaweiCanCommClass {
 public:
     bool init();
+    void attach(TaskHandle_t notify);
     void loop();
     bool gotNewRxDataFrame(bool clear);
     uint8_t  getErrorCode(bool clear);
@@ -109,6 +111,10 @@ public:
 private:
     void sendRequest();
     byte sendMsgBuf(uint32_t identifier, uint8_t extd, uint8_t len, uint8_t *data);
+    bool readFrame(twai_message_t& rx_message);
+
+    // filled by the CAN I/O task, emptied by loop()
+    CanFrameQueue _frames;
 
 #ifdef USE_CHARGER_MCP2515
 //    SPIClass *SPI;
@@ -122,6 +128,7 @@ private:
     uint32_t _lastRequestMillis = 0;              // When to send next data request to PSU
 
     std::mutex _mutex;
+    std::mutex _controllerMutex; // serializes SPI/I2C accesses with the CAN I/O task
 
     uint32_t _recValues[12];
     uint16_t _txValues[5];
@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <Arduino.h>
+#include <Stream.h>
+#include <array>
+#include <cstdint>
+
+// extracts numbers from JSON text while it is received, without building a
+// document. the paths use the syntax of Utils::getJsonValueByPath(), e.g.
+// "emeters/[0]/power". the text is passed in through the Stream interface,
+// so it can be the target of HTTPClient::writeToStream().
+class JsonPathScanner : public Stream {
+public:
+    static constexpr size_t MaxPaths = 4;
+
+    // the path is not copied, it must outlive the scanner. returns false if
+    // all slots are taken or the path is too deep.
+    bool addPath(char const* path);
+    size_t getPathCount() const { return _pathCount; }
+
+    // clears the values and the parser state, keeps the paths
+    void reset();
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+
+    // false if the text was malformed or incomplete, see getError()
+    bool isComplete() const { return _state == State::Done; }
+    char const* getError() const;
+
+    // the value found at the path, or false with the reason in error
+    bool getValue(size_t path, float& value, String& error) const;
+
+private:
+    static constexpr size_t MaxDepth = 16;
+    static constexpr size_t MaxKeyLength = 63; // longer keys never match
+
+    enum class State : uint8_t {
+        Value, // a value is expected
+        FirstKey, // after '{', a key or '}'
+        FirstElement, // after '[', a value or ']'
+        Key, // after ',' in an object
+        KeyString,
+        Colon,
+        StringValue,
+        Literal,
+        AfterValue, // ',' or the end of the container
+        Done,
+        Error
+    };
+
+    enum class Result : uint8_t {
+        Missing,
+        Number,
+        NotNumeric,
+        NotScalar
+    };
+
+    struct Segment_t {
+        uint16_t offset;
+        uint8_t length;
+    };
+
+    struct Path_t {
+        char const* text;
+        std::array<Segment_t, MaxDepth> segments;
+        uint8_t segmentCount;
+        uint8_t matched; // leading segments matching the current position
+        Result result;
+        float value;
+    };
+
+    struct Level_t {
+        bool array;
+        uint16_t index;
+    };
+
+    void parse(char c);
+    void fail(char const* error);
+    void beginValue(char c);
+    void endScalar(bool isString);
+    void enterChild(char const* key, size_t length, int index);
+    void leaveContainer();
+    bool segmentMatches(Path_t const& path, char const* key, size_t length, int index) const;
+
+    enum class StringChar : uint8_t { Skip, Append, End };
+    StringChar stringChar(char c, char& out);
+
+    std::array<Path_t, MaxPaths> _paths;
+    size_t _pathCount = 0;
+
+    State _state = State::Value;
+    char const* _error = nullptr;
+    std::array<Level_t, MaxDepth> _levels;
+    uint8_t _depth = 0;
+
+    bool _escape = false;
+    uint8_t _unicodeDigits = 0;
+
+    char _key[MaxKeyLength];
+    size_t _keyLength = 0;
+    bool _keyOverflow = false;
+
+    uint8_t _capture = 0; // bit per path whose value is being read
+    char _text[32];
+    size_t _textLength = 0;
+    bool _textOverflow = false;
+};
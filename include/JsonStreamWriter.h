@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <cstdint>
+#include <type_traits>
+
+// writes JSON text without building a document first. the text is appended
+// to buffer(), which the caller may send and clear at any time, the nesting
+// state is kept. keys are only used inside objects, array elements are
+// written with a nullptr key.
+class JsonStreamWriter {
+public:
+    void beginObject(const char* key = nullptr);
+    void endObject();
+    void beginArray(const char* key = nullptr);
+    void endArray();
+
+    void add(const char* key, const char* value);
+    void add(const char* key, const String& value) { add(key, value.c_str()); }
+    void add(const char* key, bool value);
+    void add(const char* key, float value);
+    void add(const char* key, double value);
+    void addNull(const char* key);
+
+    template<typename T>
+    typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type
+    add(const char* key, T value) { addSigned(key, value); }
+
+    template<typename T>
+    typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value>::type
+    add(const char* key, T value) { addUnsigned(key, value); }
+
+    // copies the members of a (small) document into the current object
+    void addMembers(JsonObjectConst object);
+    void add(const char* key, JsonVariantConst value);
+
+    // "name": { "v": value, "u": unit, "d": digits }
+    void addValue(const char* key, float value, const char* unit, uint8_t digits);
+
+    String& buffer() { return _buffer; }
+
+    // the top level value is complete
+    bool isComplete() const { return _depth == 0 && _started; }
+
+private:
+    void addSigned(const char* key, int64_t value);
+    void addUnsigned(const char* key, uint64_t value);
+    void writeKey(const char* key);
+    void writeString(const char* value);
+    void open(const char* key, char bracket);
+    void close(char bracket);
+
+    String _buffer;
+
+    // bit n: the container at depth n already has an element
+    uint32_t _hasElements = 0;
+    uint8_t _depth = 0;
+    bool _started = false;
+};
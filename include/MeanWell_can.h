@@ -11,6 +11,10 @@
 #include <mcp2515_can.h>
 #include <Longan_I2C_CAN_Arduino.h>
 #include <AsyncJson.h>
+#include <deque>
+#include <map>
+#include <mutex>
+#include "CanIo.h"
 #include "PinMapping.h"
 
 #define MEANWELL_MINIMAL_SET_VOLTAGE 42
@@ -177,14 +181,15 @@ public:
 
 private:
     void loop();
+    void chargerControl();
 
     Task _loopTask;
 
     void updateEEPROMwrites2NVS();
 
     void switchChargerOff(const char* reason);
-    bool getCanCharger(void);
     bool parseCanPackets(void);
+    bool readFrame(twai_message_t& rx_message);
     void calcPower();
     void onReceive(uint8_t* frame, uint8_t len);
     const char* Word2BinaryString(uint16_t w);
@@ -194,11 +199,62 @@ private:
     int16_t readSignedInt16(uint8_t* data) { return readUnsignedInt16(data); }
     float scaleValue(int16_t value, float factor) { return value * factor; }
     bool sendCmd(uint8_t id, uint16_t cmd, uint8_t* data = reinterpret_cast<uint8_t*>(NULL), int len = 0);
-    bool _sendCmd(uint8_t id, uint16_t cmd, uint8_t* data = reinterpret_cast<uint8_t*>(NULL), int len = 0);
-    bool readCmd(uint8_t id, uint16_t cmd);
     float calcEfficency(float x);
     void setupParameter(void);
 
+    // asynchronous request/response engine. read and write requests are
+    // queued and sent from the loop, responses are matched against the
+    // pending transactions by their command ID. nothing in here waits for
+    // the charger, so a slow or missing charger does not stall the loop.
+    struct Request_t {
+        uint16_t cmd;
+        uint8_t data[6];
+        uint8_t len; // 0 for read requests
+        uint16_t timeout; // ms, read requests only
+        uint8_t retries; // read requests only
+        uint32_t seq;
+    };
+
+    struct Transaction_t {
+        Request_t request;
+        uint32_t sentMillis;
+    };
+
+    static constexpr uint16_t _readTimeout = 250; // ms
+    static constexpr uint16_t _readBackTimeout = 1000; // ms, after a write the charger is busy with its EEPROM
+    static constexpr uint8_t _readRetries = 2;
+    static constexpr size_t _maxTransactions = 4; // read requests in flight at once
+    static constexpr uint32_t _writeHoldOff = 100; // ms, bus idle time after a write
+    static constexpr uint32_t _packetMarginTime = 5; // ms, between last response and next request
+
+    uint32_t queueRead(uint16_t cmd, uint16_t timeout = _readTimeout);
+    uint32_t queueWrite(uint16_t cmd, uint8_t const* data, uint8_t len);
+    bool isQueued(uint16_t cmd) const;
+    void processRequests();
+    void expireTransactions();
+    void completeTransaction(uint16_t cmd);
+    void onPowerCommandResult(bool success);
+
+    std::deque<Request_t> _requests;
+    std::map<uint16_t, Transaction_t> _transactions; // keyed by command ID
+    uint32_t _requestSeq = 0;
+    uint32_t _holdOffUntil = 0;
+
+    uint32_t _powerCommandSeq = 0; // read back of OPERATION which completes setPower()
+    bool _powerCommandPending = false;
+    bool _powerCommandTarget = false;
+
+    bool _pollPending = false;
+    uint32_t _pollStartMillis = 0;
+    bool _setupPending = false;
+    bool _setupVerboseLogging = false;
+
+    // responses of the charger, filled by the CAN I/O task
+    CanFrameQueue _frames;
+
+    // serializes the controller accesses of the CAN I/O task and the loop
+    std::mutex _controllerMutex;
+
 #ifdef USE_CHARGER_MCP2515
 //    SPIClass* spi;
 //    MCP_CAN* CAN;
@@ -1,41 +1,104 @@
-// SPDX-License-Identifier: GPL-2.0-or-later
-#pragma once
-
-#include <AsyncWebSocket.h>
-#include <TaskSchedulerDeclarations.h>
-#include <Print.h>
-#include <freertos/task.h>
-#include <mutex>
-#include <vector>
-#include <unordered_map>
-#include <queue>
-
-class MessageOutputClass : public Print {
-public:
-    MessageOutputClass();
-    void init(Scheduler& scheduler);
-    size_t write(uint8_t c) override;
-    size_t write(const uint8_t* buffer, size_t size) override;
-    void register_ws_output(AsyncWebSocket* output);
-
-private:
-    void loop();
-
-    Task _loopTask;
-
-    using message_t = std::vector<uint8_t>;
-
-    // we keep a buffer for every task and only write complete lines to the
-    // serial output and then move them to be pushed through the websocket.
-    // this way we prevent mangling of messages from different contexts.
-    std::unordered_map<TaskHandle_t, message_t> _task_messages;
-    std::queue<message_t> _lines;
-
-    AsyncWebSocket* _ws = nullptr;
-
-    std::mutex _msgLock;
-
-    void serialWrite(message_t const& m);
-};
-
-extern MessageOutputClass MessageOutput;
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <AsyncWebSocket.h>
+#include <TaskSchedulerDeclarations.h>
+#include <Print.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <pthread.h>
+#include <array>
+#include <atomic>
+#include <cstdarg>
+#include <vector>
+
+class MessageOutputClass : public Print {
+public:
+    enum class Level : uint8_t {
+        Error,
+        Warning,
+        Info,
+        Verbose
+    };
+
+    MessageOutputClass();
+    void init();
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    void register_ws_output(AsyncWebSocket* output);
+
+    // messages above this level are dropped before they are formatted.
+    // printf() without a level logs at Info.
+    void setLevel(Level level) { _level.store(level, std::memory_order_relaxed); }
+    bool isEnabled(Level level) const { return level <= _level.load(std::memory_order_relaxed); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    size_t printf(Level level, const char* format, ...) __attribute__((format(printf, 3, 4)));
+
+    // lines lost because the ring buffer or the websocket was full
+    uint32_t getDroppedLines() const { return _droppedLines; }
+
+private:
+    static constexpr size_t _lineSize = 256;
+    static constexpr size_t _lineCount = 12;
+    static constexpr size_t _ringSize = 4096; // must be a power of two
+    static constexpr size_t _wsBatchSize = 2048;
+
+    static constexpr uint32_t _taskStackSize = 3072;
+    static constexpr UBaseType_t _taskPriority = 1;
+
+    // partial line of one task. a task owns a line only until it wrote the
+    // newline, so the arena is shared by all tasks currently logging. this
+    // way messages from different contexts are not mangled.
+    struct Line_t {
+        std::atomic<TaskHandle_t> owner = { nullptr };
+        uint16_t length = 0;
+        char data[_lineSize + 1]; // room for the terminator of vsnprintf
+    };
+
+    Line_t* acquireLine();
+    void releaseLine(Line_t& line);
+    static void onTaskDeleted(void* task);
+    void append(Line_t& line, const uint8_t* buffer, size_t size);
+    void flushCompleteLines(Line_t& line);
+    size_t vprintf(const char* format, va_list args);
+
+    // multi producer, single consumer ring of records: a 32 bit header
+    // (length and commit flag) followed by the text, padded to 4 bytes.
+    // producers reserve space with a CAS and commit the header last, no
+    // task ever waits for another one.
+    bool push(const uint8_t* data, size_t size);
+    void drain();
+    void deliver(const uint8_t* data, size_t size);
+    void flushWebsocket();
+
+    static void taskLoopHelper(void* context);
+    void taskLoop();
+
+    void serialWrite(const uint8_t* data, size_t size);
+
+    alignas(4) std::array<uint8_t, _ringSize> _ring = {};
+    std::atomic<uint32_t> _reserved = { 0 };
+    std::atomic<uint32_t> _consumed = { 0 };
+    std::atomic<uint32_t> _droppedLines = { 0 };
+
+    std::array<Line_t, _lineCount> _lines;
+
+    std::atomic<Level> _level = { Level::Verbose };
+
+    // its destructor releases the line of a task deleted in the middle of
+    // a line. ESP-IDF calls it from the deletion callback of the task.
+    pthread_key_t _lineKey;
+    bool _lineKeyCreated = false;
+
+    // only used by the output task
+    std::vector<uint8_t> _wsBatch;
+    uint32_t _reportedDropped = 0;
+
+    AsyncWebSocket* _ws = nullptr;
+    TaskHandle_t _taskHandle = nullptr;
+};
+
+extern MessageOutputClass MessageOutput;
+
+using LogLevel = MessageOutputClass::Level;
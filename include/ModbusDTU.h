@@ -3,7 +3,9 @@
 #pragma once
 
 #include <TaskSchedulerDeclarations.h>
+#include <atomic>
 #include <cstdint>
+#include <vector>
 #include "Configuration.h"
 #include <ModbusIP_ESP8266.h>
 #include <Hoymiles.h>
@@ -18,12 +20,45 @@ private:
     void setup();
     void modbus();
 
+    // contiguous range of holding registers. the values are kept in the
+    // image and handed to the Modbus server when a client reads them, the
+    // registers of the server itself are never written.
+    struct Block_t {
+        uint16_t base;
+        std::vector<uint16_t> regs;
+    };
+
+    // position of an inverter in the Hoymiles DTU map
+    struct InverterSlot_t {
+        uint64_t serial;
+        uint8_t firstChannel;
+        uint8_t channels;
+    };
+
+    Block_t& addBlock(uint16_t base, uint16_t count);
+    uint16_t* findRegister(uint16_t reg);
+    static uint16_t onGetHreg(TRegister* reg, uint16_t val);
+
+    void onStatisticsUpdate(InverterAbstract& inv);
+    void refresh();
+#ifdef SIMULATE_HOYMILES_DTU
+    void refreshInverter(InverterSlot_t const& slot);
+#endif
+
+    void setHReg(uint16_t reg, uint16_t value);
     void setHRegs(uint16_t reg, float value);
-    void addHString(uint16_t reg, const char* s, uint8_t len);
+    void setHString(uint16_t reg, const char* s, uint8_t len);
 
     bool _isstarted = false;
     float _lasttotal = 0;
 
+    std::vector<Block_t> _blocks;
+    std::vector<InverterSlot_t> _slots;
+
+    // bit n set: statistics of _slots[n] changed since the last refresh
+    std::atomic<uint32_t> _dirtySlots = { 0 };
+    std::atomic<bool> _dirty = { false };
+
     Task _loopTask;
     Task _modbusTask;
 };
@@ -7,6 +7,7 @@
 #include "REFUsolRS485Receiver.h"
 #include <Arduino.h>
 #include <TaskSchedulerDeclarations.h>
+#include <vector>
 
 #ifndef REFUsol_PIN_RX
 #define REFUsol_PIN_RX 22
@@ -31,10 +32,11 @@ public:
 
 private:
     void loop();
+    void publish(size_t inverter);
 
     Task _loopTask;
 
-    REFUsolStruct _last {}; // last value store for MQTT publishing
+    std::vector<REFUsolStruct> _last; // last value store for MQTT publishing, per inverter
 
     uint32_t _lastPublish;
 };
@@ -4,17 +4,59 @@
 #include "NetworkSettings.h"
 #include <MqttSubscribeParser.h>
 #include <Ticker.h>
+#include <ArduinoJson.h>
+#include <TaskSchedulerDeclarations.h>
 #include <espMqttClient.h>
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <unordered_map>
+#include <vector>
 
 class MqttSettingsClass {
 public:
     MqttSettingsClass();
-    void init();
+    void init(Scheduler& scheduler);
     void performReconnect();
     bool getConnected();
     void publish(const String& subtopic, const String& payload);
-    void publishGeneric(const String& topic, const String& payload, const bool retain, const uint8_t qos = 0);
+
+    // Messages are queued until the client has room for them, so a broker
+    // outage can not exhaust the heap. The queue is limited to
+    // Mqtt.QueueBudget bytes. A message replaces a queued message for the
+    // same topic unless coalesce is false (e.g. for commands). If the
+    // budget is exceeded, the oldest QoS 0 messages are dropped first, the
+    // retained ones after all other QoS 0 messages. Returns false if the
+    // message was dropped.
+    bool publishGeneric(const String& topic, const String& payload, const bool retain, const uint8_t qos = 0, const bool coalesce = true);
+
+    struct QueueStats_t {
+        size_t messages;
+        size_t bytes;
+        size_t peakBytes;
+        uint32_t coalesced;
+        uint32_t droppedQos0;
+        uint32_t droppedQos12;
+    };
+    QueueStats_t getQueueStats();
+
+    // Batched publishing of the values of one device (e.g. an inverter).
+    // Values which did not change since the last publish are suppressed
+    // until Mqtt.RefreshInterval expires. If Mqtt.JsonPayload is enabled,
+    // all values of the device are sent as one JSON message to
+    // <prefix><device>/json instead. The individual topics are still
+    // published while Home Assistant discovery is enabled, as the discovered
+    // entities refer to them. Must only be used from the main loop.
+    void beginDevicePublish(const String& device);
+    void publishDeviceValue(const String& subtopic, const String& payload);
+    void endDevicePublish();
+    bool isDeviceRefreshDue() const;
+
+    // forgets the published values of a deleted device. may be called from
+    // any task, the cache is erased by the next beginDevicePublish().
+    void removeDevice(const String& device);
 
     void subscribe(const String& topic, const uint8_t qos, const espMqttClientTypes::OnMessageCallback& cb);
     void unsubscribe(const String& topic);
@@ -37,6 +79,60 @@ private:
 
     void createMqttClientObject();
 
+    struct OutboxEntry_t {
+        String topic;
+        String payload;
+        uint32_t topicHash;
+        uint8_t qos;
+        bool retain;
+        bool coalesce;
+    };
+    using Outbox = std::list<OutboxEntry_t>;
+
+    static size_t entrySize(const OutboxEntry_t& entry);
+    bool makeRoom(size_t size, uint8_t qos, const OutboxEntry_t* keep = nullptr);
+    Outbox::iterator removeEntry(Outbox::iterator it);
+    bool sendEntry(const OutboxEntry_t& entry);
+    void processQueue();
+
+    struct DevicePublishCache_t {
+        String topic; // interned "<prefix><device>/"
+        uint32_t generation = 0;
+        uint32_t lastRefresh = 0;
+        std::unordered_map<uint32_t, uint32_t> valueHashes; // subtopic hash -> payload hash
+        std::unique_ptr<JsonDocument> json;
+        bool jsonPending = false; // the last JSON message was dropped
+    };
+
+    static uint32_t hash(const char* str);
+
+    std::map<String, DevicePublishCache_t> _deviceCaches;
+    DevicePublishCache_t* _currentDevice = nullptr;
+    String _deviceTopic;
+    bool _deviceRefresh = false;
+    bool _deviceChanged = false;
+    bool _deviceIndividualTopics = true;
+
+    std::mutex _removedDevicesLock;
+    std::vector<String> _removedDevices;
+
+    // incremented on every (re)connect to enforce a full publish
+    std::atomic<uint32_t> _cacheGeneration = 1;
+
+    // messages are only handed to the client while its own outbox holds
+    // less than this number of messages
+    static constexpr size_t _clientQueueLimit = 16;
+
+    Task _queueTask;
+    std::mutex _queueLock;
+    Outbox _outbox;
+    std::unordered_map<uint32_t, Outbox::iterator> _outboxTopics; // topic hash -> coalescable entry
+    size_t _outboxBytes = 0;
+    size_t _outboxPeakBytes = 0;
+    uint32_t _coalesced = 0;
+    uint32_t _droppedQos0 = 0;
+    uint32_t _droppedQos12 = 0;
+
     MqttClient* _mqttClient = nullptr;
     Ticker _mqttReconnectTimer;
     MqttSubscribeParser _mqttSubscribeParser;
@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 
+#include "PowerLimiterLatency.h"
 #include <Hoymiles.h>
 #include <TaskSchedulerDeclarations.h>
 #include <TimeoutHelper.h>
@@ -8,6 +9,8 @@
 #include <frozen/string.h>
 #include <functional>
 #include <memory>
+#include <optional>
+#include <vector>
 
 #define PL_UI_STATE_INACTIVE 0
 #define PL_UI_STATE_CHARGING 1
@@ -61,6 +64,7 @@ public:
     uint8_t getInverterUpdateTimeouts() const { return _inverterUpdateTimeouts; }
     uint8_t getPowerLimiterState();
     int32_t getLastRequestedPowerLimit() { return _lastRequestedPowerLimit; }
+    bool isBatteryPoweredInverter(uint64_t serial) const;
     bool getFullSolarPassThroughEnabled() const { return _fullSolarPassThroughEnabled; }
 
     enum class Mode : unsigned {
@@ -78,17 +82,36 @@ private:
 
     Task _loopTask;
 
-    int32_t _lastRequestedPowerLimit = 0;
+    // an inverter governed by the DPL. the first entry of _inverters is the
+    // configured (primary) inverter, which is the one connected to the
+    // battery through the MosFETs and used to read the battery voltage.
+    // additional inverters share the load with the primary inverter.
+    struct ManagedInverter_t {
+        std::shared_ptr<InverterAbstract> inverter = nullptr;
+        bool solarPowered = false;
+        bool eligible = false; // reachable, commands enabled and device info known
+        int32_t lastRequestedPowerLimit = 0;
+        uint8_t updateTimeouts = 0;
+        uint32_t latencyMillis = 0; // smoothed time until a limit command is acknowledged
+        std::optional<uint32_t> oInverterStatsMillis = std::nullopt;
+        std::optional<uint32_t> oCommandSentMillis = std::nullopt; // awaiting statistics after a command
+        std::optional<uint32_t> oUpdateStartMillis = std::nullopt;
+        std::optional<int32_t> oTargetPowerLimitWatts = std::nullopt;
+        std::optional<bool> oTargetPowerState = std::nullopt;
+        std::optional<PowerLimiterLatencyClass::Cycle_t> oTrace = std::nullopt; // control cycle in progress
+    };
+
+    std::vector<ManagedInverter_t> _inverters;
+    int32_t _lastRequestedPowerLimit = 0; // sum of all managed inverters
+    uint8_t _inverterUpdateTimeouts = 0; // max of all managed inverters
+    bool _inverterProducing = false; // any of the managed inverters
     bool _shutdownPending = false;
-    std::optional<uint32_t> _oInverterStatsMillis = std::nullopt;
-    std::optional<uint32_t> _oUpdateStartMillis = std::nullopt;
-    std::optional<int32_t> _oTargetPowerLimitWatts = std::nullopt;
-    std::optional<bool> _oTargetPowerState = std::nullopt;
     Status _lastStatus = Status::Initializing;
     TimeoutHelper _lastStatusPrinted;
     uint32_t _lastCalculation = 0;
     static constexpr uint32_t _calculationBackoffMsDefault = 128;
     uint32_t _calculationBackoffMs = _calculationBackoffMsDefault;
+    static constexpr uint32_t _secondaryStatsTimeoutMs = 30 * 1000;
     Mode _mode = Mode::Normal;
     std::shared_ptr<InverterAbstract> _inverter = nullptr;
     bool _batteryDischargeEnabled = false;
@@ -96,7 +119,6 @@ private:
     uint32_t _nextInverterRestart = 0; // Values: 0->not calculated / 1->no restart configured / >1->time of next inverter restart in millis()
     uint32_t _nextCalculateCheck = 5000; // time in millis for next NTP check to calulate restart
     bool _fullSolarPassThroughEnabled = false;
-    uint8_t _inverterUpdateTimeouts = 0;
 
     frozen::string const& getStatusText(Status status);
     void announceStatus(Status status);
@@ -104,12 +126,20 @@ private:
     bool shutdown(Status status);
     bool shutdown() { return shutdown(_lastStatus); }
     float getBatteryVoltage(bool log = false);
+    bool syncManagedInverters();
     int32_t inverterPowerDcToAc(std::shared_ptr<InverterAbstract> inverter, int32_t dcPower);
-    void unconditionalSolarPassthrough(std::shared_ptr<InverterAbstract> inverter);
-    bool calcPowerLimit(std::shared_ptr<InverterAbstract> inverter, int32_t solarPower, int32_t batteryPowerLimit, bool batteryPower);
-    bool setNewPowerLimit(std::shared_ptr<InverterAbstract> inverter, int32_t newPowerLimit);
-    bool updateInverter();
-    int32_t scalePowerLimit(std::shared_ptr<InverterAbstract> inverter, int32_t newLimit, int32_t currentLimitWatts);
+    void unconditionalSolarPassthrough();
+    bool calcPowerLimit(int32_t solarPower, int32_t batteryPowerLimit, bool batteryPower);
+    bool hasSolarPoweredInverters() const;
+    bool shutdownBatteryPowered(Status status);
+    int32_t getAvailablePower(ManagedInverter_t const& mi);
+    int32_t distributeSolarPowered(int32_t demand);
+    void distributeBatteryPowered(int32_t demand);
+    int32_t splitPowerLimit(std::vector<ManagedInverter_t*>& group, int32_t target);
+    void setNewPowerLimit(ManagedInverter_t& mi, int32_t newPowerLimit);
+    bool updateInverters();
+    bool updateInverter(ManagedInverter_t& mi);
+    int32_t scalePowerLimit(ManagedInverter_t& mi, int32_t newLimit, int32_t currentLimitWatts);
     int32_t getSolarPower();
     int32_t getBatteryDischargeLimit();
     float getLoadCorrectedVoltage();
@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <ArduinoJson.h>
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+
+// keeps track of how long the stages of the DPL's control loop take, from the
+// power meter reading that led to a new limit until the inverter reported
+// statistics which were produced with that limit. the most recent control
+// cycles are kept in a ring buffer and evaluated as percentiles.
+class PowerLimiterLatencyClass {
+public:
+    enum class Stage : uint8_t {
+        Calculation,    // power meter reading until the new limit was calculated
+        Dispatch,       // limit calculated until the command was handed to the radio
+        Radio,          // command handed to the radio until acknowledged by the inverter
+        Statistics,     // limit acknowledged until fresh statistics were received
+        Total,          // power meter reading until fresh statistics were received
+        Count
+    };
+
+    // timestamps (millis) of a single control cycle of one inverter
+    struct Cycle_t {
+        uint64_t serial = 0;
+        int32_t limit = 0;
+        uint32_t meterMillis = 0;
+        uint32_t calculatedMillis = 0;
+        uint32_t sentMillis = 0;
+        uint32_t acknowledgedMillis = 0;
+        uint32_t statisticsMillis = 0;
+    };
+
+    struct Percentiles_t {
+        uint32_t p50;
+        uint32_t p90;
+        uint32_t p99;
+        uint32_t max;
+    };
+
+    void addCycle(Cycle_t const& cycle);
+    void clear();
+
+    size_t getCycleCount() const;
+    std::optional<Percentiles_t> getPercentiles(Stage stage) const;
+    void toJson(JsonObject& root) const;
+
+    static char const* getStageName(Stage stage);
+
+private:
+    static constexpr size_t _capacity = 64;
+
+    static uint32_t getDuration(Cycle_t const& cycle, Stage stage);
+    static uint32_t getPercentile(std::array<uint32_t, _capacity> const& durations, size_t count, size_t percent);
+    size_t getSortedDurations(Stage stage, std::array<uint32_t, _capacity>& durations) const;
+
+    mutable std::mutex _mutex;
+    std::array<Cycle_t, _capacity> _cycles;
+    size_t _next = 0;
+    size_t _count = 0;
+    uint32_t _totalCycles = 0;
+};
+
+extern PowerLimiterLatencyClass PowerLimiterLatency;
@@ -9,6 +9,7 @@
 #include <mutex>
 #include <stdint.h>
 #include "HttpGetter.h"
+#include "JsonPathScanner.h"
 #include "Configuration.h"
 #include "PowerMeterProvider.h"
 #include "Datastore.h"
@@ -39,6 +40,25 @@ private:
     std::atomic<bool> _taskDone;
     void pollingLoop();
 
+    // getters talking to the same server form a group. the groups are
+    // polled concurrently, the getters of a group one after another over
+    // their shared connection. the first group is polled by the caller of
+    // poll(), every other one by its own worker task, which is notified for
+    // each poll and notifies the caller when it is done.
+    struct GroupWorker_t {
+        PowerMeterHttpJson* instance;
+        uint8_t group;
+        TaskHandle_t handle = nullptr;
+        std::atomic<bool> done = { false };
+    };
+    static void groupWorkerHelper(void* context);
+    void groupWorkerLoop(uint8_t group);
+    void pollGroup(uint8_t group);
+
+    std::array<GroupWorker_t, POWERMETER_HTTP_JSON_MAX_VALUES> _workers;
+    std::atomic<bool> _stopWorkers = { false };
+    TaskHandle_t _pollCaller = nullptr;
+
     PowerMeterHttpJsonConfig const _cfg;
 
     uint32_t _lastPoll = 0;
@@ -47,6 +67,20 @@ private:
     power_values_t _powerValues = {};
 
     std::array<std::unique_ptr<HttpGetter>, POWERMETER_HTTP_JSON_MAX_VALUES> _httpGetters;
+    std::array<uint8_t, POWERMETER_HTTP_JSON_MAX_VALUES> _groups = {}; // per getter
+    uint8_t _groupCount = 0;
+
+    // the response of each getter is scanned for the paths of the values it
+    // serves, value i is read from getter _sources[i] at _paths[i].
+    static_assert(POWERMETER_HTTP_JSON_MAX_VALUES <= JsonPathScanner::MaxPaths,
+            "a getter may serve all values");
+    std::array<JsonPathScanner, POWERMETER_HTTP_JSON_MAX_VALUES> _scanners;
+    std::array<uint8_t, POWERMETER_HTTP_JSON_MAX_VALUES> _sources = {};
+    std::array<uint8_t, POWERMETER_HTTP_JSON_MAX_VALUES> _paths = {};
+
+    // results of the current poll, written by the group tasks
+    power_values_t _polledValues = {};
+    std::array<String, POWERMETER_HTTP_JSON_MAX_VALUES> _pollErrors;
 
     TaskHandle_t _taskHandle = nullptr;
     bool _stopPolling;
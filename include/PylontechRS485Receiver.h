@@ -4,6 +4,7 @@
 #ifdef USE_PYLONTECH_RS485_RECEIVER
 
 #include "Battery.h"
+#include "BatteryRS485Transactions.h"
 #include <TimeoutHelper.h>
 #include <espMqttClient.h>
 #include <memory>
@@ -12,15 +13,6 @@
 #define ECHO_READ_TOUT (3) // 3.5T * 8 = 28 ticks, TOUT=3 -> ~24..33 ticks
 
 #pragma pack(push, 1)
-typedef struct {
-    uint8_t ver; // HexToByte(construct.Array(2, construct.Byte)),
-    uint8_t adr; // HexToByte(construct.Array(2, construct.Byte)),
-    uint8_t cid1; // HexToByte(construct.Array(2, construct.Byte)),
-    uint8_t cid2; // HexToByte(construct.Array(2, construct.Byte)),
-    uint16_t infolength; // HexToByte(construct.Array(4, construct.Byte)),
-    uint8_t info[256]; // HexToByte(construct.GreedyRange(construct.Byte))
-} format_t;
-
 typedef union {
     int16_t i;
     uint16_t u;
@@ -46,8 +38,7 @@ class PylontechRS485Receiver : public BatteryProvider {
     enum Function : uint8_t
     {
         REQUEST = 0,
-        REQUEST_AND_GET = 1,
-        GET = 2
+        GET = 1
     };
 
     enum Command : uint8_t
@@ -105,6 +96,8 @@ private:
     std::unique_ptr<HardwareSerial> _upSerial;
 
     void readParameter();
+    void onPackCount(uint8_t module, bool found);
+    void onResponse(BatteryRS485Transactions::Request_t const& request, format_t* frame);
 
     void get_protocol_version(const PylontechRS485Receiver::Function function, uint8_t module);
     void get_manufacturer_info(const PylontechRS485Receiver::Function function, uint8_t module);
@@ -124,10 +117,6 @@ private:
     uint16_t get_info_length(const char* info);
     //void _encode_cmd(char *frame, uint8_t address, uint8_t cid2, const char* info);
     void send_cmd(uint8_t address, uint8_t cmnd, uint8_t InfoCommand = 1);
-    size_t readline(void);
-    uint32_t hex2binary(char* s, int len);
-    char* _decode_hw_frame(size_t length);
-    format_t* _decode_frame(char* frame);
     format_t* read_frame(void);
 
     //    uint16_t readUnsignedInt16(uint8_t *data) { return ((*(data+1)) << 8) + (*data); };
@@ -165,9 +154,16 @@ private:
     float DivideUint16By1000(uint8_t*& c) { return static_cast<float>(ToUint16(c)) / 1000.0; }
     float DivideUint24By1000(uint8_t*& c) { return static_cast<float>(ToUint24(c)) / 1000.0; }
 
-    char *_received_frame;
+    BatteryRS485Transactions _transactions;
+
+    // the response currently parsed, owned by _transactions
+    format_t* _received_frame = nullptr;
+
+    bool _readingParameters = false;
+    bool _parameterVerboseLogging = false;
+    uint8_t _packsFound = 0;
 
-    uint8_t _lastCmnd = 0xFF;
+    uint8_t _pollState = 0;
 
     uint8_t _masterBatteryID = 0;
     uint8_t _lastSlaveBatteryID = 0;
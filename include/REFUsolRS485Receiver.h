@@ -14,6 +14,10 @@
 
 #include <AsyncJson.h>
 #include <TaskSchedulerDeclarations.h>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <vector>
 
 // Timeout threshold for UART = number of symbols (~10 tics) with unchanged state on receive pin
 #define ECHO_READ_TOUT (3) // 3.5T * 8 = 28 ticks, TOUT=3 -> ~24..33 ticks
@@ -34,6 +38,8 @@
 #define REFUsol_PIN_RTS 4 // HardwareSerial RTS Pin
 #endif
 
+#define REFUsol_MAX_INVERTERS 8 // inverters with consecutive USS addresses on one bus
+
 #define REFUsol_MAX_NAME_LEN 9 // REFUsol Protocol: max name size is 9 including /0
 #define REFUsol_MAX_VALUE_LEN 33 // REFUsol Protocol: max value size is 33 including /0
 
@@ -164,14 +170,15 @@ public:
     REFUsolRS485ReceiverClass();
     void init(Scheduler& scheduler); // initialize HardewareSerial
     void deinit(void);
-    void updateSettings();
-    bool readParameters();
-    uint32_t getLastUpdate(); // timestamp of last successful frame read
-    bool isDataValid(void); // return true if data valid and not outdated
+    void updateSettings(); // applied by the next loop() call
+    uint32_t getLastUpdate(); // timestamp of the newest successful frame read of all inverters
+    uint32_t getLastUpdate(size_t inverter);
+    bool isDataValid(size_t inverter = 0); // return true if data valid and not outdated
 
-    REFUsolStruct Frame {}; // public struct for received name and value pairs
+    size_t getInverterCount() const;
+    REFUsolStruct getFrame(size_t inverter = 0) const; // copy, the frame is updated by the loop task
 
-    void generateJsonResponse(JsonVariant& root);
+    void generateJsonResponse(JsonVariant& root, size_t inverter = 0);
 
     bool getVerboseLogging(void) { return _verboseLogging; };
     void setVerboseLogging(bool logging) { _verboseLogging = logging; };
@@ -182,34 +189,34 @@ private:
     std::unique_ptr<HardwareSerial> _upSerial;
 
     void loop(void); // main loop to read ve.direct data
+    void applySettings(void);
+    std::atomic<bool> _settingsChanged = { false };
 
     Task _loopTask;
 
-    void parse(void);
-    void getDCpower(uint8_t adr);
-    void getDCvoltage(uint8_t adr);
-    void getDCcurrent(uint8_t adr);
-    void getACpower(uint8_t adr);
-    void getACvoltage(uint8_t adr, uint16_t ind = 0);
-    void getACcurrent(uint8_t adr, uint16_t ind = 0);
-    void getACfrequency(uint8_t adr, uint16_t ind = 0);
-    void getTotalOperatingHours(uint8_t adr);
-    void getYieldDay(uint8_t adr);
-    void getYieldMonth(uint8_t adr);
-    void getYieldYear(uint8_t adr);
-    void getYieldTotal(uint8_t adr);
-    void getPVpeak(uint8_t adr);
-    void getPVlimit(uint8_t adr);
-    void getDeviceSpecificOffset(uint8_t adr);
-    void getPlantSpecificOffset(uint8_t adr);
-    void getFixedOffset(uint8_t adr);
-    void getVariableOffset(uint8_t adr);
-    void getOptionCosPhi(uint8_t adr);
-    void getCosPhi(uint8_t adr, uint16_t ind);
-    void getTemperatursensor(uint8_t adr, uint16_t ind = 0);
-    void getActualStatus(uint8_t adr);
-    void getFehlercode(uint8_t adr);
-    void getPassword(uint8_t adr);
+    struct Inverter_t {
+        uint8_t adr;
+        REFUsolStruct frame;
+        uint32_t lastUpdate; // millis of the last response
+        std::vector<uint32_t> lastRequest; // millis per poll table entry
+        bool parametersRead;
+    };
+
+    struct Request_t {
+        uint8_t inverter; // index into _inverters
+        uint16_t PNU;
+        uint16_t IND;
+    };
+
+    enum class Receive { Pending, Complete, Error };
+
+    void schedule(void);
+    void sendNext(void);
+    void finishRequest(void);
+    void requestCosPhiParameters(size_t inverter);
+    void updateEffectiveCosPhi(REFUsolStruct& frame);
+
+    void parse(Inverter_t& inverter);
     //    IPADDR_t *getIPaddress(uint8_t adr);
     //    IPADDR_t *getIPmask(uint8_t adr);
     //    IPADDR_t *getGateway(uint8_t adr);
@@ -222,13 +229,21 @@ private:
     void computeTelegram(uint8_t adr, bool mirror, uint16_t TaskID, uint16_t PNU, int16_t IND, void* PWE, void* PZD);
     void computeTelegram(uint8_t adr, bool mirror, uint16_t TaskID, uint16_t PNU, int16_t IND, void* PWE, uint8_t pzd_anz, void* PZD);
     void sendTelegram(void);
-    uint8_t receiveTelegram(void);
+    Receive receiveTelegram(void);
     float PWE2Float(float scale = 1.0);
     uint32_t PWE2Uint32(void);
 
-    void setLastUpdate(); // set timestampt after successful frame read
+    bool isFresh(uint32_t lastUpdate) const;
 
-    uint32_t _lastPoll;
+    // guards _inverters, which is read by the web server and MQTT tasks
+    mutable std::mutex _mutex;
+    std::vector<Inverter_t> _inverters;
+    std::deque<Request_t> _requests;
+    Request_t _request {};
+    bool _requestPending = false;
+    uint32_t _requestMillis = 0; // request sent
+    uint32_t _rxMillis = 0; // last character received
+    uint16_t _rxLength = 0;
 
     TELEGRAM_t sTelegram;
     TELEGRAM_t rTelegram;
@@ -245,11 +260,9 @@ private:
     void debugRawTelegram(TELEGRAM_t* t, uint8_t len);
     bool DebugRawTelegram = true;
     int MaximumResponseTime = 20;
-
-    uint8_t adr;
+    static constexpr uint32_t _interCharacterTimeout = 10;
 
     bool _initialized = false;
-    bool _allParametersRead = false;
 
     bool _verboseLogging = false;
 };
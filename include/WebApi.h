@@ -12,6 +12,7 @@
 #include "WebApi_eventlog.h"
 #include "WebApi_firmware.h"
 #include "WebApi_gridprofile.h"
+#include "WebApi_history.h"
 #include "WebApi_inverter.h"
 #include "WebApi_limit.h"
 #include "WebApi_maintenance.h"
@@ -36,8 +37,12 @@
 #include "WebApi_MeanWell.h"
 #include "WebApi_ws_MeanWell.h"
 #include "WebApi_ws_battery.h"
+#include "JsonStreamWriter.h"
 #include <ESPAsyncWebServer.h>
 #include <TaskSchedulerDeclarations.h>
+#include <functional>
+#include <mutex>
+#include <vector>
 
 class WebApiClass {
 public:
@@ -56,7 +61,46 @@ public:
     static uint64_t parseSerialFromRequest(AsyncWebServerRequest* request, String param_name = "inv");
     static bool sendJsonResponse(AsyncWebServerRequest* request, AsyncJsonResponse* response, const char* function, const uint16_t line);
 
+    // writes the next part of a streamed response, returns false once the
+    // response is complete. called from the async_tcp task whenever the TCP
+    // stack accepts more data, step counts the calls.
+    using JsonStreamGenerator = std::function<bool(JsonStreamWriter& writer, size_t step)>;
+    void sendJsonStream(AsyncWebServerRequest* request, const char* endpoint, JsonStreamGenerator generator);
+
+    struct StreamProfile_t {
+        const char* endpoint;
+        uint32_t requests;
+        uint32_t lastBytes;
+        uint32_t maxBytes;
+        uint32_t lastMicros; // first to last chunk
+        uint32_t maxMicros;
+        uint32_t lastHeap; // free heap at the start minus the lowest seen
+        uint32_t maxHeap;
+    };
+    std::vector<StreamProfile_t> getStreamProfiles();
+
 private:
+    struct JsonStreamState_t {
+        const char* endpoint;
+        JsonStreamGenerator generator;
+        JsonStreamWriter writer;
+        size_t step = 0;
+        size_t offset = 0; // part of the writer buffer already sent
+        bool done = false;
+        bool recorded = false;
+
+        uint32_t bytes = 0;
+        uint32_t startMicros = 0;
+        uint32_t startFreeHeap = 0;
+        uint32_t minFreeHeap = 0;
+    };
+
+    size_t fillJsonStream(JsonStreamState_t& state, uint8_t* buffer, size_t maxLen);
+    void recordStreamProfile(JsonStreamState_t const& state);
+
+    std::mutex _streamProfilesMutex;
+    std::vector<StreamProfile_t> _streamProfiles;
+
     AsyncWebServer _server;
 
     WebApiBatteryClass _webApiBattery;
@@ -67,6 +111,7 @@ private:
     WebApiEventlogClass _webApiEventlog;
     WebApiFirmwareClass _webApiFirmware;
     WebApiGridProfileClass _webApiGridprofile;
+    WebApiHistoryClass _webApiHistory;
     WebApiInverterClass _webApiInverter;
     WebApiLimitClass _webApiLimit;
     WebApiMaintenanceClass _webApiMaintenance;
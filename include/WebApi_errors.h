@@ -63,6 +63,8 @@ enum WebApiError {
     MqttHassTopicCharacter,
     MqttLwtQos,
     MqttClientIdLength,
+    MqttRefreshInterval,
+    MqttQueueBudget,
 
     NetworkBase = 8000,
     NetworkIpInvalid,
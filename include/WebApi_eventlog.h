@@ -10,4 +10,5 @@ public:
 
 private:
     void onEventlogStatus(AsyncWebServerRequest* request);
+    void onEventlogArchive(AsyncWebServerRequest* request);
 };
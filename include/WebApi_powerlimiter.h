@@ -13,4 +13,6 @@ private:
     void onMetaData(AsyncWebServerRequest* request);
     void onAdminGet(AsyncWebServerRequest* request);
     void onAdminPost(AsyncWebServerRequest* request);
+    void onLatencyGet(AsyncWebServerRequest* request);
+    void onLatencyReset(AsyncWebServerRequest* request);
 };
@@ -13,11 +13,54 @@ public:
     void init(AsyncWebServer& server, Scheduler& scheduler);
 
 private:
+    enum class Section_t : uint8_t {
+        System,
+        Inverters,
+        Battery,
+        Mppt,
+        PowerMeter,
+        Charger,
+        PowerLimiter,
+        Done
+    };
+
+    // Cursor of the metrics generator. The response is generated line by
+    // line whenever the TCP stack asks for more data, so only the line
+    // currently being sent has to be kept in RAM.
+    struct MetricsState_t {
+        Section_t section = Section_t::System;
+        uint8_t step = 0;
+        uint8_t index = 0; // inverter or charge controller
+        uint8_t type = 0;
+        uint8_t channel = 0;
+        uint8_t field = 0;
+
+        const char* pending = nullptr;
+        size_t pendingLength = 0;
+        bool lineQueued = false;
+
+        char line[256];
+        size_t lineLength = 0;
+    };
+
     void onPrometheusMetricsGet(AsyncWebServerRequest* request);
 
-    void addField(AsyncResponseStream* stream, const String& serial, const uint8_t idx, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, const char* metricName, const char* channelName = nullptr);
+    size_t fillResponse(MetricsState_t& state, uint8_t* buffer, size_t maxLen);
+    bool generateNext(MetricsState_t& state);
+    void nextSection(MetricsState_t& state, Section_t section);
+    bool emit(MetricsState_t& state, const char* header, const char* format, ...) __attribute__((format(printf, 4, 5)));
+
+    bool generateSystem(MetricsState_t& state);
+    bool generateInverter(MetricsState_t& state);
+    bool generateBattery(MetricsState_t& state);
+    bool generateMppt(MetricsState_t& state);
+    bool generatePowerMeter(MetricsState_t& state);
+    bool generateCharger(MetricsState_t& state);
+    bool generatePowerLimiter(MetricsState_t& state);
+
+    bool addField(MetricsState_t& state, const uint8_t idx, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, const char* metricName, const char* channelName = nullptr);
 
-    void addPanelInfo(AsyncResponseStream* stream, const String& serial, const uint8_t idx, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel);
+    bool addPanelInfo(MetricsState_t& state, const uint8_t idx, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const uint8_t item);
 
     enum MetricType_t {
         NONE = 0,
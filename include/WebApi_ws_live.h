@@ -2,10 +2,13 @@
 #pragma once
 
 #include "Configuration.h"
+#include "JsonStreamWriter.h"
 #include <ArduinoJson.h>
 #include <ESPAsyncWebServer.h>
 #include <Hoymiles.h>
 #include <TaskSchedulerDeclarations.h>
+#include <map>
+#include <vector>
 
 class WebApiWsLiveClass {
 public:
@@ -16,21 +19,43 @@ public:
 private:
     static constexpr char const HttpLink[] = "/api/livedata/status";
 
-    static void generateInverterCommonJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv);
-    static void generateInverterChannelJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv);
-    static void generateCommonJsonResponse(JsonVariant& root);
+    static void generateInverterCommonJson(JsonStreamWriter& writer, std::shared_ptr<InverterAbstract> inv);
+    static void generateInverterChannelJson(JsonStreamWriter& writer, std::shared_ptr<InverterAbstract> inv);
+    static void generateTotalJson(JsonStreamWriter& writer);
+    static void generateHintsJson(JsonStreamWriter& writer);
 
-    void generateOnBatteryJsonResponse(JsonVariant& root, bool all);
+    void generateOnBatteryJson(JsonStreamWriter& writer, bool all);
     void sendOnBatteryStats();
 
-    static void addField(JsonObject& root, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, String topic = "");
-    static void addTotalField(JsonObject& root, const String& name, const float value, const String& unit, const uint8_t digits);
+    static void addField(JsonStreamWriter& writer, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, const char* topic = nullptr);
 
     // Daten visualisieren #168
-    static void addHourPower(JsonVariant& root, std::array<float, 24> values, const String& unit, const uint8_t digits);
+    void addHourPower(JsonStreamWriter& writer, std::array<float, 24> values, const char* unit, const uint8_t digits);
 
     void onLivedataStatus(AsyncWebServerRequest* request);
     void onWebsocketEvent(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len);
+    void onWebsocketSubscribe(AsyncWebSocketClient* client, const uint8_t* data, size_t len);
+
+    // A top level part of the livedata (e.g. "battery" or the serial of an
+    // inverter) which is serialized once and shared by all clients.
+    struct Section_t {
+        uint32_t version = 0;
+        String full;
+        String delta; // changes from version - 1 to version (inverters only)
+    };
+
+    // Subscription and the section versions already sent to a client
+    struct Client_t {
+        bool delta = false; // client merges deltas into its data
+        std::vector<String> subscriptions; // empty --> all sections
+        std::map<String, uint32_t> versions;
+    };
+
+    static bool addDelta(JsonObjectConst previous, JsonObjectConst current, JsonObject delta);
+    bool updateSection(const String& name, String&& full, bool calcDelta);
+    bool hasDeltaClients() const;
+    static bool isSubscribed(const Client_t& client, const String& name, bool isInverter);
+    void sendSectionsToClients();
 
     AsyncWebSocket _ws;
     AuthenticationMiddleware _simpleDigestAuth;
@@ -46,6 +71,12 @@ private:
 
     std::mutex _mutex;
 
+    std::map<String, Section_t> _onBatterySections;
+    std::map<String, Section_t> _inverterSections;
+    String _total;
+    String _hints;
+    std::map<uint32_t, Client_t> _clients;
+
     Task _wsCleanupTask;
     void wsCleanupTaskCb();
 
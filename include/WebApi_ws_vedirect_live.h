@@ -3,6 +3,7 @@
 
 #include "ArduinoJson.h"
 #include "Configuration.h"
+#include "JsonStreamWriter.h"
 #include <ESPAsyncWebServer.h>
 #include <TaskSchedulerDeclarations.h>
 #include <VeDirectMpptController.h>
@@ -17,8 +18,10 @@ public:
 private:
     static constexpr char const HttpLink[] = "/api/vedirectlivedata/status";
 
-    void generateCommonJsonResponse(JsonVariant& root, bool fullUpdate);
-    static void populateJson(const JsonObject &root, const VeDirectMpptController::data_t &mpptData);
+    void generateCommonJson(JsonStreamWriter& writer, bool fullUpdate);
+    void generateInstanceJson(JsonStreamWriter& writer, size_t idx);
+    static void generateDplJson(JsonStreamWriter& writer);
+    static void populateJson(JsonStreamWriter& writer, const VeDirectMpptController::data_t &mpptData);
     void onLivedataStatus(AsyncWebServerRequest* request);
     void onWebsocketEvent(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len);
     bool hasUpdate(size_t idx);
@@ -26,6 +26,8 @@
 
 #define MDNS_ENABLED false
 
+#define LOGGING_LEVEL 3 // verbose, the modules decide what they log
+
 #define SYSLOG_ENABLED false
 #define SYSLOG_PORT 514
 
@@ -91,6 +93,9 @@
 #define MQTT_LWT_OFFLINE "offline"
 #define MQTT_LWT_QOS 2U
 #define MQTT_PUBLISH_INTERVAL 5U
+#define MQTT_REFRESH_INTERVAL 60U
+#define MQTT_JSON_PAYLOAD false
+#define MQTT_QUEUE_BUDGET 32768U
 #define MQTT_CLEAN_SESSION true
 
 #define DTU_SERIAL 0x99978563412
@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2024 Thomas Basler and others
+ */
+#include "CommandQueue.h"
+
+unsigned long CommandQueue::size() const
+{
+    return _size.load(std::memory_order_acquire);
+}
+
+void CommandQueue::push(const std::shared_ptr<CommandAbstract>& cmd)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto& lane = _lanes[static_cast<uint8_t>(cmd->getPriority())];
+
+    // Replace an older, not yet sent command in place. It keeps its
+    // position, so a repeated request is not pushed to the end.
+    for (auto& queued : lane) {
+        if (queued->isReplaceableBy(*cmd)) {
+            queued = cmd;
+            return;
+        }
+    }
+
+    lane.push_back(cmd);
+    _size++;
+}
+
+std::shared_ptr<CommandAbstract> CommandQueue::front()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_current != nullptr) {
+        return _current;
+    }
+
+    for (auto& lane : _lanes) {
+        if (!lane.empty()) {
+            _current = lane.front();
+            lane.pop_front();
+            break;
+        }
+    }
+
+    return _current;
+}
+
+void CommandQueue::pop()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_current != nullptr) {
+        _current = nullptr;
+        _size--;
+        return;
+    }
+
+    for (auto& lane : _lanes) {
+        if (!lane.empty()) {
+            lane.pop_front();
+            _size--;
+            return;
+        }
+    }
+}
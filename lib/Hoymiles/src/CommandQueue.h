@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "commands/CommandAbstract.h"
+#include <array>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+// Command queue with one lane per CommandPriority. Commands are taken from
+// the highest priority lane first. A newly pushed command replaces an unsent
+// command of the same kind for the same inverter (see isReplaceableBy()).
+// The command returned by front() stays pinned until pop() is called, as it
+// is the one currently in flight.
+class CommandQueue {
+public:
+    CommandQueue() = default;
+    CommandQueue(const CommandQueue&) = delete;
+    CommandQueue& operator=(const CommandQueue&) = delete;
+
+    // Lock free, as it is polled from the radio loops all the time
+    unsigned long size() const;
+
+    void push(const std::shared_ptr<CommandAbstract>& cmd);
+
+    // Returns the command in flight, or nullptr if the queue is empty
+    std::shared_ptr<CommandAbstract> front();
+
+    void pop();
+
+private:
+    static constexpr uint8_t LANE_COUNT = static_cast<uint8_t>(CommandPriority::Housekeeping) + 1;
+
+    std::array<std::deque<std::shared_ptr<CommandAbstract>>, LANE_COUNT> _lanes;
+    std::shared_ptr<CommandAbstract> _current;
+    std::atomic<unsigned long> _size = { 0 };
+    mutable std::mutex _mutex;
+};
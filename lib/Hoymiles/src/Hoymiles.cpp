@@ -19,6 +19,7 @@
 #include "inverters/HM_2CH.h"
 #include "inverters/HM_4CH.h"
 #include <Arduino.h>
+#include <algorithm>
 
 HoymilesClass Hoymiles;
 
@@ -59,109 +60,159 @@ void HoymilesClass::loop()
         return;
     }
 
-    if (millis() - _lastPoll > (_pollInterval * 1000)) {
-        static uint8_t inverterPos = 0;
+    // Every radio gets its own scheduling decision, so NRF and CMT
+    // inverters are polled in parallel instead of taking turns.
+    pollRadio(_radioNrf.get());
+#ifdef USE_RADIO_CMT
+    pollRadio(_radioCmt.get());
+#endif
+
+    if (millis() - _lastHousekeeping < HOY_HOUSEKEEPING_INTERVAL) {
+        return;
+    }
+    _lastHousekeeping = millis();
+
+    // Perform housekeeping of all inverters on day change
+    const int8_t currentWeekDay = Utils::getWeekDay();
+    static int8_t lastWeekDay = -1;
+    if (lastWeekDay == -1) {
+        lastWeekDay = currentWeekDay;
+    } else {
+        if (currentWeekDay != lastWeekDay) {
 
-        std::shared_ptr<InverterAbstract> iv = getInverterByPos(inverterPos);
-        if ((iv == nullptr) || ((iv != nullptr) && (!iv->getRadio()->isInitialized()))) {
-            if (++inverterPos >= getNumInverters()) {
-                inverterPos = 0;
+            for (auto& inv : _inverters) {
+                inv->performDailyTask();
             }
+
+            lastWeekDay = currentWeekDay;
         }
+    }
+}
 
-// FIXME : add polling and commands
-        if (iv != nullptr
-            && iv->getRadio()->isInitialized()
-            && iv->getRadio()->isQueueEmpty())
-        {
-            if (iv->getZeroValuesIfUnreachable() && !iv->isReachable()) {
-                if (iv->Statistics()->areAllFieldsZero() == false) {
-                    _messageOutput->println("Set runtime data to zero");
-                    iv->Statistics()->zeroRuntimeData();
-                }
-            }
+uint32_t HoymilesClass::getPollIntervalMillis(const InverterAbstract& iv) const
+{
+    const uint32_t interval = _pollInterval * 1000;
+    if (iv.getPollPriority()) {
+        return interval / HOY_PRIORITY_POLL_DIVIDER;
+    }
+    return interval;
+}
 
-            if ( (iv->getEnablePolling() || iv->getEnableCommands()) && iv->isConnected() ) {
-                iv->Statistics()->flagFieldsNotZero();
-                _messageOutput->print("Fetch inverter: ");
-                _messageOutput->println(iv->serial(), HEX);
-
-                if (!iv->isReachable()) {
-                    iv->sendChangeChannelRequest();
-                }
-
-                iv->sendStatsRequest();
-
-                // Fetch event log
-                const bool force = iv->EventLog()->getLastAlarmRequestSuccess() == CMD_NOK;
-                iv->sendAlarmLogRequest(force);
-
-                // Fetch limit
-                if (((millis() - iv->SystemConfigPara()->getLastUpdateRequest() > HOY_SYSTEM_CONFIG_PARA_POLL_INTERVAL)
-                        && (millis() - iv->SystemConfigPara()->getLastUpdateCommand() > HOY_SYSTEM_CONFIG_PARA_POLL_MIN_DURATION))) {
-                    _messageOutput->println("Request SystemConfigPara");
-                    iv->sendSystemConfigParaRequest();
-                }
-
-                // Set limit if required
-                if (iv->SystemConfigPara()->getLastLimitCommandSuccess() == CMD_NOK) {
-                    _messageOutput->println("Resend ActivePowerControl");
-                    iv->resendActivePowerControlRequest();
-                }
-
-                // Set power status if required
-                if (iv->PowerCommand()->getLastPowerCommandSuccess() == CMD_NOK) {
-                    _messageOutput->println("Resend PowerCommand");
-                    iv->resendPowerControlRequest();
-                }
-
-                // Fetch dev info (but first fetch stats)
-                if (iv->Statistics()->getLastUpdate() > 0) {
-                    const bool invalidDevInfo = !iv->DevInfo()->containsValidData()
-                        && iv->DevInfo()->getLastUpdateAll() > 0
-                        && iv->DevInfo()->getLastUpdateSimple() > 0;
-
-                    if (invalidDevInfo) {
-                        _messageOutput->println("DevInfo: No Valid Data");
-                    }
-
-                    if ((iv->DevInfo()->getLastUpdateAll() == 0)
-                        || (iv->DevInfo()->getLastUpdateSimple() == 0)
-                        || invalidDevInfo) {
-                        _messageOutput->println("Request device info");
-                        iv->sendDevInfoRequest();
-                    }
-                }
-
-                // Fetch grid profile
-                if (iv->Statistics()->getLastUpdate() > 0 && (iv->GridProfile()->getLastUpdate() == 0 || !iv->GridProfile()->containsValidData())) {
-                    iv->sendGridOnProFileParaRequest();
-                }
-
-                _lastPoll = millis();
-            }
+std::shared_ptr<InverterAbstract> HoymilesClass::getNextInverterToPoll(const HoymilesRadio* radio)
+{
+    const uint32_t now = millis();
+    std::shared_ptr<InverterAbstract> next = nullptr;
+    uint32_t nextOverdue = 0;
+    uint32_t nextInterval = 1;
+
+    for (auto& iv : _inverters) {
+        if (iv->getRadio() != radio) {
+            continue;
+        }
 
-            if (++inverterPos >= getNumInverters()) {
-                inverterPos = 0;
-            }
+        const uint32_t elapsed = now - iv->getLastPoll();
+        const uint32_t interval = getPollIntervalMillis(*iv);
+        if (elapsed <= interval && iv->getLastPoll() != 0) {
+            continue;
+        }
+        const uint32_t overdue = elapsed - interval;
+
+        // The inverter which is furthest past its own interval wins
+        // (overdue / interval). Priority inverters get there faster due to
+        // their shorter interval, but an inverter waiting long enough
+        // always overtakes them, so no inverter starves.
+        if (next == nullptr
+            || static_cast<uint64_t>(overdue) * nextInterval > static_cast<uint64_t>(nextOverdue) * interval) {
+            next = iv;
+            nextOverdue = overdue;
+            nextInterval = std::max<uint32_t>(interval, 1);
         }
+    }
 
-        // Perform housekeeping of all inverters on day change
-        const int8_t currentWeekDay = Utils::getWeekDay();
-        static int8_t lastWeekDay = -1;
-        if (lastWeekDay == -1) {
-            lastWeekDay = currentWeekDay;
-        } else {
-            if (currentWeekDay != lastWeekDay) {
+    return next;
+}
 
-                for (auto& inv : _inverters) {
-                    inv->performDailyTask();
-                }
+void HoymilesClass::pollRadio(HoymilesRadio* radio)
+{
+    if (radio == nullptr || !radio->isInitialized() || !radio->isQueueEmpty()) {
+        return;
+    }
 
-                lastWeekDay = currentWeekDay;
-            }
+    std::shared_ptr<InverterAbstract> iv = getNextInverterToPoll(radio);
+    if (iv == nullptr) {
+        return;
+    }
+
+    // Also set for inverters which are currently not polled, so that they
+    // do not block the remaining inverters of this radio.
+    iv->setLastPoll(millis());
+
+    if (iv->getZeroValuesIfUnreachable() && !iv->isReachable()) {
+        if (iv->Statistics()->areAllFieldsZero() == false) {
+            _messageOutput->println("Set runtime data to zero");
+            iv->Statistics()->zeroRuntimeData();
+            iv->notifyStatisticsUpdate();
         }
     }
+
+    if (!(iv->getEnablePolling() || iv->getEnableCommands()) || !iv->isConnected()) {
+        return;
+    }
+
+    iv->Statistics()->flagFieldsNotZero();
+    _messageOutput->print("Fetch inverter: ");
+    _messageOutput->println(iv->serial(), HEX);
+
+    if (!iv->isReachable()) {
+        iv->sendChangeChannelRequest();
+    }
+
+    iv->sendStatsRequest();
+
+    // Fetch event log if the inverter reports new events
+    iv->sendAlarmLogRequest();
+
+    // Fetch limit
+    if (((millis() - iv->SystemConfigPara()->getLastUpdateRequest() > HOY_SYSTEM_CONFIG_PARA_POLL_INTERVAL)
+            && (millis() - iv->SystemConfigPara()->getLastUpdateCommand() > HOY_SYSTEM_CONFIG_PARA_POLL_MIN_DURATION))) {
+        _messageOutput->println("Request SystemConfigPara");
+        iv->sendSystemConfigParaRequest();
+    }
+
+    // Set limit if required
+    if (iv->SystemConfigPara()->getLastLimitCommandSuccess() == CMD_NOK) {
+        _messageOutput->println("Resend ActivePowerControl");
+        iv->resendActivePowerControlRequest();
+    }
+
+    // Set power status if required
+    if (iv->PowerCommand()->getLastPowerCommandSuccess() == CMD_NOK) {
+        _messageOutput->println("Resend PowerCommand");
+        iv->resendPowerControlRequest();
+    }
+
+    // Fetch dev info (but first fetch stats)
+    if (iv->Statistics()->getLastUpdate() > 0) {
+        const bool invalidDevInfo = !iv->DevInfo()->containsValidData()
+            && iv->DevInfo()->getLastUpdateAll() > 0
+            && iv->DevInfo()->getLastUpdateSimple() > 0;
+
+        if (invalidDevInfo) {
+            _messageOutput->println("DevInfo: No Valid Data");
+        }
+
+        if ((iv->DevInfo()->getLastUpdateAll() == 0)
+            || (iv->DevInfo()->getLastUpdateSimple() == 0)
+            || invalidDevInfo) {
+            _messageOutput->println("Request device info");
+            iv->sendDevInfoRequest();
+        }
+    }
+
+    // Fetch grid profile
+    if (iv->Statistics()->getLastUpdate() > 0 && (iv->GridProfile()->getLastUpdate() == 0 || !iv->GridProfile()->containsValidData())) {
+        iv->sendGridOnProFileParaRequest();
+    }
 }
 
 std::shared_ptr<InverterAbstract> HoymilesClass::addInverter(const char* name, const uint64_t serial)
@@ -250,13 +301,30 @@ void HoymilesClass::removeInverterBySerial(const uint64_t serial)
 {
     for (uint8_t i = 0; i < _inverters.size(); i++) {
         if (_inverters[i]->serial() == serial) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            _inverters.erase(_inverters.begin() + i);
+            std::shared_ptr<InverterAbstract> inv = _inverters[i];
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _inverters.erase(_inverters.begin() + i);
+            }
+            // Subscribers have to drop their data of the removed inverter
+            notifyStatisticsUpdate(*inv);
             return;
         }
     }
 }
 
+void HoymilesClass::subscribeStatisticsUpdate(StatisticsUpdateCallback callback)
+{
+    _statisticsUpdateCallbacks.push_back(std::move(callback));
+}
+
+void HoymilesClass::notifyStatisticsUpdate(InverterAbstract& inv)
+{
+    for (auto& callback : _statisticsUpdateCallbacks) {
+        callback(inv);
+    }
+}
+
 size_t HoymilesClass::getNumInverters() const
 {
     return _inverters.size();
@@ -9,11 +9,14 @@
 #include "types.h"
 #include <Print.h>
 #include <SPI.h>
+#include <functional>
 #include <memory>
 #include <vector>
 
 #define HOY_SYSTEM_CONFIG_PARA_POLL_INTERVAL (2 * 60 * 1000) // 2 minutes
 #define HOY_SYSTEM_CONFIG_PARA_POLL_MIN_DURATION (4 * 60 * 1000) // at least 4 minutes between sending limit command and read request. Otherwise eventlog entry
+#define HOY_PRIORITY_POLL_DIVIDER 2 // inverters with poll priority are polled this many times more often
+#define HOY_HOUSEKEEPING_INTERVAL 1000 // check for day change every second
 
 class HoymilesClass {
 public:
@@ -37,6 +40,12 @@ public:
     void removeInverterBySerial(const uint64_t serial);
     size_t getNumInverters() const;
 
+    // Callbacks are executed in the context of the task which changed the
+    // statistics, also for an inverter which was just removed
+    using StatisticsUpdateCallback = std::function<void(InverterAbstract& inv)>;
+    void subscribeStatisticsUpdate(StatisticsUpdateCallback callback);
+    void notifyStatisticsUpdate(InverterAbstract& inv);
+
     HoymilesRadio_NRF* getRadioNrf();
 #ifdef USE_RADIO_CMT
     HoymilesRadio_CMT* getRadioCmt();
@@ -50,6 +59,10 @@ public:
     bool isAllRadioIdle() const;
 
 private:
+    uint32_t getPollIntervalMillis(const InverterAbstract& iv) const;
+    std::shared_ptr<InverterAbstract> getNextInverterToPoll(const HoymilesRadio* radio);
+    void pollRadio(HoymilesRadio* radio);
+
     std::vector<std::shared_ptr<InverterAbstract>> _inverters;
     std::unique_ptr<HoymilesRadio_NRF> _radioNrf;
 #ifdef USE_RADIO_CMT
@@ -58,9 +71,11 @@ private:
 
     std::mutex _mutex;
 
+    std::vector<StatisticsUpdateCallback> _statisticsUpdateCallbacks;
+
     uint32_t _pollInterval = 0;
     bool _verboseLogging = false;
-    uint32_t _lastPoll = 0;
+    uint32_t _lastHousekeeping = 0;
 
     Print* _messageOutput = &Serial;
 };
@@ -1,9 +1,9 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 
+#include "CommandQueue.h"
 #include "commands/CommandAbstract.h"
 #include "types.h"
-#include <ThreadSafeQueue.h>
 #include "TimeoutHelper.h"
 #include <memory>
 
@@ -38,7 +38,7 @@ protected:
     void handleReceivedPackage();
 
     serial_u _dtuSerial;
-    ThreadSafeQueue<std::shared_ptr<CommandAbstract>> _commandQueue;
+    CommandQueue _commandQueue;
     bool _isInitialized = false;
     bool _busyFlag = false;
 
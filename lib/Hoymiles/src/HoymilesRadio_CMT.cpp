@@ -131,7 +131,7 @@ void HoymilesRadio_CMT::loop()
     if (_packetReceived) {
         Hoymiles.getVerboseMessageOutput()->println("Interrupt received");
         while (_radio->available()) {
-            if (!(_rxBuffer.size() > FRAGMENT_BUFFER_SIZE)) {
+            if (!_rxBuffer.full()) {
                 fragment_t f;
                 memset(f.fragment, 0xcc, MAX_RF_PAYLOAD_SIZE);
                 f.len = _radio->getDynamicPayloadSize();
@@ -155,8 +155,8 @@ void HoymilesRadio_CMT::loop()
 
     } else {
         // Perform package parsing only if no packages are received
-        if (!_rxBuffer.empty()) {
-            fragment_t f = _rxBuffer.back();
+        fragment_t f;
+        if (_rxBuffer.try_pop(f)) {
             if (checkFragmentCrc(f)) {
 
                 const serial_u dtuId = convertSerialToRadioId(_dtuSerial);
@@ -182,9 +182,6 @@ void HoymilesRadio_CMT::loop()
             } else {
                 Hoymiles.getMessageOutput()->println("Frame kaputt"); // ;-)
             }
-
-            // Remove paket from buffer even it was corrupted
-            _rxBuffer.pop();
         }
     }
 
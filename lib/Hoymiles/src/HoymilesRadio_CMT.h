@@ -6,8 +6,8 @@
 #include "types.h"
 #include <Arduino.h>
 #include <cmt2300wrapper.h>
+#include <SpscRingBuffer.h>
 #include <memory>
-#include <queue>
 #include <vector>
 
 // number of fragments hold in buffer
@@ -84,7 +84,7 @@ private:
     bool _gpio2_configured = false;
     bool _gpio3_configured = false;
 
-    std::queue<fragment_t> _rxBuffer;
+    SpscRingBuffer<fragment_t, FRAGMENT_BUFFER_SIZE> _rxBuffer;
     TimeoutHelper _txTimeout;
 
     uint32_t _inverterTargetFrequency = HOYMILES_CMT_WORK_FREQ;
@@ -4,9 +4,9 @@
 #include "HoymilesRadio.h"
 #include "commands/CommandAbstract.h"
 #include <RF24.h>
+#include <SpscRingBuffer.h>
 #include <memory>
 #include <nRF24L01.h>
-#include <queue>
 
 // number of fragments hold in buffer
 #define FRAGMENT_BUFFER_SIZE 30
@@ -43,5 +43,5 @@ private:
 
     volatile bool _packetReceived = false;
 
-    std::queue<fragment_t> _rxBuffer;
+    SpscRingBuffer<fragment_t, FRAGMENT_BUFFER_SIZE> _rxBuffer;
 };
@@ -36,6 +36,11 @@ String ChannelChangeCommand::getCommandName() const
     return "ChannelChangeCommand";
 }
 
+CommandPriority ChannelChangeCommand::getPriority() const
+{
+    return CommandPriority::Realtime;
+}
+
 void ChannelChangeCommand::setChannel(const uint8_t channel)
 {
     _payload[12] = channel;
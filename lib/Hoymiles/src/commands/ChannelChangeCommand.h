@@ -9,6 +9,7 @@ public:
     explicit ChannelChangeCommand(InverterAbstract* inv, const uint64_t router_address = 0, const uint8_t channel = 0);
 
     virtual String getCommandName() const;
+    virtual CommandPriority getPriority() const;
 
     void setChannel(const uint8_t channel);
     uint8_t getChannel() const;
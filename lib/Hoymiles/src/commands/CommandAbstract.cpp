@@ -85,6 +85,17 @@ uint64_t CommandAbstract::getRouterAddress() const
     return _routerAddress;
 }
 
+CommandPriority CommandAbstract::getPriority() const
+{
+    return CommandPriority::Housekeeping;
+}
+
+bool CommandAbstract::isReplaceableBy(const CommandAbstract& cmd) const
+{
+    return getTargetAddress() == cmd.getTargetAddress()
+        && getCommandName() == cmd.getCommandName();
+}
+
 void CommandAbstract::setTimeout(const uint32_t timeout)
 {
     _timeout = timeout;
@@ -11,6 +11,13 @@
 
 class InverterAbstract;
 
+// Lanes of the radio command queue, highest priority first
+enum class CommandPriority : uint8_t {
+    Control = 0,
+    Realtime,
+    Housekeeping
+};
+
 class CommandAbstract {
 public:
     explicit CommandAbstract(InverterAbstract* inv, const uint64_t router_address = 0);
@@ -31,6 +38,11 @@ public:
 
     virtual String getCommandName() const = 0;
 
+    virtual CommandPriority getPriority() const;
+
+    // Returns true if this (not yet sent) command is superseded by cmd
+    virtual bool isReplaceableBy(const CommandAbstract& cmd) const;
+
     void setSendCount(const uint8_t count);
     uint8_t getSendCount() const;
     uint8_t incrementSendCount();
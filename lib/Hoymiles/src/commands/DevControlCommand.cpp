@@ -32,6 +32,11 @@ DevControlCommand::DevControlCommand(InverterAbstract* inv, const uint64_t route
     setTimeout(1000);
 }
 
+CommandPriority DevControlCommand::getPriority() const
+{
+    return CommandPriority::Control;
+}
+
 void DevControlCommand::udpateCRC(const uint8_t len)
 {
     const uint16_t crc = crc16(&_payload[10], len);
@@ -7,6 +7,8 @@ class DevControlCommand : public CommandAbstract {
 public:
     explicit DevControlCommand(InverterAbstract* inv, const uint64_t router_address = 0);
 
+    virtual CommandPriority getPriority() const;
+
     virtual bool handleResponse(const fragment_t fragment[], const uint8_t max_fragment_id);
 
 protected:
@@ -44,6 +44,17 @@ String PowerControlCommand::getCommandName() const
     return "PowerControl";
 }
 
+bool PowerControlCommand::isReplaceableBy(const CommandAbstract& cmd) const
+{
+    if (!DevControlCommand::isReplaceableBy(cmd)) {
+        return false;
+    }
+
+    // A restart must neither be dropped nor replace a pending on/off
+    // command. Only the latest on/off state is relevant.
+    return !isRestart() && !static_cast<const PowerControlCommand&>(cmd).isRestart();
+}
+
 bool PowerControlCommand::handleResponse(const fragment_t fragment[], const uint8_t max_fragment_id)
 {
      if (!DevControlCommand::handleResponse(fragment, max_fragment_id)) {
@@ -77,3 +88,8 @@ void PowerControlCommand::setRestart()
 
     udpateCRC(CRC_SIZE); // 2 byte crc
 }
+
+bool PowerControlCommand::isRestart() const
+{
+    return _payload[10] == 0x02;
+}
@@ -9,9 +9,12 @@ public:
 
     virtual String getCommandName() const;
 
+    virtual bool isReplaceableBy(const CommandAbstract& cmd) const;
+
     virtual bool handleResponse(const fragment_t fragment[], const uint8_t max_fragment_id);
     virtual void gotTimeout();
 
     void setPowerOn(const bool state);
     void setRestart();
+    bool isRestart() const;
 };
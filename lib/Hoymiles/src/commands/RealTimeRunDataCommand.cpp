@@ -35,6 +35,11 @@ String RealTimeRunDataCommand::getCommandName() const
     return "RealTimeRunData";
 }
 
+CommandPriority RealTimeRunDataCommand::getPriority() const
+{
+    return CommandPriority::Realtime;
+}
+
 bool RealTimeRunDataCommand::handleResponse(const fragment_t fragment[], const uint8_t max_fragment_id)
 {
     // Check CRC of whole payload
@@ -65,10 +70,12 @@ bool RealTimeRunDataCommand::handleResponse(const fragment_t fragment[], const u
     _inv->Statistics()->endAppendFragment();
     _inv->Statistics()->resetRxFailureCount();
     _inv->Statistics()->setLastUpdate(millis());
+    _inv->notifyStatisticsUpdate();
     return true;
 }
 
 void RealTimeRunDataCommand::gotTimeout()
 {
     _inv->Statistics()->incrementRxFailureCount();
+    _inv->notifyStatisticsUpdate();
 }
@@ -35,6 +35,11 @@ String SystemConfigParaCommand::getCommandName() const
     return "SystemConfigPara";
 }
 
+CommandPriority SystemConfigParaCommand::getPriority() const
+{
+    return CommandPriority::Realtime;
+}
+
 bool SystemConfigParaCommand::handleResponse(const fragment_t fragment[], const uint8_t max_fragment_id)
 {
     // Check CRC of whole payload
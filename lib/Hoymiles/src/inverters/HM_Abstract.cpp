@@ -37,7 +37,7 @@ bool HM_Abstract::sendStatsRequest()
     return true;
 }
 
-bool HM_Abstract::sendAlarmLogRequest(const bool force)
+bool HM_Abstract::sendAlarmLogRequest()
 {
     if (!getEnablePolling()) {
         return false;
@@ -48,15 +48,27 @@ bool HM_Abstract::sendAlarmLogRequest(const bool force)
         return false;
     }
 
-    if (!force) {
-        if (Statistics()->hasChannelFieldValue(TYPE_INV, CH0, FLD_EVT_LOG)) {
-            if ((uint8_t)Statistics()->getChannelFieldValue(TYPE_INV, CH0, FLD_EVT_LOG) == _lastAlarmLogCnt) {
-                return false;
-            }
-        }
+    // the event count is only taken over once the log was received, so a
+    // failed request is repeated as long as the inverter has new events.
+    // the events already received are kept by the application.
+    const LastCommandSuccess status = EventLog()->getLastAlarmRequestSuccess();
+    if (status == CMD_OK) {
+        _lastAlarmLogCnt = _requestedAlarmLogCnt;
     }
 
-    _lastAlarmLogCnt = (uint8_t)Statistics()->getChannelFieldValue(TYPE_INV, CH0, FLD_EVT_LOG);
+    const uint8_t eventCount = (uint8_t)Statistics()->getChannelFieldValue(TYPE_INV, CH0, FLD_EVT_LOG);
+
+    // wait for the statistics
+    if (Statistics()->getLastUpdate() == 0) {
+        return false;
+    }
+
+    const uint8_t knownCount = (status == CMD_PENDING) ? _requestedAlarmLogCnt : _lastAlarmLogCnt;
+    if (Statistics()->hasChannelFieldValue(TYPE_INV, CH0, FLD_EVT_LOG) && eventCount == knownCount) {
+        return false;
+    }
+
+    _requestedAlarmLogCnt = eventCount;
 
     time_t now;
     time(&now);
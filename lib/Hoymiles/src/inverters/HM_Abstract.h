@@ -7,7 +7,7 @@ class HM_Abstract : public InverterAbstract {
 public:
     explicit HM_Abstract(HoymilesRadio* radio, const uint64_t serial);
     bool sendStatsRequest();
-    bool sendAlarmLogRequest(const bool force = false);
+    bool sendAlarmLogRequest();
     bool sendDevInfoRequest();
     bool sendSystemConfigParaRequest();
     bool sendActivePowerControlRequest(float limit, const PowerLimitControlType type);
@@ -18,7 +18,8 @@ public:
     bool sendGridOnProFileParaRequest();
 
 private:
-    uint8_t _lastAlarmLogCnt = 0;
+    uint8_t _lastAlarmLogCnt = 0; // event count of the last log received
+    uint8_t _requestedAlarmLogCnt = 0;
     float _activePowerControlLimit = 0;
     PowerLimitControlType _activePowerControlType = PowerLimitControlType::AbsolutNonPersistent;
 
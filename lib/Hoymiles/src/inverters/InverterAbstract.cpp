@@ -77,9 +77,22 @@ bool InverterAbstract::isReachable()
     return _enablePolling && Statistics()->getRxFailureCount() <= _reachableThreshold && isConnected();
 }
 
+void InverterAbstract::setConnected(bool value)
+{
+    if (_connected == value) {
+        return;
+    }
+    _connected = value;
+    notifyStatisticsUpdate();
+}
+
 void InverterAbstract::setEnablePolling(const bool enabled)
 {
+    if (_enablePolling == enabled) {
+        return;
+    }
     _enablePolling = enabled;
+    notifyStatisticsUpdate();
 }
 
 bool InverterAbstract::getEnablePolling() const
@@ -137,6 +150,26 @@ bool InverterAbstract::getClearEventlogOnMidnight() const
     return _clearEventlogOnMidnight;
 }
 
+void InverterAbstract::setPollPriority(const bool enabled)
+{
+    _pollPriority = enabled;
+}
+
+bool InverterAbstract::getPollPriority() const
+{
+    return _pollPriority;
+}
+
+void InverterAbstract::setLastPoll(const uint32_t lastPoll)
+{
+    _lastPoll = lastPoll;
+}
+
+uint32_t InverterAbstract::getLastPoll() const
+{
+    return _lastPoll;
+}
+
 int8_t InverterAbstract::getLastRssi() const
 {
     return _lastRssi;
@@ -292,6 +325,12 @@ void InverterAbstract::performDailyTask()
         EventLog()->clearBuffer();
     }
     resetRadioStats();
+    notifyStatisticsUpdate();
+}
+
+void InverterAbstract::notifyStatisticsUpdate()
+{
+    Hoymiles.notifyStatisticsUpdate(*this);
 }
 
 void InverterAbstract::resetRadioStats()
@@ -40,7 +40,7 @@ public:
     virtual const byteAssign_t* getByteAssignment() const = 0;
     virtual uint8_t getByteAssignmentSize() const = 0;
 
-    void setConnected(bool value) { _connected = value; };
+    void setConnected(bool value);
     bool isConnected() { return _connected; };
 
     bool isProducing();
@@ -64,6 +64,14 @@ public:
     void setClearEventlogOnMidnight(const bool enabled);
     bool getClearEventlogOnMidnight() const;
 
+    // Inverters with poll priority (e.g. the one driven by the power limiter)
+    // are polled more often than the others
+    void setPollPriority(const bool enabled);
+    bool getPollPriority() const;
+
+    void setLastPoll(const uint32_t lastPoll);
+    uint32_t getLastPoll() const;
+
     int8_t getLastRssi() const;
 
     void clearRxFragmentBuffer();
@@ -72,6 +80,10 @@ public:
 
     void performDailyTask();
 
+    // Informs all subscribers of HoymilesClass that the statistics or
+    // the reachable/producing state of this inverter changed
+    void notifyStatisticsUpdate();
+
     void resetRadioStats();
     struct {
         // TX Request Data
@@ -89,7 +101,7 @@ public:
     } RadioStats = {};
 
     virtual bool sendStatsRequest() = 0;
-    virtual bool sendAlarmLogRequest(const bool force = false) = 0;
+    virtual bool sendAlarmLogRequest() = 0;
     virtual bool sendDevInfoRequest() = 0;
     virtual bool sendSystemConfigParaRequest() = 0;
     virtual bool sendActivePowerControlRequest(float limit, const PowerLimitControlType type) = 0;
@@ -130,6 +142,9 @@ private:
     bool _zeroYieldDayOnMidnight = false;
     bool _clearEventlogOnMidnight = false;
 
+    bool _pollPriority = false;
+    uint32_t _lastPoll = 0;
+
     int8_t _lastRssi = -127;
 
     std::unique_ptr<AlarmLogParser> _alarmLogParser;
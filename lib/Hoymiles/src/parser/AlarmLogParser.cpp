@@ -233,7 +233,18 @@ void AlarmLogParser::setMessageType(const AlarmMessageType_t type)
     _messageType = type;
 }
 
+AlarmMessageType_t AlarmLogParser::getMessageType() const
+{
+    return _messageType;
+}
+
 void AlarmLogParser::getLogEntry(const uint8_t entryId, AlarmLogEntry_t& entry, const AlarmMessageLocale_t locale)
+{
+    getRawLogEntry(entryId, entry.MessageId, entry.StartTime, entry.EndTime);
+    entry.Message = getMessage(entry.MessageId, _messageType, locale);
+}
+
+void AlarmLogParser::getRawLogEntry(const uint8_t entryId, uint16_t& messageId, time_t& startTime, time_t& endTime)
 {
     const uint8_t entryStartOffset = 2 + entryId * ALARM_LOG_ENTRY_SIZE;
 
@@ -252,40 +263,45 @@ void AlarmLogParser::getLogEntry(const uint8_t entryId, AlarmLogEntry_t& entry,
         endTimeOffset = 12 * 60 * 60;
     }
 
-    entry.MessageId = _payloadAlarmLog[entryStartOffset + 1];
-    entry.StartTime = ((static_cast<uint16_t>(_payloadAlarmLog[entryStartOffset + 4]) << 8) | static_cast<uint16_t>(_payloadAlarmLog[entryStartOffset + 5])) + startTimeOffset + timezoneOffset;
-    entry.EndTime = (static_cast<uint16_t>(_payloadAlarmLog[entryStartOffset + 6]) << 8) | static_cast<uint16_t>(_payloadAlarmLog[entryStartOffset + 7]);
+    messageId = _payloadAlarmLog[entryStartOffset + 1];
+    startTime = ((static_cast<uint16_t>(_payloadAlarmLog[entryStartOffset + 4]) << 8) | static_cast<uint16_t>(_payloadAlarmLog[entryStartOffset + 5])) + startTimeOffset + timezoneOffset;
+    endTime = (static_cast<uint16_t>(_payloadAlarmLog[entryStartOffset + 6]) << 8) | static_cast<uint16_t>(_payloadAlarmLog[entryStartOffset + 7]);
 
     HOY_SEMAPHORE_GIVE();
 
-    if (entry.EndTime > 0) {
-        entry.EndTime += (endTimeOffset + timezoneOffset);
+    if (endTime > 0) {
+        endTime += (endTimeOffset + timezoneOffset);
     }
+}
 
+const char* AlarmLogParser::getMessage(const uint16_t messageId, const AlarmMessageType_t type, const AlarmMessageLocale_t locale)
+{
+    const char* message;
     switch (locale) {
     case AlarmMessageLocale_t::DE:
-        entry.Message = "Unbekannt";
+        message = "Unbekannt";
         break;
     case AlarmMessageLocale_t::FR:
-        entry.Message = "Inconnu";
+        message = "Inconnu";
         break;
     default:
-        entry.Message = "Unknown";
+        message = "Unknown";
     }
 
     for (auto& msg : _alarmMessages) {
-        if (msg.MessageId == entry.MessageId) {
-            if (msg.InverterType == _messageType) {
-                entry.Message = getLocaleMessage(&msg, locale);
-                break;
+        if (msg.MessageId == messageId) {
+            if (msg.InverterType == type) {
+                return getLocaleMessage(&msg, locale);
             } else if (msg.InverterType == AlarmMessageType_t::ALL) {
-                entry.Message = getLocaleMessage(&msg, locale);
+                message = getLocaleMessage(&msg, locale);
             }
         }
     }
+
+    return message;
 }
 
-String AlarmLogParser::getLocaleMessage(const AlarmMessage_t* msg, const AlarmMessageLocale_t locale) const
+const char* AlarmLogParser::getLocaleMessage(const AlarmMessage_t* msg, const AlarmMessageLocale_t locale)
 {
     if (locale == AlarmMessageLocale_t::DE) {
         return msg->Message_de[0] != '\0' ? msg->Message_de : msg->Message_en;
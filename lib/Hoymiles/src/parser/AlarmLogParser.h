@@ -45,14 +45,20 @@ public:
     uint8_t getEntryCount() const;
     void getLogEntry(const uint8_t entryId, AlarmLogEntry_t& entry, const AlarmMessageLocale_t locale = AlarmMessageLocale_t::EN);
 
+    // same as getLogEntry() but without looking up the message text
+    void getRawLogEntry(const uint8_t entryId, uint16_t& messageId, time_t& startTime, time_t& endTime);
+
+    static const char* getMessage(const uint16_t messageId, const AlarmMessageType_t type, const AlarmMessageLocale_t locale);
+
     void setLastAlarmRequestSuccess(const LastCommandSuccess status);
     LastCommandSuccess getLastAlarmRequestSuccess() const;
 
     void setMessageType(const AlarmMessageType_t type);
+    AlarmMessageType_t getMessageType() const;
 
 private:
     static int getTimezoneOffset();
-    String getLocaleMessage(const AlarmMessage_t* msg, const AlarmMessageLocale_t locale) const;
+    static const char* getLocaleMessage(const AlarmMessage_t* msg, const AlarmMessageLocale_t locale);
 
     uint8_t _payloadAlarmLog[ALARM_LOG_PAYLOAD_SIZE];
     uint8_t _alarmLogLength = 0;
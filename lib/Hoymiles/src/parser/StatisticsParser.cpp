@@ -59,6 +59,7 @@ const FieldId_t dailyProductionFields[] = {
 StatisticsParser::StatisticsParser()
     : Parser()
 {
+    memset(_assignmentIndex, ASSIGNMENT_NONE, sizeof(_assignmentIndex));
     clearBuffer();
 }
 
@@ -67,12 +68,23 @@ void StatisticsParser::setByteAssignment(const byteAssign_t* byteAssignment, con
     _byteAssignment = byteAssignment;
     _byteAssignmentSize = size;
 
+    memset(_assignmentIndex, ASSIGNMENT_NONE, sizeof(_assignmentIndex));
+
     for (uint8_t i = 0; i < _byteAssignmentSize; i++) {
-        if (_byteAssignment[i].div == CMD_CALC) {
+        const byteAssign_t& pos = _byteAssignment[i];
+        uint8_t& index = _assignmentIndex[pos.type][pos.ch][pos.fieldId];
+        if (index == ASSIGNMENT_NONE) { // first assignment wins, as in a linear search
+            index = i;
+        }
+
+        if (pos.div == CMD_CALC) {
             continue;
         }
-        _expectedByteCount = max<uint8_t>(_expectedByteCount, _byteAssignment[i].start + _byteAssignment[i].num);
+        _expectedByteCount = max<uint8_t>(_expectedByteCount, pos.start + pos.num);
     }
+
+    _fieldValues.assign(_byteAssignmentSize, 0);
+    decodeFieldValues();
 }
 
 uint8_t StatisticsParser::getExpectedByteCount()
@@ -99,6 +111,7 @@ void StatisticsParser::appendFragment(const uint8_t offset, const uint8_t* paylo
 void StatisticsParser::endAppendFragment()
 {
     Parser::endAppendFragment();
+    decodeFieldValues();
 
     if (!_enableYieldDayCorrection) {
         resetYieldDayCorrection();
@@ -120,14 +133,21 @@ void StatisticsParser::endAppendFragment()
     }
 }
 
+uint8_t StatisticsParser::getAssignmentIndex(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const
+{
+    if (type >= TYPE_COUNT || channel >= CH_CNT || fieldId >= FIELD_COUNT) {
+        return ASSIGNMENT_NONE;
+    }
+    return _assignmentIndex[type][channel][fieldId];
+}
+
 const byteAssign_t* StatisticsParser::getAssignmentByChannelField(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const
 {
-    for (uint8_t i = 0; i < _byteAssignmentSize; i++) {
-        if (_byteAssignment[i].type == type && _byteAssignment[i].ch == channel && _byteAssignment[i].fieldId == fieldId) {
-            return &_byteAssignment[i];
-        }
+    const uint8_t index = getAssignmentIndex(type, channel, fieldId);
+    if (index == ASSIGNMENT_NONE) {
+        return nullptr;
     }
-    return nullptr;
+    return &_byteAssignment[index];
 }
 
 fieldSettings_t* StatisticsParser::getSettingByChannelField(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
@@ -142,47 +162,59 @@ fieldSettings_t* StatisticsParser::getSettingByChannelField(const ChannelType_t
 
 float StatisticsParser::getChannelFieldValue(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
 {
-    const byteAssign_t* pos = getAssignmentByChannelField(type, channel, fieldId);
-    if (pos == nullptr) {
+    const uint8_t index = getAssignmentIndex(type, channel, fieldId);
+    if (index == ASSIGNMENT_NONE) {
         return 0;
     }
+    return _fieldValues[index];
+}
 
-    uint8_t ptr = pos->start;
-    const uint8_t end = ptr + pos->num;
-    const uint16_t div = pos->div;
+float StatisticsParser::decodeFieldValue(const byteAssign_t& pos)
+{
+    uint8_t ptr = pos.start;
+    const uint8_t end = ptr + pos.num;
 
-    if (CMD_CALC != div) {
-        // Value is a static value
-        uint32_t val = 0;
-        HOY_SEMAPHORE_TAKE();
-        do {
-            val <<= 8;
-            val |= _payloadStatistic[ptr];
-        } while (++ptr != end);
-        HOY_SEMAPHORE_GIVE();
-
-        float result;
-        if (pos->isSigned && pos->num == 2) {
-            result = static_cast<float>(static_cast<int16_t>(val));
-        } else if (pos->isSigned && pos->num == 4) {
-            result = static_cast<float>(static_cast<int32_t>(val));
-        } else {
-            result = static_cast<float>(val);
-        }
+    // Value is a static value
+    uint32_t val = 0;
+    do {
+        val <<= 8;
+        val |= _payloadStatistic[ptr];
+    } while (++ptr != end);
+
+    float result;
+    if (pos.isSigned && pos.num == 2) {
+        result = static_cast<float>(static_cast<int16_t>(val));
+    } else if (pos.isSigned && pos.num == 4) {
+        result = static_cast<float>(static_cast<int32_t>(val));
+    } else {
+        result = static_cast<float>(val);
+    }
 
-        result /= static_cast<float>(div);
+    result /= static_cast<float>(pos.div);
 
-        const fieldSettings_t* setting = getSettingByChannelField(type, channel, fieldId);
-        if (setting != nullptr && _statisticLength > 0) {
-            result += setting->offset;
+    const fieldSettings_t* setting = getSettingByChannelField(pos.type, pos.ch, pos.fieldId);
+    if (setting != nullptr && _statisticLength > 0) {
+        result += setting->offset;
+    }
+    return result;
+}
+
+void StatisticsParser::decodeFieldValues()
+{
+    // Static values first, as the calculated values are based on them
+    HOY_SEMAPHORE_TAKE();
+    for (uint8_t i = 0; i < _byteAssignmentSize; i++) {
+        if (_byteAssignment[i].div != CMD_CALC) {
+            _fieldValues[i] = decodeFieldValue(_byteAssignment[i]);
         }
-        return result;
-    } else {
-        // Value has to be calculated
-        return calcFunctions[pos->start].func(this, pos->num);
     }
+    HOY_SEMAPHORE_GIVE();
 
-    return 0;
+    for (uint8_t i = 0; i < _byteAssignmentSize; i++) {
+        if (_byteAssignment[i].div == CMD_CALC) {
+            _fieldValues[i] = calcFunctions[_byteAssignment[i].start].func(this, _byteAssignment[i].num);
+        }
+    }
 }
 
 bool StatisticsParser::setChannelFieldValue(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, float value)
@@ -222,6 +254,8 @@ bool StatisticsParser::setChannelFieldValue(const ChannelType_t type, const Chan
     } while (--ptr >= end);
     HOY_SEMAPHORE_GIVE();
 
+    decodeFieldValues();
+
     return true;
 }
 
@@ -273,6 +307,8 @@ void StatisticsParser::setChannelFieldOffset(const ChannelType_t type, const Cha
     } else {
         _fieldSettings.push_back({ type, channel, fieldId, offset });
     }
+
+    decodeFieldValues();
 }
 
 std::list<ChannelType_t> StatisticsParser::getChannelTypes() const
@@ -301,6 +337,19 @@ std::list<ChannelNum_t> StatisticsParser::getChannelsByType(const ChannelType_t
     return l;
 }
 
+bool StatisticsParser::hasChannel(const ChannelType_t type, const ChannelNum_t channel) const
+{
+    if (type >= TYPE_COUNT || channel >= CH_CNT) {
+        return false;
+    }
+    for (uint8_t f = 0; f < FIELD_COUNT; f++) {
+        if (_assignmentIndex[type][channel][f] != ASSIGNMENT_NONE) {
+            return true;
+        }
+    }
+    return false;
+}
+
 uint16_t StatisticsParser::getStringMaxPower(const uint8_t channel) const
 {
     return _stringMaxPower[channel];
@@ -310,6 +359,7 @@ void StatisticsParser::setStringMaxPower(const uint8_t channel, const uint16_t p
 {
     if (channel < sizeof(_stringMaxPower) / sizeof(_stringMaxPower[0])) {
         _stringMaxPower[channel] = power;
+        decodeFieldValues(); // irradiation depends on it
     }
 }
 
@@ -3,6 +3,7 @@
 #include "Parser.h"
 #include <cstdint>
 #include <list>
+#include <vector>
 
 #define STATISTIC_PACKET_SIZE (7 * 16)
 
@@ -132,6 +133,7 @@ public:
     std::list<ChannelType_t> getChannelTypes() const;
     const char* getChannelTypeName(const ChannelType_t type) const;
     std::list<ChannelNum_t> getChannelsByType(const ChannelType_t type) const;
+    bool hasChannel(const ChannelType_t type, const ChannelNum_t channel) const;
 
     uint16_t getStringMaxPower(const uint8_t channel) const;
     void setStringMaxPower(const uint8_t channel, const uint16_t power);
@@ -156,14 +158,30 @@ public:
     bool getYieldDayCorrection() const;
     void setYieldDayCorrection(const bool enabled);
 private:
+    static constexpr uint8_t FIELD_COUNT = FLD_IAC_3 + 1;
+    static constexpr uint8_t TYPE_COUNT = TYPE_INV + 1;
+    static constexpr uint8_t ASSIGNMENT_NONE = 0xff;
+
+    uint8_t getAssignmentIndex(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const;
+
+    // Decodes all fields of the payload into _fieldValues
+    void decodeFieldValues();
+    float decodeFieldValue(const byteAssign_t& pos);
+
     void zeroFields(const FieldId_t* fields);
 
     uint8_t _payloadStatistic[STATISTIC_PACKET_SIZE] = {};
     uint8_t _statisticLength = 0;
     uint16_t _stringMaxPower[CH_CNT];
 
-    const byteAssign_t* _byteAssignment;
-    uint8_t _byteAssignmentSize;
+    const byteAssign_t* _byteAssignment = nullptr;
+    uint8_t _byteAssignmentSize = 0;
+
+    // Index into _byteAssignment and _fieldValues for every type, channel and field
+    uint8_t _assignmentIndex[TYPE_COUNT][CH_CNT][FIELD_COUNT];
+
+    // Decoded values (including offsets) in the order of _byteAssignment
+    std::vector<float> _fieldValues;
     uint8_t _expectedByteCount = 0;
     std::list<fieldSettings_t> _fieldSettings;
 
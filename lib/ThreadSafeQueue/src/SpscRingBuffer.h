@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+
+// Fixed capacity, allocation free and lock free ring buffer. It is only
+// safe to use with exactly one producer (push) and one consumer (front,
+// pop, try_pop) task. Provides the same API as ThreadSafeQueue.
+template <typename T, size_t Capacity>
+class SpscRingBuffer {
+public:
+    static_assert(Capacity > 0, "SpscRingBuffer capacity must not be zero");
+
+    SpscRingBuffer() = default;
+    SpscRingBuffer(const SpscRingBuffer<T, Capacity>&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer<T, Capacity>&) = delete;
+
+    unsigned long size() const
+    {
+        const size_t head = _head.load(std::memory_order_acquire);
+        const size_t tail = _tail.load(std::memory_order_acquire);
+        return (tail >= head) ? (tail - head) : (Slots - head + tail);
+    }
+
+    bool empty() const
+    {
+        return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+    }
+
+    bool full() const
+    {
+        return next(_tail.load(std::memory_order_acquire)) == _head.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t capacity()
+    {
+        return Capacity;
+    }
+
+    // Returns false if the buffer is full. The item is dropped in this case.
+    bool push(const T& item)
+    {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        const size_t nextTail = next(tail);
+        if (nextTail == _head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        _buffer[tail] = item;
+        _tail.store(nextTail, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T& item)
+    {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = _buffer[head];
+        _head.store(next(head), std::memory_order_release);
+        return true;
+    }
+
+    std::optional<T> pop()
+    {
+        T tmp;
+        if (!try_pop(tmp)) {
+            return {};
+        }
+        return tmp;
+    }
+
+    // Discards all items, must only be called by the consumer
+    void clear()
+    {
+        _head.store(_tail.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    // Must not be called on an empty buffer
+    T front() const
+    {
+        return _buffer[_head.load(std::memory_order_relaxed)];
+    }
+
+private:
+    // One slot is kept free to distinguish a full from an empty buffer
+    static constexpr size_t Slots = Capacity + 1;
+
+    static constexpr size_t next(const size_t pos)
+    {
+        return (pos + 1 == Slots) ? 0 : pos + 1;
+    }
+
+    std::array<T, Slots> _buffer = {};
+    std::atomic<size_t> _head = { 0 };
+    std::atomic<size_t> _tail = { 0 };
+};
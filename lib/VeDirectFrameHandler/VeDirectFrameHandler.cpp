@@ -58,8 +58,11 @@ VeDirectFrameHandler<T>::VeDirectFrameHandler() :
 	_hexSize(0),
 	_name(""),
 	_value(""),
+	_textField(nullptr),
 	_debugIn(0),
-	_lastByteMillis(0)
+	_lastByteMillis(0),
+	_pendingCount(0),
+	_pendingTextLength(0)
 {
 }
 
@@ -98,7 +101,8 @@ void VeDirectFrameHandler<T>::reset()
 {
 	_checksum = 0;
     _state = State::IDLE;
-	_textData.clear();
+	_pendingCount = 0;
+	_pendingTextLength = 0;
 }
 
 template<typename T>
@@ -123,7 +127,7 @@ void VeDirectFrameHandler<T>::loop()
 /*
  *  rxData
  *  This function is called by loop() which passes a byte of serial data
- *  Based on Victron's example code. But using String and Map instead of pointer and arrays
+ *  Based on Victron's example code.
  */
 template<typename T>
 void VeDirectFrameHandler<T>::rxData(uint8_t inbyte)
@@ -174,6 +178,10 @@ void VeDirectFrameHandler<T>::rxData(uint8_t inbyte)
 					_state = State::CHECKSUM;
 					break;
 				}
+				_textField = findTextField(frozen::string(_name, _textPointer - _name));
+			}
+			else {
+				_textField = nullptr;
 			}
 			_textPointer = _value; /* Reset value pointer */
 			_state = State::RECORD_VALUE;
@@ -193,7 +201,7 @@ void VeDirectFrameHandler<T>::rxData(uint8_t inbyte)
 		case '\n':
 			if ( _textPointer < (_value + sizeof(_value)) ) {
 				*_textPointer = 0; // make zero ended
-                _textData.push_back({_name, _value});
+				recordTextData();
 			}
 			_state = State::RECORD_BEGIN;
 			break;
@@ -209,9 +217,7 @@ void VeDirectFrameHandler<T>::rxData(uint8_t inbyte)
 	case State::CHECKSUM:
 		if (_verboseLogging) { dumpDebugBuffer(); }
 		if (_checksum == 0) {
-			for (auto const& event : _textData) {
-				processTextData(event.first, event.second);
-			}
+			commitTextData();
 			_lastUpdate = millis();
 			frameValidEvent();
 		}
@@ -227,44 +233,104 @@ void VeDirectFrameHandler<T>::rxData(uint8_t inbyte)
 }
 
 /*
- * This function is called every time a new name/value is successfully parsed.  It writes the values to the temporary buffer.
+ * the fields every VE.Direct device sends. the derived classes add the fields
+ * specific to their device type.
  */
 template<typename T>
-void VeDirectFrameHandler<T>::processTextData(std::string const& name, std::string const& value) {
-	if (_verboseLogging) {
-		_msgOut->printf("%s Text Data '%s' = '%s'\r\n",
-				_logId, name.c_str(), value.c_str());
-	}
+typename VeDirectFrameHandler<T>::TextField const* VeDirectFrameHandler<T>::findTextField(frozen::string const& name) const
+{
+	using Type = typename TextField::Type;
 
-	if (processTextDataDerived(name, value)) { return; }
+	static constexpr frozen::unordered_map<frozen::string, TextField, 5> textFields = {
+		{ "PID", { Type::Number,  [](T& f, int32_t n, char const*) { f.productID_PID = n; } } },
+		{ "SER", { Type::Text,    [](T& f, int32_t, char const* t) { strlcpy(f.serialNr_SER, t, sizeof(f.serialNr_SER)); } } },
+		{ "FW",  { Type::Text,    [](T& f, int32_t, char const* t) { strlcpy(f.firmwareVer_FW, t, sizeof(f.firmwareVer_FW)); } } },
+		{ "V",   { Type::Decimal, [](T& f, int32_t n, char const*) { f.batteryVoltage_V_mV = n; } } },
+		{ "I",   { Type::Decimal, [](T& f, int32_t n, char const*) { f.batteryCurrent_I_mA = n; } } }
+	};
 
-	if (name == "PID") {
-		_tmpFrame.productID_PID = strtol(value.c_str(), nullptr, 0);
-		return;
-	}
+	auto it = textFields.find(name);
+	if (it != textFields.end()) { return &it->second; }
 
-	if (name == "SER") {
-		strncpy(_tmpFrame.serialNr_SER, value.c_str(), sizeof(_tmpFrame.serialNr_SER));
-		return;
+	return findTextFieldDerived(name);
+}
+
+/*
+ * This function is called every time a new name/value is successfully parsed.
+ * The value is parsed and kept until the checksum of the frame is known.
+ */
+template<typename T>
+void VeDirectFrameHandler<T>::recordTextData()
+{
+	int const maxNameLength = sizeof(_name);
+
+	if (_verboseLogging) {
+		_msgOut->printf("%s Text Data '%.*s' = '%s'\r\n",
+				_logId, maxNameLength, _name, _value);
 	}
 
-	if (name == "FW") {
-        strncpy(_tmpFrame.firmwareVer_FW, value.c_str(), sizeof(_tmpFrame.firmwareVer_FW));
+	if (_textField == nullptr) {
+		if (_verboseLogging) {
+			_msgOut->printf("%s Unknown text data '%.*s' (value '%s')\r\n",
+					_logId, maxNameLength, _name, _value);
+		}
 		return;
 	}
 
-	if (name == "V") {
-		_tmpFrame.batteryVoltage_V_mV = atol(value.c_str());
+	using Type = typename TextField::Type;
+	if (_textField->type == Type::Ignored) { return; }
+
+	if (_pendingCount >= _pendingFields.size()) {
+		_msgOut->printf("%s too many text records in frame, ignoring '%.*s'\r\n",
+				_logId, maxNameLength, _name);
 		return;
 	}
 
-	if (name == "I") {
-		_tmpFrame.batteryCurrent_I_mA = atol(value.c_str());
-		return;
+	auto& pending = _pendingFields[_pendingCount];
+	pending.field = _textField;
+	pending.number = 0;
+	pending.textOffset = 0;
+
+	switch (_textField->type) {
+	case Type::Decimal:
+		pending.number = strtol(_value, nullptr, 10);
+		break;
+	case Type::Number:
+		pending.number = static_cast<int32_t>(strtoul(_value, nullptr, 0));
+		break;
+	case Type::OnOff:
+		pending.number = (strcmp(_value, "ON") == 0) ? 1 : 0;
+		break;
+	case Type::Text: {
+		size_t length = strlen(_value) + 1;
+		if (_pendingTextLength + length > _pendingText.size()) {
+			_msgOut->printf("%s too much text in frame, ignoring '%.*s'\r\n",
+					_logId, maxNameLength, _name);
+			return;
+		}
+		memcpy(&_pendingText[_pendingTextLength], _value, length);
+		pending.textOffset = _pendingTextLength;
+		_pendingTextLength += length;
+		break;
 	}
+	case Type::Ignored:
+		break;
+	}
+
+	++_pendingCount;
+}
 
-	_msgOut->printf("%s Unknown text data '%s' (value '%s')\r\n",
-			_logId, name.c_str(), value.c_str());
+/*
+ * This function is called once the frame was found to be valid. It writes the
+ * values to the temporary buffer.
+ */
+template<typename T>
+void VeDirectFrameHandler<T>::commitTextData()
+{
+	for (size_t i = 0; i < _pendingCount; ++i) {
+		auto const& pending = _pendingFields[i];
+		pending.field->apply(_tmpFrame, pending.number, &_pendingText[pending.textOffset]);
+	}
 }
 
 /*
@@ -16,9 +16,29 @@
 #include <array>
 #include <memory>
 #include <utility>
-#include <deque>
+#include <frozen/string.h>
+#include <frozen/unordered_map.h>
 #include "VeDirectData.h"
 
+/*
+ * describes a field of the TEXT protocol. the value is parsed as soon as the
+ * record was received, apply() writes it to the frame data once the checksum
+ * of the frame was found to be valid.
+ */
+template<typename T>
+struct VeDirectTextField {
+    enum class Type : uint8_t {
+        Decimal,    // signed decimal number
+        Number,     // decimal number or hex number with 0x prefix
+        OnOff,      // "ON" or "OFF", applied as 1 or 0
+        Text,
+        Ignored
+    };
+
+    Type type;
+    void (*apply)(T& frame, int32_t number, char const* text);
+};
+
 template<typename T>
 class VeDirectFrameHandler {
 public:
@@ -30,6 +50,8 @@ public:
     bool isStateIdle() const { return (_state == State::IDLE); }
 
 protected:
+    using TextField = VeDirectTextField<T>;
+
     VeDirectFrameHandler();
     void init(char const* who, int8_t rx, int8_t tx, Print* msgOut, bool verboseLogging, uint8_t hwSerialPort);
     virtual bool hexDataHandler(VeDirectHexData const &data) { return false; } // handles the disassembled hex response
@@ -47,8 +69,10 @@ private:
     void reset();
     void dumpDebugBuffer();
     void rxData(uint8_t inbyte);              // byte of serial data
-    void processTextData(std::string const& name, std::string const& value);
-    virtual bool processTextDataDerived(std::string const& name, std::string const& value) = 0;
+    TextField const* findTextField(frozen::string const& name) const;
+    virtual TextField const* findTextFieldDerived(frozen::string const& name) const = 0;
+    void recordTextData();
+    void commitTextData();
     virtual void frameValidEvent() { }
     bool disassembleHexData(VeDirectHexData &data);     //return true if disassembling was possible
 
@@ -73,6 +97,7 @@ private:
     char _hexBuffer[VE_MAX_HEX_LEN];           // buffer for received hex frames
     char _name[VE_MAX_VALUE_LEN];              // buffer for the field name
     char _value[VE_MAX_VALUE_LEN];             // buffer for the field value
+    TextField const* _textField;               // field of the record being received
     std::array<uint8_t, 512> _debugBuffer;
     unsigned _debugIn;
     uint32_t _lastByteMillis;                  // time of last parsed byte
@@ -85,8 +110,19 @@ private:
      * this also handles fragmentation nicely, since there is no need to reset
      * our data buffer. we simply update the interpreted data from this event
      * queue, which is fine as we know the source frame was valid.
+     *
+     * the values are already parsed, only text values are kept as such.
+     * a frame has at most 22 records.
      */
-    std::deque<std::pair<std::string, std::string>> _textData;
+    struct PendingField_t {
+        TextField const* field;
+        int32_t number;
+        uint8_t textOffset;
+    };
+    std::array<PendingField_t, 24> _pendingFields;
+    size_t _pendingCount;
+    std::array<char, 2 * VE_MAX_VALUE_LEN> _pendingText;
+    size_t _pendingTextLength;
 };
 
 template class VeDirectFrameHandler<veMpptStruct>;
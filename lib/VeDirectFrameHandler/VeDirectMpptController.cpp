@@ -20,68 +20,31 @@ void VeDirectMpptController::init(int8_t rx, int8_t tx, Print* msgOut, bool verb
     _tmpFrame.hasLoad = false;
 }
 
-bool VeDirectMpptController::processTextDataDerived(std::string const& name, std::string const& value)
+using TextField = VeDirectTextField<veMpptStruct>;
+using Type = TextField::Type;
+
+static constexpr frozen::unordered_map<frozen::string, TextField, 14> textFields = {
+	{ "IL",   { Type::Decimal, [](veMpptStruct& f, int32_t n, char const*) { f.loadCurrent_IL_mA = n; f.hasLoad = true; } } },
+	{ "LOAD", { Type::OnOff,   [](veMpptStruct& f, int32_t n, char const*) { f.loadOutputState_LOAD = n; f.hasLoad = true; } } },
+	{ "CS",   { Type::Decimal, [](veMpptStruct& f, int32_t n, char const*) { f.currentState_CS = n; } } },
+	{ "ERR",  { Type::Decimal, [](veMpptStruct& f, int32_t n, char const*) { f.errorCode_ERR = n; } } },
+	{ "OR",   { Type::Number,  [](veMpptStruct& f, int32_t n, char const*) { f.offReason_OR = n; } } },
+	{ "MPPT", { Type::Decimal, [](veMpptStruct& f, int32_t n, char const*) { f.stateOfTracker_MPPT = n; } } },
+	{ "HSDS", { Type::Decimal, [](veMpptStruct& f, int32_t n, char const*) { f.daySequenceNr_HSDS = n; } } },
+	{ "VPV",  { Type::Decimal, [](veMpptStruct& f, int32_t n, char const*) { f.panelVoltage_VPV_mV = n; } } },
+	{ "PPV",  { Type::Decimal, [](veMpptStruct& f, int32_t n, char const*) { f.panelPower_PPV_W = n; } } },
+	{ "H19",  { Type::Decimal, [](veMpptStruct& f, int32_t n, char const*) { f.yieldTotal_H19_Wh = n * 10; } } },
+	{ "H20",  { Type::Decimal, [](veMpptStruct& f, int32_t n, char const*) { f.yieldToday_H20_Wh = n * 10; } } },
+	{ "H21",  { Type::Decimal, [](veMpptStruct& f, int32_t n, char const*) { f.maxPowerToday_H21_W = n; } } },
+	{ "H22",  { Type::Decimal, [](veMpptStruct& f, int32_t n, char const*) { f.yieldYesterday_H22_Wh = n * 10; } } },
+	{ "H23",  { Type::Decimal, [](veMpptStruct& f, int32_t n, char const*) { f.maxPowerYesterday_H23_W = n; } } }
+};
+
+TextField const* VeDirectMpptController::findTextFieldDerived(frozen::string const& name) const
 {
-	if (name == "IL") {
-		_tmpFrame.loadCurrent_IL_mA = atol(value.c_str());
-        _tmpFrame.hasLoad = true;
-		return true;
-	}
-	if (name == "LOAD") {
-		_tmpFrame.loadOutputState_LOAD = (value == "ON");
-        _tmpFrame.hasLoad = true;
-		return true;
-	}
-	if (name == "CS") {
-		_tmpFrame.currentState_CS = atoi(value.c_str());
-		return true;
-	}
-	if (name == "ERR") {
-		_tmpFrame.errorCode_ERR = atoi(value.c_str());
-		return true;
-	}
-	if (name == "OR") {
-		_tmpFrame.offReason_OR = strtol(value.c_str(), nullptr, 0);
-		return true;
-	}
-	if (name == "MPPT") {
-		_tmpFrame.stateOfTracker_MPPT = atoi(value.c_str());
-		return true;
-	}
-	if (name == "HSDS") {
-		_tmpFrame.daySequenceNr_HSDS = atoi(value.c_str());
-		return true;
-	}
-	if (name == "VPV") {
-		_tmpFrame.panelVoltage_VPV_mV = atol(value.c_str());
-		return true;
-	}
-	if (name == "PPV") {
-		_tmpFrame.panelPower_PPV_W = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H19") {
-		_tmpFrame.yieldTotal_H19_Wh = atol(value.c_str()) * 10;
-		return true;
-	}
-	if (name == "H20") {
-		_tmpFrame.yieldToday_H20_Wh = atol(value.c_str()) * 10;
-		return true;
-	}
-	if (name == "H21") {
-		_tmpFrame.maxPowerToday_H21_W = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H22") {
-		_tmpFrame.yieldYesterday_H22_Wh = atol(value.c_str()) * 10;
-		return true;
-	}
-	if (name == "H23") {
-		_tmpFrame.maxPowerYesterday_H23_W = atoi(value.c_str());
-		return true;
-	}
-
-	return false;
+	auto it = textFields.find(name);
+	if (it == textFields.end()) { return nullptr; }
+	return &it->second;
 }
 
 /*
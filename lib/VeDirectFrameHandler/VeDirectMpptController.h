@@ -55,7 +55,7 @@ public:
 
 private:
     bool hexDataHandler(VeDirectHexData const &data) final;
-    bool processTextDataDerived(std::string const& name, std::string const& value) final;
+    TextField const* findTextFieldDerived(frozen::string const& name) const final;
     void frameValidEvent() final;
     void sendNextHexCommandFromQueue(void);
     bool isHexCommandPossible(void);
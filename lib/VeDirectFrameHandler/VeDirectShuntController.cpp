@@ -8,125 +8,46 @@ void VeDirectShuntController::init(int8_t rx, int8_t tx, Print* msgOut, bool ver
 	VeDirectFrameHandler::init("SmartShunt", rx, tx, msgOut, verboseLogging, hwSerialPort);
 }
 
-bool VeDirectShuntController::processTextDataDerived(std::string const& name, std::string const& value)
+using TextField = VeDirectTextField<veShuntStruct>;
+using Type = TextField::Type;
+
+static constexpr frozen::unordered_map<frozen::string, TextField, 29> textFields = {
+	{ "T",     { Type::Decimal, [](veShuntStruct& f, int32_t n, char const*) { f.T = n; f.tempPresent = true; } } },
+	{ "P",     { Type::Decimal, [](veShuntStruct& f, int32_t n, char const*) { f.P = n; } } },
+	{ "CE",    { Type::Decimal, [](veShuntStruct& f, int32_t n, char const*) { f.CE = n; } } },
+	{ "SOC",   { Type::Decimal, [](veShuntStruct& f, int32_t n, char const*) { f.SOC = n; } } },
+	{ "TTG",   { Type::Decimal, [](veShuntStruct& f, int32_t n, char const*) { f.TTG = n; } } },
+	{ "ALARM", { Type::OnOff,   [](veShuntStruct& f, int32_t n, char const*) { f.ALARM = n; } } },
+	{ "AR",    { Type::Decimal, [](veShuntStruct& f, int32_t n, char const*) { f.alarmReason_AR = n; } } },
+	{ "H1",    { Type::Decimal, [](veShuntStruct& f, int32_t n, char const*) { f.H1 = n; } } },
+	{ "H2",    { Type::Decimal, [](veShuntStruct& f, int32_t n, char const*) { f.H2 = n; } } },
+	{ "H3",    { Type::Decimal, [](veShuntStruct& f, int32_t n, char const*) { f.H3 = n; } } },
+	{ "H4",    { Type::Decimal, [](veShuntStruct& f, int32_t n, char const*) { f.H4 = n; } } },
+	{ "H5",    { Type::Decimal, [](veShuntStruct& f, int32_t n, char const*) { f.H5 = n; } } },
+	{ "H6",    { Type::Decimal, [](veShuntStruct& f, int32_t n, char const*) { f.H6 = n; } } },
+	{ "H7",    { Type::Decimal, [](veShuntStruct& f, int32_t n, char const*) { f.H7 = n; } } },
+	{ "H8",    { Type::Decimal, [](veShuntStruct& f, int32_t n, char const*) { f.H8 = n; } } },
+	{ "H9",    { Type::Decimal, [](veShuntStruct& f, int32_t n, char const*) { f.H9 = n; } } },
+	{ "H10",   { Type::Decimal, [](veShuntStruct& f, int32_t n, char const*) { f.H10 = n; } } },
+	{ "H11",   { Type::Decimal, [](veShuntStruct& f, int32_t n, char const*) { f.H11 = n; } } },
+	{ "H12",   { Type::Decimal, [](veShuntStruct& f, int32_t n, char const*) { f.H12 = n; } } },
+	{ "H13",   { Type::Decimal, [](veShuntStruct& f, int32_t n, char const*) { f.H13 = n; } } },
+	{ "H14",   { Type::Decimal, [](veShuntStruct& f, int32_t n, char const*) { f.H14 = n; } } },
+	{ "H15",   { Type::Decimal, [](veShuntStruct& f, int32_t n, char const*) { f.H15 = n; } } },
+	{ "H16",   { Type::Decimal, [](veShuntStruct& f, int32_t n, char const*) { f.H16 = n; } } },
+	{ "H17",   { Type::Decimal, [](veShuntStruct& f, int32_t n, char const*) { f.H17 = n; } } },
+	{ "VM",    { Type::Decimal, [](veShuntStruct& f, int32_t n, char const*) { f.VM = n; } } },
+	{ "DM",    { Type::Decimal, [](veShuntStruct& f, int32_t n, char const*) { f.DM = n; } } },
+	{ "H18",   { Type::Decimal, [](veShuntStruct& f, int32_t n, char const*) { f.H18 = n; } } },
+	{ "MON",   { Type::Decimal, [](veShuntStruct& f, int32_t n, char const*) { f.dcMonitorMode_MON = n; } } },
+	// a textual description of the BMV model, for example 602S or 702.
+	// it is deprecated, refer to the field PID instead.
+	{ "BMV",   { Type::Ignored, nullptr } }
+};
+
+TextField const* VeDirectShuntController::findTextFieldDerived(frozen::string const& name) const
 {
-	if (name == "T") {
-		_tmpFrame.T = atoi(value.c_str());
-		_tmpFrame.tempPresent = true;
-		return true;
-	}
-	if (name == "P") {
-		_tmpFrame.P = atoi(value.c_str());
-		return true;
-	}
-	if (name == "CE") {
-		_tmpFrame.CE = atoi(value.c_str());
-		return true;
-	}
-	if (name == "SOC") {
-		_tmpFrame.SOC = atoi(value.c_str());
-		return true;
-	}
-	if (name == "TTG") {
-		_tmpFrame.TTG = atoi(value.c_str());
-		return true;
-	}
-	if (name == "ALARM") {
-		_tmpFrame.ALARM = (value == "ON");
-		return true;
-	}
-	if (name == "AR") {
-		_tmpFrame.alarmReason_AR = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H1") {
-		_tmpFrame.H1 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H2") {
-		_tmpFrame.H2 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H3") {
-		_tmpFrame.H3 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H4") {
-		_tmpFrame.H4 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H5") {
-		_tmpFrame.H5 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H6") {
-		_tmpFrame.H6 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H7") {
-		_tmpFrame.H7 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H8") {
-		_tmpFrame.H8 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H9") {
-		_tmpFrame.H9 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H10") {
-		_tmpFrame.H10 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H11") {
-		_tmpFrame.H11 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H12") {
-		_tmpFrame.H12 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H13") {
-		_tmpFrame.H13 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H14") {
-		_tmpFrame.H14 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H15") {
-		_tmpFrame.H15 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H16") {
-		_tmpFrame.H16 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H17") {
-		_tmpFrame.H17 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "VM") {
-		_tmpFrame.VM = atoi(value.c_str());
-		return true;
-	}
-	if (name == "DM") {
-		_tmpFrame.DM = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H18") {
-		_tmpFrame.H18 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "BMV") {
-		// This field contains a textual description of the BMV model,
-		// for example 602S or 702. It is deprecated, refer to the field PID instead.
-		return true;
-	}
-	if (name == "MON") {
-		_tmpFrame.dcMonitorMode_MON = static_cast<int8_t>(atoi(value.c_str()));
-		return true;
-	}
-	return false;
+	auto it = textFields.find(name);
+	if (it == textFields.end()) { return nullptr; }
+	return &it->second;
 }
@@ -13,7 +13,7 @@ public:
     using data_t = veShuntStruct;
 
 private:
-    bool processTextDataDerived(std::string const& name, std::string const& value) final;
+    TextField const* findTextFieldDerived(frozen::string const& name) const final;
 };
 
 extern VeDirectShuntController VeDirectShunt;
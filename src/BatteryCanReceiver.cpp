@@ -8,7 +8,7 @@
 #include "SpiManager.h"
 #include "mcp2515_init_spi.h"
 
-bool BatteryCanReceiver::init(char const* providerName)
+bool BatteryCanReceiver::init(char const* providerName, CanIoClass::Filters const& filters)
 {
     snprintf(_providerName, sizeof(_providerName), "[%s %s]", providerName, PinMapping.get().battery.providerName);
 
@@ -42,11 +42,21 @@ bool BatteryCanReceiver::init(char const* providerName)
                 MessageOutput.printf("Unknown frequency %u Hz, using 8 MHz\r\n", frequency);
             }
             MessageOutput.printf("MCP2515 Quarz = %u Mhz\r\n", (unsigned int)(frequency/1000000UL));
-            if ((rc = _CAN->begin(MCP_ANY, CAN_500KBPS, mcp_frequency)) != CAN_OK) {
+            if ((rc = _CAN->begin(MCP_STDEXT, CAN_500KBPS, mcp_frequency)) != CAN_OK) {
                 MessageOutput.printf("%s MCP2515 failed to initialize. Error code: %d\r\n", _providerName, rc);
                 return false;
             }
 
+            // both receive buffers only accept the identifiers the battery sends
+            uint32_t id, mask;
+            bool extd;
+            CanIoClass::mergeFilters(filters, id, mask, extd);
+            _CAN->setFilterMask(MASK0, extd, mask);
+            _CAN->setFilterMask(MASK1, extd, mask);
+            for (auto rxf : { RXF0, RXF1, RXF2, RXF3, RXF4, RXF5 }) {
+                _CAN->setFilter(rxf, extd, id);
+            }
+
             // Change to normal mode to allow messages to be transmitted
             _CAN->setMode(MCP_NORMAL);
             }
@@ -64,9 +74,11 @@ bool BatteryCanReceiver::init(char const* providerName)
 #if defined(BOARD_HAS_PSRAM)
             g_config.intr_flags = ESP_INTR_FLAG_LEVEL2;
 #endif
+            // keep some headroom for bursts at high bus load
+            g_config.rx_queue_len = 32;
             // Initialize configuration structures using macro initializers
             twai_timing_config_t t_config = TWAI_TIMING_CONFIG_500KBITS();
-            twai_filter_config_t f_config = TWAI_FILTER_CONFIG_ACCEPT_ALL();
+            twai_filter_config_t f_config = CanIo.getTwaiFilterConfig(filters);
 
             // Install TWAI driver
             MessageOutput.print("Twai driver install");
@@ -142,6 +154,14 @@ bool BatteryCanReceiver::init(char const* providerName)
             return false;
     }
 
+    auto wakeup = CanIoClass::Wakeup::Poll;
+    if (pin.provider == Battery_Provider_t::MCP2515) { wakeup = CanIoClass::Wakeup::Interrupt; }
+    if (pin.provider == Battery_Provider_t::CAN0) { wakeup = CanIoClass::Wakeup::Twai; }
+
+    _frames.clear();
+    CanIo.attach(_providerName, [this](twai_message_t& rx_message) { return readFrame(rx_message); },
+            filters, _frames, wakeup, pin.mcp2515.irq);
+
     MessageOutput.println(" Done");
 
     _initialized = true;
@@ -151,6 +171,8 @@ bool BatteryCanReceiver::init(char const* providerName)
 
 void BatteryCanReceiver::deinit()
 {
+    CanIo.detach(_frames);
+
     const auto &pin = PinMapping.get().battery;
 
     switch(pin.provider) {
@@ -209,31 +231,42 @@ void BatteryCanReceiver::deinit()
 
 void BatteryCanReceiver::loop()
 {
-    const auto _provider = PinMapping.get().battery.provider;
+    CanFrame_t frame;
+
+    while (_frames.try_pop(frame)) {
+        auto& rx_message = frame.message;
+        if (rx_message.data_length_code == 0) { continue; }
 
-    twai_message_t rx_message;
+        if (_verboseLogging) {
+            MessageOutput.printf("%s Received CAN message: 0x%04X (%u ms ago) -", _providerName,
+                rx_message.identifier, millis() - frame.timestamp);
+
+            for (int i = 0; i < rx_message.data_length_code; i++) {
+                MessageOutput.printf(" %02X", rx_message.data[i]);
+            }
+
+            MessageOutput.printf("\r\n");
+        }
+
+        onMessage(rx_message);
+    }
+}
+
+// called from the CAN I/O task
+bool BatteryCanReceiver::readFrame(twai_message_t& rx_message)
+{
+    const auto _provider = PinMapping.get().battery.provider;
 
     switch (_provider) {
 #ifdef USE_BATTERY_MCP2515
         case Battery_Provider_t::MCP2515:
             {
-            if(!_CAN->isInterrupt()) return;  // If CAN0_INT pin is low, read receive buffer
+            if(!_CAN->isInterrupt()) return false;  // If CAN0_INT pin is low, read receive buffer
 
             int rc;
             if ((rc = _CAN->readMsgBuf(reinterpret_cast<can_message_t*>(&rx_message)))  != CAN_OK) {      // Read data: len = data length, buf = data byte(s)
                 MessageOutput.printf("%s failed to read CAN message: Error code %d\r\n", _providerName, rc);
-                return;
-            }
-            if (_verboseLogging) {
-                if(rx_message.extd)     // Determine if ID is standard (11 bits) or extended (29 bits)
-                    MessageOutput.printf("Extended ID: 0x%.8" PRIx32 " DLC: %1d  Data:", rx_message.identifier & 0x1FFFFFFF, rx_message.data_length_code);
-                else
-                    MessageOutput.printf("Standard ID: 0x%.3" PRIx32 " DLC: %1d  Data:", rx_message.identifier, rx_message.data_length_code);
-            }
-
-            if (rx_message.rtr){    // Determine if message is a remote request frame.
-                MessageOutput.printf(" REMOTE REQUEST FRAME %s\r\n", rx_message.data);
-                return;
+                return false;
             }
             }
             break;
@@ -241,12 +274,11 @@ void BatteryCanReceiver::loop()
 #ifdef USE_BATTERY_CAN0
         case Battery_Provider_t::CAN0:
             {
-
-            // Check for messages. twai_receive is blocking when there is no data so we return if there are no frames in the buffer
-            twai_status_info_t status_info;
-            esp_err_t twaiLastResult = twai_get_status_info(&status_info);
+            // the driver queues received frames, do not wait for more
+            esp_err_t twaiLastResult = twai_receive(&rx_message, 0);
+            if (twaiLastResult == ESP_ERR_TIMEOUT) { return false; }
             if (twaiLastResult != ESP_OK) {
-                MessageOutput.printf("%s Twai driver get status ", _providerName);
+                MessageOutput.printf("%s Twai driver receive ", _providerName);
                 switch (twaiLastResult) {
                 case ESP_ERR_INVALID_ARG:
                     MessageOutput.println("- invalid arg");
@@ -257,17 +289,7 @@ void BatteryCanReceiver::loop()
                 default:;
                     MessageOutput.println("- failure");
                 }
-                return;
-            }
-
-            if (status_info.msgs_to_rx == 0) {
-                return;
-            }
-
-            // Wait for message to be received, function is blocking
-            if (twai_receive(&rx_message, pdMS_TO_TICKS(100)) != ESP_OK) {
-                MessageOutput.printf("%s Failed to receive message\r\n", _providerName);
-                return;
+                return false;
             }
             }
             break;
@@ -275,39 +297,23 @@ void BatteryCanReceiver::loop()
 #ifdef USE_BATTERY_I2C
         case Battery_Provider_t::I2C0:
         case Battery_Provider_t::I2C1:
-            if (CAN_MSGAVAIL != i2c_can->checkReceive()) return;
+            if (CAN_MSGAVAIL != i2c_can->checkReceive()) return false;
 
             if (CAN_OK != i2c_can->readMsgBuf(&rx_message.data_length_code, rx_message.data)) {    // read data,  len: data length, buf: data buf
                 MessageOutput.println("I2C CAN nothing received");
-                return;
-            }
-
-            if (rx_message.data_length_code > 8) {
-                MessageOutput.printf("I2C CAN received %d bytes\r\n", rx_message.data_length_code);
-                return;
+                return false;
             }
 
-            if (rx_message.data_length_code == 0) return;
-
             rx_message.identifier = i2c_can->getCanId();
             rx_message.extd = i2c_can->isExtendedFrame();
             rx_message.rtr = i2c_can->isRemoteRequest();
             break;
 #endif
         default:;
+            return false;
     }
 
-    if (_verboseLogging) {
-        MessageOutput.printf("%s Received CAN message: 0x%04X -", _providerName, rx_message.identifier);
-
-        for (int i = 0; i < rx_message.data_length_code; i++) {
-            MessageOutput.printf(" %02X", rx_message.data[i]);
-        }
-
-        MessageOutput.printf("\r\n");
-    }
-
-    onMessage(rx_message);
+    return true;
 }
 
 uint8_t BatteryCanReceiver::readUnsignedInt8(uint8_t *data)
@@ -0,0 +1,124 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#if defined(USE_PYLONTECH_RS485_RECEIVER) || defined(USE_GOBEL_RS485_RECEIVER)
+
+#include "BatteryRS485FrameDecoder.h"
+#include <array>
+
+namespace {
+
+// value of a hex digit, -1 for every other character
+constexpr std::array<int8_t, 256> makeNibbleTable()
+{
+    std::array<int8_t, 256> table = {};
+
+    for (size_t i = 0; i < table.size(); ++i) { table[i] = -1; }
+    for (uint8_t i = 0; i < 10; ++i) { table['0' + i] = i; }
+    for (uint8_t i = 0; i < 6; ++i) {
+        table['A' + i] = 10 + i;
+        table['a' + i] = 10 + i;
+    }
+
+    return table;
+}
+
+constexpr std::array<int8_t, 256> nibbleTable = makeNibbleTable();
+
+} // namespace
+
+void BatteryRS485FrameDecoder::reset()
+{
+    _started = false;
+    _highNibble = -1;
+    _bytes = 0;
+    _chars = 0;
+    _expectedChars = 0;
+    _sum = 0;
+}
+
+BatteryRS485FrameDecoder::Result BatteryRS485FrameDecoder::fail(char const* error)
+{
+    _error = error;
+    reset();
+    return Result::Error;
+}
+
+BatteryRS485FrameDecoder::Result BatteryRS485FrameDecoder::feed(char c)
+{
+    if (c == 0x7E) {
+        // a new SOI discards an incomplete frame
+        reset();
+        _started = true;
+        return Result::Pending;
+    }
+
+    if (!_started) { return Result::Ignored; }
+
+    if (c == 0x0D) { return finish(); }
+
+    int8_t nibble = nibbleTable[static_cast<uint8_t>(c)];
+    if (nibble < 0) { return fail("invalid character"); }
+
+    if (_expectedChars == 0 || _chars < _expectedChars - _checksumChars) {
+        _sum += static_cast<uint8_t>(c);
+    }
+
+    if (++_chars > _expectedChars && _expectedChars != 0) { return fail("frame longer than LENID"); }
+
+    if (_highNibble < 0) {
+        _highNibble = nibble;
+        return Result::Pending;
+    }
+
+    uint8_t value = (_highNibble << 4) | nibble;
+    _highNibble = -1;
+
+    switch (_bytes) {
+    case 0: _frame.ver = value; break;
+    case 1: _frame.adr = value; break;
+    case 2: _frame.cid1 = value; break;
+    case 3: _frame.cid2 = value; break;
+    case 4: _frame.infolength = value << 8; break;
+    case 5: {
+        _frame.infolength |= value;
+
+        // LCHKSUM makes the sum of all four nibbles of LENID a multiple of 16
+        uint16_t lenid = _frame.infolength & 0x0FFF;
+        uint8_t nibbles = (lenid & 0xF) + ((lenid >> 4) & 0xF) + ((lenid >> 8) & 0xF) + (_frame.infolength >> 12);
+        if ((nibbles & 0xF) != 0) { return fail("LENID checksum error"); }
+        if ((lenid & 1) != 0) { return fail("odd LENID"); }
+
+        // the checksum is decoded into info as well, right behind the data
+        if (lenid / 2 + _checksumChars / 2 > sizeof(_frame.info)) { return fail("frame too long"); }
+
+        _expectedChars = _headerBytes * 2 + lenid + _checksumChars;
+        break;
+    }
+    default:
+        _frame.info[_bytes - _headerBytes] = value;
+        break;
+    }
+
+    ++_bytes;
+    return Result::Pending;
+}
+
+BatteryRS485FrameDecoder::Result BatteryRS485FrameDecoder::finish()
+{
+    if (_expectedChars == 0 || _chars != _expectedChars) { return fail("frame length does not match LENID"); }
+
+    size_t infoBytes = (_frame.infolength & 0x0FFF) / 2;
+    uint16_t received = (_frame.info[infoBytes] << 8) | _frame.info[infoBytes + 1];
+    uint16_t computed = ~_sum + 1;
+
+    if (received != computed) { return fail("frame checksum error"); }
+
+    // keep the length of the frame for getLength()
+    size_t chars = _chars;
+    reset();
+    _chars = chars;
+
+    return Result::Complete;
+}
+
+#endif
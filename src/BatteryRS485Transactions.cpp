@@ -0,0 +1,138 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#if defined(USE_PYLONTECH_RS485_RECEIVER) || defined(USE_GOBEL_RS485_RECEIVER)
+
+#include "BatteryRS485Transactions.h"
+#include "MessageOutput.h"
+
+void BatteryRS485Transactions::begin(char const* tag, HardwareSerial* serial, Sender sender, Handler handler)
+{
+    _tag = tag;
+    _serial = serial;
+    _sender = sender;
+    _handler = handler;
+
+    clear();
+}
+
+void BatteryRS485Transactions::end()
+{
+    clear();
+    _serial = nullptr;
+}
+
+void BatteryRS485Transactions::enqueue(uint8_t module, uint8_t cmd, uint8_t infoCommand)
+{
+    _requests.push_back({ module, cmd, infoCommand, 0 });
+}
+
+void BatteryRS485Transactions::clear()
+{
+    _requests.clear();
+    _inFlight = false;
+    _decoder.reset();
+}
+
+void BatteryRS485Transactions::loop()
+{
+    if (_serial == nullptr) { return; }
+
+    receive();
+
+    if (_inFlight && millis() - _sentMillis > _responseTimeout) {
+        MessageOutput.printf("%s RS485 read timeout, Cmnd: %02X, Module: %d\r\n",
+                _tag, _request.cmd, _request.module);
+
+        _decoder.reset();
+
+        // the response may have collided with the late one of another module
+        if (_foreignFrame && _request.retries < _maxRetries) {
+            _request.retries++;
+            _requests.push_front(_request);
+            _inFlight = false;
+            _completedMillis = millis();
+        } else {
+            complete(nullptr);
+        }
+    }
+
+    sendNext();
+}
+
+// consumes everything the UART driver buffered so far, a frame may span
+// several calls.
+void BatteryRS485Transactions::receive()
+{
+    while (_serial->available()) {
+        switch (_decoder.feed(_serial->read())) {
+        case BatteryRS485FrameDecoder::Result::Ignored:
+            // interference on the line, some RS485 adapters are very
+            // sensitive. everything outside of a frame is dropped.
+            ++_spikes;
+            break;
+
+        case BatteryRS485FrameDecoder::Result::Pending:
+            break;
+
+        case BatteryRS485FrameDecoder::Result::Error:
+            MessageOutput.printf("%s RS485 frame discarded: %s\r\n", _tag, _decoder.getError());
+            if (_inFlight) { complete(nullptr); }
+            break;
+
+        case BatteryRS485FrameDecoder::Result::Complete: {
+            format_t* frame = _decoder.getFrame();
+            if (!_inFlight) {
+                MessageOutput.printf("%s unexpected frame, adr: %02X, cid2: %02X\r\n",
+                        _tag, frame->adr, frame->cid2);
+                break;
+            }
+
+            // e.g. the late response to a request which already timed out.
+            // the request stays in flight, its own response may follow.
+            if (frame->adr != _request.module) {
+                MessageOutput.printf("%s frame of module %d discarded, waiting for module %d, cid2: %02X\r\n",
+                        _tag, frame->adr, _request.module, frame->cid2);
+                _foreignFrame = true;
+                break;
+            }
+
+            _responseTime = millis() - _sentMillis;
+            complete(frame);
+            break;
+        }
+        }
+    }
+
+    if (_spikes > _spikeWarningThreshold) {
+        MessageOutput.printf("%s Warning found %d signal interferences\r\n", _tag, _spikes);
+        _spikes = 0;
+    }
+}
+
+void BatteryRS485Transactions::complete(format_t* frame)
+{
+    _inFlight = false;
+    _completedMillis = millis();
+    _handler(_request, frame);
+}
+
+void BatteryRS485Transactions::sendNext()
+{
+    if (_inFlight || _requests.empty()) { return; }
+
+    if (millis() - _completedMillis < _interFrameDelay) { return; }
+
+    _request = _requests.front();
+    _requests.pop_front();
+
+    // whatever is still buffered can not be the response to this request
+    while (_serial->available()) { _serial->read(); }
+    _decoder.reset();
+
+    _sender(_request);
+    _sentMillis = millis();
+    _inFlight = true;
+    _foreignFrame = false;
+}
+
+#endif
@@ -633,23 +633,23 @@ void JkBmsBatteryStats::updateFrom(JkBms::DataPointContainer const& dp)
 
     {auto oSoCValue = dp.get<Label::BatterySoCPercent>();
     if (oSoCValue.has_value()) {
-        auto oSoCDataPoint = dp.getDataPointFor<Label::BatterySoCPercent>();
+        auto pSoCDataPoint = dp.getDataPointFor<Label::BatterySoCPercent>();
         BatteryStats::setSoC(*oSoCValue, 0 /*precision*/,
-            oSoCDataPoint->getTimestamp());
+            pSoCDataPoint->getTimestamp());
     }}
 
     {auto oVoltage = dp.get<Label::BatteryVoltageMilliVolt>();
     if (oVoltage.has_value()) {
-        auto oVoltageDataPoint = dp.getDataPointFor<Label::BatteryVoltageMilliVolt>();
+        auto pVoltageDataPoint = dp.getDataPointFor<Label::BatteryVoltageMilliVolt>();
         BatteryStats::setVoltage(static_cast<float>(*oVoltage) / 1000,
-            oVoltageDataPoint->getTimestamp());
+            pVoltageDataPoint->getTimestamp());
     }}
 
     {auto oCurrent = dp.get<Label::BatteryCurrentMilliAmps>();
     if (oCurrent.has_value()) {
-        auto oCurrentDataPoint = dp.getDataPointFor<Label::BatteryCurrentMilliAmps>();
+        auto pCurrentDataPoint = dp.getDataPointFor<Label::BatteryCurrentMilliAmps>();
         BatteryStats::setCurrent(static_cast<float>(*oCurrent) / 1000, 2/*precision*/,
-                oCurrentDataPoint->getTimestamp());
+                pCurrentDataPoint->getTimestamp());
     }}
 
     _dataPoints.updateFrom(dp);
@@ -847,23 +847,23 @@ void JbdBmsBatteryStats::updateFrom(JbdBms::DataPointContainer const& dp)
 
     {auto oSoCValue = dp.get<Label::BatterySoCPercent>();
     if (oSoCValue.has_value()) {
-        auto oSoCDataPoint = dp.getDataPointFor<Label::BatterySoCPercent>();
+        auto pSoCDataPoint = dp.getDataPointFor<Label::BatterySoCPercent>();
         BatteryStats::setSoC(*oSoCValue, 0/*precision*/,
-                oSoCDataPoint->getTimestamp());
+                pSoCDataPoint->getTimestamp());
     }}
 
     {auto oVoltage = dp.get<Label::BatteryVoltageMilliVolt>();
     if (oVoltage.has_value()) {
-        auto oVoltageDataPoint = dp.getDataPointFor<Label::BatteryVoltageMilliVolt>();
+        auto pVoltageDataPoint = dp.getDataPointFor<Label::BatteryVoltageMilliVolt>();
         BatteryStats::setVoltage(static_cast<float>(*oVoltage) / 1000,
-                oVoltageDataPoint->getTimestamp());
+                pVoltageDataPoint->getTimestamp());
     }}
 
     {auto oCurrent = dp.get<Label::BatteryCurrentMilliAmps>();
     if (oCurrent.has_value()) {
-        auto oCurrentDataPoint = dp.getDataPointFor<Label::BatteryCurrentMilliAmps>();
+        auto pCurrentDataPoint = dp.getDataPointFor<Label::BatteryCurrentMilliAmps>();
         BatteryStats::setCurrent(static_cast<float>(*oCurrent) / 1000, 2/*precision*/,
-                oCurrentDataPoint->getTimestamp());
+                pCurrentDataPoint->getTimestamp());
     }}
 
     _dataPoints.updateFrom(dp);
@@ -1488,7 +1488,8 @@ void JkBmsBatteryStats::mqttPublish() /* const */
         auto skipMatch = std::find(mqttSkip.begin(), mqttSkip.end(), iter->first);
         if (skipMatch != mqttSkip.end()) { continue; }
 
-        String topic((std::string("battery/") + iter->second.getLabelText()).c_str());
+        String topic("battery/");
+        topic += iter->second.getLabelText();
         MqttSettings.publish(topic, iter->second.getValueText().c_str());
     }
 
@@ -1562,7 +1563,8 @@ void JbdBmsBatteryStats::mqttPublish() // const
         auto skipMatch = std::find(mqttSkip.begin(), mqttSkip.end(), iter->first);
         if (skipMatch != mqttSkip.end()) { continue; }
 
-        String topic((std::string("battery/") + iter->second.getLabelText()).c_str());
+        String topic("battery/");
+        topic += iter->second.getLabelText();
         MqttSettings.publish(topic, iter->second.getValueText().c_str());
     }
 
@@ -0,0 +1,234 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "CanIo.h"
+#include "MessageOutput.h"
+#include <algorithm>
+
+CanIoClass CanIo;
+
+void CanIoClass::attach(char const* name, Reader reader, Filters const& filters,
+        CanFrameQueue& queue, Wakeup wakeup, int8_t interruptPin, TaskHandle_t notify)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (wakeup == Wakeup::Interrupt && interruptPin < 0) { wakeup = Wakeup::Poll; }
+
+    _ports.push_back({ name, reader, filters, &queue, notify, wakeup, interruptPin, 0 });
+
+    if (_taskHandle == nullptr
+            && !xTaskCreate(CanIoClass::taskLoopHelper, "CAN:IO", _taskStackSize, this, _taskPriority, &_taskHandle)) {
+        MessageOutput.printf("[CanIo] ERROR: creating the CAN I/O task failed\r\n");
+        _taskHandle = nullptr;
+        return;
+    }
+
+    switch (wakeup) {
+    case Wakeup::Interrupt:
+        pinMode(interruptPin, INPUT_PULLUP);
+        attachInterruptArg(interruptPin, CanIoClass::interruptHandler, this, FALLING);
+        break;
+    case Wakeup::Twai:
+        // the alert only reports a frame, it stays queued for the reader
+        if (twai_reconfigure_alerts(TWAI_ALERT_RX_DATA, nullptr) != ESP_OK) {
+            MessageOutput.printf("[CanIo] %s: enabling the TWAI receive alert failed\r\n", name);
+        }
+        if (_twaiTaskHandle == nullptr
+                && !xTaskCreate(CanIoClass::twaiLoopHelper, "CAN:TWAI", _twaiTaskStackSize, this, _taskPriority, &_twaiTaskHandle)) {
+            MessageOutput.printf("[CanIo] ERROR: creating the TWAI alert task failed\r\n");
+            _twaiTaskHandle = nullptr;
+        }
+        break;
+    case Wakeup::Poll:
+        break;
+    }
+
+    xTaskNotifyGive(_taskHandle);
+}
+
+// the reader is not called anymore once this returns
+void CanIoClass::detach(CanFrameQueue& queue)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (auto const& port : _ports) {
+        if (port.queue == &queue && port.wakeup == Wakeup::Interrupt) {
+            detachInterrupt(port.interruptPin);
+        }
+    }
+
+    _ports.erase(std::remove_if(_ports.begin(), _ports.end(),
+            [&queue](Port_t const& port) { return port.queue == &queue; }),
+        _ports.end());
+}
+
+CanIoClass::Filters CanIoClass::exactStandardIds(std::initializer_list<uint32_t> ids)
+{
+    Filters filters;
+    filters.reserve(ids.size());
+
+    for (auto id : ids) {
+        filters.push_back({ id, 0x7FF, false });
+    }
+
+    return filters;
+}
+
+bool CanIoClass::matches(Filters const& filters, twai_message_t const& message)
+{
+    // none of the consumers is interested in remote requests
+    if (message.rtr || message.data_length_code > 8) { return false; }
+
+    if (filters.empty()) { return true; }
+
+    uint32_t identifier = message.identifier & 0x1FFFFFFF;
+
+    for (auto const& filter : filters) {
+        if (static_cast<bool>(message.extd) != filter.extd) { continue; }
+        if (((identifier ^ filter.id) & filter.mask) == 0) { return true; }
+    }
+
+    return false;
+}
+
+void CanIoClass::mergeFilters(Filters const& filters, uint32_t& id, uint32_t& mask, bool& extd)
+{
+    id = 0;
+    mask = 0;
+    extd = false;
+
+    if (filters.empty()) { return; }
+
+    extd = filters.front().extd;
+    mask = filters.front().mask;
+    id = filters.front().id & mask;
+
+    for (auto const& filter : filters) {
+        if (filter.extd != extd) {
+            // one acceptance filter can not match both frame formats
+            id = mask = 0;
+            return;
+        }
+
+        // only bits all filters care about and agree on remain relevant
+        mask &= filter.mask;
+        mask &= ~(id ^ filter.id);
+        id &= mask;
+    }
+}
+
+// the layout of the single filter mode is described in the ESP-IDF TWAI
+// documentation. the RTR bit and, for standard frames, the data bytes are
+// don't care.
+twai_filter_config_t CanIoClass::getTwaiFilterConfig(Filters const& filters)
+{
+    twai_filter_config_t config = TWAI_FILTER_CONFIG_ACCEPT_ALL();
+
+    uint32_t id, mask;
+    bool extd;
+    mergeFilters(filters, id, mask, extd);
+    if (mask == 0) { return config; }
+
+    if (extd) {
+        config.acceptance_code = (id & 0x1FFFFFFF) << 3;
+        config.acceptance_mask = ((~mask & 0x1FFFFFFF) << 3) | 0x7;
+    } else {
+        config.acceptance_code = (id & 0x7FF) << 21;
+        config.acceptance_mask = ((~mask & 0x7FF) << 21) | 0x1FFFFF;
+    }
+    config.single_filter = true;
+
+    return config;
+}
+
+void CanIoClass::taskLoopHelper(void* context)
+{
+    auto pInstance = static_cast<CanIoClass*>(context);
+    pInstance->taskLoop();
+}
+
+void CanIoClass::taskLoop()
+{
+    while (true) {
+        TickType_t wait = pdMS_TO_TICKS(_maxWaitMs);
+        bool more = false;
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            if (_ports.empty()) { wait = portMAX_DELAY; }
+
+            for (auto& port : _ports) {
+                bool queued = false;
+                twai_message_t message = {};
+                uint8_t reads = 0;
+
+                for (; reads < _maxFramesPerRead && port.reader(message); ++reads) {
+                    if (!matches(port.filters, message)) { continue; }
+
+                    CanFrame_t frame = { message, static_cast<uint32_t>(millis()) };
+                    if (!port.queue->push(frame)) {
+                        uint32_t dropped = ++port.dropped;
+                        // do not flood the console if the consumer is stuck
+                        if ((dropped & (dropped - 1)) == 0) {
+                            MessageOutput.printf("[CanIo] %s queue full, %u frames dropped\r\n",
+                                    port.name, dropped);
+                        }
+                        continue;
+                    }
+
+                    queued = true;
+                }
+
+                if (queued && port.notify != nullptr) { xTaskNotifyGive(port.notify); }
+
+                // the controller may hold more frames than were read
+                if (reads == _maxFramesPerRead) { more = true; }
+
+                // an interrupt output still low will not see another edge.
+                // the controllers buffer incoming frames in the meantime.
+                if (port.wakeup == Wakeup::Poll
+                        || (port.wakeup == Wakeup::Interrupt && digitalRead(port.interruptPin) == LOW)) {
+                    wait = 1;
+                }
+            }
+        }
+
+        if (more) {
+            taskYIELD();
+            continue;
+        }
+
+        ulTaskNotifyTake(pdTRUE, wait);
+    }
+}
+
+void CanIoClass::twaiLoopHelper(void* context)
+{
+    auto pInstance = static_cast<CanIoClass*>(context);
+    pInstance->twaiLoop();
+}
+
+// blocks on the TWAI driver and wakes the CAN I/O task for every frame
+void CanIoClass::twaiLoop()
+{
+    while (true) {
+        uint32_t alerts = 0;
+
+        // fails while the driver is not installed
+        if (twai_read_alerts(&alerts, portMAX_DELAY) != ESP_OK) {
+            vTaskDelay(pdMS_TO_TICKS(_maxWaitMs));
+            continue;
+        }
+
+        if (alerts & TWAI_ALERT_RX_DATA) { xTaskNotifyGive(_taskHandle); }
+    }
+}
+
+void IRAM_ATTR CanIoClass::interruptHandler(void* context)
+{
+    auto pInstance = static_cast<CanIoClass*>(context);
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
+
+    vTaskNotifyGiveFromISR(pInstance->_taskHandle, &higherPriorityTaskWoken);
+
+    if (higherPriorityTaskWoken) { portYIELD_FROM_ISR(); }
+}
@@ -9,12 +9,192 @@
 #include "defaults.h"
 #include <ArduinoJson.h>
 #include <LittleFS.h>
+#include <array>
+#include <cstddef>
+#include <esp_rom_crc.h>
 #include <nvs_flash.h>
 
 CONFIG_T config;
 
 static constexpr char TAG[] = "[Configuration]";
 
+namespace {
+
+constexpr uint32_t SectionMagic = 0x47464343; // "CCFG"
+
+// every section is stored as a copy of its part of CONFIG_T. increase the
+// version if the layout of a section changes without changing its size,
+// sections which do not match are reset to their defaults.
+struct Section_t {
+    char const* name;
+    uint16_t version;
+    size_t offset;
+    size_t size;
+};
+
+#define CONFIG_SECTION(name, member, version) { name, version, offsetof(CONFIG_T, member), sizeof(CONFIG_T::member) }
+
+constexpr Section_t Sections[] = {
+    CONFIG_SECTION("cfg", Cfg, 1),
+    CONFIG_SECTION("wifi", WiFi, 1),
+    CONFIG_SECTION("mdns", Mdns, 1),
+    CONFIG_SECTION("logging", Logging, 1),
+#ifdef USE_SYSLOG
+    CONFIG_SECTION("syslog", Syslog, 1),
+#endif
+#ifdef USE_ModbusDTU
+    CONFIG_SECTION("modbus", Modbus, 1),
+#endif
+    CONFIG_SECTION("ntp", Ntp, 1),
+    CONFIG_SECTION("mqtt", Mqtt, 1),
+    CONFIG_SECTION("dtu", Dtu, 1),
+    CONFIG_SECTION("security", Security, 1),
+#ifdef USE_DISPLAY_GRAPHIC
+    CONFIG_SECTION("display", Display, 1),
+#endif
+#if defined(USE_LED_SINGLE) || defined(USE_LED_STRIP)
+    CONFIG_SECTION("led", Led, 1),
+#endif
+    CONFIG_SECTION("vedirect", Vedirect, 1),
+    CONFIG_SECTION("powermeter", PowerMeter, 1),
+    CONFIG_SECTION("powerlimiter", PowerLimiter, 1),
+    CONFIG_SECTION("battery", Battery, 1),
+    CONFIG_SECTION("mcp2515", MCP2515, 1),
+#ifdef USE_CHARGER_HUAWEI
+    CONFIG_SECTION("huawei", Huawei, 1),
+#endif
+#ifdef USE_CHARGER_MEANWELL
+    CONFIG_SECTION("meanwell", MeanWell, 1),
+#endif
+#ifdef USE_REFUsol_INVERTER
+    CONFIG_SECTION("refusol", REFUsol, 1),
+#endif
+    CONFIG_SECTION("zeroexport", ZeroExport, 1),
+    CONFIG_SECTION("inverters", Inverter, 1),
+    CONFIG_SECTION("pinmapping", Dev_PinMapping, 1),
+};
+
+#undef CONFIG_SECTION
+
+constexpr size_t SectionCount = sizeof(Sections) / sizeof(Sections[0]);
+
+struct __attribute__((packed)) SectionHeader_t {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t size;
+    uint32_t crc; // of the data following the header
+};
+
+// checksums of the sections on flash, unchanged sections are not rewritten
+std::array<uint32_t, SectionCount> storedCrc = {};
+
+uint8_t* sectionData(Section_t const& section)
+{
+    return reinterpret_cast<uint8_t*>(&config) + section.offset;
+}
+
+uint32_t sectionCrc(Section_t const& section)
+{
+    return esp_rom_crc32_le(0, sectionData(section), section.size);
+}
+
+String sectionPath(Section_t const& section, char const* extension)
+{
+    return String(CONFIG_DIRECTORY) + "/" + section.name + extension;
+}
+
+bool readSection(size_t index)
+{
+    auto const& section = Sections[index];
+
+    File f = LittleFS.open(sectionPath(section, ".bin"), "r", false);
+    if (!f) {
+        return false;
+    }
+
+    // the data is read in place, an invalid section is overwritten afterwards
+    SectionHeader_t header;
+    bool valid = f.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) == sizeof(header)
+        && header.magic == SectionMagic && header.version == section.version && header.size == section.size
+        && f.read(sectionData(section), section.size) == section.size
+        && sectionCrc(section) == header.crc;
+    f.close();
+
+    if (valid) {
+        storedCrc[index] = header.crc;
+    } else {
+        MessageOutput.printf("%s section %s invalid\r\n", TAG, section.name);
+    }
+
+    return valid;
+}
+
+// returns true if all sections are valid
+bool readSections(std::array<bool, SectionCount>& valid)
+{
+    bool all = true;
+    for (size_t i = 0; i < SectionCount; i++) {
+        valid[i] = readSection(i);
+        all = all && valid[i];
+    }
+    return all;
+}
+
+bool writeSection(size_t index, uint32_t crc)
+{
+    auto const& section = Sections[index];
+
+    SectionHeader_t header = {};
+    header.magic = SectionMagic;
+    header.version = section.version;
+    header.size = section.size;
+    header.crc = crc;
+
+    // written to a temporary file first, a power loss keeps the old section
+    String temp = sectionPath(section, ".tmp");
+    File f = LittleFS.open(temp, "w");
+    if (!f) {
+        return false;
+    }
+
+    bool success = f.write(reinterpret_cast<uint8_t const*>(&header), sizeof(header)) == sizeof(header)
+        && f.write(sectionData(section), section.size) == section.size;
+    f.close();
+
+    if (success) {
+        success = LittleFS.rename(temp, sectionPath(section, ".bin"));
+    }
+
+    if (!success) {
+        MessageOutput.printf("%s failed to write section %s\r\n", TAG, section.name);
+        LittleFS.remove(temp);
+        return false;
+    }
+
+    storedCrc[index] = crc;
+    return true;
+}
+
+bool writeSections(bool all)
+{
+    if (!LittleFS.exists(CONFIG_DIRECTORY)) {
+        LittleFS.mkdir(CONFIG_DIRECTORY);
+    }
+
+    bool success = true;
+    for (size_t i = 0; i < SectionCount; i++) {
+        uint32_t crc = sectionCrc(Sections[i]);
+        if (!all && crc == storedCrc[i]) {
+            continue;
+        }
+        success = writeSection(i, crc) && success;
+    }
+    return success;
+}
+
+} // namespace
+
 void ConfigurationClass::init()
 {
     memset(&config, 0x0, sizeof(config));
@@ -79,13 +259,29 @@ void ConfigurationClass::serializePowerMeterHttpSmlConfig(PowerMeterHttpSmlConfi
 }
 
 bool ConfigurationClass::write()
+{
+    config.Cfg.SaveCount++;
+    return writeSections(false);
+}
+
+bool ConfigurationClass::writeJson()
 {
     File f = LittleFS.open(CONFIG_FILENAME, "w");
     if (!f) {
         return false;
     }
-    config.Cfg.SaveCount++;
 
+    bool success = exportJson(f);
+    f.close();
+
+    if (!success) {
+        LittleFS.remove(CONFIG_FILENAME);
+    }
+    return success;
+}
+
+bool ConfigurationClass::exportJson(Print& target)
+{
     JsonDocument doc;
 
     JsonObject cfg = doc["cfg"].to<JsonObject>();
@@ -107,6 +303,9 @@ bool ConfigurationClass::write()
     JsonObject mdns = doc["mdns"].to<JsonObject>();
     mdns["enabled"] = config.Mdns.Enabled;
 
+    JsonObject logging = doc["logging"].to<JsonObject>();
+    logging["level"] = config.Logging.Level;
+
 #ifdef USE_SYSLOG
     JsonObject syslog = doc["syslog"].to<JsonObject>();
     syslog["enabled"] = config.Syslog.Enabled;
@@ -145,6 +344,9 @@ bool ConfigurationClass::write()
     mqtt["topic"] = config.Mqtt.Topic;
     mqtt["retain"] = config.Mqtt.Retain;
     mqtt["publish_interval"] = config.Mqtt.PublishInterval;
+    mqtt["refresh_interval"] = config.Mqtt.RefreshInterval;
+    mqtt["json_payload"] = config.Mqtt.JsonPayload;
+    mqtt["queue_budget"] = config.Mqtt.QueueBudget;
     mqtt["clean_session"] = config.Mqtt.CleanSession;
 
     JsonObject mqtt_lwt = mqtt["lwt"].to<JsonObject>();
@@ -241,6 +443,7 @@ bool ConfigurationClass::write()
     refusol["updatesonly"] = config.REFUsol.UpdatesOnly;
     refusol["pollinterval"] = config.REFUsol.PollInterval;
     refusol["uss_address"] = config.REFUsol.USSaddress;
+    refusol["uss_address_count"] = config.REFUsol.USSaddressCount;
     refusol["baudrate"] = config.REFUsol.Baudrate;
     refusol["parity"] = config.REFUsol.Parity;
     refusol["verbose_logging"] = config.REFUsol.VerboseLogging;
@@ -325,12 +528,11 @@ bool ConfigurationClass::write()
     }
 */
     // Serialize JSON to file
-    if (serializeJson(doc, f) == 0) {
+    if (serializeJson(doc, target) == 0) {
         MessageOutput.println("Failed to write file");
         return false;
     }
 
-    f.close();
     return true;
 }
 
@@ -497,6 +699,13 @@ void ConfigurationClass::serializePowerLimiterConfig(PowerLimiterConfig const& s
     target["use_overscaling_to_compensate_shading"] = source.UseOverscalingToCompensateShading;
     target["inverter_serial"] = String(source.InverterId); //config.Inverter[config.PowerLimiter.InverterId].Serial;
     target["inverter_channel_id"] = source.InverterChannelId;
+    JsonArray additional = target["additional_inverters"].to<JsonArray>();
+    for (uint8_t i = 0; i < POWERLIMITER_MAX_ADDITIONAL_INVERTERS; i++) {
+        if (source.AdditionalInverters[i].Serial == 0) { continue; }
+        JsonObject inv = additional.add<JsonObject>();
+        inv["serial"] = String(source.AdditionalInverters[i].Serial);
+        inv["is_solar_powered"] = source.AdditionalInverters[i].IsSolarPowered;
+    }
     target["target_power_consumption"] = source.TargetPowerConsumption;
     target["target_power_consumption_hysteresis"] = source.TargetPowerConsumptionHysteresis;
     target["lower_power_limit"] = source.LowerPowerLimit;
@@ -534,6 +743,18 @@ void ConfigurationClass::deserializePowerLimiterConfig(JsonObject const& source,
     if (target.InverterId == POWERLIMITER_INVERTER_ID) // legacy
         target.InverterId = source["inverter_id"].as<uint64_t>() | POWERLIMITER_INVERTER_ID;
     target.InverterChannelId = source["inverter_channel_id"].as<uint8_t>() | POWERLIMITER_INVERTER_CHANNEL_ID;
+    if (source["additional_inverters"].is<JsonArray>()) {
+        memset(target.AdditionalInverters, 0, sizeof(target.AdditionalInverters));
+        uint8_t additionalCount = 0;
+        for (JsonObject inv : source["additional_inverters"].as<JsonArray>()) {
+            if (additionalCount >= POWERLIMITER_MAX_ADDITIONAL_INVERTERS) { break; }
+            uint64_t serial = inv["serial"].as<uint64_t>();
+            if (serial == 0 || serial == target.InverterId) { continue; }
+            target.AdditionalInverters[additionalCount].Serial = serial;
+            target.AdditionalInverters[additionalCount].IsSolarPowered = inv["is_solar_powered"] | false;
+            additionalCount++;
+        }
+    }
     target.TargetPowerConsumption = source["target_power_consumption"] | POWERLIMITER_TARGET_POWER_CONSUMPTION;
     target.TargetPowerConsumptionHysteresis = source["target_power_consumption_hysteresis"] | POWERLIMITER_TARGET_POWER_CONSUMPTION_HYSTERESIS;
     target.LowerPowerLimit = source["lower_power_limit"] | POWERLIMITER_LOWER_POWER_LIMIT;
@@ -560,12 +781,44 @@ void ConfigurationClass::deserializePowerLimiterConfig(JsonObject const& source,
 
 bool ConfigurationClass::read()
 {
+    // a json file was uploaded or left by a firmware update
+    bool import = LittleFS.exists(CONFIG_FILENAME);
+
+    std::array<bool, SectionCount> valid = {};
+    if (!import && readSections(valid)) {
+        return true;
+    }
+
+    // the json file, or the defaults for the sections which are missing
     File f = LittleFS.open(CONFIG_FILENAME, "r", false);
+    bool success = importJson(f);
+    f.close();
+
+    if (!success) {
+        return false;
+    }
+
+    // keep the sections which are still valid
+    for (size_t i = 0; i < SectionCount && !import; i++) {
+        if (valid[i]) {
+            readSection(i);
+        }
+    }
+
+    if (writeSections(import) && import) {
+        MessageOutput.printf("%s imported %s\r\n", TAG, CONFIG_FILENAME);
+        LittleFS.remove(CONFIG_FILENAME);
+    }
+
+    return true;
+}
 
+bool ConfigurationClass::importJson(Stream& source)
+{
     JsonDocument doc;
 
     // Deserialize the JSON document
-    const DeserializationError error = deserializeJson(doc, f);
+    const DeserializationError error = deserializeJson(doc, source);
     if (error) {
         MessageOutput.println("Failed to read file, using default configuration");
     }
@@ -624,6 +877,9 @@ bool ConfigurationClass::read()
     JsonObject mdns = doc["mdns"];
     config.Mdns.Enabled = mdns["enabled"] | MDNS_ENABLED;
 
+    JsonObject logging = doc["logging"];
+    config.Logging.Level = logging["level"] | LOGGING_LEVEL;
+
 #ifdef USE_SYSLOG
     JsonObject syslog = doc["syslog"];
     config.Syslog.Enabled = syslog["enabled"] | SYSLOG_ENABLED;
@@ -633,8 +889,8 @@ bool ConfigurationClass::read()
 
 #ifdef USE_ModbusDTU
     JsonObject modbus = doc["modbus"];
-    config.modbus.Modbus_tcp_enabled = modbus["modbus_tcp_enabled"] | MODBUS_ENABLED;
-    config.modbus.Modbus_delaystart = modbus["modbus_delaystart"] | MODBUS_DELAY_START;
+    config.Modbus.modbus_tcp_enabled = modbus["modbus_tcp_enabled"] | MODBUS_ENABLED;
+    config.Modbus.modbus_delaystart = modbus["modbus_delaystart"] | MODBUS_DELAY_START;
     strlcpy(config.Modbus.mfrname, modbus["mfrname"] | MODBUS_MFRNAME, sizeof(config.Modbus.mfrname));
     strlcpy(config.Modbus.modelname, modbus["modelname"] | MODBUS_MODELNAME, sizeof(config.Modbus.modelname));
     strlcpy(config.Modbus.options, modbus["options"] | MODBUS_OPTIONS, sizeof(config.Modbus.options));
@@ -661,6 +917,9 @@ bool ConfigurationClass::read()
     strlcpy(config.Mqtt.Topic, mqtt["topic"] | MQTT_TOPIC, sizeof(config.Mqtt.Topic));
     config.Mqtt.Retain = mqtt["retain"] | MQTT_RETAIN;
     config.Mqtt.PublishInterval = mqtt["publish_interval"] | MQTT_PUBLISH_INTERVAL;
+    config.Mqtt.RefreshInterval = mqtt["refresh_interval"] | MQTT_REFRESH_INTERVAL;
+    config.Mqtt.JsonPayload = mqtt["json_payload"] | MQTT_JSON_PAYLOAD;
+    config.Mqtt.QueueBudget = mqtt["queue_budget"] | MQTT_QUEUE_BUDGET;
     config.Mqtt.CleanSession = mqtt["clean_session"] | MQTT_CLEAN_SESSION;
 
     JsonObject mqtt_lwt = mqtt["lwt"];
@@ -757,6 +1016,7 @@ bool ConfigurationClass::read()
     config.REFUsol.UpdatesOnly = refusol["updatesonly"] | REFUsol_UPDATESONLY;
     config.REFUsol.PollInterval = refusol["pollinterval"] | REFUsol_POLLINTERVAL;
     config.REFUsol.USSaddress = refusol["uss_address"] | 1;
+    config.REFUsol.USSaddressCount = refusol["uss_address_count"] | 1;
     config.REFUsol.Baudrate = refusol["baudrate"] | 57600;
     config.REFUsol.Parity = refusol["parity"] | REFUsol_CONFIG_T::Parity_t::None;
     config.REFUsol.VerboseLogging = refusol["verbose_logging"] | false;
@@ -847,71 +1107,11 @@ bool ConfigurationClass::read()
     config.ZeroExport.MinimumLimit = zeroExport["MinimumLimit"] | ZERO_EXPORT_MINIMUM_LIMIT;
     config.ZeroExport.Tn = zeroExport["Tn"] | ZERO_EXPORT_TN;
 
-    f.close();
     return true;
 }
 
 void ConfigurationClass::migrate()
 {
-    File f = LittleFS.open(CONFIG_FILENAME, "r", false);
-    if (!f) {
-        MessageOutput.println("Failed to open file, cancel migration");
-        return;
-    }
-
-    JsonDocument doc;
-
-    // Deserialize the JSON document
-    const DeserializationError error = deserializeJson(doc, f);
-    if (error) {
-        MessageOutput.printf("Failed to read file, cancel migration: %s\r\n", error.c_str());
-        return;
-    }
-
-    if (!Utils::checkJsonAlloc(doc, __FUNCTION__, __LINE__)) {
-        return;
-    }
-
-    /*
-    if (config.Cfg.Version < 0x00011700) {
-        JsonArray inverters = doc["inverters"];
-        for (uint8_t i = 0; i < INV_MAX_COUNT; i++) {
-            JsonObject inv = inverters[i].as<JsonObject>();
-            JsonArray channels = inv["channels"];
-            for (uint8_t c = 0; c < INV_MAX_CHAN_COUNT; c++) {
-                config.Inverter[i].channel[c].MaxChannelPower = channels[c];
-                strlcpy(config.Inverter[i].channel[c].Name, "", sizeof(config.Inverter[i].channel[c].Name));
-            }
-        }
-    }
-
-    if (config.Cfg.Version < 0x00011800) {
-        JsonObject mqtt = doc["mqtt"];
-        config.Mqtt.PublishInterval = mqtt["publish_invterval"];
-    }
-
-    if  (config.Cfg.Version < 0x00011900) {
-        JsonObject dtu = doc["dtu"];
-        config.Dtu.Nrf.PaLevel = dtu["pa_level"];
-    }
-
-    if (config.Cfg.Version < 0x00011a00) {
-        // This migration fixes this issue: https://github.com/espressif/arduino-esp32/issues/8828
-        // It occours when migrating from Core 2.0.9 to 2.0.14
-        // which was done by updating ESP32 PlatformIO from 6.3.2 to 6.5.0
-        nvs_flash_erase();
-        nvs_flash_init();
-    }
-
-    if (config.Cfg.Version < 0x00011c00) {
-        if (!strcmp(config.Ntp.Server, NTP_SERVER_OLD)) {
-            strlcpy(config.Ntp.Server, NTP_SERVER, sizeof(config.Ntp.Server));
-        }
-    }
-    */
-
-    f.close();
-
     if (config.Cfg.Version < 0x00011b00) {
         // Convert from kHz to Hz
 #ifdef USE_RADIO_CMT
@@ -921,7 +1121,6 @@ void ConfigurationClass::migrate()
 
     config.Cfg.Version = CONFIG_VERSION;
     write();
-    read();
 }
 
 CONFIG_T& ConfigurationClass::get()
@@ -929,6 +1128,16 @@ CONFIG_T& ConfigurationClass::get()
     return config;
 }
 
+void ConfigurationClass::erase()
+{
+    for (auto const& section : Sections) {
+        LittleFS.remove(sectionPath(section, ".bin"));
+    }
+    LittleFS.rmdir(CONFIG_DIRECTORY);
+
+    storedCrc = {};
+}
+
 INVERTER_CONFIG_T* ConfigurationClass::getFreeInverterSlot()
 {
     for (uint8_t i = 0; i < INV_MAX_COUNT; i++) {
@@ -265,7 +265,7 @@ bool DalyBmsController::requestData(uint8_t data_id) // new function to request
     request_message[12] = (uint8_t)(request_message[0] + request_message[1] + request_message[2] + request_message[3]); // Checksum (Lower byte of the other bytes sum)
 
     if (_verboseLogging)
-        MessageOutput.printf("%s %d Request datapacket Nr %x\r\n", TAG, _nextRequest, data_id);
+        MessageOutput.printf(LogLevel::Verbose, "%s %d Request datapacket Nr %x\r\n", TAG, _nextRequest, data_id);
 
     _upSerial->write(request_message, sizeof(request_message));
 
@@ -319,13 +319,13 @@ void DalyBmsController::decodeData(std::vector<uint8_t> rxBuffer)
             if (checksum == it[12]) {
                 _wasActive = true;
                 if (_verboseLogging)
-                    MessageOutput.printf("%s Receive datapacket Nr %02X\r\n", TAG, it[2]);
+                    MessageOutput.printf(LogLevel::Verbose, "%s Receive datapacket Nr %02X\r\n", TAG, it[2]);
                 switch (it[2]) {
                 case Command::REQUEST_RATED_CAPACITY_CELL_VOLTAGE:
                     _stats->ratedCapacity = to_AmpHour(&it[4]); // in Ah 0.001
                     _stats->_ratedCellVoltage = to_Volt_001(&it[10]); // in V 0.001
                     if (_verboseLogging)
-                        MessageOutput.printf("%s rated capacity: %.3fAh,  rated cell voltage: %.3fV\r\n", TAG, _stats->ratedCapacity, _stats->_ratedCellVoltage);
+                        MessageOutput.printf(LogLevel::Verbose, "%s rated capacity: %.3fAh,  rated cell voltage: %.3fV\r\n", TAG, _stats->ratedCapacity, _stats->_ratedCellVoltage);
                     break;
 
                 case Command::REQUEST_ACQUISITION_BOARD_INFO:
@@ -340,7 +340,7 @@ void DalyBmsController::decodeData(std::vector<uint8_t> rxBuffer)
                     _stats->_cumulativeChargeCapacity = ToUint32(&it[4]); // in Ah
                     _stats->_cumulativeDischargeCapacity = ToUint32(&it[8]); // in Ah
                     if (_verboseLogging)
-                        MessageOutput.printf("%s cumulative charge capacity: %uAh,  cumulative discharge capacity: %uAh\r\n", TAG, _stats->_cumulativeChargeCapacity, _stats->_cumulativeDischargeCapacity);
+                        MessageOutput.printf(LogLevel::Verbose, "%s cumulative charge capacity: %uAh,  cumulative discharge capacity: %uAh\r\n", TAG, _stats->_cumulativeChargeCapacity, _stats->_cumulativeDischargeCapacity);
                     break;
 
                 case Command::REQUEST_BATTERY_TYPE_INFO:
@@ -358,7 +358,7 @@ void DalyBmsController::decodeData(std::vector<uint8_t> rxBuffer)
                         }
                         _stats->_batteryCode[it[4] * 7] = 0;
                         if (_verboseLogging)
-                            MessageOutput.printf("%s %d battery code: %s\r\n", TAG, it[4], _stats->_batteryCode);
+                            MessageOutput.printf(LogLevel::Verbose, "%s %d battery code: %s\r\n", TAG, it[4], _stats->_batteryCode);
                     }
                     break;
 
@@ -437,7 +437,7 @@ void DalyBmsController::decodeData(std::vector<uint8_t> rxBuffer)
                         _stats->_bmsSWversion[it[4] * 7] = 0;
                     }
                     if (_verboseLogging)
-                        MessageOutput.printf("%s %d bms SW version: %s\r\n", TAG, it[4], _stats->_bmsSWversion);
+                        MessageOutput.printf(LogLevel::Verbose, "%s %d bms SW version: %s\r\n", TAG, it[4], _stats->_bmsSWversion);
                     break;
 
                 case Command::REQUEST_BMS_HW_VERSION:
@@ -447,7 +447,7 @@ void DalyBmsController::decodeData(std::vector<uint8_t> rxBuffer)
                         _stats->_bmsHWversion[it[4] * 7] = 0;
                     }
                     if (_verboseLogging)
-                        MessageOutput.printf("%s %d bms HW version: %s\r\n", TAG, it[4], _stats->_bmsHWversion);
+                        MessageOutput.printf(LogLevel::Verbose, "%s %d bms HW version: %s\r\n", TAG, it[4], _stats->_bmsHWversion);
                     _stats->setManufacturer(String("Daly ") + String(_stats->_bmsHWversion));
                     break;
 
@@ -535,7 +535,7 @@ void DalyBmsController::decodeData(std::vector<uint8_t> rxBuffer)
                         }
                     }
                     if (_verboseLogging)
-                        MessageOutput.printf("%s it[4] %d\r\n", TAG, it[4]);
+                        MessageOutput.printf(LogLevel::Verbose, "%s it[4] %d\r\n", TAG, it[4]);
                     break;
 
                 case Command::REQUEST_CELL_VOLTAGE:
@@ -553,7 +553,7 @@ void DalyBmsController::decodeData(std::vector<uint8_t> rxBuffer)
                         }
                     }
                     if (_verboseLogging)
-                        MessageOutput.printf("%s it[4] %d\r\n", TAG, it[4]);
+                        MessageOutput.printf(LogLevel::Verbose, "%s it[4] %d\r\n", TAG, it[4]);
                     break;
 
                 case Command::REQUEST_CELL_BALANCE_STATES:
@@ -593,7 +593,7 @@ void DalyBmsController::decodeData(std::vector<uint8_t> rxBuffer)
                     bytes[(8 + 1) * 6 + 8] = 0;
                     _stats->_faultCode = it[11];
                     if (_verboseLogging)
-                        MessageOutput.printf("%s failure status %s, fault code: %02X\r\n", TAG, bytes, _stats->_faultCode);
+                        MessageOutput.printf(LogLevel::Verbose, "%s failure status %s, fault code: %02X\r\n", TAG, bytes, _stats->_faultCode);
                 }
                     _stats->Warning.lowVoltage = _stats->FailureStatus.levelOneCellVoltageTooLow || _stats->FailureStatus.levelOnePackVoltageTooLow;
                     _stats->Warning.highVoltage = _stats->FailureStatus.levelOneCellVoltageTooHigh || _stats->FailureStatus.levelOnePackVoltageTooHigh;
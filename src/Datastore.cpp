@@ -18,227 +18,254 @@ void DatastoreClass::init(Scheduler& scheduler)
 {
     MessageOutput.print("initialize Datastore... ");
 
+    Hoymiles.subscribeStatisticsUpdate(std::bind(&DatastoreClass::onStatisticsUpdate, this, std::placeholders::_1));
+
     scheduler.addTask(_loopTask);
     _loopTask.enable();
 
     MessageOutput.println("done");
 }
 
-void DatastoreClass::loop()
+void DatastoreClass::onStatisticsUpdate(InverterAbstract& inv)
 {
-    if (!Hoymiles.isAllRadioIdle()) {
-        _loopTask.forceNextIteration();
-        return;
-    }
-
-    uint8_t isProducing = 0;
-    uint8_t isReachable = 0;
-    uint8_t pollEnabledCount = 0;
-
     std::lock_guard<std::mutex> lock(_mutex);
 
-    _totalAcYieldTotalEnabled = 0;
-    _totalAcYieldTotalDigits = 0;
+    InverterData_t* data = nullptr;
+    for (auto& d : _inverterData) {
+        if (d.serial == inv.serial()) {
+            data = &d;
+            break;
+        }
+    }
 
-    _totalAcYieldDayEnabled = 0;
-    _totalAcYieldDayDigits = 0;
+    auto cfg = Configuration.getInverterConfig(inv.serial());
+    if (cfg == nullptr || Hoymiles.getInverterBySerial(inv.serial()) == nullptr) {
+        // inverter was removed
+        if (data != nullptr) {
+            *data = {};
+            updateTotals();
+        }
+        return;
+    }
 
-    _totalAcPowerEnabled = 0;
-    _totalAcPowerDigits = 0;
+    if (data == nullptr) {
+        for (auto& d : _inverterData) {
+            if (d.serial == 0) {
+                data = &d;
+                break;
+            }
+        }
+        if (data == nullptr) {
+            return;
+        }
+    }
 
-    _totalDcPowerEnabled = 0;
-    _totalDcPowerDigits = 0;
+    *data = {};
+    data->serial = inv.serial();
+    data->pollEnabled = inv.getEnablePolling();
+    data->producing = inv.isProducing();
+    data->reachable = inv.isReachable();
+    data->yieldEnabled = cfg->Poll_Enable_Day || cfg->Poll_Enable_Night;
 
-    _totalDcPowerIrradiation = 0;
-    _totalDcIrradiationInstalled = 0;
+    auto stats = inv.Statistics();
 
-    _isAllEnabledProducing = true;
-    _isAllEnabledReachable = true;
+    if (data->yieldEnabled) {
+        for (auto& c : stats->getChannelsByType(TYPE_INV)) {
+            data->acYieldTotal += stats->getChannelFieldValue(TYPE_INV, c, FLD_YT);
+            data->acYieldDay += stats->getChannelFieldValue(TYPE_INV, c, FLD_YD);
 
-    for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
-        auto inv = Hoymiles.getInverterByPos(i);
-        if (inv == nullptr) {
-            continue;
+            data->acYieldTotalDigits = max<unsigned int>(data->acYieldTotalDigits, stats->getChannelFieldDigits(TYPE_INV, c, FLD_YT));
+            data->acYieldDayDigits = max<unsigned int>(data->acYieldDayDigits, stats->getChannelFieldDigits(TYPE_INV, c, FLD_YD));
         }
+    }
 
-        auto cfg = Configuration.getInverterConfig(inv->serial());
-        if (cfg == nullptr) {
-            continue;
+    if (data->pollEnabled) {
+        for (auto& c : stats->getChannelsByType(TYPE_AC)) {
+            data->acPower += stats->getChannelFieldValue(TYPE_AC, c, FLD_PAC);
+            data->acPowerDigits = max<unsigned int>(data->acPowerDigits, stats->getChannelFieldDigits(TYPE_AC, c, FLD_PAC));
         }
 
-        if (inv->getEnablePolling()) {
-            pollEnabledCount++;
-        }
+        for (auto& c : stats->getChannelsByType(TYPE_DC)) {
+            data->dcPower += stats->getChannelFieldValue(TYPE_DC, c, FLD_PDC);
+            data->dcPowerDigits = max<unsigned int>(data->dcPowerDigits, stats->getChannelFieldDigits(TYPE_DC, c, FLD_PDC));
 
-        if (inv->isProducing()) {
-            isProducing++;
-        } else {
-            if (inv->getEnablePolling()) {
-                _isAllEnabledProducing = false;
+            if (stats->getStringMaxPower(c) > 0) {
+                data->dcPowerIrradiation += stats->getChannelFieldValue(TYPE_DC, c, FLD_PDC);
+                data->dcIrradiationInstalled += stats->getStringMaxPower(c);
             }
         }
+    }
 
-        if (inv->isReachable()) {
-            isReachable++;
-        } else {
-            if (inv->getEnablePolling()) {
-                _isAllEnabledReachable = false;
-            }
-        }
+    updateTotals();
+}
 
-        for (auto& c : inv->Statistics()->getChannelsByType(TYPE_INV)) {
-            if (cfg->Poll_Enable_Day || cfg->Poll_Enable_Night) {
-                _totalAcYieldTotalEnabled += inv->Statistics()->getChannelFieldValue(TYPE_INV, c, FLD_YT);
-                _totalAcYieldDayEnabled += inv->Statistics()->getChannelFieldValue(TYPE_INV, c, FLD_YD);
+// Must be called with _mutex held
+void DatastoreClass::updateTotals()
+{
+    Totals_t totals;
 
-                _totalAcYieldTotalDigits = max<unsigned int>(_totalAcYieldTotalDigits, inv->Statistics()->getChannelFieldDigits(TYPE_INV, c, FLD_YT));
-                _totalAcYieldDayDigits = max<unsigned int>(_totalAcYieldDayDigits, inv->Statistics()->getChannelFieldDigits(TYPE_INV, c, FLD_YD));
-            }
+    for (auto& d : _inverterData) {
+        if (d.serial == 0) {
+            continue;
         }
 
-        for (auto& c : inv->Statistics()->getChannelsByType(TYPE_AC)) {
-            if (inv->getEnablePolling()) {
-                _totalAcPowerEnabled += inv->Statistics()->getChannelFieldValue(TYPE_AC, c, FLD_PAC);
-                _totalAcPowerDigits = max<unsigned int>(_totalAcPowerDigits, inv->Statistics()->getChannelFieldDigits(TYPE_AC, c, FLD_PAC));
-            }
+        totals.isAtLeastOnePollEnabled |= d.pollEnabled;
+        totals.isAtLeastOneProducing |= d.producing;
+        totals.isAtLeastOneReachable |= d.reachable;
+        if (d.pollEnabled) {
+            totals.isAllEnabledProducing &= d.producing;
+            totals.isAllEnabledReachable &= d.reachable;
         }
 
-        for (auto& c : inv->Statistics()->getChannelsByType(TYPE_DC)) {
-            if (inv->getEnablePolling()) {
-                _totalDcPowerEnabled += inv->Statistics()->getChannelFieldValue(TYPE_DC, c, FLD_PDC);
-                _totalDcPowerDigits = max<unsigned int>(_totalDcPowerDigits, inv->Statistics()->getChannelFieldDigits(TYPE_DC, c, FLD_PDC));
+        totals.acYieldTotalEnabled += d.acYieldTotal;
+        totals.acYieldDayEnabled += d.acYieldDay;
+        totals.acYieldTotalDigits = max<unsigned int>(totals.acYieldTotalDigits, d.acYieldTotalDigits);
+        totals.acYieldDayDigits = max<unsigned int>(totals.acYieldDayDigits, d.acYieldDayDigits);
 
-                if (inv->Statistics()->getStringMaxPower(c) > 0) {
-                    _totalDcPowerIrradiation += inv->Statistics()->getChannelFieldValue(TYPE_DC, c, FLD_PDC);
-                    _totalDcIrradiationInstalled += inv->Statistics()->getStringMaxPower(c);
-                }
-            }
-        }
+        totals.acPowerEnabled += d.acPower;
+        totals.acPowerDigits = max<unsigned int>(totals.acPowerDigits, d.acPowerDigits);
+
+        totals.dcPowerEnabled += d.dcPower;
+        totals.dcPowerDigits = max<unsigned int>(totals.dcPowerDigits, d.dcPowerDigits);
+
+        totals.dcPowerIrradiation += d.dcPowerIrradiation;
+        totals.dcIrradiationInstalled += d.dcIrradiationInstalled;
     }
 
+    totals.dcIrradiation = totals.dcIrradiationInstalled > 0 ? totals.dcPowerIrradiation / totals.dcIrradiationInstalled * 100.0f : 0;
+
+    _totalsSequence.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    _totals = totals;
+    _totalsSequence.fetch_add(1, std::memory_order_release);
+}
+
+DatastoreClass::Totals_t DatastoreClass::getTotals() const
+{
+    Totals_t totals;
+    uint32_t sequence;
+
+    do {
+        sequence = _totalsSequence.load(std::memory_order_acquire);
+        if (sequence & 1) {
+            // writer is active, give it the chance to finish even if it
+            // runs with a lower priority on the same core
+            vTaskDelay(1);
+            continue;
+        }
+        totals = _totals;
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((sequence & 1) || sequence != _totalsSequence.load(std::memory_order_relaxed));
+
+    return totals;
+}
+
+void DatastoreClass::loop()
+{
     // Daten visualisieren #168
     struct tm timeinfo;
 
     if (getLocalTime(&timeinfo, 50)) {
+        const float totalAcYieldDay = getTotals().acYieldDayEnabled;
         float previousSum = 0.0f;
 
+        std::lock_guard<std::mutex> lock(_mutex);
+
         if (_currentDay != timeinfo.tm_mday && timeinfo.tm_sec > 10) {
             _currentDay = timeinfo.tm_mday;
             for (uint8_t i = 0; i < _hourlyPowerData.size(); i++) {
                 _hourlyPowerData[i] = 0.0f;
             }
-            previousSum = _totalAcYieldDayEnabled;
+            previousSum = totalAcYieldDay;
         }
 
         uint8_t currentHour = timeinfo.tm_hour;
         for (uint8_t hour = 0; hour < currentHour; hour++) {
             previousSum += _hourlyPowerData[hour];
         }
-        _hourlyPowerData[currentHour] = _totalAcYieldDayEnabled - previousSum;
+        _hourlyPowerData[currentHour] = totalAcYieldDay - previousSum;
     }
     // Daten visualisieren #168
-
-    _isAtLeastOneProducing = isProducing > 0;
-    _isAtLeastOneReachable = isReachable > 0;
-    _isAtLeastOnePollEnabled = pollEnabledCount > 0;
-
-    _totalDcIrradiation = _totalDcIrradiationInstalled > 0 ? _totalDcPowerIrradiation / _totalDcIrradiationInstalled * 100.0f : 0;
 }
 
 float DatastoreClass::getTotalAcYieldTotalEnabled()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _totalAcYieldTotalEnabled;
+    return getTotals().acYieldTotalEnabled;
 }
 
 float DatastoreClass::getTotalAcYieldDayEnabled()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _totalAcYieldDayEnabled;
+    return getTotals().acYieldDayEnabled;
 }
 
 float DatastoreClass::getTotalAcPowerEnabled()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _totalAcPowerEnabled;
+    return getTotals().acPowerEnabled;
 }
 
 float DatastoreClass::getTotalDcPowerEnabled()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _totalDcPowerEnabled;
+    return getTotals().dcPowerEnabled;
 }
 
 float DatastoreClass::getTotalDcPowerIrradiation()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _totalDcPowerIrradiation;
+    return getTotals().dcPowerIrradiation;
 }
 
 float DatastoreClass::getTotalDcIrradiationInstalled()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _totalDcIrradiationInstalled;
+    return getTotals().dcIrradiationInstalled;
 }
 
 float DatastoreClass::getTotalDcIrradiation()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _totalDcIrradiation;
+    return getTotals().dcIrradiation;
 }
 
 unsigned int DatastoreClass::getTotalAcYieldTotalDigits()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _totalAcYieldTotalDigits;
+    return getTotals().acYieldTotalDigits;
 }
 
 unsigned int DatastoreClass::getTotalAcYieldDayDigits()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _totalAcYieldDayDigits;
+    return getTotals().acYieldDayDigits;
 }
 
 unsigned int DatastoreClass::getTotalAcPowerDigits()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _totalAcPowerDigits;
+    return getTotals().acPowerDigits;
 }
 
 unsigned int DatastoreClass::getTotalDcPowerDigits()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _totalDcPowerDigits;
+    return getTotals().dcPowerDigits;
 }
 
 bool DatastoreClass::getIsAtLeastOneReachable()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _isAtLeastOneReachable;
+    return getTotals().isAtLeastOneReachable;
 }
 
 bool DatastoreClass::getIsAtLeastOneProducing()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _isAtLeastOneProducing;
+    return getTotals().isAtLeastOneProducing;
 }
 
 bool DatastoreClass::getIsAllEnabledProducing()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _isAllEnabledProducing;
+    return getTotals().isAllEnabledProducing;
 }
 
 bool DatastoreClass::getIsAllEnabledReachable()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _isAllEnabledReachable;
+    return getTotals().isAllEnabledReachable;
 }
 
 bool DatastoreClass::getIsAtLeastOnePollEnabled()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _isAtLeastOnePollEnabled;
+    return getTotals().isAtLeastOnePollEnabled;
 }
 
 // Daten visualisieren #168
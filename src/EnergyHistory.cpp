@@ -0,0 +1,695 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "EnergyHistory.h"
+#include "Battery.h"
+#include "Configuration.h"
+#include "Datastore.h"
+#include "MessageOutput.h"
+#include "PowerMeter.h"
+#include "VictronMppt.h"
+#include <LittleFS.h>
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <ctime>
+
+EnergyHistoryClass EnergyHistory;
+
+namespace {
+
+constexpr char const* HistoryDirectory = "/history";
+constexpr uint32_t SegmentMagic = 0x48594e45; // "ENYH"
+constexpr uint8_t SegmentVersion = 1;
+
+constexpr uint32_t SampleInterval = 10; // seconds
+constexpr float MaxSampleSeconds = 30; // the task was delayed, don't extrapolate further
+constexpr uint32_t ValidTime = 1577836800; // 2020-01-01, the clock was not set before
+constexpr float MaxYieldStep = 2; // kWh, larger jumps come from devices going on- or offline
+constexpr size_t MinFreeBytes = 24 * 1024; // keep room for the configuration
+
+struct TierConfig_t {
+    char const* name;
+    uint16_t scale; // Wh per unit of the records
+    uint16_t recordsPerSegment;
+    uint8_t maxSegments;
+    uint8_t bufferedRecords; // written at once to save flash cycles
+    uint32_t seconds; // nominal length of a period
+};
+
+// header and records of a full segment fill exactly one 4 KiB block
+constexpr uint16_t RecordsPerBlock = 255;
+
+constexpr std::array<TierConfig_t, EnergyHistoryClass::TierCount> TierConfigs = {{
+    { "minute", 1, RecordsPerBlock, 6, 15, 60 }, // ~1 day
+    { "hour", 1, RecordsPerBlock, 5, 1, 3600 }, // ~6 weeks
+    { "day", 10, RecordsPerBlock, 3, 1, 86400 }, // ~1.5 years
+    { "month", 100, RecordsPerBlock, 2, 1, 2629800 }, // ~21 years
+}};
+
+constexpr std::array<char const*, EnergyHistoryClass::ChannelCount> ChannelNames = {
+    "ac_yield", "dc_yield", "mppt_yield", "grid_import", "grid_export"
+};
+
+TierConfig_t const& tierConfig(EnergyHistoryClass::Tier tier)
+{
+    return TierConfigs[static_cast<size_t>(tier)];
+}
+
+size_t freeBytes()
+{
+    return LittleFS.totalBytes() - LittleFS.usedBytes();
+}
+
+} // namespace
+
+EnergyHistoryClass::EnergyHistoryClass()
+    : _loopTask(SampleInterval * TASK_SECOND, TASK_FOREVER, std::bind(&EnergyHistoryClass::loop, this))
+{
+}
+
+void EnergyHistoryClass::init(Scheduler& scheduler)
+{
+    MessageOutput.print("initialize energy history... ");
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        loadSegments();
+    }
+
+    scheduler.addTask(_loopTask);
+    _loopTask.enable();
+
+    MessageOutput.println("done");
+}
+
+char const* EnergyHistoryClass::getTierName(Tier tier)
+{
+    return tierConfig(tier).name;
+}
+
+bool EnergyHistoryClass::getTierByName(char const* name, Tier& tier)
+{
+    for (size_t i = 0; i < TierCount; ++i) {
+        if (strcmp(TierConfigs[i].name, name) == 0) {
+            tier = static_cast<Tier>(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+char const* EnergyHistoryClass::getChannelName(uint8_t channel)
+{
+    return (channel < ChannelCount) ? ChannelNames[channel] : "";
+}
+
+void EnergyHistoryClass::loop()
+{
+    time_t now = time(nullptr);
+    if (now < ValidTime) { return; }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (!_restored) {
+        restorePeriods(now);
+        _restored = true;
+    }
+
+    auto& minute = state(Tier::Minute).period;
+    uint32_t millisNow = millis();
+
+    if (minute.start != 0) {
+        sample(minute, std::min((millisNow - _lastSampleMillis) / 1000.0f, MaxSampleSeconds));
+    }
+    _lastSampleMillis = millisNow;
+
+    uint32_t start = periodStart(Tier::Minute, now);
+    if (minute.start != 0 && minute.start != start) { closeMinute(); }
+    if (minute.start == 0) { minute.start = start; }
+}
+
+// only counts the yield counters if they moved plausibly
+static void addYieldDelta(std::array<float, EnergyHistoryClass::ChannelCount>& energy,
+        uint8_t channel, float total, float& lastTotal)
+{
+    float delta = total - lastTotal;
+    if (lastTotal > 0 && delta >= 0 && delta < MaxYieldStep) {
+        energy[channel] += delta * 1000;
+    }
+    lastTotal = total;
+}
+
+void EnergyHistoryClass::sample(Period_t& period, float seconds)
+{
+    auto const& config = Configuration.get();
+
+    if (Datastore.getIsAtLeastOnePollEnabled()) {
+        period.valid |= (1 << AcYield) | (1 << DcYield);
+        addYieldDelta(period.energy, AcYield, Datastore.getTotalAcYieldTotalEnabled(), _lastAcYieldTotal);
+        period.energy[DcYield] += Datastore.getTotalDcPowerEnabled() * seconds / 3600;
+    }
+
+    if (VictronMppt.isDataValid()) {
+        period.valid |= 1 << MpptYield;
+        addYieldDelta(period.energy, MpptYield, VictronMppt.getYieldTotal(), _lastMpptYieldTotal);
+    }
+
+    if (config.PowerMeter.Enabled && PowerMeter.isDataValid()) {
+        period.valid |= (1 << GridImport) | (1 << GridExport);
+        float power = PowerMeter.getPowerTotal();
+        if (power > 0) {
+            period.energy[GridImport] += power * seconds / 3600;
+        } else {
+            period.energy[GridExport] -= power * seconds / 3600;
+        }
+    }
+
+    if (config.Battery.Enabled) {
+        auto stats = Battery.getStats();
+
+        if (stats->getVoltageAgeSeconds() < 60) {
+            period.valid |= BatteryValid;
+            period.batteryEnergy += stats->getVoltage() * stats->getChargeCurrent() * seconds / 3600;
+            period.batterySeconds += seconds;
+        }
+
+        if (stats->getSoCAgeSeconds() < 60) {
+            period.valid |= BatteryValid;
+            period.soc = std::clamp<long>(std::lround(stats->getSoC()), 0, 100);
+        }
+    }
+}
+
+void EnergyHistoryClass::closeMinute()
+{
+    Entry_t entry = finishPeriod(Tier::Minute);
+    append(Tier::Minute, entry);
+
+    // the higher tiers are summed up from the minutes, a period is appended
+    // once the first minute of the next one arrives
+    for (size_t t = 1; t < TierCount; ++t) {
+        auto tier = static_cast<Tier>(t);
+        auto& period = state(tier).period;
+        uint32_t start = periodStart(tier, entry.time);
+
+        if (period.start != 0 && period.start != start) { append(tier, finishPeriod(tier)); }
+        if (period.start == 0) { period.start = start; }
+
+        addEntry(period, entry, tierConfig(Tier::Minute).seconds);
+    }
+}
+
+// sums up the periods of the higher tiers again after a restart. periods
+// which ended while the device was off are appended as well.
+void EnergyHistoryClass::restorePeriods(uint32_t now)
+{
+    std::vector<Entry_t> entries;
+
+    for (size_t t = 1; t < TierCount; ++t) {
+        auto tier = static_cast<Tier>(t);
+        auto lower = static_cast<Tier>(t - 1);
+        auto& tierState = state(tier);
+        auto& period = tierState.period;
+
+        auto addToPeriod = [&](uint32_t start) {
+            if (period.start != 0 && period.start != start) { append(tier, finishPeriod(tier)); }
+            if (period.start == 0) { period.start = start; }
+        };
+
+        Cursor_t cursor = { lower, tierState.lastTime, UINT32_MAX };
+        size_t count;
+        do {
+            count = readLocked(cursor, entries, 32);
+            for (auto const& entry : entries) {
+                uint32_t start = periodStart(tier, entry.time);
+                if (tierState.lastTime != 0 && start <= tierState.lastTime) { continue; }
+
+                addToPeriod(start);
+                addEntry(period, entry, tierConfig(lower).seconds);
+            }
+        } while (count == 32);
+
+        auto const& lowerPeriod = state(lower).period;
+        if (lowerPeriod.start != 0) {
+            addToPeriod(periodStart(tier, lowerPeriod.start));
+            addPeriod(period, lowerPeriod);
+        }
+
+        if (period.start != 0 && period.start != periodStart(tier, now)) {
+            append(tier, finishPeriod(tier));
+        }
+    }
+}
+
+EnergyHistoryClass::Entry_t EnergyHistoryClass::finishPeriod(Tier tier)
+{
+    auto& tierState = state(tier);
+    auto const& period = tierState.period;
+    uint16_t scale = tierConfig(tier).scale;
+
+    Entry_t entry = {};
+    entry.time = period.start;
+    entry.valid = period.valid;
+    entry.soc = period.soc;
+
+    if (period.batterySeconds > 0) {
+        long power = std::lround(period.batteryEnergy * 3600 / period.batterySeconds);
+        entry.batteryPower = std::clamp<long>(power, INT16_MIN, INT16_MAX);
+    }
+
+    // the remainder of the scaling is added to the next period
+    for (size_t c = 0; c < ChannelCount; ++c) {
+        float energy = period.energy[c] + tierState.carry[c];
+        uint32_t units = std::min<uint32_t>(energy / scale, UINT16_MAX);
+        entry.energy[c] = units * scale;
+        tierState.carry[c] = (units < UINT16_MAX) ? energy - entry.energy[c] : 0;
+    }
+
+    tierState.period = {};
+    return entry;
+}
+
+void EnergyHistoryClass::addEntry(Period_t& period, Entry_t const& entry, uint32_t seconds)
+{
+    period.valid |= entry.valid;
+
+    for (size_t c = 0; c < ChannelCount; ++c) {
+        period.energy[c] += entry.energy[c];
+    }
+
+    if (entry.valid & BatteryValid) {
+        period.batteryEnergy += entry.batteryPower * (seconds / 3600.0f);
+        period.batterySeconds += seconds;
+    }
+
+    if (entry.soc != SocUnknown) { period.soc = entry.soc; }
+}
+
+void EnergyHistoryClass::addPeriod(Period_t& period, Period_t const& other)
+{
+    period.valid |= other.valid;
+
+    for (size_t c = 0; c < ChannelCount; ++c) {
+        period.energy[c] += other.energy[c];
+    }
+
+    period.batteryEnergy += other.batteryEnergy;
+    period.batterySeconds += other.batterySeconds;
+
+    if (other.soc != SocUnknown) { period.soc = other.soc; }
+}
+
+void EnergyHistoryClass::append(Tier tier, Entry_t const& entry)
+{
+    auto& tierState = state(tier);
+
+    // the clock went backwards, the segments have to stay sorted
+    if (tierState.lastTime != 0 && entry.time <= tierState.lastTime) { return; }
+
+    tierState.lastTime = entry.time;
+    tierState.buffer.push_back(entry);
+
+    if (tierState.buffer.size() >= tierConfig(tier).bufferedRecords) {
+        writeBuffer(tier);
+    }
+}
+
+void EnergyHistoryClass::writeBuffer(Tier tier)
+{
+    auto& tierState = state(tier);
+    auto const& config = tierConfig(tier);
+
+    File file;
+    uint32_t fileSequence = 0;
+    size_t written = 0;
+
+    for (auto const& entry : tierState.buffer) {
+        Segment_t* segment = tierState.segments.empty() ? nullptr : &tierState.segments.back();
+
+        if (segment == nullptr || segment->sealed || segment->count >= config.recordsPerSegment
+                || periodOffset(tier, segment->start, entry.time) > UINT16_MAX) {
+            if (file) { file.close(); }
+            if (!createSegment(tier, entry.time)) { break; }
+            segment = &tierState.segments.back();
+        }
+
+        if (!file || fileSequence != segment->sequence) {
+            char path[40];
+            segmentPath(tier, segment->sequence, path, sizeof(path));
+            file = LittleFS.open(path, "a");
+            fileSequence = segment->sequence;
+            if (!file) { break; }
+        }
+
+        Record_t record = {};
+        record.offset = periodOffset(tier, segment->start, entry.time);
+        record.valid = entry.valid;
+        record.soc = entry.soc;
+        record.batteryPower = entry.batteryPower;
+        for (size_t c = 0; c < ChannelCount; ++c) {
+            record.energy[c] = entry.energy[c] / config.scale;
+        }
+
+        if (file.write(reinterpret_cast<uint8_t const*>(&record), sizeof(record)) != sizeof(record)) {
+            // the segment may end with a partial record now
+            segment->sealed = true;
+            break;
+        }
+
+        ++segment->count;
+        ++written;
+    }
+
+    if (file) { file.close(); }
+
+    // records which could not be written are dropped, keeping them would
+    // only fill the memory while the file system is full
+    if (written < tierState.buffer.size()) {
+        MessageOutput.printf("[EnergyHistory] ERROR: %zu %s records lost\r\n",
+                tierState.buffer.size() - written, config.name);
+    }
+
+    tierState.buffer.clear();
+}
+
+bool EnergyHistoryClass::createSegment(Tier tier, uint32_t start)
+{
+    auto& tierState = state(tier);
+
+    while (tierState.segments.size() >= tierConfig(tier).maxSegments) {
+        removeOldestSegment(tier);
+    }
+
+    if (freeBytes() < MinFreeBytes && !tierState.segments.empty()) {
+        removeOldestSegment(tier);
+    }
+
+    if (freeBytes() < MinFreeBytes) {
+        MessageOutput.printf("[EnergyHistory] ERROR: file system full\r\n");
+        return false;
+    }
+
+    if (!LittleFS.exists(HistoryDirectory)) {
+        LittleFS.mkdir(HistoryDirectory);
+    }
+
+    SegmentHeader_t header = {};
+    header.magic = SegmentMagic;
+    header.version = SegmentVersion;
+    header.tier = static_cast<uint8_t>(tier);
+    header.start = start;
+    header.sequence = _nextSequence;
+
+    char path[40];
+    segmentPath(tier, header.sequence, path, sizeof(path));
+
+    File file = LittleFS.open(path, "w");
+    if (!file) {
+        MessageOutput.printf("[EnergyHistory] ERROR: cannot create %s\r\n", path);
+        return false;
+    }
+
+    bool success = file.write(reinterpret_cast<uint8_t const*>(&header), sizeof(header)) == sizeof(header);
+    file.close();
+
+    if (!success) {
+        LittleFS.remove(path);
+        return false;
+    }
+
+    tierState.segments.push_back({ _nextSequence++, start, 0, false });
+    return true;
+}
+
+void EnergyHistoryClass::removeOldestSegment(Tier tier)
+{
+    auto& segments = state(tier).segments;
+    if (segments.empty()) { return; }
+
+    char path[40];
+    segmentPath(tier, segments.front().sequence, path, sizeof(path));
+    LittleFS.remove(path);
+
+    segments.erase(segments.begin());
+}
+
+void EnergyHistoryClass::loadSegments()
+{
+    File dir = LittleFS.open(HistoryDirectory);
+    if (!dir || !dir.isDirectory()) { return; }
+
+    std::vector<String> invalid;
+
+    for (File file = dir.openNextFile(); file; file = dir.openNextFile()) {
+        // depending on the core version the name includes the directory
+        String name = file.name();
+        int slash = name.lastIndexOf('/');
+        if (slash >= 0) { name = name.substring(slash + 1); }
+
+        SegmentHeader_t header;
+        size_t size = file.size();
+        bool valid = !file.isDirectory() && size >= sizeof(header)
+            && file.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) == sizeof(header)
+            && header.magic == SegmentMagic && header.version == SegmentVersion
+            && header.tier < TierCount;
+        file.close();
+
+        char path[40];
+        if (valid) {
+            segmentPath(static_cast<Tier>(header.tier), header.sequence, path, sizeof(path));
+            valid = name == strrchr(path, '/') + 1;
+        }
+
+        if (!valid) {
+            invalid.push_back(String(HistoryDirectory) + "/" + name);
+            continue;
+        }
+
+        size_t records = (size - sizeof(header)) / sizeof(Record_t);
+
+        Segment_t segment;
+        segment.sequence = header.sequence;
+        segment.start = header.start;
+        segment.count = std::min<size_t>(records, RecordsPerBlock);
+        segment.sealed = (size - sizeof(header)) % sizeof(Record_t) != 0;
+
+        _tiers[header.tier].segments.push_back(segment);
+        _nextSequence = std::max(_nextSequence, header.sequence + 1);
+    }
+
+    dir.close();
+
+    for (auto const& path : invalid) {
+        MessageOutput.printf("[EnergyHistory] removing invalid file %s\r\n", path.c_str());
+        LittleFS.remove(path);
+    }
+
+    for (size_t t = 0; t < TierCount; ++t) {
+        auto tier = static_cast<Tier>(t);
+        auto& segments = _tiers[t].segments;
+
+        std::sort(segments.begin(), segments.end(),
+            [](Segment_t const& a, Segment_t const& b) { return a.sequence < b.sequence; });
+
+        // time of the last record, later records must not be older
+        for (auto it = segments.rbegin(); it != segments.rend(); ++it) {
+            if (it->count == 0) { continue; }
+
+            std::vector<Entry_t> entries;
+            Cursor_t cursor = { tier, 0, UINT32_MAX, it->sequence, static_cast<uint16_t>(it->count - 1) };
+            if (readSegment(tier, *it, cursor, entries, 1) > 0) {
+                _tiers[t].lastTime = entries.front().time;
+            }
+            break;
+        }
+    }
+}
+
+size_t EnergyHistoryClass::readSegment(Tier tier, Segment_t const& segment, Cursor_t& cursor, std::vector<Entry_t>& entries, size_t maxCount)
+{
+    auto const& config = tierConfig(tier);
+    size_t found = 0;
+
+    // all records before the one following the last returned entry are older
+    uint16_t index = (segment.sequence == cursor.sequence) ? cursor.index : 0;
+
+    char path[40];
+    segmentPath(tier, segment.sequence, path, sizeof(path));
+
+    File file = LittleFS.open(path, "r");
+    if (!file) { return 0; }
+
+    if (!file.seek(sizeof(SegmentHeader_t) + index * sizeof(Record_t))) {
+        file.close();
+        return 0;
+    }
+
+    std::array<Record_t, 16> records;
+
+    while (index < segment.count && entries.size() < maxCount) {
+        size_t count = std::min<size_t>(records.size(), segment.count - index);
+        size_t bytes = count * sizeof(Record_t);
+        if (file.read(reinterpret_cast<uint8_t*>(records.data()), bytes) != bytes) { break; }
+
+        for (size_t i = 0; i < count && entries.size() < maxCount; ++i) {
+            auto const& record = records[i];
+            ++index;
+
+            uint32_t time = periodTime(tier, segment.start, record.offset);
+            if (time >= cursor.to) {
+                cursor.from = cursor.to;
+                file.close();
+                return found;
+            }
+            if (time < cursor.from) { continue; }
+
+            Entry_t entry;
+            entry.time = time;
+            entry.valid = record.valid;
+            entry.soc = record.soc;
+            entry.batteryPower = record.batteryPower;
+            for (size_t c = 0; c < ChannelCount; ++c) {
+                entry.energy[c] = record.energy[c] * config.scale;
+            }
+            entries.push_back(entry);
+            ++found;
+
+            cursor.from = time + 1;
+            cursor.sequence = segment.sequence;
+            cursor.index = index;
+        }
+    }
+
+    file.close();
+    return found;
+}
+
+size_t EnergyHistoryClass::read(Cursor_t& cursor, std::vector<Entry_t>& entries, size_t maxCount)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return readLocked(cursor, entries, maxCount);
+}
+
+size_t EnergyHistoryClass::readLocked(Cursor_t& cursor, std::vector<Entry_t>& entries, size_t maxCount)
+{
+    entries.clear();
+
+    auto const& tierState = state(cursor.tier);
+    auto const& segments = tierState.segments;
+
+    for (size_t i = 0; i < segments.size() && entries.size() < maxCount; ++i) {
+        if (cursor.from >= cursor.to || segments[i].start >= cursor.to) { break; }
+
+        // all records of a segment are older than the start of the next one
+        if (i + 1 < segments.size() && segments[i + 1].start <= cursor.from) { continue; }
+
+        readSegment(cursor.tier, segments[i], cursor, entries, maxCount);
+    }
+
+    for (auto const& entry : tierState.buffer) {
+        if (entries.size() >= maxCount) { break; }
+        if (entry.time < cursor.from || entry.time >= cursor.to) { continue; }
+
+        entries.push_back(entry);
+        cursor.from = entry.time + 1;
+    }
+
+    return entries.size();
+}
+
+void EnergyHistoryClass::flush()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (size_t t = 0; t < TierCount; ++t) {
+        if (!_tiers[t].buffer.empty()) { writeBuffer(static_cast<Tier>(t)); }
+    }
+}
+
+void EnergyHistoryClass::reset()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (auto& tierState : _tiers) { tierState = {}; }
+
+    File dir = LittleFS.open(HistoryDirectory);
+    if (!dir || !dir.isDirectory()) { return; }
+
+    std::vector<String> files;
+    for (File file = dir.openNextFile(); file; file = dir.openNextFile()) {
+        String name = file.name();
+        int slash = name.lastIndexOf('/');
+        if (slash >= 0) { name = name.substring(slash + 1); }
+        files.push_back(String(HistoryDirectory) + "/" + name);
+        file.close();
+    }
+    dir.close();
+
+    for (auto const& path : files) { LittleFS.remove(path); }
+    LittleFS.rmdir(HistoryDirectory);
+}
+
+uint32_t EnergyHistoryClass::periodStart(Tier tier, uint32_t time)
+{
+    if (tier == Tier::Minute) { return time - time % 60; }
+
+    // hours, days and months follow the local time
+    time_t t = time;
+    struct tm local;
+    localtime_r(&t, &local);
+
+    local.tm_sec = 0;
+    local.tm_min = 0;
+    if (tier != Tier::Hour) { local.tm_hour = 0; }
+    if (tier == Tier::Month) { local.tm_mday = 1; }
+    local.tm_isdst = -1;
+
+    return mktime(&local);
+}
+
+uint32_t EnergyHistoryClass::periodOffset(Tier tier, uint32_t start, uint32_t time)
+{
+    switch (tier) {
+    case Tier::Minute:
+        return (time - start) / 60;
+    case Tier::Hour:
+        return (time - start + 1800) / 3600;
+    case Tier::Day:
+        // days are 23 or 25 hours long when the daylight saving time changes
+        return (time - start + 43200) / 86400;
+    case Tier::Month: {
+        time_t a = start;
+        time_t b = time;
+        struct tm first, last;
+        localtime_r(&a, &first);
+        localtime_r(&b, &last);
+        return (last.tm_year - first.tm_year) * 12 + last.tm_mon - first.tm_mon;
+    }
+    }
+
+    return 0;
+}
+
+uint32_t EnergyHistoryClass::periodTime(Tier tier, uint32_t start, uint32_t offset)
+{
+    if (tier == Tier::Minute) { return start + offset * 60; }
+    if (tier == Tier::Hour) { return start + offset * 3600; }
+
+    time_t t = start;
+    struct tm local;
+    localtime_r(&t, &local);
+
+    if (tier == Tier::Day) {
+        local.tm_mday += offset;
+    } else {
+        local.tm_mon += offset;
+    }
+    local.tm_isdst = -1;
+
+    return mktime(&local);
+}
+
+void EnergyHistoryClass::segmentPath(Tier tier, uint32_t sequence, char* path, size_t size)
+{
+    snprintf(path, size, "%s/%s-%08" PRIu32 ".bin", HistoryDirectory, tierConfig(tier).name, sequence);
+}
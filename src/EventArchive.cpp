@@ -0,0 +1,375 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "EventArchive.h"
+#include "MessageOutput.h"
+#include <Hoymiles.h>
+#include <LittleFS.h>
+#include <algorithm>
+#include <cinttypes>
+#include <ctime>
+
+EventArchiveClass EventArchive;
+
+namespace {
+
+constexpr char const* ArchiveDirectory = "/events";
+constexpr uint32_t ArchiveMagic = 0x56455645; // "EVEV"
+constexpr uint8_t ArchiveVersion = 1;
+
+constexpr uint32_t PollInterval = 5; // seconds
+constexpr uint32_t ValidTime = 1577836800; // 2020-01-01, the clock was not set before
+constexpr uint32_t MaxClockSkew = 600; // seconds the inverter's clock may be ahead
+constexpr size_t MinFreeBytes = 16 * 1024; // keep room for the configuration
+
+size_t freeBytes()
+{
+    return LittleFS.totalBytes() - LittleFS.usedBytes();
+}
+
+uint32_t secondsOfDay(time_t time)
+{
+    return ((time % 86400) + 86400) % 86400;
+}
+
+// the time of the day as reported by the inverter
+uint32_t localSecondsOfDay(uint32_t unixTime)
+{
+    time_t t = unixTime;
+    struct tm local;
+    localtime_r(&t, &local);
+    return local.tm_hour * 3600 + local.tm_min * 60 + local.tm_sec;
+}
+
+} // namespace
+
+EventArchiveClass::EventArchiveClass()
+    : _loopTask(PollInterval * TASK_SECOND, TASK_FOREVER, std::bind(&EventArchiveClass::loop, this))
+{
+}
+
+void EventArchiveClass::init(Scheduler& scheduler)
+{
+    MessageOutput.print("initialize event archive... ");
+
+    scheduler.addTask(_loopTask);
+    _loopTask.enable();
+
+    MessageOutput.println("done");
+}
+
+void EventArchiveClass::loop()
+{
+    time_t now = time(nullptr);
+    if (now < ValidTime) { return; }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
+        auto inv = Hoymiles.getInverterByPos(i);
+        if (inv == nullptr) { continue; }
+
+        uint32_t lastUpdate = inv->EventLog()->getLastUpdate();
+        if (lastUpdate == 0) { continue; }
+
+        auto& archive = getArchive(inv->serial());
+        if (archive.lastUpdate == lastUpdate) { continue; }
+
+        merge(archive, *inv->EventLog());
+        archive.lastUpdate = lastUpdate;
+    }
+}
+
+// the inverter reports the times as seconds of the day, the events are
+// assigned to the last 24 hours
+uint32_t EventArchiveClass::toUnixTime(time_t timeOfDay, uint32_t now)
+{
+    time_t t = now;
+    struct tm local;
+    localtime_r(&t, &local);
+
+    local.tm_hour = 0;
+    local.tm_min = 0;
+    local.tm_sec = secondsOfDay(timeOfDay);
+    local.tm_isdst = -1;
+    time_t result = mktime(&local);
+
+    if (result > static_cast<time_t>(now + MaxClockSkew)) {
+        local.tm_mday -= 1;
+        local.tm_isdst = -1;
+        result = mktime(&local);
+    }
+
+    return result;
+}
+
+void EventArchiveClass::merge(Archive_t& archive, AlarmLogParser& log)
+{
+    uint32_t now = time(nullptr);
+    std::vector<Record_t> added;
+
+    for (uint8_t i = 0; i < log.getEntryCount(); i++) {
+        uint16_t messageId;
+        time_t startTime;
+        time_t endTime;
+        log.getRawLogEntry(i, messageId, startTime, endTime);
+
+        // the log of an inverter running through the night spans several
+        // days. dating a known event against now would move it to today.
+        uint32_t startOfDay = secondsOfDay(startTime);
+        auto known = std::find_if(archive.recent.rbegin(), archive.recent.rend(), [&](Recent_t const& r) {
+            return r.inLog && !r.matched && r.record.messageId == messageId
+                && localSecondsOfDay(r.record.startTime) == startOfDay;
+        });
+
+        Record_t record = {};
+        record.startTime = (known != archive.recent.rend()) ? known->record.startTime : toUnixTime(startTime, now);
+        record.messageId = messageId;
+        record.messageType = static_cast<uint8_t>(log.getMessageType());
+
+        if (endTime > 0) {
+            uint32_t duration = (secondsOfDay(endTime) + 86400 - startOfDay) % 86400;
+            record.endTime = record.startTime + duration;
+        }
+
+        if (known == archive.recent.rend()) {
+            added.push_back(record);
+            continue;
+        }
+
+        known->matched = true;
+
+        if (known->record.endTime != record.endTime) {
+            known->record.endTime = record.endTime;
+            writeRecord(archive, known->slot, known->record);
+        }
+    }
+
+    // events which left the log can not be reported again
+    for (auto& r : archive.recent) {
+        r.inLog = r.matched;
+        r.matched = false;
+    }
+
+    std::sort(added.begin(), added.end(), [](Record_t const& a, Record_t const& b) { return a.startTime < b.startTime; });
+
+    for (auto const& record : added) { store(archive, record); }
+}
+
+void EventArchiveClass::store(Archive_t& archive, Record_t const& record)
+{
+    auto& header = archive.header;
+    uint16_t slot = header.head;
+
+    header.head = (header.head + 1) % Capacity;
+    header.count = std::min<uint16_t>(header.count + 1, Capacity);
+
+    if (!writeRecord(archive, slot, record)) {
+        // the file is rewritten from scratch on the next event
+        archive.header = {};
+        archive.recent.clear();
+        return;
+    }
+
+    archive.recent.push_back({ record, slot });
+    if (archive.recent.size() > RecentCount) { archive.recent.erase(archive.recent.begin()); }
+}
+
+bool EventArchiveClass::writeRecord(Archive_t& archive, uint16_t slot, Record_t const& record)
+{
+    char path[40];
+    archivePath(archive.serial, path, sizeof(path));
+
+    if (archive.header.magic != ArchiveMagic) {
+        if (freeBytes() < MinFreeBytes) {
+            MessageOutput.printf("[EventArchive] ERROR: file system full\r\n");
+            return false;
+        }
+
+        if (!LittleFS.exists(ArchiveDirectory)) {
+            LittleFS.mkdir(ArchiveDirectory);
+        }
+
+        File file = LittleFS.open(path, "w");
+        if (!file) {
+            MessageOutput.printf("[EventArchive] ERROR: cannot create %s\r\n", path);
+            return false;
+        }
+        file.close();
+
+        archive.header.magic = ArchiveMagic;
+        archive.header.version = ArchiveVersion;
+        archive.header.capacity = Capacity;
+    }
+
+    File file = LittleFS.open(path, "r+");
+    if (!file) {
+        MessageOutput.printf("[EventArchive] ERROR: cannot open %s\r\n", path);
+        return false;
+    }
+
+    // the records are written in place, the file grows until the ring is full
+    bool success = file.seek(sizeof(FileHeader_t) + slot * sizeof(Record_t))
+        && file.write(reinterpret_cast<uint8_t const*>(&record), sizeof(record)) == sizeof(record)
+        && file.seek(0)
+        && file.write(reinterpret_cast<uint8_t const*>(&archive.header), sizeof(FileHeader_t)) == sizeof(FileHeader_t);
+    file.close();
+
+    if (!success) {
+        MessageOutput.printf("[EventArchive] ERROR: cannot write %s\r\n", path);
+        LittleFS.remove(path);
+    }
+
+    return success;
+}
+
+void EventArchiveClass::load(Archive_t& archive)
+{
+    char path[40];
+    archivePath(archive.serial, path, sizeof(path));
+    if (!LittleFS.exists(path)) { return; }
+
+    File file = LittleFS.open(path, "r");
+    if (!file) { return; }
+
+    FileHeader_t header;
+    bool valid = file.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) == sizeof(header)
+        && header.magic == ArchiveMagic && header.version == ArchiveVersion
+        && header.capacity == Capacity && header.count <= Capacity && header.head < Capacity
+        && file.size() >= sizeof(header) + header.count * sizeof(Record_t);
+
+    if (valid) {
+        archive.header = header;
+
+        size_t recent = std::min<size_t>(header.count, RecentCount);
+        for (size_t i = recent; i > 0; i--) {
+            uint16_t slot = (header.head + Capacity - i) % Capacity;
+
+            Recent_t entry;
+            entry.slot = slot;
+            valid = file.seek(sizeof(header) + slot * sizeof(Record_t))
+                && file.read(reinterpret_cast<uint8_t*>(&entry.record), sizeof(Record_t)) == sizeof(Record_t);
+            if (!valid) { break; }
+
+            archive.recent.push_back(entry);
+        }
+    }
+
+    file.close();
+
+    if (!valid) {
+        MessageOutput.printf("[EventArchive] removing invalid file %s\r\n", path);
+        LittleFS.remove(path);
+        archive.header = {};
+        archive.recent.clear();
+    }
+}
+
+EventArchiveClass::Archive_t* EventArchiveClass::findArchive(uint64_t serial)
+{
+    for (auto& archive : _archives) {
+        if (archive.serial == serial) { return &archive; }
+    }
+
+    return nullptr;
+}
+
+EventArchiveClass::Archive_t& EventArchiveClass::getArchive(uint64_t serial)
+{
+    if (auto pArchive = findArchive(serial)) { return *pArchive; }
+
+    _archives.emplace_back();
+    auto& archive = _archives.back();
+    archive.serial = serial;
+    load(archive);
+    return archive;
+}
+
+size_t EventArchiveClass::query(uint64_t serial, Filter_t const& filter, size_t offset, size_t limit, std::vector<Event_t>& events)
+{
+    events.clear();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // archives are only kept for the configured inverters
+    auto pArchive = findArchive(serial);
+    if (pArchive == nullptr) {
+        if (Hoymiles.getInverterBySerial(serial) == nullptr) { return 0; }
+        pArchive = &getArchive(serial);
+    }
+
+    auto const& header = pArchive->header;
+    if (header.count == 0) { return 0; }
+
+    char path[40];
+    archivePath(serial, path, sizeof(path));
+
+    File file = LittleFS.open(path, "r");
+    if (!file) { return 0; }
+
+    std::vector<Record_t> records(header.count);
+    bool success = file.seek(sizeof(FileHeader_t))
+        && file.read(reinterpret_cast<uint8_t*>(records.data()), records.size() * sizeof(Record_t)) == records.size() * sizeof(Record_t);
+    file.close();
+
+    if (!success) { return 0; }
+
+    size_t matches = 0;
+
+    // newest first, starting with the slot before the head
+    for (size_t i = 1; i <= header.count; i++) {
+        auto const& record = records[(header.head + Capacity - i) % Capacity];
+
+        if (record.startTime < filter.from || record.startTime >= filter.to) { continue; }
+        if (filter.messageId >= 0 && record.messageId != filter.messageId) { continue; }
+        if (filter.activeOnly && record.endTime != 0) { continue; }
+
+        if (matches >= offset && events.size() < limit) {
+            events.push_back({ record.startTime, record.endTime, record.messageId,
+                static_cast<AlarmMessageType_t>(record.messageType) });
+        }
+        matches++;
+    }
+
+    return matches;
+}
+
+void EventArchiveClass::remove(uint64_t serial)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _archives.erase(std::remove_if(_archives.begin(), _archives.end(),
+                        [serial](Archive_t const& archive) { return archive.serial == serial; }),
+        _archives.end());
+
+    char path[40];
+    archivePath(serial, path, sizeof(path));
+    if (LittleFS.exists(path)) { LittleFS.remove(path); }
+}
+
+void EventArchiveClass::reset()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _archives.clear();
+
+    File dir = LittleFS.open(ArchiveDirectory);
+    if (!dir || !dir.isDirectory()) { return; }
+
+    std::vector<String> files;
+    for (File file = dir.openNextFile(); file; file = dir.openNextFile()) {
+        String name = file.name();
+        int slash = name.lastIndexOf('/');
+        if (slash >= 0) { name = name.substring(slash + 1); }
+        files.push_back(String(ArchiveDirectory) + "/" + name);
+        file.close();
+    }
+    dir.close();
+
+    for (auto const& path : files) { LittleFS.remove(path); }
+    LittleFS.rmdir(ArchiveDirectory);
+}
+
+void EventArchiveClass::archivePath(uint64_t serial, char* path, size_t size)
+{
+    snprintf(path, size, "%s/%08" PRIx32 "%08" PRIx32 ".bin", ArchiveDirectory,
+        static_cast<uint32_t>(serial >> 32), static_cast<uint32_t>(serial & 0xffffffff));
+}
@@ -65,7 +65,13 @@ bool GobelRS485Receiver::init()
         vTaskDelay(1);
     }
 
-    _received_frame = reinterpret_cast<char*>(malloc(128)); // receiver buffer with initially 128 bytes, will be expanded on request up to 256
+    _transactions.begin(TAG, _upSerial.get(),
+            [this](BatteryRS485Transactions::Request_t const& request) {
+                send_cmd(request.module, request.cmd, request.infoCommand);
+            },
+            [this](BatteryRS485Transactions::Request_t const& request, format_t* frame) {
+                onResponse(request, frame);
+            });
 
     MessageOutput.println(", initialized successfully.");
 
@@ -75,66 +81,63 @@ bool GobelRS485Receiver::init()
 void GobelRS485Receiver::readParameter()
 {
     MessageOutput.printf("%s::%s: Read basic infos and parameters.\r\n", TAG, __FUNCTION__);
-    bool temp = _verboseLogging;
+    _parameterVerboseLogging = _verboseLogging;
 
     _verboseLogging = true;
 
     _masterBatteryID = 2; // Master battery starts with ID = 2
 
-    // search the amount of connected batteries
-    uint8_t number_of_packs = 0;
-    for (uint8_t i = _masterBatteryID; i < _masterBatteryID + 8; i++) {
-        if (get_pack_count(REQUEST_AND_GET, i) == false) {
-            break;
+    // search the amount of connected batteries, the next pack is probed
+    // once the previous one answered
+    _readingParameters = true;
+    _packsFound = 0;
+    get_pack_count(REQUEST, _masterBatteryID);
+}
+
+void GobelRS485Receiver::onPackCount(uint8_t module, bool found)
+{
+    if (found) {
+        ++_packsFound;
+        if (module + 1 < _masterBatteryID + 8) {
+            get_pack_count(REQUEST, module + 1);
+            return;
         }
-        number_of_packs++;
-        vTaskDelay(500);
     }
-    MessageOutput.printf("%s Found %d Battery Packs\r\n", TAG, number_of_packs);
+
+    MessageOutput.printf("%s Found %d Battery Packs\r\n", TAG, _packsFound);
 
     _stats->_number_of_packs = Configuration.get().Battery.numberOfBatteries;
 
     _lastSlaveBatteryID = _masterBatteryID + _stats->_number_of_packs;
 
+    // the requests are sent back to back, each one as soon as the
+    // previous one was answered
     for (uint8_t i = _masterBatteryID; i < _lastSlaveBatteryID; i++) {
         MessageOutput.printf("%s %s Battery Pack %d\r\n", TAG, i == 2 ? "Master" : "Slave", i);
-        get_protocol_version(REQUEST_AND_GET, i);
-        vTaskDelay(500);
-        get_manufacturer_info(REQUEST_AND_GET, i);
-        vTaskDelay(500);
-        get_module_serial_number(REQUEST_AND_GET, i);
-        vTaskDelay(500);
-        get_firmware_info(REQUEST_AND_GET, i);
-        vTaskDelay(500);
-
-        get_system_parameters(REQUEST_AND_GET, i);
-        vTaskDelay(500);
-
-        //        get_barcode(REQUEST_AND_GET, i);
-        //          vTaskDelay(500);
-        //        get_version_info(REQUEST_AND_GET, i);
-        //          vTaskDelay(500);
-
-        get_charge_discharge_management_info(REQUEST_AND_GET, i);
-        vTaskDelay(500);
-
-        get_analog_value(REQUEST_AND_GET, i);
-        vTaskDelay(500);
-
-        get_alarm_info(REQUEST_AND_GET, i);
-        vTaskDelay(500);
-    }
-    _lastCmnd = 0xFF;
+        get_protocol_version(REQUEST, i);
+        get_manufacturer_info(REQUEST, i);
+        get_module_serial_number(REQUEST, i);
+        get_firmware_info(REQUEST, i);
+
+        get_system_parameters(REQUEST, i);
 
-    _verboseLogging = temp;
+        //        get_barcode(REQUEST, i);
+        //        get_version_info(REQUEST, i);
+        get_pack_capacity(REQUEST, i);
 
-    MessageOutput.printf("%s::%s done\r\n", TAG, __FUNCTION__);
+        get_charge_discharge_management_info(REQUEST, i);
 
-    _initialized = true;
+        get_analog_value(REQUEST, i);
+
+        get_alarm_info(REQUEST, i);
+    }
 }
 
 void GobelRS485Receiver::deinit()
 {
+    _transactions.end();
+    _readingParameters = false;
+
     _upSerial->end();
 
     if (PinMapping.get().battery.rs485.rts >= 0) { pinMode(PinMapping.get().battery.rs485.rts, INPUT); }
@@ -148,66 +151,31 @@ void GobelRS485Receiver::deinit()
 
 void GobelRS485Receiver::loop()
 {
-    if (!_initialized) readParameter();
-
-    static uint8_t BatteryID = _lastSlaveBatteryID;
-    uint8_t module = BatteryID;
-    if (module >= _lastSlaveBatteryID)
-        module = _masterBatteryID; // inital check
-
-    if (_upSerial->available()) {
-        uint32_t t_start = millis();
-        switch (_lastCmnd) {
-        case Command::GetChargeDischargeManagementInfo:
-            get_charge_discharge_management_info(GobelRS485Receiver::Function::GET, module);
-            break;
-        case Command::GetAlarmInfo:
-            get_alarm_info(GobelRS485Receiver::Function::GET, module);
-            break;
-        case Command::GetAnalogValue:
-            get_analog_value(GobelRS485Receiver::Function::GET, module);
-            break;
-        case Command::GetSystemParameter:
-            get_system_parameters(GobelRS485Receiver::Function::GET, module);
-            break;
-        case 0xff:
-            // Filtering out interference on the receiving line.
-            // This shouldn't happen in normal operation, but it seems like some RS485 adapters/chips are very sensitive or out of specification.
-            // In order not to block the scheduler too much, the filter will periodically read the input buffer for a maximum of 50ms per loop
-            static uint16_t spikes = 0;
-            while (_upSerial->available() && (millis() - t_start) < 50) {
-                if (_upSerial->peek() != 0x7E) {
-                    // we consume all incomming bytes which are not 0x7E (start sequence of a frame)
-                    spikes++;
-                    _upSerial->read();
-                } else {
-                    // this should never happen.
-                    // It would mean that we had issued a command to the battery that was not recognized and processed in the parser above.
-                    bool temp = _verboseLogging;
-                    _verboseLogging = true; // switch on verbose logging, to see what happen
-                    read_frame();
-                    _verboseLogging = temp; // switch verbose logging to previous setting.
-                    break;
-                }
-            }
-            //
-            if (spikes > 100) {
-                MessageOutput.printf("%s Warning found %d signal interferences\r\n", TAG, spikes);
-                spikes = 0;
-            }
-        }
-        if (_lastCmnd != 0xFF) {
-            MessageOutput.printf("%s response time %lu ms, Cmnd: %02X\r\n", TAG, millis() - t_start, _lastCmnd);
+    if (!_initialized && !_readingParameters) readParameter();
 
-            // indicate that we have updated some battery values
-            _stats->setLastUpdate(millis());
-        }
-        _lastCmnd = 0xFF;
+    // receives, parses and sends without waiting for the battery
+    _transactions.loop();
+
+    if (_readingParameters) {
+        if (!_transactions.isIdle()) { return; }
+
+        _readingParameters = false;
+        _verboseLogging = _parameterVerboseLogging;
+
+        MessageOutput.printf("%s::%s done\r\n", TAG, "readParameter");
+
+        _initialized = true;
     }
 
     if (!_lastBatteryCheck.occured()) { return; }
     _lastBatteryCheck.set(Configuration.get().Battery.PollInterval * 1000);
 
+    // the battery did not answer all requests of the previous round yet
+    if (!_transactions.isIdle()) {
+        MessageOutput.printf("%s poll skipped, %u requests pending\r\n", TAG, _transactions.getQueueSize());
+        return;
+    }
+
     typedef struct {
         Command cmd;
         uint8_t InfoCommand;
@@ -222,16 +190,90 @@ void GobelRS485Receiver::loop()
         { Command::GetSystemParameter, 0 },
     };
 
-    static uint8_t state = 0;
-    if (state == 0) {
-        if (++BatteryID >= _lastSlaveBatteryID) BatteryID = _masterBatteryID;
+    // every pack gets the next command of the sequence, round-robin and
+    // back to back
+    for (uint8_t i = _masterBatteryID; i < _lastSlaveBatteryID; i++) {
+        _transactions.enqueue(i, Commands[_pollState].cmd, Commands[_pollState].InfoCommand);
+    }
+
+    if (_verboseLogging) {
+        MessageOutput.printf("%s %d Battery Packs requested, Cmnd: %02X\r\n", TAG,
+                _lastSlaveBatteryID - _masterBatteryID, Commands[_pollState].cmd);
+    }
+
+    if (++_pollState >= sizeof(Commands) / sizeof(Commands_t)) _pollState = 0;
+}
+
+void GobelRS485Receiver::onResponse(BatteryRS485Transactions::Request_t const& request, format_t* frame)
+{
+    if (frame == nullptr) {
+        MessageOutput.printf("%s Battery not responding, check cabling or battery power switch\r\n", TAG);
+        if (request.cmd == Command::GetPackCount) { onPackCount(request.module, false); }
+        return;
+    }
+
+    // read_frame() hands this frame to the parsers
+    _received_frame = frame;
+
+    switch (request.cmd) {
+    case Command::GetPackCount:
+        onPackCount(request.module, get_pack_count(GET, request.module));
+        break;
+    case Command::GetProtocolVersion:
+        get_protocol_version(GET, request.module);
+        break;
+    case Command::GetManufacturerInfo:
+        get_manufacturer_info(GET, request.module);
+        break;
+    case Command::GetSerialNumber:
+        get_module_serial_number(GET, request.module);
+        break;
+    case Command::GetFirmwareInfo:
+        get_firmware_info(GET, request.module);
+        break;
+    case Command::GetBarCode:
+        get_barcode(GET, request.module);
+        break;
+    case Command::GetVersionInfo:
+        get_version_info(GET, request.module);
+        break;
+    case Command::GetPackCapacity:
+        get_pack_capacity(GET, request.module);
+        break;
+    case Command::GetChargeDischargeManagementInfo:
+        get_charge_discharge_management_info(GET, request.module);
+        break;
+    case Command::GetAlarmInfo:
+        get_alarm_info(GET, request.module);
+        break;
+    case Command::GetAnalogValue:
+        get_analog_value(GET, request.module);
+        break;
+    case Command::GetSystemParameter:
+        get_system_parameters(GET, request.module);
+        break;
+    case Command::TurnOffModule:
+        turn_off_module(GET, request.module);
+        break;
+    default: {
+        // no parser for this response, switch on verbose logging to see what happened
+        bool temp = _verboseLogging;
+        _verboseLogging = true;
+        read_frame();
+        _verboseLogging = temp;
+        break;
+    }
     }
-    MessageOutput.printf("%s %s Battery Pack %d\r\n", TAG, BatteryID == _masterBatteryID ? "Master" : "Slave", BatteryID);
 
-    send_cmd(BatteryID, Commands[state].cmd, Commands[state].InfoCommand);
-    if (++state >= sizeof(Commands) / sizeof(Commands_t)) state = 0;
+    _received_frame = nullptr;
 
-    MessageOutput.printf("%s request time %u ms, Cmnd: %02X\r\n", TAG, _lastBatteryCheck.elapsed(), _lastCmnd);
+    if (_readingParameters) { return; }
+
+    MessageOutput.printf("%s response time %u ms, Module: %d, Cmnd: %02X\r\n", TAG,
+            _transactions.getResponseTime(), request.module, request.cmd);
+
+    // indicate that we have updated some battery values
+    _stats->setLastUpdate(millis());
 }
 
 static void errorBatteryNotResponding()
@@ -239,21 +281,15 @@ static void errorBatteryNotResponding()
     MessageOutput.printf("%s Battery not responding, check cabling or battery power switch\r\n", TAG);
 }
 
-static const char* _Function_[] = { "REQUEST", "REQUEST & GET", "GET" };
+static const char* _Function_[] = { "REQUEST", "GET" };
 void GobelRS485Receiver::get_protocol_version(const GobelRS485Receiver::Function function, uint8_t module)
 {
     if (_verboseLogging)
-        MessageOutput.printf("%s::%s %s Module %d\r\n", TAG, __FUNCTION__, _Function_[function], module);
+        MessageOutput.printf(LogLevel::Verbose, "%s::%s %s Module %d\r\n", TAG, __FUNCTION__, _Function_[function], module);
 
-    if (function != GobelRS485Receiver::Function::GET) {
-        send_cmd(module, Command::GetProtocolVersion, 0);
-        yield();
-        if (function == GobelRS485Receiver::Function::REQUEST)
-            return;
-        else {
-            vTaskDelay(100);
-            // and fall through to get the data from the battery
-        }
+    if (function == GobelRS485Receiver::Function::REQUEST) {
+        _transactions.enqueue(module, Command::GetProtocolVersion, 0);
+        return;
     }
 
     format_t* f;
@@ -263,23 +299,17 @@ void GobelRS485Receiver::get_protocol_version(const GobelRS485Receiver::Function
     };
 
     if (_verboseLogging)
-        MessageOutput.printf("%s Protocol Version: %d.%d\r\n", TAG, (f->ver & 0xF0) >> 4, f->ver & 0xF);
+        MessageOutput.printf(LogLevel::Verbose, "%s Protocol Version: %d.%d\r\n", TAG, (f->ver & 0xF0) >> 4, f->ver & 0xF);
 }
 
 void GobelRS485Receiver::get_barcode(const GobelRS485Receiver::Function function, uint8_t module)
 {
     if (_verboseLogging)
-        MessageOutput.printf("%s::%s %s Module %d\r\n", TAG, __FUNCTION__, _Function_[function], module);
+        MessageOutput.printf(LogLevel::Verbose, "%s::%s %s Module %d\r\n", TAG, __FUNCTION__, _Function_[function], module);
 
-    if (function != GobelRS485Receiver::Function::GET) {
-        send_cmd(module, Command::GetBarCode);
-        yield();
-        if (function == GobelRS485Receiver::Function::REQUEST)
-            return;
-        else {
-            vTaskDelay(100);
-            // and fall through to get the data from the battery
-        }
+    if (function == GobelRS485Receiver::Function::REQUEST) {
+        _transactions.enqueue(module, Command::GetBarCode, 1);
+        return;
     }
 
     format_t* f = read_frame();
@@ -292,17 +322,11 @@ void GobelRS485Receiver::get_barcode(const GobelRS485Receiver::Function function
 void GobelRS485Receiver::get_firmware_info(const GobelRS485Receiver::Function function, uint8_t module)
 {
     if (_verboseLogging)
-        MessageOutput.printf("%s::%s %s Module %d\r\n", TAG, __FUNCTION__, _Function_[function], module);
+        MessageOutput.printf(LogLevel::Verbose, "%s::%s %s Module %d\r\n", TAG, __FUNCTION__, _Function_[function], module);
 
-    if (function != GobelRS485Receiver::Function::GET) {
-        send_cmd(module, Command::GetFirmwareInfo);
-        yield();
-        if (function == GobelRS485Receiver::Function::REQUEST)
-            return;
-        else {
-            vTaskDelay(100);
-            // and fall through to get the data from the battery
-        }
+    if (function == GobelRS485Receiver::Function::REQUEST) {
+        _transactions.enqueue(module, Command::GetFirmwareInfo, 1);
+        return;
     }
 
     format_t* f = read_frame();
@@ -333,17 +357,11 @@ void GobelRS485Receiver::get_firmware_info(const GobelRS485Receiver::Function fu
 void GobelRS485Receiver::get_version_info(const GobelRS485Receiver::Function function, uint8_t module)
 {
     if (_verboseLogging)
-        MessageOutput.printf("%s::%s %s Module %d\r\n", TAG, __FUNCTION__, _Function_[function], module);
+        MessageOutput.printf(LogLevel::Verbose, "%s::%s %s Module %d\r\n", TAG, __FUNCTION__, _Function_[function], module);
 
-    if (function != GobelRS485Receiver::Function::GET) {
-        send_cmd(module, Command::GetVersionInfo);
-        yield();
-        if (function == GobelRS485Receiver::Function::REQUEST)
-            return;
-        else {
-            vTaskDelay(100);
-            // and fall through to get the data from the battery
-        }
+    if (function == GobelRS485Receiver::Function::REQUEST) {
+        _transactions.enqueue(module, Command::GetVersionInfo, 1);
+        return;
     }
 
     format_t* f = read_frame();
@@ -356,19 +374,13 @@ void GobelRS485Receiver::get_version_info(const GobelRS485Receiver::Function fun
 bool GobelRS485Receiver::get_pack_count(const GobelRS485Receiver::Function function, uint8_t module, uint8_t InfoCommand)
 {
     if (_verboseLogging)
-        MessageOutput.printf("%s::%s %s Module %d InfoCommand %02X\r\n", TAG, __FUNCTION__,
+        MessageOutput.printf(LogLevel::Verbose, "%s::%s %s Module %d InfoCommand %02X\r\n", TAG, __FUNCTION__,
             _Function_[function], module, InfoCommand == 0 ? 0 : InfoCommand == 1 ? module
                                                                                   : 0xFF);
 
-    if (function != GobelRS485Receiver::Function::GET) {
-        send_cmd(module, Command::GetPackCount, InfoCommand);
-        yield();
-        if (function == GobelRS485Receiver::Function::REQUEST)
-            return true;
-        else {
-            vTaskDelay(100);
-            // and fall through to get the data from the battery
-        }
+    if (function == GobelRS485Receiver::Function::REQUEST) {
+        _transactions.enqueue(module, Command::GetPackCount, InfoCommand);
+        return true;
     }
 
     format_t* f = read_frame();
@@ -384,7 +396,7 @@ bool GobelRS485Receiver::get_pack_count(const GobelRS485Receiver::Function funct
         _stats->_number_of_packs = Configuration.get().Battery.numberOfBatteries;
 
     if (_verboseLogging)
-        MessageOutput.printf("%s::%s Number of Battery Packs %u\r\n", TAG, __FUNCTION__, _stats->_number_of_packs);
+        MessageOutput.printf(LogLevel::Verbose, "%s::%s Number of Battery Packs %u\r\n", TAG, __FUNCTION__, _stats->_number_of_packs);
 
     return true;
 }
@@ -392,17 +404,11 @@ bool GobelRS485Receiver::get_pack_count(const GobelRS485Receiver::Function funct
 void GobelRS485Receiver::get_manufacturer_info(const GobelRS485Receiver::Function function, uint8_t module)
 {
     if (_verboseLogging)
-        MessageOutput.printf("%s::%s %s Module %d\r\n", TAG, __FUNCTION__, _Function_[function], module);
+        MessageOutput.printf(LogLevel::Verbose, "%s::%s %s Module %d\r\n", TAG, __FUNCTION__, _Function_[function], module);
 
-    if (function != GobelRS485Receiver::Function::GET) {
-        send_cmd(module, Command::GetManufacturerInfo, 0);
-        yield();
-        if (function == GobelRS485Receiver::Function::REQUEST)
-            return;
-        else {
-            vTaskDelay(100);
-            // and fall through to get the data from the battery
-        }
+    if (function == GobelRS485Receiver::Function::REQUEST) {
+        _transactions.enqueue(module, Command::GetManufacturerInfo, 0);
+        return;
     }
 
     format_t* f = read_frame();
@@ -455,25 +461,19 @@ void GobelRS485Receiver::get_manufacturer_info(const GobelRS485Receiver::Functio
     Pack.deviceName = deviceName;
 
     if (_verboseLogging)
-        MessageOutput.printf("%s Device Name: '%s' Manufacturer Name: '%s'\r\n", TAG, Pack.deviceName.c_str(), _stats->getManufacturer().c_str());
+        MessageOutput.printf(LogLevel::Verbose, "%s Device Name: '%s' Manufacturer Name: '%s'\r\n", TAG, Pack.deviceName.c_str(), _stats->getManufacturer().c_str());
 }
 
 void GobelRS485Receiver::get_analog_value(const GobelRS485Receiver::Function function, uint8_t module, uint8_t InfoCommand)
 {
     if (_verboseLogging)
-        MessageOutput.printf("%s::%s %s Module %d InfoCommand %02X\r\n", TAG, __FUNCTION__,
+        MessageOutput.printf(LogLevel::Verbose, "%s::%s %s Module %d InfoCommand %02X\r\n", TAG, __FUNCTION__,
             _Function_[function], module, InfoCommand == 0 ? 0 : InfoCommand == 1 ? module
                                                                                   : 0xFF);
 
-    if (function != GobelRS485Receiver::Function::GET) {
-        send_cmd(module, Command::GetAnalogValue, InfoCommand);
-        yield();
-        if (function == GobelRS485Receiver::Function::REQUEST)
-            return;
-        else {
-            vTaskDelay(100);
-            // and fall through to get the data from the battery
-        }
+    if (function == GobelRS485Receiver::Function::REQUEST) {
+        _transactions.enqueue(module, Command::GetAnalogValue, InfoCommand);
+        return;
     }
 
     format_t* f = read_frame();
@@ -496,7 +496,7 @@ void GobelRS485Receiver::get_analog_value(const GobelRS485Receiver::Function fun
     Pack.numberOfCells = min(*info++, static_cast<uint8_t>(15));
 
     if (_verboseLogging)
-        MessageOutput.printf("%s InfoFlag: %02X, Number of Cells: %d\r\n", TAG, InfoFlag, Pack.numberOfCells);
+        MessageOutput.printf(LogLevel::Verbose, "%s InfoFlag: %02X, Number of Cells: %d\r\n", TAG, InfoFlag, Pack.numberOfCells);
 
     Pack.cellMinVoltage = 999999.0;
     Pack.cellMaxVoltage = -999999.0;
@@ -515,7 +515,7 @@ void GobelRS485Receiver::get_analog_value(const GobelRS485Receiver::Function fun
     Pack.numberOfTemperatures = min(*info++, static_cast<uint8_t>(6));
 
     if (_verboseLogging)
-        MessageOutput.printf("%s Number of Temperatures: %d\r\n", TAG, Pack.numberOfTemperatures);
+        MessageOutput.printf(LogLevel::Verbose, "%s Number of Temperatures: %d\r\n", TAG, Pack.numberOfTemperatures);
 
     Pack.averageBMSTemperature = to_Celsius(info);
     Pack.averageCellTemperature = 0.0;
@@ -597,20 +597,14 @@ void GobelRS485Receiver::get_analog_value(const GobelRS485Receiver::Function fun
     }
 }
 
-void GobelRS485Receiver::get_pack_capacity(const GobelRS485Receiver::Function function)
+void GobelRS485Receiver::get_pack_capacity(const GobelRS485Receiver::Function function, uint8_t module)
 {
     if (_verboseLogging)
-        MessageOutput.printf("%s::%s %s Module %d\r\n", TAG, __FUNCTION__, _Function_[function], module);
+        MessageOutput.printf(LogLevel::Verbose, "%s::%s %s Module %d\r\n", TAG, __FUNCTION__, _Function_[function], module);
 
-    if (function != GobelRS485Receiver::Function::GET) {
-        send_cmd(module, Command::GetPackCapacity, 0);
-        yield();
-        if (function == GobelRS485Receiver::Function::REQUEST)
-            return;
-        else {
-            vTaskDelay(100);
-            // and fall through to get the data from the battery
-        }
+    if (function == GobelRS485Receiver::Function::REQUEST) {
+        _transactions.enqueue(module, Command::GetPackCapacity, 0);
+        return;
     }
 
     format_t* f = read_frame();
@@ -634,17 +628,11 @@ void GobelRS485Receiver::get_pack_capacity(const GobelRS485Receiver::Function fu
 void GobelRS485Receiver::get_system_parameters(const GobelRS485Receiver::Function function, uint8_t module)
 {
     if (_verboseLogging)
-        MessageOutput.printf("%s::%s %s Module %d\r\n", TAG, __FUNCTION__, _Function_[function], module);
+        MessageOutput.printf(LogLevel::Verbose, "%s::%s %s Module %d\r\n", TAG, __FUNCTION__, _Function_[function], module);
 
-    if (function != GobelRS485Receiver::Function::GET) {
-        send_cmd(module, Command::GetSystemParameter, 0);
-        yield();
-        if (function == GobelRS485Receiver::Function::REQUEST)
-            return;
-        else {
-            vTaskDelay(100);
-            // and fall through to get the data from the battery
-        }
+    if (function == GobelRS485Receiver::Function::REQUEST) {
+        _transactions.enqueue(module, Command::GetSystemParameter, 0);
+        return;
     }
 
     format_t* f = read_frame();
@@ -716,19 +704,13 @@ void GobelRS485Receiver::get_system_parameters(const GobelRS485Receiver::Functio
 void GobelRS485Receiver::get_alarm_info(const GobelRS485Receiver::Function function, uint8_t module, uint8_t InfoCommand)
 {
     if (_verboseLogging)
-        MessageOutput.printf("%s::%s %s Module %d InfoCommand %02X\r\n", TAG, __FUNCTION__,
+        MessageOutput.printf(LogLevel::Verbose, "%s::%s %s Module %d InfoCommand %02X\r\n", TAG, __FUNCTION__,
             _Function_[function], module, InfoCommand == 0 ? 0 : InfoCommand == 1 ? module
                                                                                   : 0xFF);
 
-    if (function != GobelRS485Receiver::Function::GET) {
-        send_cmd(module, Command::GetAlarmInfo, InfoCommand);
-        yield();
-        if (function == GobelRS485Receiver::Function::REQUEST)
-            return;
-        else {
-            vTaskDelay(100);
-            // and fall through to get the data from the battery
-        }
+    if (function == GobelRS485Receiver::Function::REQUEST) {
+        _transactions.enqueue(module, Command::GetAlarmInfo, InfoCommand);
+        return;
     }
 
     format_t* f = read_frame();
@@ -755,7 +737,7 @@ void GobelRS485Receiver::get_alarm_info(const GobelRS485Receiver::Function funct
     Warning.lowVoltage = 0;
     Warning.highVoltage = 0;
 
-    if (_verboseLogging) MessageOutput.printf("%s DataFlag: %02X, CommandValue: %02X, Number of Cell: %d, Status: ", TAG,
+    if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s DataFlag: %02X, CommandValue: %02X, Number of Cell: %d, Status: ", TAG,
                             DataFlag,
                             CommandValue,
                             AlarmInfo.numberOfCells);
@@ -766,7 +748,7 @@ void GobelRS485Receiver::get_alarm_info(const GobelRS485Receiver::Function funct
         if (AlarmInfo.cellVoltages[i] & 0x01) Warning.lowVoltage = 1;
         if (AlarmInfo.cellVoltages[i] & 0x02) Warning.highVoltage = 1;
 
-        if (_verboseLogging) MessageOutput.printf("%02X ", AlarmInfo.cellVoltages[i]);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%02X ", AlarmInfo.cellVoltages[i]);
     }
     if (_verboseLogging) MessageOutput.println();
 
@@ -861,17 +843,11 @@ void GobelRS485Receiver::get_alarm_info(const GobelRS485Receiver::Function funct
 void GobelRS485Receiver::get_charge_discharge_management_info(const GobelRS485Receiver::Function function, uint8_t module)
 {
     if (_verboseLogging)
-        MessageOutput.printf("%s::%s %s Module %d\r\n", TAG, __FUNCTION__, _Function_[function], module);
+        MessageOutput.printf(LogLevel::Verbose, "%s::%s %s Module %d\r\n", TAG, __FUNCTION__, _Function_[function], module);
 
-    if (function != GobelRS485Receiver::Function::GET) {
-        send_cmd(module, Command::GetChargeDischargeManagementInfo);
-        yield();
-        if (function == GobelRS485Receiver::Function::REQUEST)
-            return;
-        else {
-            vTaskDelay(100);
-            // and fall through to get the data from the battery
-        }
+    if (function == GobelRS485Receiver::Function::REQUEST) {
+        _transactions.enqueue(module, Command::GetChargeDischargeManagementInfo, 1);
+        return;
     }
 
     format_t* f = read_frame();
@@ -926,17 +902,11 @@ void GobelRS485Receiver::get_charge_discharge_management_info(const GobelRS485Re
 void GobelRS485Receiver::get_module_serial_number(const GobelRS485Receiver::Function function, uint8_t module)
 {
     if (_verboseLogging)
-        MessageOutput.printf("%s::%s %s Module %d\r\n", TAG, __FUNCTION__, _Function_[function], module);
+        MessageOutput.printf(LogLevel::Verbose, "%s::%s %s Module %d\r\n", TAG, __FUNCTION__, _Function_[function], module);
 
-    if (function != GobelRS485Receiver::Function::GET) {
-        send_cmd(module, Command::GetSerialNumber);
-        yield();
-        if (function == GobelRS485Receiver::Function::REQUEST)
-            return;
-        else {
-            vTaskDelay(100);
-            // and fall through to get the data from the battery
-        }
+    if (function == GobelRS485Receiver::Function::REQUEST) {
+        _transactions.enqueue(module, Command::GetSerialNumber, 1);
+        return;
     }
 
     format_t* f = read_frame();
@@ -955,40 +925,28 @@ void GobelRS485Receiver::get_module_serial_number(const GobelRS485Receiver::Func
     strncpy(ModuleSerialNumber.moduleSerialNumber, (const char*)&(f->info[1]), sizeof(ModuleSerialNumber.moduleSerialNumber) - 1);
 
     if (_verboseLogging)
-        MessageOutput.printf("%s CommandValue %02X, S/N '%s'\r\n", TAG, CommandValue, ModuleSerialNumber.moduleSerialNumber);
+        MessageOutput.printf(LogLevel::Verbose, "%s CommandValue %02X, S/N '%s'\r\n", TAG, CommandValue, ModuleSerialNumber.moduleSerialNumber);
 }
 
 void GobelRS485Receiver::setting_charge_discharge_management_info(const GobelRS485Receiver::Function function, uint8_t module, const char* info)
 {
     if (_verboseLogging)
-        MessageOutput.printf("%s::%s %s Module %d\r\n", TAG, __FUNCTION__, _Function_[function], module);
+        MessageOutput.printf(LogLevel::Verbose, "%s::%s %s Module %d\r\n", TAG, __FUNCTION__, _Function_[function], module);
 
-    if (function != GobelRS485Receiver::Function::GET) {
-        send_cmd(module, Command::SetChargeDischargeManagementInfo);
-        yield();
-        if (function == GobelRS485Receiver::Function::REQUEST)
-            return;
-        else {
-            vTaskDelay(100);
-            // and fall through to get the data from the battery
-        }
+    if (function == GobelRS485Receiver::Function::REQUEST) {
+        _transactions.enqueue(module, Command::SetChargeDischargeManagementInfo, 1);
+        return;
     }
 }
 
 void GobelRS485Receiver::turn_off_module(const GobelRS485Receiver::Function function, uint8_t module)
 {
     if (_verboseLogging)
-        MessageOutput.printf("%s::%s %s Module %d\r\n", TAG, __FUNCTION__, _Function_[function], module);
+        MessageOutput.printf(LogLevel::Verbose, "%s::%s %s Module %d\r\n", TAG, __FUNCTION__, _Function_[function], module);
 
-    if (function != GobelRS485Receiver::Function::GET) {
-        send_cmd(module, Command::TurnOffModule);
-        yield();
-        if (function == GobelRS485Receiver::Function::REQUEST)
-            return;
-        else {
-            vTaskDelay(100);
-            // and fall through to get the data from the battery
-        }
+    if (function == GobelRS485Receiver::Function::REQUEST) {
+        _transactions.enqueue(module, Command::TurnOffModule, 1);
+        return;
     }
 
     /*format_t *f =*/read_frame();
@@ -1047,152 +1005,32 @@ void GobelRS485Receiver::send_cmd(uint8_t address, uint8_t cmnd, uint8_t InfoCom
 
     size_t length = strlen(raw_frame);
 
-    if (_verboseLogging) MessageOutput.printf("%s:%s frame=%s\r\n", TAG, __FUNCTION__, raw_frame);
+    if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s:%s frame=%s\r\n", TAG, __FUNCTION__, raw_frame);
 
     if (_upSerial->write(raw_frame, length) != length) {
         MessageOutput.printf("%s Send data critical failure.\r\n", TAG);
         // add your code to handle sending failure here
         //        abort();
     }
-    _lastCmnd = cmnd;
-}
-
-size_t GobelRS485Receiver::readline(void)
-{
-    uint32_t t_end = millis() + 2000; // timeout 2 seconds
-    while (millis() < t_end) {
-        if (_upSerial->available()) break;
-        yield();
-    }
-    if (!_upSerial->available()) {
-        // #ifdef GOBEL_RS485_DEBUG_ENABLED
-        MessageOutput.printf("%s RS485 read timeout\r\n", TAG);
-        // #endif
-        return 0;
-    }
-
-    int idx = 0;
-    bool start = false;
-
-    t_end = millis() + 1000; // timeout 1 second
-    while (millis() < t_end) {
-        char c;
-        if (_upSerial->available()) {
-            c = _upSerial->read();
-            if (!start && c != 0x7E) { // start of line ?
-                yield();
-                continue;
-            }
-
-            start = true;
-
-            static int _receivedFrameSize = 128;
-            if (((idx % 32) == 0) && (idx >= _receivedFrameSize) && (_receivedFrameSize < 256)) {
-                char* prev;
-                _received_frame = reinterpret_cast<char*>(realloc(prev = _received_frame, _receivedFrameSize + 32));
-                _receivedFrameSize += 32;
-                MessageOutput.printf("%s %s realloc location: %p. Size: %d bytes.\r\n", TAG,
-                    prev != _received_frame ? "New" : "Old", reinterpret_cast<void*>(_received_frame), _receivedFrameSize);
-            }
-            _received_frame[idx++] = c;
-
-            if (c == 0x0D) { // end of line ?
-                _received_frame[idx] = 0;
-                break;
-            }
-
-            if (idx > 255) {
-                MessageOutput.printf("%s RS485 buffer overflow\r\n", TAG);
-                break;
-            }
-            yield();
-        }
-    }
-
-    return idx;
 }
 
-uint32_t GobelRS485Receiver::hex2binary(char* s, int len)
+// the frame was decoded and validated by BatteryRS485FrameDecoder while it was received
+format_t* GobelRS485Receiver::read_frame(void)
 {
-    uint32_t b = 0;
-
-    if (len == 0) return 0;
-
-    do {
-        if      (*s >= '0' && *s <= '9') b |= *s - '0';
-        else if (*s >= 'A' && *s <= 'F') b |= *s - 'A' + 10;
-        else if (*s >= 'a' && *s <= 'f') b |= *s - 'a' + 10;
-        if (len > 1) b <<= 4;
-        s++;
-    } while (--len);
-
-    return b;
-}
-
-char* GobelRS485Receiver::_decode_hw_frame(size_t length)
-{
-#ifdef GOBEL_RS485_DEBUG_ENABLED
-    MessageOutput.printf("%s _received_frame '%s' length=%d\r\n", TAG, _received_frame, length);
-#endif
-    if (length < 12) return NULL;
-
-    char* frame_data = &_received_frame[1]; // remove SOI 0x7E
-    _received_frame[length - 1] = 0; // remove EOI 0x0D
-    length -= 2;
-
-    uint16_t read_chksum = strtol(&frame_data[length - 4], NULL, 16);
-    frame_data[length - 4] = 0; // remove frame checksum
-    length -= 4;
-
-    uint16_t computed_chksum = get_frame_checksum(frame_data);
+    format_t* f = _received_frame;
+    if (f == NULL) return NULL; // no valid frame received
 
     if (_verboseLogging) {
-        MessageOutput.printf("%s frame_data '%s' length=%d\r\n", TAG, frame_data, length);
-        MessageOutput.printf("%s frame_chksum read=%04X, computed=%04X\r\n", TAG, read_chksum, computed_chksum);
-    }
-
-    // frame checksum not correct, discard complete frame
-    if (read_chksum != computed_chksum) return NULL;
-
-    return frame_data;
-}
-
-format_t* GobelRS485Receiver::_decode_frame(char* frame)
-{
-    format_t* f = reinterpret_cast<format_t*>(frame);
-    size_t length = strlen(frame);
-    f->ver = static_cast<uint8_t>(hex2binary(&frame[0], 2));
-    f->adr = static_cast<uint8_t>(hex2binary(&frame[2], 2));
-    f->cid1 = static_cast<uint8_t>(hex2binary(&frame[4], 2));
-    f->cid2 = static_cast<uint8_t>(hex2binary(&frame[6], 2));
-    f->infolength = static_cast<uint16_t>(hex2binary(&frame[8], 4));
-
-    if (_verboseLogging)
         MessageOutput.printf("%s ver: %02X, adr: %02X, cid1: %02X, cid2: %02X, infolength: %d info:\r\n", TAG, f->ver, f->adr, f->cid1, f->cid2, (f->infolength) & 0xFFF);
 
-    for (int idx = 12, pos = 0; idx < length; idx += 2, pos++) {
-        f->info[pos] = static_cast<uint8_t>(hex2binary(&frame[idx], 2));
-        if (_verboseLogging) {
+        for (int pos = 0; pos < ((f->infolength) & 0xFFF) / 2; pos++) {
             MessageOutput.printf(" %02X", f->info[pos]);
             if (((pos + 1) % 16) == 0) MessageOutput.println();
         }
+        MessageOutput.println();
     }
-    if (_verboseLogging) MessageOutput.println();
 
     return f;
 }
 
-format_t* GobelRS485Receiver::read_frame(void)
-{
-    size_t length;
-
-    if (!(length = readline()))
-        return NULL; // nothing read, timeout
-
-    char* frame = _decode_hw_frame(length);
-    if (frame == NULL) return NULL;
-
-    return _decode_frame(frame);
-}
-
 #endif
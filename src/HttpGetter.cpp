@@ -60,8 +60,8 @@ bool HttpGetter::init()
     // get port
     index = _host.indexOf(':');
     if (index >= 0) {
-        _host = _host.substring(0, index); // up until colon
         _port = _host.substring(index + 1).toInt(); // after colon
+        _host = _host.substring(0, index); // up until colon
     }
 
     if (_useHttps) {
@@ -72,9 +72,26 @@ bool HttpGetter::init()
         _spWiFiClient = std::make_shared<WiFiClient>();
     }
 
+    if (_keepAlive) {
+        _spHttpClient = std::make_shared<HTTPClient>();
+        _spHttpClient->setReuse(true);
+    }
+
     return true;
 }
 
+bool HttpGetter::sameServer(HttpGetter const& other) const
+{
+    return _useHttps == other._useHttps && _port == other._port
+        && _host.equalsIgnoreCase(other._host);
+}
+
+void HttpGetter::shareConnection(HttpGetter const& other)
+{
+    _spWiFiClient = other._spWiFiClient;
+    _spHttpClient = other._spHttpClient;
+}
+
 HttpRequestResult HttpGetter::performGetRequest()
 {
     // hostByName in WiFiGeneric fails to resolve local names. issue described at
@@ -84,7 +101,9 @@ HttpRequestResult HttpGetter::performGetRequest()
     // IP adresses. have to do it manually.
     IPAddress ipaddr(static_cast<uint32_t>(0));
 
-    if (!ipaddr.fromString(_host)) {
+    if (_addressValid) {
+        ipaddr = _address;
+    } else if (!ipaddr.fromString(_host)) {
         // host is not an IP address, so try to resolve the name to an address.
         // first try locally via mDNS, then via DNS. WiFiGeneric::hostByName()
         // will spam the console if done the other way around.
@@ -100,28 +119,34 @@ HttpRequestResult HttpGetter::performGetRequest()
         }
     }
 
-    auto upTmpHttpClient = std::make_unique<HTTPClient>();
+    if (_keepAlive) {
+        _address = ipaddr;
+        _addressValid = true;
+    }
+
+    auto spHttpClient = _keepAlive ? _spHttpClient : std::make_shared<HTTPClient>();
 
     // use HTTP1.0 to avoid problems with chunked transfer encoding when the
-    // stream is later used to read the server's response.
-    upTmpHttpClient->useHTTP10(true);
+    // stream is later used to read the server's response. a kept-alive
+    // connection needs HTTP/1.1, its response is read by writeToStream().
+    spHttpClient->useHTTP10(!_keepAlive);
 
-    if (!upTmpHttpClient->begin(*_spWiFiClient, ipaddr.toString(), _port, _uri, _useHttps)) {
+    if (!spHttpClient->begin(*_spWiFiClient, ipaddr.toString(), _port, _uri, _useHttps)) {
         logError("HTTP client begin() failed for %s://%s",
                 (_useHttps ? "https" : "http"), _host.c_str());
         return { false };
     }
 
-    upTmpHttpClient->setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
-    upTmpHttpClient->setUserAgent("OpenDTU-OnBattery");
-    upTmpHttpClient->setConnectTimeout(_config.Timeout);
-    upTmpHttpClient->setTimeout(_config.Timeout);
+    spHttpClient->setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
+    spHttpClient->setUserAgent("OpenDTU-OnBattery");
+    spHttpClient->setConnectTimeout(_config.Timeout);
+    spHttpClient->setTimeout(_config.Timeout);
     for (auto const& h : _additionalHeaders) {
-        upTmpHttpClient->addHeader(h.first.c_str(), h.second.c_str());
+        spHttpClient->addHeader(h.first.c_str(), h.second.c_str());
     }
 
     if (strlen(_config.HeaderKey) > 0) {
-        upTmpHttpClient->addHeader(_config.HeaderKey, _config.HeaderValue);
+        spHttpClient->addHeader(_config.HeaderKey, _config.HeaderValue);
     }
 
     using Auth_t = HttpRequestConfig::Auth;
@@ -131,41 +156,45 @@ HttpRequestResult HttpGetter::performGetRequest()
         case Auth_t::Basic: {
             String credentials = String(_config.Username) + ":" + _config.Password;
             String authorization = "Basic " + base64::encode(credentials);
-            upTmpHttpClient->addHeader("Authorization", authorization);
+            spHttpClient->addHeader("Authorization", authorization);
             break;
         }
         case Auth_t::Digest: {
             const char *headers[1] = {"WWW-Authenticate"};
-            upTmpHttpClient->collectHeaders(headers, 1);
+            spHttpClient->collectHeaders(headers, 1);
             break;
         }
     }
 
-    int httpCode = upTmpHttpClient->GET();
+    int httpCode = spHttpClient->GET();
 
     if (httpCode == HTTP_CODE_UNAUTHORIZED && _config.AuthType == Auth_t::Digest) {
-        if (!upTmpHttpClient->hasHeader("WWW-Authenticate")) {
+        if (!spHttpClient->hasHeader("WWW-Authenticate")) {
             logError("Cannot perform digest authentication as server did "
                         "not send a WWW-Authenticate header");
-            return { false };
+            return { false, std::move(spHttpClient), _spWiFiClient };
         }
-        String authReq = upTmpHttpClient->header("WWW-Authenticate");
+        String authReq = spHttpClient->header("WWW-Authenticate");
         String authorization = getAuthDigest(authReq, 1);
-        upTmpHttpClient->addHeader("Authorization", authorization);
-        httpCode = upTmpHttpClient->GET();
+        spHttpClient->addHeader("Authorization", authorization);
+        httpCode = spHttpClient->GET();
     }
 
     if (httpCode <= 0) {
-        logError("HTTP Error: %s", upTmpHttpClient->errorToString(httpCode).c_str());
-        return { false };
+        // the server may have moved to another address
+        _addressValid = false;
+        logError("HTTP Error: %s", spHttpClient->errorToString(httpCode).c_str());
+        return { false, std::move(spHttpClient), _spWiFiClient };
     }
 
     if (httpCode != HTTP_CODE_OK) {
+        // ending the request through the result discards the response,
+        // so a kept-alive connection stays usable
         logError("Bad HTTP code: %d", httpCode);
-        return { false };
+        return { false, std::move(spHttpClient), _spWiFiClient };
     }
 
-    return { true, std::move(upTmpHttpClient), _spWiFiClient };
+    return { true, std::move(spHttpClient), _spWiFiClient };
 }
 
 static String sha256(const String& data) {
@@ -33,7 +33,8 @@ static constexpr char TAG[] = "[HuaweiCanClass]";
 void HuaweiCanCommunicationTask(void* parameter) {
   for( ;; ) {
     HuaweiCanComm.loop();
-    yield();
+    // woken up by the CAN I/O task when frames arrived
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
   }
 }
 
@@ -59,6 +60,7 @@ bool HuaweiCanCommClass::init() {
 #if defined(BOARD_HAS_PSRAM)
             g_config.intr_flags = ESP_INTR_FLAG_LEVEL2;
 #endif
+            g_config.rx_queue_len = 32;
             twai_timing_config_t t_config = TWAI_TIMING_CONFIG_125KBITS();
             twai_filter_config_t f_config = {.acceptance_code = 0x1081407F,
                                              .acceptance_mask = TWAI_EXTD_ID_MASK,
@@ -158,78 +160,82 @@ bool HuaweiCanCommClass::init() {
     return true;
 }
 
-// Public methods need to obtain semaphore
-
-void HuaweiCanCommClass::loop()
+// called from the CAN I/O task, reads one frame without waiting for it
+bool HuaweiCanCommClass::readFrame(twai_message_t& rx_message)
 {
-  std::lock_guard<std::mutex> lock(_mutex);
-
-  twai_message_t rx_message = {};
-  bool gotMessage = false;
   auto _provider = PinMapping.get().charger.provider;
 
   switch (_provider) {
 #ifdef USE_CHARGER_MCP2515
     case Charger_Provider_t::MCP2515:
         {
-        if (!_CAN->isInterrupt()) break;
+        std::lock_guard<std::mutex> lock(_controllerMutex);
+
+        if (!_CAN->isInterrupt()) return false;
 
         // If CAN_INT pin is low, read receive buffer
         uint8_t rc;
         if ((rc = _CAN->readMsgBuf(reinterpret_cast<can_message_t*>(&rx_message))) != CAN_OK) {
             MessageOutput.printf("%s MCP2515 failed to read CAN message: Error code %d\r\n", TAG, rc);
-            break;
+            return false;
         }
-        gotMessage = true;
         }
-        break;
+        return true;
 #endif
 #ifdef USE_CHARGER_CAN0
     case Charger_Provider_t::CAN0:
-        {
-        // Check for messages. twai_recive is blocking when there is no data so we return if there are no frames in the buffer
-        twai_status_info_t status_info;
-        if (twai_get_status_info(&status_info) != ESP_OK) {
-            MessageOutput.printf("%s Failed to get Twai status info\r\n", TAG);
-            break;
-        }
-
-        if (status_info.msgs_to_rx) {
-            // Wait for message to be received, function is blocking
-            if (twai_receive(&rx_message, pdMS_TO_TICKS(100)) == ESP_OK) {
-                gotMessage = true;
-            } else {
-                MessageOutput.printf("%s Failed to receive message\r\n", TAG);
-            }
-        } else {
-            //  MessageOutput.printf("%s no message received\r\n", TAG);
-        }
-        }
-        break;
+        // the driver queues received frames, do not wait for more
+        return twai_receive(&rx_message, 0) == ESP_OK;
 #endif
 #ifdef USE_CHARGER_I2C
     case Charger_Provider_t::I2C0:
     case Charger_Provider_t::I2C1:
-        if (CAN_MSGAVAIL != i2c_can->checkReceive()) break;
-
-        if (CAN_OK == i2c_can->readMsgBuf(&rx_message.data_length_code, rx_message.data)) {    // read data,  len: data length, buf: data buf
-            if (rx_message.data_length_code > 0 && rx_message.data_length_code <= 8) {
-                rx_message.identifier = i2c_can->getCanId();
-                rx_message.extd = i2c_can->isExtendedFrame();
-                rx_message.rtr = i2c_can->isRemoteRequest();
-                gotMessage = true;
-            } else {
-//                MessageOutput.printf("I2C CAN received %d bytes\r\n", rx_message.data_length_code);
-            }
-        } else {
+        {
+        std::lock_guard<std::mutex> lock(_controllerMutex);
+
+        if (CAN_MSGAVAIL != i2c_can->checkReceive()) return false;
+
+        if (CAN_OK != i2c_can->readMsgBuf(&rx_message.data_length_code, rx_message.data)) {    // read data,  len: data length, buf: data buf
 //            MessageOutput.println("I2C CAN nothing received");
+            return false;
+        }
+
+        rx_message.identifier = i2c_can->getCanId();
+        rx_message.extd = i2c_can->isExtendedFrame();
+        rx_message.rtr = i2c_can->isRemoteRequest();
         }
-        break;
+        return true;
 #endif
     default:;
   }
 
-  if (gotMessage) {
+  return false;
+}
+
+void HuaweiCanCommClass::attach(TaskHandle_t notify)
+{
+  static const CanIoClass::Filters filters = { { 0x1081407F, 0x1FFFFFFF, true } };
+
+  auto const& pin = PinMapping.get().charger;
+  auto wakeup = CanIoClass::Wakeup::Poll;
+  if (pin.provider == Charger_Provider_t::MCP2515) { wakeup = CanIoClass::Wakeup::Interrupt; }
+  if (pin.provider == Charger_Provider_t::CAN0) { wakeup = CanIoClass::Wakeup::Twai; }
+
+  _frames.clear();
+  CanIo.attach(TAG, [this](twai_message_t& rx_message) { return readFrame(rx_message); },
+      filters, _frames, wakeup, pin.mcp2515.irq, notify);
+}
+
+// Public methods need to obtain semaphore
+
+void HuaweiCanCommClass::loop()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  CanFrame_t frame;
+  while (_frames.try_pop(frame)) {
+    auto& rx_message = frame.message;
+
     if((rx_message.identifier & 0x80000000) == 0x80000000) {   // Determine if ID is standard (11 bits) or extended (29 bits)
       if ((rx_message.identifier & 0x1FFFFFFF) == 0x1081407F && rx_message.data_length_code == 8) {
 
@@ -313,6 +319,7 @@ byte HuaweiCanCommClass::sendMsgBuf(uint32_t identifier, uint8_t extd, uint8_t l
 #ifdef USE_CHARGER_MCP2515
         case Charger_Provider_t::MCP2515:
             {
+            std::lock_guard<std::mutex> lock(_controllerMutex);
             int rc;
             if ((rc = _CAN->sendMsgBuf(reinterpret_cast<can_message_t*>(&tx_message))) == CAN_OK)
             {
@@ -325,7 +332,10 @@ byte HuaweiCanCommClass::sendMsgBuf(uint32_t identifier, uint8_t extd, uint8_t l
 #ifdef USE_CHARGER_I2C
         case Charger_Provider_t::I2C0:
         case Charger_Provider_t::I2C1:
+            {
+            std::lock_guard<std::mutex> lock(_controllerMutex);
             i2c_can->sendMsgBuf(tx_message.identifier, (uint8_t)tx_message.extd, tx_message.data_length_code, tx_message.data);
+            }
             return CAN_OK;
 #endif
         default:;
@@ -430,6 +440,8 @@ void HuaweiCanClass::updateSettings()
     xTaskCreate(HuaweiCanCommunicationTask, "HUAWEI_CAN_0", 3072/*stack size*/,
         NULL/*params*/, 0/*prio*/, &_HuaweiCanCommunicationTaskHdl);
 
+    HuaweiCanComm.attach(_HuaweiCanCommunicationTaskHdl);
+
     MessageOutput.printf("%s::%s CAN Bus Controller initialized Successfully!\r\n", TAG, __FUNCTION__);
     _initialized = true;
 }
@@ -102,6 +102,7 @@ void InverterSettingsClass::init(Scheduler& scheduler)
                         inv->Statistics()->setStringMaxPower(c, config.Inverter[i].channel[c].MaxChannelPower);
                         inv->Statistics()->setChannelFieldOffset(TYPE_DC, static_cast<ChannelNum_t>(c), FLD_YT, config.Inverter[i].channel[c].YieldTotalOffset);
                     }
+                    inv->notifyStatisticsUpdate();
                 }
                 MessageOutput.println(" done");
             }
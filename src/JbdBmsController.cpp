@@ -259,9 +259,9 @@ void Controller::processDataPoints(DataPointContainer const& dataPoints)
     while ( iter != dataPoints.cend() ) {
         MessageOutput.printf("[%11.3f] JBD BMS: %s: %s%s\r\n",
             static_cast<double>(iter->second.getTimestamp())/1000,
-            iter->second.getLabelText().c_str(),
+            iter->second.getLabelText(),
             iter->second.getValueText().c_str(),
-            iter->second.getUnitText().c_str());
+            iter->second.getUnitText());
         ++iter;
     }
 }
@@ -234,9 +234,9 @@ void Controller::processDataPoints(DataPointContainer const& dataPoints)
     while ( iter != dataPoints.cend() ) {
         MessageOutput.printf("%s:[%11.3f] %s: %s%s\r\n", TAG,
             static_cast<double>(iter->second.getTimestamp())/1000,
-            iter->second.getLabelText().c_str(),
+            iter->second.getLabelText(),
             iter->second.getValueText().c_str(),
-            iter->second.getUnitText().c_str());
+            iter->second.getUnitText());
         ++iter;
     }
 }
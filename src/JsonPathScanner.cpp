@@ -0,0 +1,385 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "JsonPathScanner.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+bool isWhitespace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+} // namespace
+
+bool JsonPathScanner::addPath(char const* path)
+{
+    if (_pathCount >= MaxPaths) { return false; }
+
+    auto& p = _paths[_pathCount];
+    p.text = path;
+    p.segmentCount = 0;
+
+    // empty segments are skipped, like in Utils::getJsonValueByPath()
+    size_t length = strlen(path);
+    size_t start = 0;
+    while (start <= length) {
+        size_t end = start;
+        while (end < length && path[end] != '/') { end++; }
+
+        if (end > start) {
+            if (p.segmentCount >= MaxDepth) { return false; }
+            p.segments[p.segmentCount++] = { static_cast<uint16_t>(start),
+                static_cast<uint8_t>(std::min<size_t>(end - start, UINT8_MAX)) };
+        }
+
+        start = end + 1;
+    }
+
+    p.matched = 0;
+    p.result = Result::Missing;
+    p.value = 0;
+
+    _pathCount++;
+    return true;
+}
+
+void JsonPathScanner::reset()
+{
+    for (size_t i = 0; i < _pathCount; i++) {
+        _paths[i].matched = 0;
+        _paths[i].result = Result::Missing;
+        _paths[i].value = 0;
+    }
+
+    _state = State::Value;
+    _error = nullptr;
+    _depth = 0;
+    _escape = false;
+    _unicodeDigits = 0;
+    _keyLength = 0;
+    _keyOverflow = false;
+    _capture = 0;
+    _textLength = 0;
+    _textOverflow = false;
+}
+
+size_t JsonPathScanner::write(uint8_t c)
+{
+    parse(static_cast<char>(c));
+    return 1;
+}
+
+size_t JsonPathScanner::write(const uint8_t* buffer, size_t size)
+{
+    for (size_t i = 0; i < size && _state != State::Error; i++) {
+        parse(static_cast<char>(buffer[i]));
+    }
+
+    // the rest of a malformed text is discarded, the transfer must go on
+    return size;
+}
+
+char const* JsonPathScanner::getError() const
+{
+    if (_error != nullptr) { return _error; }
+    if (_state != State::Done) { return "incomplete JSON"; }
+    return nullptr;
+}
+
+bool JsonPathScanner::getValue(size_t path, float& value, String& error) const
+{
+    if (path >= _pathCount) {
+        error = "Invalid JSON path index";
+        return false;
+    }
+
+    auto const& p = _paths[path];
+
+    switch (p.result) {
+    case Result::Number:
+        value = p.value;
+        return true;
+    case Result::Missing:
+        error = String("Value at JSON path '") + p.text + "' not found";
+        break;
+    case Result::NotNumeric:
+        error = String("Value at JSON path '") + p.text + "' is not numeric";
+        break;
+    case Result::NotScalar:
+        error = String("JSON path '") + p.text + "' points to an object or array";
+        break;
+    }
+
+    return false;
+}
+
+void JsonPathScanner::fail(char const* error)
+{
+    _state = State::Error;
+    _error = error;
+}
+
+JsonPathScanner::StringChar JsonPathScanner::stringChar(char c, char& out)
+{
+    // the digits of \uXXXX, the character itself is replaced by '?'
+    if (_unicodeDigits > 0) {
+        _unicodeDigits--;
+        return StringChar::Skip;
+    }
+
+    if (_escape) {
+        _escape = false;
+        switch (c) {
+        case 'b': out = '\b'; break;
+        case 'f': out = '\f'; break;
+        case 'n': out = '\n'; break;
+        case 'r': out = '\r'; break;
+        case 't': out = '\t'; break;
+        case 'u':
+            _unicodeDigits = 4;
+            out = '?';
+            break;
+        default: out = c; break;
+        }
+        return StringChar::Append;
+    }
+
+    if (c == '\\') {
+        _escape = true;
+        return StringChar::Skip;
+    }
+
+    if (c == '"') { return StringChar::End; }
+
+    out = c;
+    return StringChar::Append;
+}
+
+void JsonPathScanner::parse(char c)
+{
+    char out;
+
+    switch (_state) {
+    case State::Value:
+        if (isWhitespace(c)) { return; }
+        beginValue(c);
+        return;
+
+    case State::FirstElement:
+        if (isWhitespace(c)) { return; }
+        if (c == ']') {
+            leaveContainer();
+            return;
+        }
+        enterChild(nullptr, 0, _levels[_depth - 1].index++);
+        beginValue(c);
+        return;
+
+    case State::FirstKey:
+        if (isWhitespace(c)) { return; }
+        if (c == '}') {
+            leaveContainer();
+            return;
+        }
+        // fall through
+    case State::Key:
+        if (isWhitespace(c)) { return; }
+        if (c != '"') { return fail("expected a key"); }
+        _keyLength = 0;
+        _keyOverflow = false;
+        _state = State::KeyString;
+        return;
+
+    case State::KeyString:
+        switch (stringChar(c, out)) {
+        case StringChar::Skip:
+            return;
+        case StringChar::Append:
+            if (_keyLength < MaxKeyLength) {
+                _key[_keyLength++] = out;
+            } else {
+                _keyOverflow = true;
+            }
+            return;
+        case StringChar::End:
+            enterChild(_key, _keyLength, -1);
+            _state = State::Colon;
+            return;
+        }
+        return;
+
+    case State::Colon:
+        if (isWhitespace(c)) { return; }
+        if (c != ':') { return fail("expected ':'"); }
+        _state = State::Value;
+        return;
+
+    case State::StringValue:
+        switch (stringChar(c, out)) {
+        case StringChar::Skip:
+            return;
+        case StringChar::Append:
+            if (_capture == 0) { return; }
+            if (_textLength < sizeof(_text) - 1) {
+                _text[_textLength++] = out;
+            } else {
+                _textOverflow = true;
+            }
+            return;
+        case StringChar::End:
+            endScalar(true);
+            return;
+        }
+        return;
+
+    case State::Literal:
+        if (isWhitespace(c) || c == ',' || c == ']' || c == '}') {
+            endScalar(false);
+            parse(c);
+            return;
+        }
+        if (_capture == 0) { return; }
+        if (_textLength < sizeof(_text) - 1) {
+            _text[_textLength++] = c;
+        } else {
+            _textOverflow = true;
+        }
+        return;
+
+    case State::AfterValue: {
+        if (isWhitespace(c)) { return; }
+        auto& level = _levels[_depth - 1];
+        if (c == ',') {
+            if (level.array) {
+                enterChild(nullptr, 0, level.index++);
+                _state = State::Value;
+            } else {
+                _state = State::Key;
+            }
+            return;
+        }
+        if ((c == ']' && level.array) || (c == '}' && !level.array)) {
+            leaveContainer();
+            return;
+        }
+        return fail("expected ',' or the end of a container");
+    }
+
+    case State::Done:
+        if (isWhitespace(c)) { return; }
+        return fail("unexpected data after the JSON value");
+
+    case State::Error:
+        return;
+    }
+}
+
+void JsonPathScanner::beginValue(char c)
+{
+    // the paths ending at the current position
+    uint8_t targets = 0;
+    for (size_t i = 0; i < _pathCount; i++) {
+        auto const& p = _paths[i];
+        if (p.segmentCount == _depth && p.matched == _depth) { targets |= 1 << i; }
+    }
+
+    if (c == '{' || c == '[') {
+        for (size_t i = 0; i < _pathCount; i++) {
+            if (targets & (1 << i)) { _paths[i].result = Result::NotScalar; }
+        }
+
+        if (_depth >= MaxDepth) { return fail("JSON nested too deeply"); }
+
+        _levels[_depth++] = { c == '[', 0 };
+        _state = (c == '[') ? State::FirstElement : State::FirstKey;
+        return;
+    }
+
+    _capture = targets;
+    _textLength = 0;
+    _textOverflow = false;
+
+    if (c == '"') {
+        _escape = false;
+        _unicodeDigits = 0;
+        _state = State::StringValue;
+        return;
+    }
+
+    if (c == '-' || (c >= '0' && c <= '9') || c == 't' || c == 'f' || c == 'n') {
+        if (_capture != 0) { _text[_textLength++] = c; }
+        _state = State::Literal;
+        return;
+    }
+
+    fail("unexpected character");
+}
+
+void JsonPathScanner::endScalar(bool isString)
+{
+    if (_capture != 0) {
+        _text[_textLength] = '\0';
+
+        char* end = nullptr;
+        float value = strtof(_text, &end);
+
+        // strings only need to start with a number, like std::stof() did
+        bool numeric = isString
+            ? (end != _text)
+            : (_textLength > 0 && !_textOverflow && end == _text + _textLength);
+
+        for (size_t i = 0; i < _pathCount; i++) {
+            if (!(_capture & (1 << i))) { continue; }
+            _paths[i].result = numeric ? Result::Number : Result::NotNumeric;
+            _paths[i].value = value;
+        }
+
+        _capture = 0;
+    }
+
+    _state = (_depth == 0) ? State::Done : State::AfterValue;
+}
+
+// called for every object member and array element at the current depth
+void JsonPathScanner::enterChild(char const* key, size_t length, int index)
+{
+    uint8_t parent = _depth - 1;
+
+    for (size_t i = 0; i < _pathCount; i++) {
+        auto& p = _paths[i];
+        if (p.matched > parent) { p.matched = parent; }
+
+        if (p.matched == parent && parent < p.segmentCount
+            && segmentMatches(p, key, length, index)) {
+            p.matched = _depth;
+        }
+    }
+}
+
+void JsonPathScanner::leaveContainer()
+{
+    _depth--;
+
+    for (size_t i = 0; i < _pathCount; i++) {
+        if (_paths[i].matched > _depth) { _paths[i].matched = _depth; }
+    }
+
+    _state = (_depth == 0) ? State::Done : State::AfterValue;
+}
+
+bool JsonPathScanner::segmentMatches(Path_t const& path, char const* key, size_t length, int index) const
+{
+    auto const& segment = path.segments[_depth - 1];
+    char const* text = path.text + segment.offset;
+
+    if (index >= 0) {
+        // "[n]" selects an array element
+        if (segment.length < 3 || text[0] != '[' || text[segment.length - 1] != ']') { return false; }
+        return atoi(text + 1) == index;
+    }
+
+    if (_keyOverflow) { return false; }
+    return segment.length == length && memcmp(text, key, length) == 0;
+}
@@ -0,0 +1,165 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "JsonStreamWriter.h"
+#include <cinttypes>
+#include <cmath>
+
+void JsonStreamWriter::writeKey(const char* key)
+{
+    _started = true;
+
+    if (_depth == 0) { return; }
+
+    uint32_t bit = 1UL << (_depth - 1);
+    if (_hasElements & bit) { _buffer += ','; }
+    _hasElements |= bit;
+
+    if (key != nullptr) {
+        writeString(key);
+        _buffer += ':';
+    }
+}
+
+void JsonStreamWriter::writeString(const char* value)
+{
+    _buffer += '"';
+
+    for (const char* p = value; *p != '\0'; ++p) {
+        char c = *p;
+        switch (c) {
+        case '"': _buffer += "\\\""; break;
+        case '\\': _buffer += "\\\\"; break;
+        case '\n': _buffer += "\\n"; break;
+        case '\r': _buffer += "\\r"; break;
+        case '\t': _buffer += "\\t"; break;
+        default:
+            if (static_cast<uint8_t>(c) < 0x20) {
+                char escaped[7];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                _buffer += escaped;
+            } else {
+                _buffer += c;
+            }
+            break;
+        }
+    }
+
+    _buffer += '"';
+}
+
+void JsonStreamWriter::open(const char* key, char bracket)
+{
+    writeKey(key);
+    _buffer += bracket;
+
+    ++_depth;
+    _hasElements &= ~(1UL << (_depth - 1));
+}
+
+void JsonStreamWriter::close(char bracket)
+{
+    if (_depth == 0) { return; }
+
+    --_depth;
+    _buffer += bracket;
+}
+
+void JsonStreamWriter::beginObject(const char* key) { open(key, '{'); }
+void JsonStreamWriter::endObject() { close('}'); }
+void JsonStreamWriter::beginArray(const char* key) { open(key, '['); }
+void JsonStreamWriter::endArray() { close(']'); }
+
+void JsonStreamWriter::add(const char* key, const char* value)
+{
+    writeKey(key);
+
+    if (value == nullptr) {
+        _buffer += "null";
+        return;
+    }
+
+    writeString(value);
+}
+
+void JsonStreamWriter::add(const char* key, bool value)
+{
+    writeKey(key);
+    _buffer += value ? "true" : "false";
+}
+
+// same precision as ArduinoJson uses for float values
+void JsonStreamWriter::add(const char* key, float value)
+{
+    writeKey(key);
+
+    if (!std::isfinite(value)) {
+        _buffer += "null";
+        return;
+    }
+
+    char text[24];
+    snprintf(text, sizeof(text), "%.7g", value);
+    _buffer += text;
+}
+
+void JsonStreamWriter::add(const char* key, double value)
+{
+    writeKey(key);
+
+    if (!std::isfinite(value)) {
+        _buffer += "null";
+        return;
+    }
+
+    char text[32];
+    snprintf(text, sizeof(text), "%.15g", value);
+    _buffer += text;
+}
+
+void JsonStreamWriter::addNull(const char* key)
+{
+    writeKey(key);
+    _buffer += "null";
+}
+
+void JsonStreamWriter::addSigned(const char* key, int64_t value)
+{
+    writeKey(key);
+
+    char text[24];
+    snprintf(text, sizeof(text), "%" PRId64, value);
+    _buffer += text;
+}
+
+void JsonStreamWriter::addUnsigned(const char* key, uint64_t value)
+{
+    writeKey(key);
+
+    char text[24];
+    snprintf(text, sizeof(text), "%" PRIu64, value);
+    _buffer += text;
+}
+
+void JsonStreamWriter::addMembers(JsonObjectConst object)
+{
+    for (JsonPairConst kv : object) {
+        add(kv.key().c_str(), kv.value());
+    }
+}
+
+void JsonStreamWriter::add(const char* key, JsonVariantConst value)
+{
+    writeKey(key);
+
+    String text;
+    serializeJson(value, text);
+    _buffer += text;
+}
+
+void JsonStreamWriter::addValue(const char* key, float value, const char* unit, uint8_t digits)
+{
+    beginObject(key);
+    add("v", value);
+    add("u", unit);
+    add("d", digits);
+    endObject();
+}
@@ -14,8 +14,10 @@
 #include "SunPosition.h"
 #include "PowerMeter.h"
 #include "Configuration.h"
+#include "PowerLimiter.h"
 #include <Hoymiles.h>
 #include <math.h>
+#include <algorithm>
 #include <AsyncJson.h>
 #include "SpiManager.h"
 #include "mcp2515_init_spi.h"
@@ -25,8 +27,6 @@ Preferences preferences;
 
 MeanWellCanClass MeanWellCan;
 
-SemaphoreHandle_t xSemaphore = NULL;
-
 MeanWellCanClass::MeanWellCanClass()
     : _loopTask(TASK_IMMEDIATE, TASK_FOREVER, std::bind(&MeanWellCanClass::loop, this))
 {
@@ -34,6 +34,9 @@ MeanWellCanClass::MeanWellCanClass()
 
 static constexpr char sEEPROMwrites[] = "EEPROMwrites";
 
+// responses of the charger are sent with identifier 0x000C00xx
+static const CanIoClass::Filters sResponseFilters = { { 0x000C0000, 0x1FFFFF00, true } };
+
 void MeanWellCanClass::init(Scheduler& scheduler)
 {
     MessageOutput.print("Initialize MeanWell AC charger interface... ");
@@ -50,9 +53,6 @@ void MeanWellCanClass::init(Scheduler& scheduler)
     EEPROMwrites = preferences.getULong(sEEPROMwrites);
     MessageOutput.printf("%s = %u, ", sEEPROMwrites, EEPROMwrites);
 
-    if (xSemaphore == NULL)
-        xSemaphore = xSemaphoreCreateMutex();
-
     scheduler.addTask(_loopTask);
 
     if (!Configuration.get().MeanWell.Enabled) {
@@ -103,8 +103,9 @@ void MeanWellCanClass::updateSettings()
 #if defined(BOARD_HAS_PSRAM)
             g_config.intr_flags = ESP_INTR_FLAG_LEVEL2;
 #endif
+            g_config.rx_queue_len = 32;
             twai_timing_config_t t_config = TWAI_TIMING_CONFIG_250KBITS();
-            twai_filter_config_t f_config = TWAI_FILTER_CONFIG_ACCEPT_ALL();
+            twai_filter_config_t f_config = CanIo.getTwaiFilterConfig(sResponseFilters);
 
             // Install TWAI driver
             MessageOutput.print("Twai driver install");
@@ -184,11 +185,20 @@ void MeanWellCanClass::updateSettings()
     	    }
             MessageOutput.printf("MCP2515 CAN: Quarz = %u Mhz\r\n", (unsigned int)(frequency/1000000UL));
 
-            if ((rc = CAN->begin(MCP_ANY, CAN_250KBPS, mcp_frequency)) != CAN_OK) {
+            if ((rc = CAN->begin(MCP_STDEXT, CAN_250KBPS, mcp_frequency)) != CAN_OK) {
                 MessageOutput.printf("%s MCP2515 failed to initialize. Error code: %d\r\n", _providerName, rc);
                 return;
             };
 
+            uint32_t id, mask;
+            bool extd;
+            CanIoClass::mergeFilters(sResponseFilters, id, mask, extd);
+            CAN->setFilterMask(MASK0, extd, mask);
+            CAN->setFilterMask(MASK1, extd, mask);
+            for (auto rxf : { RXF0, RXF1, RXF2, RXF3, RXF4, RXF5 }) {
+                CAN->setFilter(rxf, extd, id);
+            }
+
 	        // Change to normal mode to allow messages to be transmitted
 	        if ((rc = CAN->setMode(MCP_NORMAL)) != CAN_OK) {
                 MessageOutput.printf("%s MCP2515 failed to set mode to NORMAL. Error code: %d\r\n", _providerName, rc);
@@ -202,6 +212,13 @@ void MeanWellCanClass::updateSettings()
             return;
     }
 
+    auto wakeup = CanIoClass::Wakeup::Poll;
+    if (pin.provider == Charger_Provider_t::MCP2515) { wakeup = CanIoClass::Wakeup::Interrupt; }
+    if (pin.provider == Charger_Provider_t::CAN0) { wakeup = CanIoClass::Wakeup::Twai; }
+
+    CanIo.attach(_providerName, [this](twai_message_t& rx_message) { return readFrame(rx_message); },
+            sResponseFilters, _frames, wakeup, pin.mcp2515.irq);
+
     _loopTask.enable();
 
     _initialized = true;
@@ -209,152 +226,80 @@ void MeanWellCanClass::updateSettings()
     MessageOutput.println("Initialized Successfully!");
 }
 
-bool MeanWellCanClass::getCanCharger(void)
+// called from the CAN I/O task, reads one frame without waiting for it
+bool MeanWellCanClass::readFrame(twai_message_t& rx_message)
 {
-    bool rc = false;
+    std::lock_guard<std::mutex> lock(_controllerMutex);
 
-    uint32_t t = millis();
-    while (millis() - t < 750) { // timeout 750ms
-        rc = parseCanPackets();
-        if (rc == true)
-            break;
-    }
-
-    return rc;
-}
-
-bool MeanWellCanClass::parseCanPackets(void)
-{
-    if (xSemaphore == NULL) {
-        MessageOutput.printf("%s xSemapore not initialized\r\n", _providerName);
-        return false;
-    }
-
-      auto _provider = PinMapping.get().charger.provider;
-
-    /* See if we can obtain the semaphore.  If the semaphore is not
-       available wait 1000 ticks to see if it becomes free. */
-    if (xSemaphoreTake(xSemaphore, (TickType_t)1000) == pdTRUE) {
-        twai_message_t rx_message = {};
+    auto _provider = PinMapping.get().charger.provider;
 
-        switch (_provider) {
+    switch (_provider) {
 #ifdef USE_CHARGER_CAN0
-            case Charger_Provider_t::CAN0:
-                {
-                // Check for messages. twai_recive is blocking when there is no data so we return if there are no frames in the buffer
-                twai_status_info_t status_info;
-                if (twai_get_status_info(&status_info) != ESP_OK) {
-                    MessageOutput.printf("%s CAN Failed to get Twai status info\r\n", _providerName);
-                    xSemaphoreGive(xSemaphore);
-                    return false;
-                }
-                if (status_info.msgs_to_rx == 0) {
-                    //  MessageOutput.printf("%s CAN no message received\r\n", _providerName);
-                    xSemaphoreGive(xSemaphore);
-                    return false;
-                }
-
-                // Wait for message to be received, function is blocking
-                if (twai_receive(&rx_message, pdMS_TO_TICKS(100)) != ESP_OK) {
-                    MessageOutput.printf("%s CAN Failed to receive message\r\n", _providerName);
-                    xSemaphoreGive(xSemaphore);
-                    return false;
-                }
-                }
-                break;
+        case Charger_Provider_t::CAN0:
+            // the driver queues received frames, do not wait for more
+            return twai_receive(&rx_message, 0) == ESP_OK;
 #endif
 #ifdef USE_CHARGER_I2C
-            case Charger_Provider_t::I2C0:
-            case Charger_Provider_t::I2C1:
-                if (CAN_MSGAVAIL != i2c_can->checkReceive()) {
-                    xSemaphoreGive(xSemaphore);
-                    return false;
-                }
-
-                if (CAN_OK != i2c_can->readMsgBuf(&rx_message.data_length_code, rx_message.data)) {    // read data,  len: data length, buf: data buf
-                    MessageOutput.printf("%s CAN nothing received\r\n", _providerName);
-                    xSemaphoreGive(xSemaphore);
-                    return false;
-                }
-
-                if (rx_message.data_length_code > 8) {
-                    MessageOutput.printf("%s CAN received %d bytes\r\n", _providerName, rx_message.data_length_code);
-                    xSemaphoreGive(xSemaphore);
-                    return false;
-                }
+        case Charger_Provider_t::I2C0:
+        case Charger_Provider_t::I2C1:
+            if (CAN_MSGAVAIL != i2c_can->checkReceive()) {
+                return false;
+            }
 
-                if(rx_message.data_length_code == 0) {
-                    xSemaphoreGive(xSemaphore);
-                    return false;
-                }
+            if (CAN_OK != i2c_can->readMsgBuf(&rx_message.data_length_code, rx_message.data)) {    // read data,  len: data length, buf: data buf
+                MessageOutput.printf("%s CAN nothing received\r\n", _providerName);
+                return false;
+            }
 
-                rx_message.identifier = i2c_can->getCanId();
-                rx_message.extd = i2c_can->isExtendedFrame();
-                rx_message.rtr = i2c_can->isRemoteRequest();
-                break;
+            rx_message.identifier = i2c_can->getCanId();
+            rx_message.extd = i2c_can->isExtendedFrame();
+            rx_message.rtr = i2c_can->isRemoteRequest();
+            return true;
 #endif
 #ifdef USE_CHARGER_MCP2515
-            case Charger_Provider_t::MCP2515:
-                {
-                if (!CAN->isInterrupt()) {
-                    //  MessageOutput.printf("%s CAN no message received\r\n", _providerName);
-                    xSemaphoreGive(xSemaphore);
-                    return false;
-                }
-                // If CAN_INT pin is low, read receive buffer
-
-                int rc;
-                if ((rc = CAN->readMsgBuf(reinterpret_cast<can_message_t*>(&rx_message))) != CAN_OK) { // Read data: len = data length, buf = data byte(s)
-                    MessageOutput.printf("%s failed to read CAN message: Error code %d\r\n", _providerName, rc);
-                    xSemaphoreGive(xSemaphore);
-                    return false;
-                }
+        case Charger_Provider_t::MCP2515:
+            {
+            if (!CAN->isInterrupt()) {
+                return false;
+            }
+            // If CAN_INT pin is low, read receive buffer
 
-                if (_verboseLogging) {
-                    if(rx_message.extd)     // Determine if ID is standard (11 bits) or extended (29 bits)
-                        MessageOutput.printf("Extended ID: 0x%.8" PRIx32 " DLC: %1d  Data:", rx_message.identifier & 0x1FFFFFFF, rx_message.data_length_code);
-                    else
-                    MessageOutput.printf("Standard ID: 0x%.3" PRIx32 " DLC: %1d  Data:", rx_message.identifier, rx_message.data_length_code);
-                }
-                if (rx_message.rtr){    // Determine if message is a remote request frame.
-                    int len = rx_message.data_length_code>32?32:rx_message.data_length_code;
-                    char data[len*3+1] = "";
-                    for (uint8_t i=0; i<len; i++)
-                        snprintf(&data[i*3], sizeof(data)-i*3, "%02X ", rx_message.data[i]);
-                    data[strlen(data)] = 0;
-                    MessageOutput.printf(" REMOTE REQUEST FRAME %s\r\n", data);
-                    xSemaphoreGive(xSemaphore);
-                    return false;
-                }
-                }
-                break;
+            int rc;
+            if ((rc = CAN->readMsgBuf(reinterpret_cast<can_message_t*>(&rx_message))) != CAN_OK) { // Read data: len = data length, buf = data byte(s)
+                MessageOutput.printf("%s failed to read CAN message: Error code %d\r\n", _providerName, rc);
+                return false;
+            }
+            }
+            return true;
 #endif
-            default:;
-        }
+        default:;
+    }
 
-        _meanwellLastResponseTime = millis(); // save last response time
-        yield();
+    return false;
+}
 
-        if (_verboseLogging)
-            MessageOutput.printf("%s id: 0x%08X, extd: %d, data len: %d bytes\r\n", _providerName,
-                rx_message.identifier, rx_message.extd, rx_message.data_length_code);
-
-        switch (rx_message.identifier & 0xFFFFFF00) {
-        case 0x000C0100:
-            // MessageOutput.printf("%s 0x%08X len: %d\r\n", _providerName, rx_message.identifier, rx_message.data_length_code);
-            xSemaphoreGive(xSemaphore);
-            return false;
-        case 0x000C0000:
-            onReceive(rx_message.data, rx_message.data_length_code);
-        }
+// handles at most one frame queued by the CAN I/O task. returns true if a
+// frame was handled, so the caller can drain the queue by calling this until
+// it returns false.
+bool MeanWellCanClass::parseCanPackets(void)
+{
+    CanFrame_t frame;
+    if (!_frames.try_pop(frame)) { return false; }
 
-        xSemaphoreGive(xSemaphore);
-        return true;
-    }
+    auto& rx_message = frame.message;
 
-    MessageOutput.printf("%s xSemapore not free\r\n", _providerName);
+    _meanwellLastResponseTime = frame.timestamp; // save last response time
 
-    return false;
+    if (_verboseLogging)
+        MessageOutput.printf(LogLevel::Verbose, "%s id: 0x%08X, extd: %d, data len: %d bytes\r\n", _providerName,
+            rx_message.identifier, rx_message.extd, rx_message.data_length_code);
+
+    if (rx_message.data_length_code >= 2) {
+        onReceive(rx_message.data, rx_message.data_length_code);
+        completeTransaction(readUnsignedInt16(rx_message.data));
+    }
+
+    return true;
 }
 
 typedef struct {
@@ -428,21 +373,21 @@ void MeanWellCanClass::onReceive(uint8_t* frame, uint8_t len)
     case 0x0000: // OPERATION 1 byte ON/OFF control
         _rp.operation = *(frame + 2);
 #ifdef MEANWELL_DEBUG_ENABLED
-        if (_verboseLogging) MessageOutput.printf("%s Operation: %02X %s\r\n", _providerName, _rp.operation, _rp.operation ? "On" : "Off");
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s Operation: %02X %s\r\n", _providerName, _rp.operation, _rp.operation ? "On" : "Off");
 #endif
         break;
 
     case 0x0020: // VOUT_SET 2 bytes Output voltage setting (format: value, F=0.01)
         _rp.outputVoltageSet = scaleValue(readUnsignedInt16(frame + 2), 0.01f);
 #ifdef MEANWELL_DEBUG_ENABLED
-        if (_verboseLogging) MessageOutput.printf("%s OutputVoltage(VOUT_SET): %.2fV\r\n", _providerName, _rp.outputVoltageSet);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s OutputVoltage(VOUT_SET): %.2fV\r\n", _providerName, _rp.outputVoltageSet);
 #endif
         break;
 
     case 0x0030: // IOUT_SET 2 bytes Output current setting (format: value, F=0.01)
         _rp.outputCurrentSet = scaleValue(readUnsignedInt16(frame + 2), 0.01f);
 #ifdef MEANWELL_DEBUG_ENABLED
-        if (_verboseLogging) MessageOutput.printf("%s OutputCurrent(IOUT_SET): %.2fA\r\n", _providerName, _rp.outputCurrentSet);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s OutputCurrent(IOUT_SET): %.2fA\r\n", _providerName, _rp.outputCurrentSet);
 #endif
         break;
 
@@ -450,7 +395,7 @@ void MeanWellCanClass::onReceive(uint8_t* frame, uint8_t len)
         _rp.FaultStatus = readUnsignedInt16(frame + 2);
 #ifdef MEANWELL_DEBUG_ENABLED
         if (_verboseLogging)
-            MessageOutput.printf("%s FAULT_STATUS : %s : HI_TEMP: %d, OP_OFF: %d, AC_FAIL: %d, SHORT: %d, OLP: %d, OVP: %d, OTP: %d\r\n", _providerName,
+            MessageOutput.printf(LogLevel::Verbose, "%s FAULT_STATUS : %s : HI_TEMP: %d, OP_OFF: %d, AC_FAIL: %d, SHORT: %d, OLP: %d, OVP: %d, OTP: %d\r\n", _providerName,
                 Word2BinaryString(_rp.FaultStatus),
                 _rp.FAULT_STATUS.HI_TEMP,
                 _rp.FAULT_STATUS.OP_OFF,
@@ -466,7 +411,7 @@ void MeanWellCanClass::onReceive(uint8_t* frame, uint8_t len)
         _rp.inputVoltage = scaleValue(readUnsignedInt16(frame + 2), 0.1f);
         if (_model < NPB_Model_t::NPB_1200_24) _rp.inputVoltage = 230.0;
 #ifdef MEANWELL_DEBUG_ENABLED
-        if (_verboseLogging) MessageOutput.printf("%s InputVoltage: %.1fV\r\n", _providerName, _rp.inputVoltage);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s InputVoltage: %.1fV\r\n", _providerName, _rp.inputVoltage);
 #endif
         break;
 
@@ -474,7 +419,7 @@ void MeanWellCanClass::onReceive(uint8_t* frame, uint8_t len)
         _rp.outputVoltage = scaleValue(readUnsignedInt16(frame + 2), 0.01f);
         calcPower();
 #ifdef MEANWELL_DEBUG_ENABLED
-        if (_verboseLogging) MessageOutput.printf("%s OutputVoltage: %.2fV\r\n", _providerName, _rp.outputVoltage);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s OutputVoltage: %.2fV\r\n", _providerName, _rp.outputVoltage);
 #endif
         break;
 
@@ -482,14 +427,14 @@ void MeanWellCanClass::onReceive(uint8_t* frame, uint8_t len)
         _rp.outputCurrent = scaleValue(readUnsignedInt16(frame + 2), 0.01f);
         calcPower();
 #ifdef MEANWELL_DEBUG_ENABLED
-        if (_verboseLogging) MessageOutput.printf("%s OutputCurrent: %.2fA\r\n", _providerName, _rp.outputCurrent);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s OutputCurrent: %.2fA\r\n", _providerName, _rp.outputCurrent);
 #endif
         break;
 
     case 0x0062: // READ_TEMPERATURE_1 2 bytes Internal ambient temperature (format: value, F=0.1)
         _rp.internalTemperature = scaleValue(readSignedInt16(frame + 2), 0.1f);
 #ifdef MEANWELL_DEBUG_ENABLED
-        if (_verboseLogging) MessageOutput.printf("%s Temperature: %.1f°C\r\n", _providerName, _rp.internalTemperature);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s Temperature: %.1f°C\r\n", _providerName, _rp.internalTemperature);
 #endif
         break;
 
@@ -506,7 +451,7 @@ void MeanWellCanClass::onReceive(uint8_t* frame, uint8_t len)
                 break;
         }
 #ifdef MEANWELL_DEBUG_ENABLED
-        if (_verboseLogging) MessageOutput.printf("%s Manufacturer Name: '%s'\r\n", _providerName, _rp.ManufacturerName);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s Manufacturer Name: '%s'\r\n", _providerName, _rp.ManufacturerName);
 #endif
         break;
 
@@ -589,7 +534,7 @@ void MeanWellCanClass::onReceive(uint8_t* frame, uint8_t len)
 
 //#ifdef MEANWELL_DEBUG_ENABLED
         //if (_verboseLogging)
-            MessageOutput.printf("%s Manufacturer Model Name: '%s' %d\r\n", _providerName, _rp.ManufacturerModelName, static_cast<int>(_model));
+            MessageOutput.printf(LogLevel::Verbose, "%s Manufacturer Model Name: '%s' %d\r\n", _providerName, _rp.ManufacturerModelName, static_cast<int>(_model));
 //#endif
         }
         break;
@@ -615,14 +560,14 @@ void MeanWellCanClass::onReceive(uint8_t* frame, uint8_t len)
     case 0x0085: // MFR_LOCATION_B0B2 3 bytes Manufacturer's factory location
         strncpy(reinterpret_cast<char*>(_rp.ManufacturerFactoryLocation), reinterpret_cast<char*>(frame + 2), 3);
 #ifdef MEANWELL_DEBUG_ENABLED
-        if (_verboseLogging) MessageOutput.printf("%s Manufacturer Factory Location: '%s'\r\n", _providerName, _rp.ManufacturerFactoryLocation);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s Manufacturer Factory Location: '%s'\r\n", _providerName, _rp.ManufacturerFactoryLocation);
 #endif
         break;
 
     case 0x0086: // MFR_DATE_B0B5 6 bytes Manufacturer date
         strncpy(reinterpret_cast<char*>(_rp.ManufacturerDate), reinterpret_cast<char*>(frame + 2), 6);
 #ifdef MEANWELL_DEBUG_ENABLED
-        if (_verboseLogging) MessageOutput.printf("%s Manufacturer Date: '%s'\r\n", _providerName, _rp.ManufacturerDate);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s Manufacturer Date: '%s'\r\n", _providerName, _rp.ManufacturerDate);
 #endif
         break;
 
@@ -633,35 +578,35 @@ void MeanWellCanClass::onReceive(uint8_t* frame, uint8_t len)
     case 0x0088: // MFR_SERIAL_B6B11 6 bytes Product serial number
         strncpy(reinterpret_cast<char*>(&(_rp.ProductSerialNo[6])), reinterpret_cast<char*>(frame + 2), 6);
 #ifdef MEANWELL_DEBUG_ENABLED
-        if (_verboseLogging) MessageOutput.printf("%s Product Serial No '%s'\r\n", _providerName, _rp.ProductSerialNo);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s Product Serial No '%s'\r\n", _providerName, _rp.ProductSerialNo);
 #endif
         break;
 
     case 0x00B0: // CURVE_CC 2 bytes Constant current setting of charge curve (format: value, F=0.01)
         _rp.curveCC = scaleValue(readUnsignedInt16(frame + 2), 0.01f);
 #ifdef MEANWELL_DEBUG_ENABLED
-        if (_verboseLogging) MessageOutput.printf("%s CurveCC: %.2fA\r\n", _providerName, _rp.curveCC);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s CurveCC: %.2fA\r\n", _providerName, _rp.curveCC);
 #endif
         break;
 
     case 0x00B1: // CURVE_CV 2 bytes Constant voltage setting of charge curve (format: value, F=0.01)
         _rp.curveCV = scaleValue(readUnsignedInt16(frame + 2), 0.01f);
 #ifdef MEANWELL_DEBUG_ENABLED
-        if (_verboseLogging) MessageOutput.printf("%s CurveCV: %.2fV\r\n", _providerName, _rp.curveCV);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s CurveCV: %.2fV\r\n", _providerName, _rp.curveCV);
 #endif
         break;
 
     case 0x00B2: // CURVE_FV 2 bytes Floating voltage setting of charge curve (format: value, F=0.01)
         _rp.curveFV = scaleValue(readUnsignedInt16(frame + 2), 0.01f);
 #ifdef MEANWELL_DEBUG_ENABLED
-        if (_verboseLogging) MessageOutput.printf("%s CurveFV: %.2fV\r\n", _providerName, _rp.curveFV);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s CurveFV: %.2fV\r\n", _providerName, _rp.curveFV);
 #endif
         break;
 
     case 0x00B3: // CURVE_TC 2 bytes Taper current setting value of charging curve (format: value, F=0.01)
         _rp.curveTC = scaleValue(readUnsignedInt16(frame + 2), 0.01f);
 #ifdef MEANWELL_DEBUG_ENABLED
-        if (_verboseLogging) MessageOutput.printf("%s CurveTC: %.2fA\r\n", _providerName, _rp.curveTC);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s CurveTC: %.2fA\r\n", _providerName, _rp.curveTC);
 #endif
         break;
 
@@ -669,7 +614,7 @@ void MeanWellCanClass::onReceive(uint8_t* frame, uint8_t len)
         _rp.CurveConfig = readUnsignedInt16(frame + 2);
 #ifdef MEANWELL_DEBUG_ENABLED
         if (_verboseLogging)
-            MessageOutput.printf("%s CURVE_CONFIG : %s : CUVE: %d, STGS: %d, TCS: %d, CUVS: %X\r\n", _providerName,
+            MessageOutput.printf(LogLevel::Verbose, "%s CURVE_CONFIG : %s : CUVE: %d, STGS: %d, TCS: %d, CUVS: %X\r\n", _providerName,
                 Word2BinaryString(_rp.CurveConfig),
                 _rp.CURVE_CONFIG.CUVE,
                 _rp.CURVE_CONFIG.STGS,
@@ -681,21 +626,21 @@ void MeanWellCanClass::onReceive(uint8_t* frame, uint8_t len)
     case 0x00B5: // CURVE_CC_TIMEOUT 2 bytes CC charge timeout setting of charging curve
         _rp.curveCC_Timeout = readUnsignedInt16(frame + 2);
 #ifdef MEANWELL_DEBUG_ENABLED
-        if (_verboseLogging) MessageOutput.printf("%s CurveCC_Timeout: %d minutes\r\n", _providerName, _rp.curveCC_Timeout);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s CurveCC_Timeout: %d minutes\r\n", _providerName, _rp.curveCC_Timeout);
 #endif
         break;
 
     case 0x00B6: // CURVE_CV_TIMEOUT 2 bytes CV charge timeout setting of charging curve
         _rp.curveCV_Timeout = readUnsignedInt16(frame + 2);
 #ifdef MEANWELL_DEBUG_ENABLED
-        if (_verboseLogging) MessageOutput.printf("%s CurveCV_Timeout: %d minutes\r\n", _providerName, _rp.curveCV_Timeout);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s CurveCV_Timeout: %d minutes\r\n", _providerName, _rp.curveCV_Timeout);
 #endif
         break;
 
     case 0x00B7: // CURVE_FV_TIMEOUT 2 bytes FV charge timeout setting of charging curve
         _rp.curveFV_Timeout = readUnsignedInt16(frame + 2);
 #ifdef MEANWELL_DEBUG_ENABLED
-        if (_verboseLogging) MessageOutput.printf("%s CurveFV_Timeout: %d minutes\r\n", _providerName, _rp.curveFV_Timeout);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s CurveFV_Timeout: %d minutes\r\n", _providerName, _rp.curveFV_Timeout);
 #endif
         break;
 
@@ -703,7 +648,7 @@ void MeanWellCanClass::onReceive(uint8_t* frame, uint8_t len)
         _rp.ChargeStatus = readUnsignedInt16(frame + 2);
 #ifdef MEANWELL_DEBUG_ENABLED
         if (_verboseLogging)
-            MessageOutput.printf("%s CHG_STATUS : %s : BTNC: %d, WAKUP_STOP: %d, FVM: %d, CVM: %d, CCM: %d, FULLM: %d\r\n", _providerName,
+            MessageOutput.printf(LogLevel::Verbose, "%s CHG_STATUS : %s : BTNC: %d, WAKUP_STOP: %d, FVM: %d, CVM: %d, CCM: %d, FULLM: %d\r\n", _providerName,
                 Word2BinaryString(_rp.ChargeStatus),
                 _rp.CHG_STATUS.BTNC,
                 _rp.CHG_STATUS.WAKEUP_STOP,
@@ -717,14 +662,14 @@ void MeanWellCanClass::onReceive(uint8_t* frame, uint8_t len)
     case 0x00B9: // CHG_RST_VBAT 2 bytes The voltage Rest to art the charging after the battery is fully
         {
             uint16_t ChgRstVbat = readUnsignedInt16(frame + 2);
-            if (_verboseLogging) MessageOutput.printf("%s CHG_RST_VBAT: %d\r\n", _providerName, ChgRstVbat);
+            if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s CHG_RST_VBAT: %d\r\n", _providerName, ChgRstVbat);
         }
         return;
 
     case 0x00C0: // SCALING_FACTOR 2 bytes Scaling ratio
         _rp.scalingFactor = readUnsignedInt16(frame + 2);
 #ifdef MEANWELL_DEBUG_ENABLED
-        if (_verboseLogging) MessageOutput.printf("%s ScalingFactor: %d, %04X\r\n", _providerName, _rp.scalingFactor, _rp.scalingFactor);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s ScalingFactor: %d, %04X\r\n", _providerName, _rp.scalingFactor, _rp.scalingFactor);
 #endif
         break;
 
@@ -732,7 +677,7 @@ void MeanWellCanClass::onReceive(uint8_t* frame, uint8_t len)
         _rp.SystemStatus = readUnsignedInt16(frame + 2);
 #ifdef MEANWELL_DEBUG_ENABLED
         if (_verboseLogging)
-            MessageOutput.printf("%s SYSTEM_STATUS : %s : EEPER: %d, INITIAL_STATE: %d, DC_OK: %d\r\n", _providerName,
+            MessageOutput.printf(LogLevel::Verbose, "%s SYSTEM_STATUS : %s : EEPER: %d, INITIAL_STATE: %d, DC_OK: %d\r\n", _providerName,
                 Word2BinaryString(_rp.SystemStatus),
                 _rp.SYSTEM_STATUS.EEPER,
                 _rp.SYSTEM_STATUS.INITIAL_STATE,
@@ -776,111 +721,70 @@ void MeanWellCanClass::setupParameter()
 {
     auto const& cMeanWell = Configuration.get().MeanWell;
 
-    bool temp = _verboseLogging;
+    // the responses arrive after this function returned, so verbose logging
+    // stays enabled until all setup requests are answered (see loop())
+    if (!_setupPending) { _setupVerboseLogging = _verboseLogging; }
+    _setupPending = true;
     _verboseLogging = true;
 
-    if (_verboseLogging) MessageOutput.printf("%s read parameter\r\n", _providerName);
+    if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s read parameter\r\n", _providerName);
 
     // Switch Charger off
     _rp.operation = 0; // Operation OFF
-    sendCmd(ChargerID, 0x0000, &_rp.operation, 1);
-    vTaskDelay(100); // delay 100 tick
-    getCanCharger();
-    readCmd(ChargerID, 0x0000);
-
-    readCmd(ChargerID, 0x0080); // read Manufacturer Name
-    yield();
-    readCmd(ChargerID, 0x0081); // read Manufacturer Name
-    readCmd(ChargerID, 0x0082); // read Manufacturer Model Name
-    yield();
-    readCmd(ChargerID, 0x0083); // read Manufacturer Model Name
-    readCmd(ChargerID, 0x0084); // read Firmware Revision
-    yield();
-    readCmd(ChargerID, 0x0085); // read Manufacturer Factory Location
-    readCmd(ChargerID, 0x0086); // read Manufacture Date
-    yield();
-    readCmd(ChargerID, 0x0087); // read Product Serial No
-    readCmd(ChargerID, 0x0088); // read Product Serial No
-    yield();
-
-    sendCmd(ChargerID, 0x0020, Float2Uint(53.0f / 0.01f), 2); // set Output Voltage
-    vTaskDelay(100); // delay 100 tick
-    yield();
-    getCanCharger();
-    readCmd(ChargerID, 0x0020); // read Output Voltage
-    yield();
-
-    sendCmd(ChargerID, 0x0030, Float2Uint(cMeanWell.MinCurrent / 0.01f), 2); // set Output Current
-    vTaskDelay(100); // delay 100 tick
-    yield();
-    getCanCharger();
-    readCmd(ChargerID, 0x0030); // read Output Current
-    yield();
-
-    sendCmd(ChargerID, 0x00B0, Float2Uint(cMeanWell.MaxCurrent / 0.01f), 2); // set Curve_CC
-    vTaskDelay(100); // delay 100 tick
-    yield();
-    getCanCharger();
-    yield();
-    readCmd(ChargerID, 0x00B0); // read CURVE_CC
-    yield();
-
-    sendCmd(ChargerID, 0x00B1, Float2Uint(53.0f / 0.01f), 2); // set Curve_CV
-    getCanCharger();
-    readCmd(ChargerID, 0x00B1); // read CURVE_CV
-
-    sendCmd(ChargerID, 0x00B2, Float2Uint(52.9f / 0.01f), 2); // set Curve_FV
-    getCanCharger();
-    readCmd(ChargerID, 0x00B2); // read CURVE_FV
-
-    sendCmd(ChargerID, 0x00B3, Float2Uint(1.0f / 0.01f), 2); // set Curve_TC
-    vTaskDelay(100); // delay 100 tick
-    getCanCharger();
-    readCmd(ChargerID, 0x00B3); // read CURVE_TC
-
-    readCmd(ChargerID, 0x00B5); // read CURVE_CC_TIMEOUT
-    yield();
-    readCmd(ChargerID, 0x00B6); // read CURVE_CV_TIMEOUT
-    yield();
-    readCmd(ChargerID, 0x00B7); // read CURVE_FV_TIMEOUT
-    yield();
-
-    readCmd(ChargerID, 0x00B9); // read CHG_RST_VBAT
-    yield();
-
-    readCmd(ChargerID, 0x00C0); // read Scaling Factor
-    yield();
-
-    readCmd(ChargerID, 0x00C2); // read SYSTEM_CONFIG
-    yield();
+    queueWrite(0x0000, &_rp.operation, 1);
+    queueRead(0x0000, _readBackTimeout);
+
+    queueRead(0x0080); // read Manufacturer Name
+    queueRead(0x0081); // read Manufacturer Name
+    queueRead(0x0082); // read Manufacturer Model Name
+    queueRead(0x0083); // read Manufacturer Model Name
+    queueRead(0x0084); // read Firmware Revision
+    queueRead(0x0085); // read Manufacturer Factory Location
+    queueRead(0x0086); // read Manufacture Date
+    queueRead(0x0087); // read Product Serial No
+    queueRead(0x0088); // read Product Serial No
+
+    queueWrite(0x0020, Float2Uint(53.0f / 0.01f), 2); // set Output Voltage
+    queueRead(0x0020, _readBackTimeout); // read Output Voltage
+
+    queueWrite(0x0030, Float2Uint(cMeanWell.MinCurrent / 0.01f), 2); // set Output Current
+    queueRead(0x0030, _readBackTimeout); // read Output Current
+
+    queueWrite(0x00B0, Float2Uint(cMeanWell.MaxCurrent / 0.01f), 2); // set Curve_CC
+    queueRead(0x00B0, _readBackTimeout); // read CURVE_CC
+
+    queueWrite(0x00B1, Float2Uint(53.0f / 0.01f), 2); // set Curve_CV
+    queueRead(0x00B1, _readBackTimeout); // read CURVE_CV
+
+    queueWrite(0x00B2, Float2Uint(52.9f / 0.01f), 2); // set Curve_FV
+    queueRead(0x00B2, _readBackTimeout); // read CURVE_FV
+
+    queueWrite(0x00B3, Float2Uint(1.0f / 0.01f), 2); // set Curve_TC
+    queueRead(0x00B3, _readBackTimeout); // read CURVE_TC
+
+    queueRead(0x00B5); // read CURVE_CC_TIMEOUT
+    queueRead(0x00B6); // read CURVE_CV_TIMEOUT
+    queueRead(0x00B7); // read CURVE_FV_TIMEOUT
+
+    queueRead(0x00B9); // read CHG_RST_VBAT
+
+    queueRead(0x00C0); // read Scaling Factor
+
     _rp.SystemConfig = 0b0000000000000001; // Initial operation with power on 00: Power Supply is OFF
     _rp.SYSTEM_CONFIG.EEP_OFF = 1;  // disable realtime writing to EEPROM
     MessageOutput.printf("%s SystemConfig: %s\r\n", _providerName,  Word2BinaryString(_rp.SystemConfig));
-    sendCmd(ChargerID, 0x00C2, reinterpret_cast<uint8_t*>(&_rp.SystemConfig), 2); // read SYSTEM_CONFIG
-    vTaskDelay(100); // delay 200 tick
-    yield();
-    getCanCharger();
-    readCmd(ChargerID, 0x00C2); // read SYSTEM_CONFIG
-    yield();
+    queueWrite(0x00C2, reinterpret_cast<uint8_t*>(&_rp.SystemConfig), 2); // set SYSTEM_CONFIG
+    queueRead(0x00C2, _readBackTimeout); // read SYSTEM_CONFIG
 
     _rp.CurveConfig = 0; // first reset the configuration bits
     _rp.CURVE_CONFIG.CUVS = 0; // customized charging curve (default)
     _rp.CURVE_CONFIG.TCS = 1; // Temperature compensation -3mv/°C/cell (default)
     _rp.CURVE_CONFIG.STGS = 0; // 3 Stage charge mode
     _rp.CURVE_CONFIG.CUVE = 0; // Power supply mode
-    sendCmd(ChargerID, 0x00B4, reinterpret_cast<uint8_t*>(&(_rp.CURVE_CONFIG)), 2);
-    vTaskDelay(100); // delay 200 tick
-    yield();
-    getCanCharger();
-    readCmd(ChargerID, 0x00B4); // read CURVE_CONFIG
-    yield();
+    queueWrite(0x00B4, reinterpret_cast<uint8_t*>(&(_rp.CurveConfig)), 2); // set CURVE_CONFIG
+    queueRead(0x00B4, _readBackTimeout); // read CURVE_CONFIG
 
-    readCmd(ChargerID, 0x0040); // read Fault Status
-    yield();
-
-    if (_verboseLogging) MessageOutput.printf("%s done\r\n", _providerName);
-
-    _verboseLogging = temp;
+    queueRead(0x0040); // read Fault Status
 
     _setupParameter = false;
 }
@@ -909,14 +813,33 @@ void MeanWellCanClass::loop()
 
     if (_setupParameter) setupParameter();
 
-    uint32_t t_start = millis();
+    // handle the responses queued by the CAN I/O task
+    while (parseCanPackets()) { }
 
-    parseCanPackets();
+    expireTransactions();
+    processRequests();
+
+    if (_setupPending && _requests.empty() && _transactions.empty()) {
+        MessageOutput.printf("%s setup done\r\n", _providerName);
+        _verboseLogging = _setupVerboseLogging;
+        _setupPending = false;
+    }
 
     updateEEPROMwrites2NVS();
 
+    // the charge controller runs once the responses to this poll's
+    // VOUT and IOUT requests arrived or timed out
+    if (_pollPending) {
+        if (isQueued(0x0060) || isQueued(0x0061)) { return; }
+        _pollPending = false;
+        chargerControl();
+        return;
+    }
+
+    uint32_t t_start = millis();
     if (t_start - _previousMillis < config.MeanWell.PollInterval * 1000) { return; }
     _previousMillis = t_start;
+    _pollStartMillis = t_start;
 
     static int state = 0;
     static constexpr uint16_t Cmnds[] = {
@@ -927,12 +850,22 @@ void MeanWellCanClass::loop()
         0x0000,  // read ON/OFF Status
         0x0040   // read FAULT_STATUS
     };
-    if (_verboseLogging) MessageOutput.printf("%s State: %d\r\n", _providerName, state);
-    readCmd(ChargerID, Cmnds[state++]);
+    if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s State: %d\r\n", _providerName, state);
+
+    // all three requests are in flight together
+    queueRead(Cmnds[state++]);
     if (state >= sizeof(Cmnds)/sizeof(uint16_t)) state = 0;
 
-    readCmd(ChargerID, 0x0060); // read VOUT
-    readCmd(ChargerID, 0x0061); // read IOUT
+    queueRead(0x0060); // read VOUT
+    queueRead(0x0061); // read IOUT
+    processRequests();
+
+    _pollPending = true;
+}
+
+void MeanWellCanClass::chargerControl()
+{
+    auto const& config = Configuration.get();
 
     float InverterPower = 0.0;
     String invName;
@@ -945,7 +878,7 @@ void MeanWellCanClass::loop()
     for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
         auto inv = Hoymiles.getInverterByPos(i);
         if (inv != NULL) {
-            if (inv->serial() != config.PowerLimiter.InverterId) {
+            if (inv->serial() != config.PowerLimiter.InverterId && !PowerLimiter.isBatteryPoweredInverter(inv->serial())) {
                 InverterPower += inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_PAC);
                 if (first) {
                     isProducing = inv->isProducing();
@@ -958,8 +891,9 @@ void MeanWellCanClass::loop()
                     invName += String(" + ") + inv->name();
                 }
             } else {
-                batteryConnected_isProducing = inv->isProducing();
-                BattInvName = inv->name();
+                batteryConnected_isProducing = batteryConnected_isProducing || inv->isProducing();
+                if (!BattInvName.isEmpty()) { BattInvName += " + "; }
+                BattInvName += inv->name();
             }
         }
     }
@@ -967,8 +901,8 @@ void MeanWellCanClass::loop()
     // static_cast<unsigned int>(inv0->Statistics()->getChannelFieldDigits(TYPE_AC, CH0, FLD_PAC)));
     float GridPower = PowerMeter.getPowerTotal();
     if (_verboseLogging)
-        MessageOutput.printf("%s %lu ms, House Power: %.1fW, Grid Power: %.1fW, Inverter (%s) Day Power: %.1fW, Batt con. Inverter (%s), Charger Power: %.1fW\r\n", _providerName,
-            millis() - t_start, PowerMeter.getHousePower(), GridPower, invName.c_str(), InverterPower, BattInvName.c_str(), _rp.outputPower);
+        MessageOutput.printf(LogLevel::Verbose, "%s %lu ms, House Power: %.1fW, Grid Power: %.1fW, Inverter (%s) Day Power: %.1fW, Batt con. Inverter (%s), Charger Power: %.1fW\r\n", _providerName,
+            millis() - _pollStartMillis, PowerMeter.getHousePower(), GridPower, invName.c_str(), InverterPower, BattInvName.c_str(), _rp.outputPower);
 
     auto stats = Battery.getStats();
 
@@ -976,7 +910,7 @@ void MeanWellCanClass::loop()
 
     if (_automaticCharge) {
         if (_verboseLogging)
-            MessageOutput.printf("%s automatic mode, it's %s, SOC: %.1f%%, %s%s%scharge%sabled, ChargeTemperatur is %svalid, %s is %sproducing, %s is %sproducing, Charger is %s", _providerName,
+            MessageOutput.printf(LogLevel::Verbose, "%s automatic mode, it's %s, SOC: %.1f%%, %s%s%scharge%sabled, ChargeTemperatur is %svalid, %s is %sproducing, %s is %sproducing, Charger is %s", _providerName,
                 SunPosition.isDayPeriod() ? "day" : "night",
                 stats->getSoC(),
                 stats->getAlarm().overVoltage ? "alarmOverVoltage, " : "",
@@ -1040,8 +974,8 @@ void MeanWellCanClass::loop()
                 setValue(RecommendedChargeVoltageLimit - 0.25f, MEANWELL_SET_CURVE_CV); // set to battery recommended charge voltage according to BMS value and user manual
                 setValue(RecommendedChargeVoltageLimit - 0.30f, MEANWELL_SET_CURVE_FV); // set to battery recommended charge voltage according to BMS value and user manual
                 setValue(RecommendedChargeVoltageLimit - 0.25f, MEANWELL_SET_VOLTAGE); // set to battery recommended charge voltage according to BMS value and user manual
-                readCmd(ChargerID, 0x0060); // read VOUT
-                readCmd(ChargerID, 0x0061); // read IOUT
+                queueRead(0x0060); // read VOUT
+                queueRead(0x0061); // read IOUT
             } else {
                 if (_verboseLogging) MessageOutput.println();
             }
@@ -1059,13 +993,13 @@ void MeanWellCanClass::loop()
                 )
                )
             {
-                if (_verboseLogging) MessageOutput.printf("%s Immediate Charge requested", _providerName);
+                if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s Immediate Charge requested", _providerName);
                 setValue(config.MeanWell.MaxCurrent, MEANWELL_SET_CURRENT);
                 setValue(config.MeanWell.MaxCurrent, MEANWELL_SET_CURVE_CC);
                 _chargeImmediateRequested = true;
             } else {
                 // Zero Grid Export Charging Algorithm (Charger consums at operation minimum 180 Watt = 3.6A*50V)
-                if (_verboseLogging) MessageOutput.printf("%s Zero Grid Charger controller", _providerName);
+                if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s Zero Grid Charger controller", _providerName);
                 float pCharger = config.MeanWell.MinCurrent * stats->getVoltage(); // Minimum power usage of charger
                 float hysteresis = 25.0;
                 float minPowerNeeded = pCharger;
@@ -1077,7 +1011,7 @@ void MeanWellCanClass::loop()
                     efficiency = _rp.efficiency / 100.0;
                 }
                 if ((GridPower < -(minPowerNeeded + hysteresis)) && ((fabs(GridPower) - minPowerNeeded) > config.MeanWell.Hysteresis)) { // 25 Watt Hysteresic
-                    if (_verboseLogging) MessageOutput.printf(", increment");
+                    if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, ", increment");
                     // Solar Inverter produces enough power, we export to the Grid
                     if (_rp.outputCurrent >= config.MeanWell.MaxCurrent)
                     {
@@ -1089,12 +1023,12 @@ void MeanWellCanClass::loop()
                     else if (_rp.outputCurrent < stats->getRecommendedChargeCurrentLimit())
                     {
                         float increment = fabs(GridPower) / stats->getVoltage() * efficiency;
-                        if (_verboseLogging) MessageOutput.printf(" by %.2f A", increment);
+                        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, " by %.2f A", increment);
                         setValue(_rp.outputCurrentSet + increment, MEANWELL_SET_CURRENT);
                         setValue(_rp.outputCurrentSet, MEANWELL_SET_CURVE_CC);
                     }
                 } else if ((GridPower >= 0.0) && (_rp.outputCurrent > 0.0f)) {
-                    if (_verboseLogging) MessageOutput.printf(", decrement");
+                    if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, ", decrement");
                     float decrement = GridPower / stats->getVoltage() * efficiency;
                     // check if Solar Inverter produces not enough power, then we have to reduce switch off the charger
                     // otherwise we have to reduce the OutputCurrent
@@ -1113,11 +1047,11 @@ void MeanWellCanClass::loop()
                     }
                     // else if (_rp.OutputCurrent > _rp.CurveCC && _rp.OutputCurrent < _rp.OutputCurrentSetting) {
                     else if (_rp.outputCurrent > config.MeanWell.MinCurrent) {
-                        if (_verboseLogging) MessageOutput.printf(" by %.2f A", decrement);
+                        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, " by %.2f A", decrement);
                         setValue(_rp.outputCurrentSet - decrement, MEANWELL_SET_CURRENT);
                         setValue(_rp.outputCurrentSet, MEANWELL_SET_CURVE_CC);
                     } else {
-                        if (_verboseLogging) MessageOutput.printf(", sorry I don't know, OutputCurrent: %.3f, MinCurrent: %.3f",
+                        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, ", sorry I don't know, OutputCurrent: %.3f, MinCurrent: %.3f",
                                                                     _rp.outputCurrent, config.MeanWell.MinCurrent);
                     }
                 } else if (_rp.outputCurrent > 0.0f) {
@@ -1151,7 +1085,7 @@ void MeanWellCanClass::loop()
            )
         {
             if (!_rp.operation) {
-                if (_verboseLogging) MessageOutput.printf("%s charge request\r\n", _FullChargeRequest?"Full":"Immediately");
+                if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s charge request\r\n", _FullChargeRequest?"Full":"Immediately");
 
                 setPower(true);
                 float RecommendedChargeVoltageLimit = stats->getRecommendedChargeVoltageLimit();
@@ -1192,24 +1126,24 @@ void MeanWellCanClass::loop()
 
 exit:;
 
-    MessageOutput.printf("%s Round trip %lu ms\r\n", _providerName, millis() - t_start);
+    MessageOutput.printf("%s Round trip %lu ms\r\n", _providerName, millis() - _pollStartMillis);
 }
 
 void MeanWellCanClass::switchChargerOff(const char* reason)
 {
     if (_rp.operation) {
-        if (_verboseLogging) MessageOutput.printf(", switch charger OFF%s", reason);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, ", switch charger OFF%s", reason);
         setValue(0.0, MEANWELL_SET_CURRENT);
         setValue(0.0, MEANWELL_SET_CURVE_CC);
         setPower(false);
     } else {
         if (_rp.outputCurrent > 0.0) {
-            if (_verboseLogging) MessageOutput.printf(", force charger to switch OFF%s", reason);
+            if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, ", force charger to switch OFF%s", reason);
             setValue(0.0, MEANWELL_SET_CURRENT);
             setValue(0.0, MEANWELL_SET_CURVE_CC);
             setPower(false);
         } else {
-            if (_verboseLogging) MessageOutput.printf(", charger is OFF%s", reason);
+            if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, ", charger is OFF%s", reason);
         }
     }
 }
@@ -1219,35 +1153,35 @@ void MeanWellCanClass::setValue(float in, uint8_t parameterType)
     const char* type[] = { "Voltage", "Current", "Curve_CV", "Curve_CC", "Curve_FV", "Curve_TC" };
     const char unit[] = { 'V', 'A', 'V', 'A', 'V', 'A' };
     if (_verboseLogging)
-        MessageOutput.printf("%s setValue %s: %.2f%c ... ", _providerName, type[parameterType], in, unit[parameterType]);
+        MessageOutput.printf(LogLevel::Verbose, "%s setValue %s: %.2f%c ... ", _providerName, type[parameterType], in, unit[parameterType]);
 
     auto const& cMeanWell = Configuration.get().MeanWell;
     auto stats = Battery.getStats();
 
+    // the cached value is assumed to be written until the read back
+    // arrives, so follow up calls within the same control cycle see the new
+    // value and do not queue the same write twice.
+    auto write = [this](uint16_t cmd, float& cached, float value, bool changed) {
+        if (changed) {
+            queueWrite(cmd, Float2Uint(value / 0.01f), 2);
+            cached = value;
+        }
+        queueRead(cmd, _readBackTimeout);
+    };
+
     switch (parameterType) {
     case MEANWELL_SET_VOLTAGE:
         in = min(in, stats->getRecommendedChargeVoltageLimit()); // Pylontech US3000C max voltage limit
         in = max(in, stats->getRecommendedDischargeVoltageLimit()); // Pylontech US3000C min voltage limit
 
-        readCmd(ChargerID, 0x0020); // read UOUT_SET
-        if (fabs(_rp.outputVoltageSet - in) > 0.01) {
-            sendCmd(ChargerID, 0x0020, Float2Uint(in / 0.01f), 2); // set Output Voltage
-            vTaskDelay(100); // delay 100 tick
-            getCanCharger();
-            readCmd(ChargerID, 0x0020); // read UOUT_SET
-        }
+        write(0x0020, _rp.outputVoltageSet, in, fabs(_rp.outputVoltageSet - in) > 0.01); // set Output Voltage
         break;
 
     case MEANWELL_SET_CURVE_CV:
         in = min(in, stats->getRecommendedChargeVoltageLimit()); // Pylontech US3000C max voltage limit
         in = max(in, stats->getRecommendedDischargeVoltageLimit()); // Pylontech US3000C min voltage limit
 
-        readCmd(ChargerID, 0x00B1); // read Curve_CV
-        if (fabs(_rp.curveCV - in) > 0.01) {
-            sendCmd(ChargerID, 0x00B1, Float2Uint(in / 0.01f), 2); // set Curve_CV
-            getCanCharger();
-            readCmd(ChargerID, 0x00B1); // read Curve_CV
-        }
+        write(0x00B1, _rp.curveCV, in, fabs(_rp.curveCV - in) > 0.01); // set Curve_CV
         break;
 
     case MEANWELL_SET_CURVE_FV:
@@ -1255,64 +1189,41 @@ void MeanWellCanClass::setValue(float in, uint8_t parameterType)
         in = min(in, _rp.curveCV); // Pylontech US3000C max voltage limit, must be below or equal constant voltage curveCV
         in = max(in, stats->getRecommendedDischargeVoltageLimit()); // Pylontech US3000C min voltage limit
 
-        readCmd(ChargerID, 0x00B2); // read Curve_FV
-        if (fabs(_rp.curveFV - in) > 0.01) {
-            sendCmd(ChargerID, 0x00B2, Float2Uint(in / 0.01f), 2); // set Curve_FV
-            getCanCharger();
-            readCmd(ChargerID, 0x00B2); // read Curve_FV
-        }
+        write(0x00B2, _rp.curveFV, in, fabs(_rp.curveFV - in) > 0.01); // set Curve_FV
         break;
 
     case MEANWELL_SET_CURRENT:
         in = min(in, cMeanWell.MaxCurrent); // Meanwell NPB-xxxx-xx OutputCurrent max limit
         in = max(in, cMeanWell.MinCurrent); // Meanwell NPB-xxxx-xx OutputCurrent min limit
 
-        readCmd(ChargerID, 0x0030); // read IOUT_SET
-        if (fabs(_rp.outputCurrentSet - in) > 0.01) {
-            sendCmd(ChargerID, 0x0030, Float2Uint(in / 0.01f), 2); // set Output Current
-            vTaskDelay(100); // delay 100 tick
-            getCanCharger();
-            readCmd(ChargerID, 0x0030); // read IOUT_SET
-        }
+        write(0x0030, _rp.outputCurrentSet, in, fabs(_rp.outputCurrentSet - in) > 0.01); // set Output Current
         break;
 
     case MEANWELL_SET_CURVE_CC:
         in = min(in, cMeanWell.MaxCurrent); // Meanwell NPB-xxxx-xx OutputCurrent max limit
         in = max(in, cMeanWell.MinCurrent); // Meanwell NPB-xxxx-xx OutputCurrent min limit
 
-        readCmd(ChargerID, 0x00B0); // read Curve_CC
-        if (fabs(_rp.curveCC -in) > 0.01) {
-            sendCmd(ChargerID, 0x00B0, Float2Uint(in / 0.01f), 2); // set Curve_CC
-            vTaskDelay(100); // delay 100 tick
-            getCanCharger();
-            readCmd(ChargerID, 0x00B0); // read Curve_CC
-        }
+        write(0x00B0, _rp.curveCC, in, fabs(_rp.curveCC - in) > 0.01); // set Curve_CC
         break;
 
     case MEANWELL_SET_CURVE_TC:
         in = min(in, cMeanWell.MaxCurrent / 3.333333333f); // 3.3% Meanwell NPB-xxxx-xx OutputCurrent max limit
         in = max(in, cMeanWell.MinCurrent / 10.0f); // 10% of Meanwell NPB-xxxx-xx OutputCurrent min limit
 
-        readCmd(ChargerID, 0x00B3); // read Curve_TC
-        if (fabs(_rp.curveTC) > 0.01) {
-            sendCmd(ChargerID, 0x00B3, Float2Uint(in / 0.01f), 2); // set Curve_TC
-            getCanCharger();
-            readCmd(ChargerID, 0x00B3); // read Curve_TC
-        }
+        write(0x00B3, _rp.curveTC, in, fabs(_rp.curveTC) > 0.01); // set Curve_TC
         break;
     default:;
         return;
     }
-    yield();
 
     if (_verboseLogging)
-        MessageOutput.println(" done");
+        MessageOutput.println(" queued");
 }
 
 void MeanWellCanClass::setPower(bool power)
 {
     if (_verboseLogging)
-        MessageOutput.printf("%s setPower %s\r\n", _providerName, power ? "on" : "off");
+        MessageOutput.printf(LogLevel::Verbose, "%s setPower %s\r\n", _providerName, power ? "on" : "off");
 
     /*
         if (_meanwell_power > 0) {
@@ -1320,28 +1231,37 @@ void MeanWellCanClass::setPower(bool power)
         }
     */
     _rp.CURVE_CONFIG.CUVE = (power == true) ? 1 : 0; // enable/disable automatic charger
-    sendCmd(ChargerID, 0x00B4, reinterpret_cast<uint8_t*>(&(_rp.CURVE_CONFIG)), 2);
-    vTaskDelay(100); // delay 100 tick
-    getCanCharger();
-    readCmd(ChargerID, 0x00B4); // read CURVE_CONFIG
-    yield();
+    queueWrite(0x00B4, reinterpret_cast<uint8_t*>(&(_rp.CurveConfig)), 2);
+    queueRead(0x00B4, _readBackTimeout); // read CURVE_CONFIG
 
     // Switch Charger on/off
     _rp.operation = (power == true) ? 1 : 0;
-    sendCmd(ChargerID, 0x0000, &_rp.operation, 1);
-    vTaskDelay(100); // delay 100 tick
-    getCanCharger();
-    readCmd(ChargerID, 0x0000);
+    queueWrite(0x0000, &_rp.operation, 1);
+
+    // the command succeeded if the read back of OPERATION, which is answered
+    // after the one of CURVE_CONFIG, confirms both settings
+    _powerCommandSeq = queueRead(0x0000, _readBackTimeout);
+    _powerCommandTarget = power;
+    _powerCommandPending = true;
+    _lastPowerCommandSuccess = false;
+}
 
-    if (power)
-        _lastPowerCommandSuccess = (_rp.operation == 1) && (_rp.CURVE_CONFIG.CUVE == 1) ? true : false;
-    else
-        _lastPowerCommandSuccess = (_rp.operation == 0) && (_rp.CURVE_CONFIG.CUVE == 0) ? true : false;
+void MeanWellCanClass::onPowerCommandResult(bool success)
+{
+    _powerCommandPending = false;
 
-    yield();
+    if (success) {
+        if (_powerCommandTarget)
+            _lastPowerCommandSuccess = (_rp.operation == 1) && (_rp.CURVE_CONFIG.CUVE == 1) ? true : false;
+        else
+            _lastPowerCommandSuccess = (_rp.operation == 0) && (_rp.CURVE_CONFIG.CUVE == 0) ? true : false;
+    } else {
+        _lastPowerCommandSuccess = false;
+    }
 
     if (_verboseLogging)
-        MessageOutput.println(" done");
+        MessageOutput.printf(LogLevel::Verbose, "%s setPower %s %s\r\n", _providerName, _powerCommandTarget ? "on" : "off",
+            _lastPowerCommandSuccess ? "done" : "failed");
 }
 
 const char* MeanWellCanClass::Word2BinaryString(uint16_t w)
@@ -1382,20 +1302,7 @@ uint16_t MeanWellCanClass::readUnsignedInt16(uint8_t* data)
     return (bytes[1] << 8) + bytes[0];
 }
 
-volatile uint8_t semaphore = 0;
-
 bool MeanWellCanClass::sendCmd(uint8_t id, uint16_t cmd, uint8_t* data, int len)
-{
-
-    while (semaphore)
-        yield();
-    semaphore++;
-    bool rc = _sendCmd(id, cmd, data, len);
-    semaphore--;
-    return rc;
-}
-
-bool MeanWellCanClass::_sendCmd(uint8_t id, uint16_t cmd, uint8_t* data, int len)
 {
     twai_message_t tx_message = {};
     memset(tx_message.data, 0, sizeof(tx_message.data));
@@ -1427,27 +1334,26 @@ bool MeanWellCanClass::_sendCmd(uint8_t id, uint16_t cmd, uint8_t* data, int len
             tx_message.identifier, tx_message.extd, tx_message.data_length_code, data);
     }
 
-    yield();
-    uint32_t packetMarginTime = millis() - _meanwellLastResponseTime;
-    if (packetMarginTime < 5)
-    vTaskDelay(5 - packetMarginTime); // ensure minimum packet time  of 5ms between last response and new request
+
+    std::lock_guard<std::mutex> lock(_controllerMutex);
 
     switch (_provider) {
 #ifdef USE_CHARGER_CAN0
         case Charger_Provider_t::CAN0:
             // Queue message for transmission
 
-            if (twai_transmit(&tx_message, pdMS_TO_TICKS(1000)) == ESP_OK) {
-                yield();
+            // do not wait for room in the transmit queue, the request is
+            // sent again from the next loop
+            if (twai_transmit(&tx_message, 0) == ESP_OK) {
 #ifdef MEANWELL_DEBUG_ENABLED__
                 if (_verboseLogging)
-                    MessageOutput.printf("%s Message queued for transmission cmnd %04X with %d data bytes\r\n", _providerName, cmd, len + 2);
+                    MessageOutput.printf(LogLevel::Verbose, "%s Message queued for transmission cmnd %04X with %d data bytes\r\n", _providerName, cmd, len + 2);
 #endif
                 if (len>0) EEPROMwrites++;
 
             } else {
-                yield();
-                MessageOutput.printf("%s Failed to queue message for transmission\r\n", _providerName);
+                if (_verboseLogging)
+                    MessageOutput.printf(LogLevel::Verbose, "%s Failed to queue message for transmission\r\n", _providerName);
                 return false;
             }
             break;
@@ -1473,35 +1379,138 @@ bool MeanWellCanClass::_sendCmd(uint8_t id, uint16_t cmd, uint8_t* data, int len
         default:;
     }
 
-    yield();
-
     return true;
 }
 
-bool MeanWellCanClass::readCmd(uint8_t id, uint16_t cmd)
+// returns the sequence number of the request
+uint32_t MeanWellCanClass::queueRead(uint16_t cmd, uint16_t timeout)
+{
+    // a read which is still queued behind the last write to the same
+    // command delivers the same value, so it is not queued twice
+    for (auto it = _requests.rbegin(); it != _requests.rend(); ++it) {
+        if (it->cmd != cmd) { continue; }
+        if (it->len == 0) {
+            it->timeout = std::max(it->timeout, timeout);
+            return it->seq;
+        }
+        break;
+    }
+
+    Request_t request = {};
+    request.cmd = cmd;
+    request.timeout = timeout;
+    request.retries = _readRetries;
+    request.seq = ++_requestSeq;
+    _requests.push_back(request);
+
+    return request.seq;
+}
+
+// returns the sequence number of the request
+uint32_t MeanWellCanClass::queueWrite(uint16_t cmd, uint8_t const* data, uint8_t len)
 {
-    bool rc = false;
+    Request_t request = {};
+    request.cmd = cmd;
+    request.len = std::min<uint8_t>(len, sizeof(request.data));
+    memcpy(request.data, data, request.len);
+    request.seq = ++_requestSeq;
+    _requests.push_back(request);
+
+    return request.seq;
+}
 
-    while (semaphore)
-        yield();
-    semaphore++;
-    if (semaphore > 1)
-        MessageOutput.printf("%s Semaphore = %d\r\n", _providerName, semaphore);
+// true while a request for the command is queued or waiting for a response
+bool MeanWellCanClass::isQueued(uint16_t cmd) const
+{
+    if (_transactions.find(cmd) != _transactions.end()) { return true; }
 
-    if (_sendCmd(id, cmd) == false) { // read parameter
-        semaphore--;
-        return rc;
+    for (auto const& request : _requests) {
+        if (request.cmd == cmd) { return true; }
     }
-    uint32_t t = millis();
-    while (millis() - t < 2000) {
-        if ((rc = getCanCharger()) == true)
-            break;
-        yield();
+
+    return false;
+}
+
+void MeanWellCanClass::processRequests()
+{
+    while (!_requests.empty()) {
+        uint32_t now = millis();
+
+        // ensure minimum packet time of 5ms between last response and new request
+        if (now - _meanwellLastResponseTime < _packetMarginTime) { return; }
+
+        // the charger needs some time to process a write
+        if (static_cast<int32_t>(_holdOffUntil - now) > 0) { return; }
+
+        auto const& request = _requests.front();
+
+        // requests are sent in order. the head waits for a pending
+        // transaction of the same command, otherwise a write could
+        // overtake a read or a response could not be assigned.
+        if (_transactions.find(request.cmd) != _transactions.end()) { return; }
+
+        bool isRead = (request.len == 0);
+        if (isRead && _transactions.size() >= _maxTransactions) { return; }
+
+        uint8_t data[sizeof(request.data)];
+        memcpy(data, request.data, request.len);
+
+        if (!sendCmd(ChargerID, request.cmd, isRead ? nullptr : data, request.len)) { return; }
+
+        if (isRead) {
+            _transactions[request.cmd] = { request, now };
+        } else {
+            _holdOffUntil = now + _writeHoldOff;
+        }
+
+        _requests.pop_front();
     }
+}
 
-    semaphore--;
+void MeanWellCanClass::expireTransactions()
+{
+    uint32_t now = millis();
 
-    return rc;
+    for (auto it = _transactions.begin(); it != _transactions.end(); ) {
+        auto& transaction = it->second;
+        if (now - transaction.sentMillis < transaction.request.timeout) {
+            ++it;
+            continue;
+        }
+
+        if (transaction.request.retries > 0) {
+            // the read is repeated, still keyed by its command ID
+            if (now - _meanwellLastResponseTime >= _packetMarginTime
+                    && sendCmd(ChargerID, transaction.request.cmd)) {
+                --transaction.request.retries;
+                transaction.sentMillis = now;
+            }
+            ++it;
+            continue;
+        }
+
+        MessageOutput.printf("%s no response to command %04X within %u ms\r\n", _providerName,
+            transaction.request.cmd, transaction.request.timeout);
+
+        if (_powerCommandPending && transaction.request.seq == _powerCommandSeq) {
+            onPowerCommandResult(false);
+        }
+
+        it = _transactions.erase(it);
+    }
+}
+
+void MeanWellCanClass::completeTransaction(uint16_t cmd)
+{
+    auto it = _transactions.find(cmd);
+    if (it == _transactions.end()) { return; }
+
+    uint32_t seq = it->second.request.seq;
+    _transactions.erase(it);
+
+    if (_powerCommandPending && seq == _powerCommandSeq) {
+        onPowerCommandResult(true);
+    }
 }
 
 template <typename T>
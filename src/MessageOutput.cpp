@@ -5,28 +5,46 @@
 #include <HardwareSerial.h>
 #include "MessageOutput.h"
 #include "SyslogLogger.h"
+#include <algorithm>
+#include <cstring>
 
 MessageOutputClass MessageOutput;
 
+namespace {
+
+constexpr uint32_t CommittedFlag = 0x80000000;
+constexpr uint32_t PaddingLength = 0x7FFFFFFF;
+constexpr uint32_t HeaderSize = sizeof(uint32_t);
+
+constexpr uint32_t recordSize(size_t size)
+{
+    return (HeaderSize + size + 3) & ~3U;
+}
+
+} // namespace
+
 MessageOutputClass::MessageOutputClass()
-    : _loopTask(TASK_IMMEDIATE, TASK_FOREVER, std::bind(&MessageOutputClass::loop, this))
 {
 }
 
-void MessageOutputClass::init(Scheduler& scheduler)
+void MessageOutputClass::init()
 {
-    scheduler.addTask(_loopTask);
-    _loopTask.enable();
+    _wsBatch.reserve(_wsBatchSize);
+
+    _lineKeyCreated = (pthread_key_create(&_lineKey, MessageOutputClass::onTaskDeleted) == 0);
+
+    if (!xTaskCreate(MessageOutputClass::taskLoopHelper, "MSG:OUT", _taskStackSize, this, _taskPriority, &_taskHandle)) {
+        _taskHandle = nullptr;
+        Serial.println("[MessageOutput] ERROR: creating the output task failed");
+    }
 }
 
 void MessageOutputClass::register_ws_output(AsyncWebSocket* output)
 {
-    std::lock_guard<std::mutex> lock(_msgLock);
-
     _ws = output;
 }
 
-void MessageOutputClass::serialWrite(MessageOutputClass::message_t const& m)
+void MessageOutputClass::serialWrite(const uint8_t* data, size_t size)
 {
     // operator bool() of HWCDC returns false if the device is not attached to
     // a USB host. in general it makes sense to skip writing entirely if the
@@ -34,88 +52,284 @@ void MessageOutputClass::serialWrite(MessageOutputClass::message_t const& m)
     if (!Serial) { return; }
 
     size_t written = 0;
-    while (written < m.size()) {
-        written += Serial.write(m.data() + written, m.size() - written);
+    while (written < size) {
+        written += Serial.write(data + written, size - written);
     }
 }
 
-size_t MessageOutputClass::write(uint8_t c)
+MessageOutputClass::Line_t* MessageOutputClass::acquireLine()
 {
-    std::lock_guard<std::mutex> lock(_msgLock);
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+
+    for (auto& line : _lines) {
+        if (line.owner.load(std::memory_order_acquire) == self) { return &line; }
+    }
 
-    auto res = _task_messages.emplace(xTaskGetCurrentTaskHandle(), message_t());
-    auto iter = res.first;
-    auto& message = iter->second;
+    for (auto& line : _lines) {
+        TaskHandle_t expected = nullptr;
+        if (line.owner.compare_exchange_strong(expected, self, std::memory_order_acq_rel)) {
+            line.length = 0;
 
-    message.push_back(c);
+            // only allocates the first time a task claims a line
+            if (_lineKeyCreated && pthread_getspecific(_lineKey) == nullptr) {
+                pthread_setspecific(_lineKey, self);
+            }
 
-    if (c == '\n') {
-        serialWrite(message);
-        _lines.emplace(std::move(message));
-        _task_messages.erase(iter);
+            return &line;
+        }
     }
 
-    return 1;
+    return nullptr;
 }
 
-size_t MessageOutputClass::write(const uint8_t *buffer, size_t size)
+void MessageOutputClass::releaseLine(Line_t& line)
 {
-    std::lock_guard<std::mutex> lock(_msgLock);
-
-    auto res = _task_messages.emplace(xTaskGetCurrentTaskHandle(), message_t());
-    auto iter = res.first;
-    auto& message = iter->second;
+    line.owner.store(nullptr, std::memory_order_release);
+}
 
-    message.reserve(message.size() + size);
+// the handle is not reused before this returns
+void MessageOutputClass::onTaskDeleted(void* task)
+{
+    for (auto& line : MessageOutput._lines) {
+        TaskHandle_t expected = static_cast<TaskHandle_t>(task);
+        line.owner.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel);
+    }
+}
 
+void MessageOutputClass::append(Line_t& line, const uint8_t* buffer, size_t size)
+{
     for (size_t idx = 0; idx < size; ++idx) {
-        uint8_t c = buffer[idx];
+        if (line.length == _lineSize) {
+            // overlong line, send what we have
+            push(reinterpret_cast<uint8_t*>(line.data), line.length);
+            line.length = 0;
+        }
 
-        message.push_back(c);
+        uint8_t c = buffer[idx];
+        line.data[line.length++] = c;
 
         if (c == '\n') {
-            serialWrite(message);
-            _lines.emplace(std::move(message));
-            message.clear();
-            message.reserve(size - idx - 1);
+            push(reinterpret_cast<uint8_t*>(line.data), line.length);
+            line.length = 0;
         }
     }
+}
+
+// pushes everything up to and including the last newline
+void MessageOutputClass::flushCompleteLines(Line_t& line)
+{
+    const char* last = static_cast<const char*>(memrchr(line.data, '\n', line.length));
+    if (last == nullptr) { return; }
+
+    size_t complete = last - line.data + 1;
+    push(reinterpret_cast<uint8_t*>(line.data), complete);
+
+    line.length -= complete;
+    memmove(line.data, line.data + complete, line.length);
+}
+
+size_t MessageOutputClass::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t MessageOutputClass::write(const uint8_t *buffer, size_t size)
+{
+    Line_t* line = acquireLine();
+    if (line == nullptr) {
+        // all lines are taken, the text may be mangled but is not lost
+        push(buffer, size);
+        return size;
+    }
 
-    if (message.empty()) { _task_messages.erase(iter); }
+    append(*line, buffer, size);
+
+    if (line->length == 0) { releaseLine(*line); }
 
     return size;
 }
 
-void MessageOutputClass::loop()
+size_t MessageOutputClass::printf(const char* format, ...)
+{
+    if (!isEnabled(Level::Info)) { return 0; }
+
+    va_list args;
+    va_start(args, format);
+    size_t len = vprintf(format, args);
+    va_end(args);
+    return len;
+}
+
+size_t MessageOutputClass::printf(Level level, const char* format, ...)
+{
+    if (!isEnabled(level)) { return 0; }
+
+    va_list args;
+    va_start(args, format);
+    size_t len = vprintf(format, args);
+    va_end(args);
+    return len;
+}
+
+// formats straight into the line of the calling task, nothing is allocated
+size_t MessageOutputClass::vprintf(const char* format, va_list args)
+{
+    Line_t* line = acquireLine();
+    if (line == nullptr) {
+        char buffer[128];
+        int len = vsnprintf(buffer, sizeof(buffer), format, args);
+        if (len < 0) { return 0; }
+        size_t pushed = std::min<size_t>(len, sizeof(buffer) - 1);
+        push(reinterpret_cast<uint8_t*>(buffer), pushed);
+        return pushed;
+    }
+
+    va_list retry;
+    va_copy(retry, args);
+
+    size_t available = _lineSize - line->length;
+    int len = vsnprintf(line->data + line->length, available + 1, format, args);
+
+    if (len >= 0 && static_cast<size_t>(len) > available && line->length > 0) {
+        // does not fit behind the partial line, send that one on its own
+        push(reinterpret_cast<uint8_t*>(line->data), line->length);
+        line->length = 0;
+        available = _lineSize;
+        len = vsnprintf(line->data, available + 1, format, retry);
+    }
+
+    va_end(retry);
+
+    if (len > 0) {
+        line->length += std::min<size_t>(len, available);
+        flushCompleteLines(*line);
+
+        if (line->length == _lineSize) {
+            // truncated
+            push(reinterpret_cast<uint8_t*>(line->data), line->length);
+            push(reinterpret_cast<const uint8_t*>("...\r\n"), 5);
+            line->length = 0;
+        }
+    }
+
+    if (line->length == 0) { releaseLine(*line); }
+
+    return std::max(len, 0);
+}
+
+bool MessageOutputClass::push(const uint8_t* data, size_t size)
 {
-    std::lock_guard<std::mutex> lock(_msgLock);
+    if (size == 0) { return true; }
+
+    size = std::min<size_t>(size, _ringSize / 4);
+    uint32_t need = recordSize(size);
 
-    // clean up (possibly filled) buffers of deleted tasks
-    auto map_iter = _task_messages.begin();
-    while (map_iter != _task_messages.end()) {
-        if (eTaskGetState(map_iter->first) == eDeleted) {
-            map_iter = _task_messages.erase(map_iter);
-            continue;
+    uint32_t pos, offset, padding;
+    do {
+        pos = _reserved.load(std::memory_order_relaxed);
+        offset = pos & (_ringSize - 1);
+        // records do not wrap around, the rest of the ring is skipped instead
+        padding = (offset + need > _ringSize) ? _ringSize - offset : 0;
+
+        if (pos + padding + need - _consumed.load(std::memory_order_acquire) > _ringSize) {
+            _droppedLines.fetch_add(1, std::memory_order_relaxed);
+            return false;
         }
+    } while (!_reserved.compare_exchange_weak(pos, pos + padding + need,
+                std::memory_order_acq_rel, std::memory_order_relaxed));
 
-        ++map_iter;
+    // the headers are accessed with the atomic builtins, the rest of the
+    // record is only touched by its producer until the header is committed
+    if (padding > 0) {
+        __atomic_store_n(reinterpret_cast<uint32_t*>(&_ring[offset]), CommittedFlag | PaddingLength, __ATOMIC_RELEASE);
+        offset = 0;
     }
 
-    if (!_ws) {
-        while (!_lines.empty()) {
-#ifdef USE_SYSLOG
-            Syslog.write(_lines.front().data(), _lines.front().size());
-#endif
-            _lines.pop(); // do not hog memory
+    memcpy(&_ring[offset + HeaderSize], data, size);
+    __atomic_store_n(reinterpret_cast<uint32_t*>(&_ring[offset]), CommittedFlag | size, __ATOMIC_RELEASE);
+
+    if (_taskHandle != nullptr) { xTaskNotifyGive(_taskHandle); }
+
+    return true;
+}
+
+void MessageOutputClass::drain()
+{
+    while (true) {
+        uint32_t pos = _consumed.load(std::memory_order_relaxed);
+        if (pos == _reserved.load(std::memory_order_acquire)) { return; }
+
+        uint32_t offset = pos & (_ringSize - 1);
+        uint32_t header = __atomic_load_n(reinterpret_cast<uint32_t*>(&_ring[offset]), __ATOMIC_ACQUIRE);
+
+        // the producer of this record is still copying
+        if ((header & CommittedFlag) == 0) { return; }
+
+        uint32_t length = header & ~CommittedFlag;
+        uint32_t size = (length == PaddingLength) ? _ringSize - offset : recordSize(length);
+
+        if (length != PaddingLength) {
+            deliver(&_ring[offset + HeaderSize], length);
         }
-        return;
+
+        // a stale header must never look committed in the next round
+        memset(&_ring[offset], 0, size);
+        _consumed.store(pos + size, std::memory_order_release);
     }
+}
+
+void MessageOutputClass::deliver(const uint8_t* data, size_t size)
+{
+    serialWrite(data, size);
 
-    while (!_lines.empty() && _ws->availableForWriteAll()) {
 #ifdef USE_SYSLOG
-        Syslog.write(_lines.front().data(), _lines.front().size());
+    Syslog.write(data, size);
 #endif
-        _ws->textAll(std::make_shared<message_t>(std::move(_lines.front())));
-        _lines.pop();
+
+    if (_ws == nullptr) { return; }
+
+    if (_wsBatch.size() + size > _wsBatchSize) {
+        flushWebsocket();
+    }
+
+    if (_wsBatch.size() + size > _wsBatchSize) {
+        // the websocket clients are too slow
+        _droppedLines.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    _wsBatch.insert(_wsBatch.end(), data, data + size);
+}
+
+void MessageOutputClass::flushWebsocket()
+{
+    if (_ws == nullptr || _wsBatch.empty() || !_ws->availableForWriteAll()) { return; }
+
+    _ws->textAll(std::make_shared<std::vector<uint8_t>>(_wsBatch));
+    _wsBatch.clear();
+}
+
+void MessageOutputClass::taskLoopHelper(void* context)
+{
+    auto pInstance = static_cast<MessageOutputClass*>(context);
+    pInstance->taskLoop();
+}
+
+void MessageOutputClass::taskLoop()
+{
+    while (true) {
+        // the websocket may not have accepted the last batch, try again soon
+        ulTaskNotifyTake(pdTRUE, _wsBatch.empty() ? pdMS_TO_TICKS(1000) : pdMS_TO_TICKS(50));
+
+        drain();
+        flushWebsocket();
+
+        uint32_t dropped = _droppedLines.load(std::memory_order_relaxed);
+        if (dropped != _reportedDropped) {
+            _reportedDropped = dropped;
+            char message[64];
+            int len = snprintf(message, sizeof(message), "[MessageOutput] %u lines dropped\r\n", dropped);
+            deliver(reinterpret_cast<uint8_t*>(message), len);
+        }
     }
 }
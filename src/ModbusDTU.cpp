@@ -10,7 +10,7 @@ ModbusDtuClass ModbusDtu;
 
 ModbusDtuClass::ModbusDtuClass()
     : _loopTask(Configuration.get().Dtu.PollInterval * TASK_SECOND, TASK_FOREVER, std::bind(&ModbusDtuClass::loop, this))
-    , _mbloopTask(TASK_IMMEDIATE, TASK_FOREVER, std::bind(&ModbusDtuClass::mbloop, this))
+    , _modbusTask(TASK_IMMEDIATE, TASK_FOREVER, std::bind(&ModbusDtuClass::modbus, this))
 {
 }
 
@@ -18,6 +18,8 @@ void ModbusDtuClass::init(Scheduler& scheduler)
 {
     MessageOutput.print("Initialize ModbusDTU... ");
 
+    Hoymiles.subscribeStatisticsUpdate(std::bind(&ModbusDtuClass::onStatisticsUpdate, this, std::placeholders::_1));
+
     scheduler.addTask(_loopTask);
     _loopTask.enable();
     scheduler.addTask(_modbusTask);
@@ -25,12 +27,44 @@ void ModbusDtuClass::init(Scheduler& scheduler)
     MessageOutput.println("done");
 }
 
-
 void ModbusDtuClass::modbus()
 {
+    if (!(Configuration.get().Modbus.modbus_tcp_enabled) || !_isstarted) {
+        return;
+    }
+
+    // serves all connected clients, see MODBUSIP_MAX_CLIENTS
     mb.task();
 }
 
+ModbusDtuClass::Block_t& ModbusDtuClass::addBlock(uint16_t base, uint16_t count)
+{
+    _blocks.push_back({ base, std::vector<uint16_t>(count, 0) });
+
+    // one allocation per block, reads are answered from the image
+    mb.addHreg(base, 0, count);
+    mb.onGetHreg(base, &ModbusDtuClass::onGetHreg, count);
+
+    return _blocks.back();
+}
+
+uint16_t* ModbusDtuClass::findRegister(uint16_t reg)
+{
+    for (auto& block : _blocks) {
+        if (reg >= block.base && static_cast<size_t>(reg - block.base) < block.regs.size()) {
+            return &block.regs[reg - block.base];
+        }
+    }
+
+    return nullptr;
+}
+
+uint16_t ModbusDtuClass::onGetHreg(TRegister* reg, uint16_t val)
+{
+    uint16_t* value = ModbusDtu.findRegister(reg->address.address);
+    return value != nullptr ? *value : val;
+}
+
 void ModbusDtuClass::setup()
 {
     MessageOutput.print("Starting ModbusDTU Server... ");
@@ -48,78 +82,106 @@ void ModbusDtuClass::setup()
     }
 
     mb.server();
-#ifdef SIMULATE_HOYMILES_DTU
-    mb.addHreg(0x2000, (config.Dtu.Serial >> 32) & 0xFFFF);
-    mb.addHreg(0x2001, (config.Dtu.Serial >> 16) & 0xFFFF);
-    mb.addHreg(0x2002, (config.Dtu.Serial) & 0xFFFF);
 
+    _blocks.clear();
+    _slots.clear();
+    // the blocks must not move once they are handed out by findRegister()
+    _blocks.reserve(3);
+
+#ifdef SIMULATE_HOYMILES_DTU
+    // the layout is fixed while the server is running, inverters added
+    // later are not part of the map.
     uint8_t channels = 0;
-    for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
+    for (uint8_t i = 0; i < Hoymiles.getNumInverters() && i < 32; i++) {
         auto inv = Hoymiles.getInverterByPos(i);
         if (inv == nullptr) {
             continue;
         }
-        uint64_t serialInv = inv->serial();
-        for (auto& t : inv->Statistics()->getChannelTypes()) {
-            for (auto& c : inv->Statistics()->getChannelsByType(t)) {
-                if (t == TYPE_DC) {
-                    mb.addHreg(channels * 3 + 0x2056, (serialInv >> 16) & 0xFFFF);
-                    mb.addHreg(channels * 3 + 0x2057, (serialInv >> 8) & 0xFFFF);
-                    mb.addHreg(channels * 3 + 0x2058, serialInv & 0xFFFF);
-                    channels++;
-                }
-            }
-        }
+        uint8_t dcChannels = inv->Statistics()->getChannelsByType(TYPE_DC).size();
+        _slots.push_back({ inv->serial(), channels, dcChannels });
+        channels += dcChannels;
     }
 
-    for (uint8_t i = 0; i <= channels; i++) {
-        for (uint8_t j = 0; j < 20; j++) {
-            mb.addHreg(i * 20 + 0x1000 + j, 0);
+    addBlock(0x1000, (channels + 1) * 20);
+    addBlock(0x2000, 0x56 + channels * 3);
+    addBlock(0x2501, 1);
+
+    setHReg(0x2000, (config.Dtu.Serial >> 32) & 0xFFFF);
+    setHReg(0x2001, (config.Dtu.Serial >> 16) & 0xFFFF);
+    setHReg(0x2002, (config.Dtu.Serial) & 0xFFFF);
+    setHReg(0x2501, 502); // Ethernet Port Number
+
+    // everything that does not depend on the statistics
+    for (auto const& slot : _slots) {
+        for (uint8_t c = 0; c < slot.channels; c++) {
+            uint16_t chan = slot.firstChannel + c;
+            uint16_t row = chan * 20 + 0x1000;
+
+            setHReg(chan * 3 + 0x2056, (slot.serial >> 16) & 0xFFFF);
+            setHReg(chan * 3 + 0x2057, (slot.serial >> 8) & 0xFFFF);
+            setHReg(chan * 3 + 0x2058, slot.serial & 0xFFFF);
+
+            setHReg(row + 0x00, 0x3C00 + ((slot.serial >> 40) & 0xFF));
+            setHReg(row + 0x01, (slot.serial >> 24) & 0xFFFF);
+            setHReg(row + 0x02, (slot.serial >> 8) & 0xFFFF);
+            setHReg(row + 0x03, ((slot.serial << 8) + c + 1) & 0xFFFF);
+            setHReg(row + 0x0D, 3);
+            setHReg(row + 0x10, 0x0107);
         }
-        yield();
     }
 
-    mb.addHreg(0x2501, 502); // Ethernet Port Number
-
+    _dirtySlots = (1ULL << _slots.size()) - 1;
 #else
     // simulate Fornius
-    mb.addHreg(40000, 0x5375); // 40001 0x5375 Su
-    mb.addHreg(40001, 0x6E53); // 0x6E53 nS
-    mb.addHreg(40002, 1); // indetifies this as a SunSpec common model block
-    mb.addHreg(40003, 65); // length of common model block
-    addHString(40004, config.modbus.mfrname, 16); // Manufacturer start
-    addHString(40020, config.modbus.modelname, 16); // Device Model start
-    addHString(40036, config.modbus.options, 8); // Options start
-    addHString(40044, config.modbus.version, 8); // Software Version start
-    const char *serialconfig = config.modbus.serial;
-    if (!strlen(serialconfig)) {
+    addBlock(40000, 197);
+
+    setHReg(40000, 0x5375); // 40001 0x5375 Su
+    setHReg(40001, 0x6E53); // 0x6E53 nS
+    setHReg(40002, 1); // indetifies this as a SunSpec common model block
+    setHReg(40003, 65); // length of common model block
+    setHString(40004, config.Modbus.mfrname, 16); // Manufacturer start
+    setHString(40020, config.Modbus.modelname, 16); // Device Model start
+    setHString(40036, config.Modbus.options, 8); // Options start
+    setHString(40044, config.Modbus.version, 8); // Software Version start
+    if (!strlen(config.Modbus.serial)) {
         char serial[24];
-        snprintf(serial,sizeof(serial),"%llx",(config.Dtu.Serial));
+        snprintf(serial, sizeof(serial), "%llx", (config.Dtu.Serial));
         MessageOutput.printf("Modbus: init uses DTU Serial: %s\r\n", serial);
-        addHString(40052, buff, 6); // Serial Number start
-        mb.addHreg(40058, 0, 10);
+        setHString(40052, serial, 16); // 40052 - 40067 Serial Number
     } else {
-        for (uint8_t i = 0; i < 32; i += 2) {
-            uint16_t value = 0;
-            if (strlen(serialconfig) > i) value = (serialconfig[i] << 8) | (i + 1 < strlen(serialconfig) ? serialconfig[i + 1] : 0);
-            mb.addHreg(40052 + (i / 2), value); //40052 - 40067 Serial Number
-            // MessageOutput.printf("Modbus: write %d to register %d\r\n", value, (40052 + (i / 2)));
-        }
+        setHString(40052, config.Modbus.serial, 16); // 40052 - 40067 Serial Number
     }
 
-    mb.addHreg(40068, 202); // Modbus TCP Address: 202
-    mb.addHreg(40069, 213);   //40069 SunSpec_DID
-    mb.addHreg(40070, 124);   //40070 SunSpec_Length
-    mb.addHreg(40071, 0, 123);//40071 - 40194 smartmeter data
-    mb.addHreg(40195, 65535); //40195 end block identifier
-    mb.addHreg(40196, 0);     //40196
+    setHReg(40068, 202); // Modbus TCP Address: 202
+    setHReg(40069, 213); // 40069 SunSpec_DID
+    setHReg(40070, 124); // 40070 SunSpec_Length
+    // 40071 - 40194 smartmeter data
+    setHReg(40195, 65535); // 40195 end block identifier
 #endif
 
+    _dirty = true;
     _isstarted = true;
 
     MessageOutput.println("done");
 }
 
+void ModbusDtuClass::onStatisticsUpdate(InverterAbstract& inv)
+{
+    if (!_isstarted) { return; }
+
+#ifdef SIMULATE_HOYMILES_DTU
+    for (size_t i = 0; i < _slots.size(); i++) {
+        if (_slots[i].serial == inv.serial()) {
+            _dirtySlots.fetch_or(1UL << i);
+            break;
+        }
+    }
+#endif
+
+    _dirty = true;
+    _loopTask.forceNextIteration();
+}
+
 void ModbusDtuClass::loop()
 {
     auto const& config = Configuration.get();
@@ -128,17 +190,12 @@ void ModbusDtuClass::loop()
 
     if (!(config.Modbus.modbus_tcp_enabled)) return;
 
-    if (!Hoymiles.isAllRadioIdle()) {
-         _loopTask.forceNextIteration();
-         return;
-    }
-
     if (!_isstarted) {
-        if (!config.modbus.modbus_delaystart ||
+        if (!config.Modbus.modbus_delaystart ||
             (Datastore.getIsAllEnabledReachable() && Datastore.getTotalAcYieldTotalEnabled() != 0))
         {
             MessageOutput.printf("Modbus: starting server ...\r\n");
-            ModbusDtu.setup();
+            setup();
             _modbusTask.enable();
         } else {
             MessageOutput.printf("Modbus: not initializing yet! (Total Yield = 0 or not all configured inverters reachable)\r\n");
@@ -146,137 +203,128 @@ void ModbusDtuClass::loop()
         }
     }
 
+    // the image only changes when new statistics arrived
+    if (_isstarted && _dirty.exchange(false)) {
+        refresh();
+    }
+}
+
+// runs in the same task as mb.task(), so a client always reads a complete
+// update and never one half of a float.
+void ModbusDtuClass::refresh()
+{
 #ifdef SIMULATE_HOYMILES_DTU
-    uint8_t chan = 0;
-    uint8_t invNumb = 0;
+    uint32_t dirty = _dirtySlots.exchange(0);
 
-    for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
-        auto inv = Hoymiles.getInverterByPos(i);
-        if (inv == nullptr) {
-            continue;
+    for (size_t i = 0; i < _slots.size(); i++) {
+        if (dirty & (1UL << i)) {
+            refreshInverter(_slots[i]);
         }
-        // Loop all channels
-        for (auto& t : inv->Statistics()->getChannelTypes()) {
-            for (auto& c : inv->Statistics()->getChannelsByType(t)) {
-                if (t == TYPE_DC) {
-                    uint64_t serialInv = inv->serial();
-                    mb.Hreg(chan * 20 + 0x1000, 0x3C00 + ((serialInv >> 40) & 0xFF));
-                    mb.Hreg(chan * 20 + 0x1001, (serialInv >> 24) & 0xFFFF);
-                    mb.Hreg(chan * 20 + 0x1002, (serialInv >> 8) & 0xFFFF);
-                    mb.Hreg(chan * 20 + 0x1003, (serialInv << 8) + c + 1);
-                    if (inv->Statistics()->getStringMaxPower(c) > 0 && inv->Statistics()->getChannelFieldValue(t, c, FLD_IRR) < 500) {
-                        mb.Hreg(chan * 20 + 0x1004, static_cast<uint16_t>(inv->Statistics()->getChannelFieldValue(t, c, FLD_UDC)) * 10);
-                        mb.Hreg(chan * 20 + 0x1005, static_cast<uint16_t>(inv->Statistics()->getChannelFieldValue(t, c, FLD_IDC)) * 100);
-                        mb.Hreg(chan * 20 + 0x1008, static_cast<uint16_t>(inv->Statistics()->getChannelFieldValue(t, c, FLD_PDC)) * 10);
-                    } else if (inv->Statistics()->getStringMaxPower(c) == 0) {
-                        mb.Hreg(chan * 20 + 0x1004, static_cast<uint16_t>(inv->Statistics()->getChannelFieldValue(t, c, FLD_UDC)) * 10);
-                        mb.Hreg(chan * 20 + 0x1005, static_cast<uint16_t>(inv->Statistics()->getChannelFieldValue(t, c, FLD_IDC)) * 100);
-                        mb.Hreg(chan * 20 + 0x1008, static_cast<uint16_t>(inv->Statistics()->getChannelFieldValue(t, c, FLD_PDC)) * 10);
-                    }
-
-                    mb.Hreg(chan * 20 + 0x1006, static_cast<uint16_t>(inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_UAC)) * 10);
-                    mb.Hreg(chan * 20 + 0x1007, static_cast<uint16_t>(inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_F)) * 100);
-                    mb.Hreg(chan * 20 + 0x1009, static_cast<uint16_t>(inv->Statistics()->getChannelFieldValue(t, c, FLD_YD)));
-                    mb.Hreg(chan * 20 + 0x100A, static_cast<uint16_t>(static_cast<uint32_t>(inv->Statistics()->getChannelFieldValue(t, c, FLD_YT)) * 1000 >> 16) & 0xFFFF);
-                    mb.Hreg(chan * 20 + 0x100B, static_cast<uint16_t>(static_cast<uint32_t>(inv->Statistics()->getChannelFieldValue(t, c, FLD_YT)) * 1000) & 0xFFFF);
-                    mb.Hreg(chan * 20 + 0x100C, static_cast<uint16_t>(inv->Statistics()->getChannelFieldValue(TYPE_INV, CH0, FLD_T)) * 10);
-                    mb.Hreg(chan * 20 + 0x100D, 3);
-                    mb.Hreg(chan * 20 + 0x100E, 0);
-                    mb.Hreg(chan * 20 + 0x100F, 0);
-                    mb.Hreg(chan * 20 + 0x1010, 0x0107);
-                    mb.Hreg(chan * 20 + 0x1011, 0);
-                    mb.Hreg(chan * 20 + 0x1012, 0);
-                    mb.Hreg(chan * 20 + 0x1013, 0);
-
-                    chan++;
-                }
-            }
-        }
-        invNumb++;
     }
 #else
     if (!Datastore.getIsAllEnabledReachable() ||
-        !(Datastore.getTotalAcYieldTotalEnabled() != 0) ||
-        !_isstarted ||
-        !config.modbus.modbus_delaystart)
+        !(Datastore.getTotalAcYieldTotalEnabled() != 0))
     {
         MessageOutput.printf("Modbus: not updating registers! (Total Yield = 0 or not all configured inverters reachable)\r\n");
         return;
-    } else {
-        setHRegs(40097, Datastore.getTotalAcPowerEnabled() * -1);
-        float value = (Datastore.getTotalAcYieldTotalEnabled() * 1000);
-        if (value > _lasttotal) {
-            _lasttotal = value;
-            setHRegs(40129, value);
-        }
+    }
 
-        if (Hoymiles.getNumInverters() == 1) {
-            auto inv = Hoymiles.getInverterByPos(0);
-            if (inv != nullptr) {
-                for (auto& t : inv->Statistics()->getChannelTypes()) {
-                    if (t == TYPE_DC) {
-                        setHregs(40071, inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_IAC));
-                        setHregs(40073, inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_IAC_1) != 0 ? inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_IAC_1) : inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_IAC));
-                        setHRegs(40075, inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_IAC_2));
-                        setHRegs(40077, inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_IAC_3));
-                        setHRegs(40079, inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_UAC_1N));
-                        setHRegs(40081, inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_UAC_1N) != 0 ? inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_UAC_1N) : inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_UAC));
-                        setHRegs(40083, inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_UAC_2N));
-                        setHRegs(40085, inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_UAC_3N));
-                        setHRegs(40087, inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_UAC));
-                        setHRegs(40089, inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_UAC_12));
-                        setHRegs(40091, inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_UAC_23));
-                        setHRegs(40093, inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_UAC_31));
-                        setHRegs(40095, inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_F));
-                        //setHRegs(40097, inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_PAC)*-1); //done above already!
-                        setHRegs(40099, inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_IAC_1) != 0 ?
-                                        inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_IAC_1) * inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_UAC_1N) * -1 :
-                                        inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_IAC) * inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_UAC) * -1;
-                        setHRegs(40101, inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_IAC_2) * inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_UAC_2N) * -1);
-                        setHRegs(40103, inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_IAC_3) * inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_UAC_3N) * -1);
-
-                        setHRegs(40113, inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_Q));  // apparent power
-
-                        setHRegs(40121, inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_PF)); // Power Factor
-
-                        //value = inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_YT)*1000.0;  // AC Lifetime Energy Production
-                        //if (value > _lastttotal) {
-                        //    _lasttotal = value;
-                        //    setHRegs(40129, value);
-                        //}
-                    }
-                }
-            }
-            // MessageOutput.printf("Modbus: End additional SM Information\r\n");
-        }
+    setHRegs(40097, Datastore.getTotalAcPowerEnabled() * -1);
+    float value = (Datastore.getTotalAcYieldTotalEnabled() * 1000);
+    if (value > _lasttotal) {
+        _lasttotal = value;
+        setHRegs(40129, value);
     }
+
+    if (Hoymiles.getNumInverters() != 1) { return; }
+
+    auto inv = Hoymiles.getInverterByPos(0);
+    if (inv == nullptr || inv->Statistics()->getChannelsByType(TYPE_DC).empty()) { return; }
+
+    auto stats = inv->Statistics();
+    auto ac = [&stats](FieldId_t field) { return stats->getChannelFieldValue(TYPE_AC, CH0, field); };
+
+    setHRegs(40071, ac(FLD_IAC));
+    setHRegs(40073, ac(FLD_IAC_1) != 0 ? ac(FLD_IAC_1) : ac(FLD_IAC));
+    setHRegs(40075, ac(FLD_IAC_2));
+    setHRegs(40077, ac(FLD_IAC_3));
+    setHRegs(40079, ac(FLD_UAC_1N));
+    setHRegs(40081, ac(FLD_UAC_1N) != 0 ? ac(FLD_UAC_1N) : ac(FLD_UAC));
+    setHRegs(40083, ac(FLD_UAC_2N));
+    setHRegs(40085, ac(FLD_UAC_3N));
+    setHRegs(40087, ac(FLD_UAC));
+    setHRegs(40089, ac(FLD_UAC_12));
+    setHRegs(40091, ac(FLD_UAC_23));
+    setHRegs(40093, ac(FLD_UAC_31));
+    setHRegs(40095, ac(FLD_F));
+    // 40097 total AC power is set above
+    setHRegs(40099, ac(FLD_IAC_1) != 0 ?
+                    ac(FLD_IAC_1) * ac(FLD_UAC_1N) * -1 :
+                    ac(FLD_IAC) * ac(FLD_UAC) * -1);
+    setHRegs(40101, ac(FLD_IAC_2) * ac(FLD_UAC_2N) * -1);
+    setHRegs(40103, ac(FLD_IAC_3) * ac(FLD_UAC_3N) * -1);
+
+    setHRegs(40113, ac(FLD_Q)); // apparent power
+
+    setHRegs(40121, ac(FLD_PF)); // Power Factor
 #endif
 }
 
-void ModbusDtuClass::mbloop()
+#ifdef SIMULATE_HOYMILES_DTU
+void ModbusDtuClass::refreshInverter(InverterSlot_t const& slot)
 {
-    if (!(Configuration.get().Modbus.Fronius_SM_Simulation_Enabled) || !_isstarted) {
-        return;
+    auto inv = Hoymiles.getInverterBySerial(slot.serial);
+    if (inv == nullptr) { return; }
+
+    auto stats = inv->Statistics();
+    uint8_t i = 0;
+
+    for (auto& c : stats->getChannelsByType(TYPE_DC)) {
+        if (i >= slot.channels) { break; }
+        uint16_t row = (slot.firstChannel + i++) * 20 + 0x1000;
+
+        if (stats->getStringMaxPower(c) == 0 || stats->getChannelFieldValue(TYPE_DC, c, FLD_IRR) < 500) {
+            setHReg(row + 0x04, static_cast<uint16_t>(stats->getChannelFieldValue(TYPE_DC, c, FLD_UDC) * 10));
+            setHReg(row + 0x05, static_cast<uint16_t>(stats->getChannelFieldValue(TYPE_DC, c, FLD_IDC) * 100));
+            setHReg(row + 0x08, static_cast<uint16_t>(stats->getChannelFieldValue(TYPE_DC, c, FLD_PDC) * 10));
+        }
+
+        uint32_t yieldTotal = static_cast<uint32_t>(stats->getChannelFieldValue(TYPE_DC, c, FLD_YT) * 1000);
+
+        setHReg(row + 0x06, static_cast<uint16_t>(stats->getChannelFieldValue(TYPE_AC, CH0, FLD_UAC) * 10));
+        setHReg(row + 0x07, static_cast<uint16_t>(stats->getChannelFieldValue(TYPE_AC, CH0, FLD_F) * 100));
+        setHReg(row + 0x09, static_cast<uint16_t>(stats->getChannelFieldValue(TYPE_DC, c, FLD_YD)));
+        setHReg(row + 0x0A, yieldTotal >> 16);
+        setHReg(row + 0x0B, yieldTotal & 0xFFFF);
+        setHReg(row + 0x0C, static_cast<uint16_t>(stats->getChannelFieldValue(TYPE_INV, CH0, FLD_T) * 10));
     }
+}
+#endif
 
-    mb.task();
+void ModbusDtuClass::setHReg(uint16_t reg, uint16_t value)
+{
+    uint16_t* target = findRegister(reg);
+    if (target != nullptr) { *target = value; }
 }
 
 void ModbusDtuClass::setHRegs(uint16_t reg, float value)
 {
-    uint16_t* hexbytes = reinterpret_cast<uint16_t*>(&value);
-    mb.Hreg(reg++, hexbytes[1]);
-    mb.Hreg(reg, hexbytes[0]);
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    setHReg(reg, bits >> 16);
+    setHReg(reg + 1, bits & 0xFFFF);
 }
 
-void ModbusDtuClass::addHString(uint16_t reg, const char* s, uint8_t len)
+// SunSpec strings are stored big endian, two characters per register and
+// padded with NUL
+void ModbusDtuClass::setHString(uint16_t reg, const char* s, uint8_t len)
 {
-    len *= 2; // convert to number of bytes
-    for (uint8_t i = 0; i < len; i += 2) {
-        uint16_t value = 0;
-        if (i < strlen(s))
-            value = *(reinterpret_cast<uint16_t*>(&s[i]));
-        mb.addHreg(reg++, value);
+    size_t length = strlen(s);
+
+    for (size_t i = 0; i < len; i++) {
+        uint8_t high = (2 * i < length) ? s[2 * i] : 0;
+        uint8_t low = (2 * i + 1 < length) ? s[2 * i + 1] : 0;
+        setHReg(reg + i, (high << 8) | low);
     }
 }
 
@@ -165,7 +165,9 @@ void MqttHandleHassClass::publishInverterField(std::shared_ptr<InverterAbstract>
         root["uniq_id"] = serial + "_ch" + chanNum + "_" + fieldName;
 
         if (Configuration.get().Mqtt.Hass.Expire) {
-            root["exp_aft"] = Hoymiles.getNumInverters() * max<uint32_t>(Hoymiles.PollInterval(), Configuration.get().Mqtt.PublishInterval) * inv->getReachableThreshold();
+            // unchanged values are only published again after the refresh interval
+            const uint32_t expireAfter = Hoymiles.getNumInverters() * max<uint32_t>(Hoymiles.PollInterval(), Configuration.get().Mqtt.PublishInterval) * inv->getReachableThreshold();
+            root["exp_aft"] = max<uint32_t>(expireAfter, 2 * Configuration.get().Mqtt.RefreshInterval);
         }
         if (stateCls != 0) {
             root["stat_cla"] = stateCls;
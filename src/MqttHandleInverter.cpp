@@ -38,58 +38,59 @@ void MqttHandleInverterClass::loop()
     for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
         auto inv = Hoymiles.getInverterByPos(i);
 
-        const String subtopic = inv->serialString();
+        MqttSettings.beginDevicePublish(inv->serialString());
 
         // Name
-        MqttSettings.publish(subtopic + "/name", inv->name());
+        MqttSettings.publishDeviceValue("name", inv->name());
 
        // Radio Statistics
-        MqttSettings.publish(subtopic + "/radio/tx_request", String(inv->RadioStats.TxRequestData));
-        MqttSettings.publish(subtopic + "/radio/tx_re_request", String(inv->RadioStats.TxReRequestFragment));
-        MqttSettings.publish(subtopic + "/radio/rx_success", String(inv->RadioStats.RxSuccess));
-        MqttSettings.publish(subtopic + "/radio/rx_fail_nothing", String(inv->RadioStats.RxFailNoAnswer));
-        MqttSettings.publish(subtopic + "/radio/rx_fail_partial", String(inv->RadioStats.RxFailPartialAnswer));
-        MqttSettings.publish(subtopic + "/radio/rx_fail_corrupt", String(inv->RadioStats.RxFailCorruptData));
-        MqttSettings.publish(subtopic + "/radio/rssi", String(inv->getLastRssi()));
+        MqttSettings.publishDeviceValue("radio/tx_request", String(inv->RadioStats.TxRequestData));
+        MqttSettings.publishDeviceValue("radio/tx_re_request", String(inv->RadioStats.TxReRequestFragment));
+        MqttSettings.publishDeviceValue("radio/rx_success", String(inv->RadioStats.RxSuccess));
+        MqttSettings.publishDeviceValue("radio/rx_fail_nothing", String(inv->RadioStats.RxFailNoAnswer));
+        MqttSettings.publishDeviceValue("radio/rx_fail_partial", String(inv->RadioStats.RxFailPartialAnswer));
+        MqttSettings.publishDeviceValue("radio/rx_fail_corrupt", String(inv->RadioStats.RxFailCorruptData));
+        MqttSettings.publishDeviceValue("radio/rssi", String(inv->getLastRssi()));
 
         if (inv->DevInfo()->getLastUpdate() > 0) {
             // Bootloader Version
-            MqttSettings.publish(subtopic + "/device/bootloaderversion", String(inv->DevInfo()->getFwBootloaderVersion()));
+            MqttSettings.publishDeviceValue("device/bootloaderversion", String(inv->DevInfo()->getFwBootloaderVersion()));
 
             // Firmware Version
-            MqttSettings.publish(subtopic + "/device/fwbuildversion", String(inv->DevInfo()->getFwBuildVersion()));
+            MqttSettings.publishDeviceValue("device/fwbuildversion", String(inv->DevInfo()->getFwBuildVersion()));
 
             // Firmware Build DateTime
-            MqttSettings.publish(subtopic + "/device/fwbuilddatetime", inv->DevInfo()->getFwBuildDateTimeStr());
+            MqttSettings.publishDeviceValue("device/fwbuilddatetime", inv->DevInfo()->getFwBuildDateTimeStr());
 
             // Hardware part number
-            MqttSettings.publish(subtopic + "/device/hwpartnumber", String(inv->DevInfo()->getHwPartNumber()));
+            MqttSettings.publishDeviceValue("device/hwpartnumber", String(inv->DevInfo()->getHwPartNumber()));
 
             // Hardware version
-            MqttSettings.publish(subtopic + "/device/hwversion", inv->DevInfo()->getHwVersion());
+            MqttSettings.publishDeviceValue("device/hwversion", inv->DevInfo()->getHwVersion());
         }
 
         if (inv->SystemConfigPara()->getLastUpdate() > 0) {
             // Limit
-            MqttSettings.publish(subtopic + "/status/limit_relative", String(inv->SystemConfigPara()->getLimitPercent()));
+            MqttSettings.publishDeviceValue("status/limit_relative", String(inv->SystemConfigPara()->getLimitPercent()));
 
             uint16_t maxpower = inv->DevInfo()->getMaxPower();
             if (maxpower > 0) {
-                MqttSettings.publish(subtopic + "/status/limit_absolute", String(inv->SystemConfigPara()->getLimitPercent() * maxpower / 100));
+                MqttSettings.publishDeviceValue("status/limit_absolute", String(inv->SystemConfigPara()->getLimitPercent() * maxpower / 100));
             }
         }
 
-        MqttSettings.publish(subtopic + "/status/reachable", String(inv->isReachable()));
-        MqttSettings.publish(subtopic + "/status/producing", String(inv->isProducing()));
+        MqttSettings.publishDeviceValue("status/reachable", String(inv->isReachable()));
+        MqttSettings.publishDeviceValue("status/producing", String(inv->isProducing()));
 
         if (inv->Statistics()->getLastUpdate() > 0) {
-            MqttSettings.publish(subtopic + "/status/last_update", String(std::time(0) - (millis() - inv->Statistics()->getLastUpdate()) / 1000));
+            MqttSettings.publishDeviceValue("status/last_update", String(std::time(0) - (millis() - inv->Statistics()->getLastUpdate()) / 1000));
         } else {
-            MqttSettings.publish(subtopic + "/status/last_update", String(0));
+            MqttSettings.publishDeviceValue("status/last_update", String(0));
         }
 
+        // unchanged statistics are only published again on a forced refresh
         const uint32_t lastUpdateInternal = inv->Statistics()->getLastUpdateFromInternal();
-        if (inv->Statistics()->getLastUpdate() > 0 && (lastUpdateInternal != _lastPublishStats[i])) {
+        if (inv->Statistics()->getLastUpdate() > 0 && (lastUpdateInternal != _lastPublishStats[i] || MqttSettings.isDeviceRefreshDue())) {
             _lastPublishStats[i] = lastUpdateInternal;
 
             // Loop all channels
@@ -99,7 +100,7 @@ void MqttHandleInverterClass::loop()
                         INVERTER_CONFIG_T* inv_cfg = Configuration.getInverterConfig(inv->serial());
                         if (inv_cfg != nullptr) {
                             // TODO(tbnobody)
-                            MqttSettings.publish(inv->serialString() + "/" + String(static_cast<uint8_t>(c) + 1) + "/name", inv_cfg->channel[c].Name);
+                            MqttSettings.publishDeviceValue(String(static_cast<uint8_t>(c) + 1) + "/name", inv_cfg->channel[c].Name);
                         }
                     }
                     for (uint8_t f = 0; f < sizeof(_publishFields) / sizeof(FieldId_t); f++) {
@@ -109,21 +110,33 @@ void MqttHandleInverterClass::loop()
             }
         }
 
+        MqttSettings.endDevicePublish();
+
         yield();
     }
 }
 
 void MqttHandleInverterClass::publishField(std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
 {
-    const String topic = getTopic(inv, type, channel, fieldId);
-    if (topic == "") {
+    const String subtopic = getSubtopic(inv, type, channel, fieldId);
+    if (subtopic == "") {
         return;
     }
 
-    MqttSettings.publish(topic, inv->Statistics()->getChannelFieldValueString(type, channel, fieldId));
+    MqttSettings.publishDeviceValue(subtopic, inv->Statistics()->getChannelFieldValueString(type, channel, fieldId));
 }
 
 String MqttHandleInverterClass::getTopic(std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
+{
+    const String subtopic = getSubtopic(inv, type, channel, fieldId);
+    if (subtopic == "") {
+        return subtopic;
+    }
+
+    return inv->serialString() + "/" + subtopic;
+}
+
+String MqttHandleInverterClass::getSubtopic(std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
 {
     if (!inv->Statistics()->hasChannelFieldValue(type, channel, fieldId)) {
         return String("");
@@ -145,7 +158,7 @@ String MqttHandleInverterClass::getTopic(std::shared_ptr<InverterAbstract> inv,
         chanNum = channel;
     }
 
-    return inv->serialString() + "/" + chanNum + "/" + chanName;
+    return chanNum + "/" + chanName;
 }
 
 void MqttHandleInverterClass::onMqttMessage(Topic t, const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, const size_t len, const size_t index, const size_t total)
@@ -6,6 +6,7 @@
 #include "MqttSettings.h"
 #include "MqttHandlePowerLimiter.h"
 #include "PowerLimiter.h"
+#include "PowerLimiterLatency.h"
 #include <ctime>
 #include <string>
 
@@ -90,6 +91,18 @@ void MqttHandlePowerLimiterClass::loop()
     MqttSettings.publish("powerlimiter/status/target_power_consumption", String(config.PowerLimiter.TargetPowerConsumption));
     MqttSettings.publish("powerlimiter/status/inverter_update_timeouts", String(PowerLimiter.getInverterUpdateTimeouts()));
 
+    for (uint8_t s = 0; s < static_cast<uint8_t>(PowerLimiterLatencyClass::Stage::Count); ++s) {
+        auto stage = static_cast<PowerLimiterLatencyClass::Stage>(s);
+        auto oPercentiles = PowerLimiterLatency.getPercentiles(stage);
+        if (!oPercentiles.has_value()) { continue; }
+
+        String topic = String("powerlimiter/status/latency/") + PowerLimiterLatencyClass::getStageName(stage) + "/";
+        MqttSettings.publish(topic + "p50", String(oPercentiles->p50));
+        MqttSettings.publish(topic + "p90", String(oPercentiles->p90));
+        MqttSettings.publish(topic + "p99", String(oPercentiles->p99));
+        MqttSettings.publish(topic + "max", String(oPercentiles->max));
+    }
+
     // no thresholds are relevant for setups without a battery
     if (config.PowerLimiter.IsInverterSolarPowered) { return; }
 
@@ -24,9 +24,9 @@ void MqttHandleREFUsolClass::init(Scheduler& scheduler)
     _lastPublish = millis();
 }
 
-#define MQTTpublish(value)                                                \
-    if (!config.REFUsol.UpdatesOnly || _last.value != REFUsol.Frame.value) \
-        MqttSettings.publish(subtopic + #value, String(_last.value = REFUsol.Frame.value));
+#define MQTTpublish(value)                                       \
+    if (!config.REFUsol.UpdatesOnly || last.value != frame.value) \
+        MqttSettings.publish(subtopic + #value, String(last.value = frame.value));
 
 void MqttHandleREFUsolClass::loop()
 {
@@ -37,21 +37,34 @@ void MqttHandleREFUsolClass::loop()
     }
 
     if (!MqttSettings.getConnected() ||
-        (millis() - _lastPublish) < config.Mqtt.PublishInterval * 1000 ||
-        !REFUsol.isDataValid())
+        (millis() - _lastPublish) < config.Mqtt.PublishInterval * 1000)
     {
         return;
     }
 
-    String value;
+    _last.resize(REFUsol.getInverterCount());
+
+    for (size_t i = 0; i < REFUsol.getInverterCount(); ++i) {
+        if (REFUsol.isDataValid(i)) { publish(i); }
+    }
+
+    _lastPublish = millis();
+}
+
+void MqttHandleREFUsolClass::publish(size_t inverter)
+{
+    auto const& config = Configuration.get();
+    auto const& frame = REFUsol.getFrame(inverter);
+    auto& last = _last[inverter];
+
     String subtopic = "refusol/";
-    subtopic.concat(REFUsol.Frame.serNo);
+    subtopic.concat(frame.serNo);
     subtopic.concat("/");
 
-    if (!config.REFUsol.UpdatesOnly || strcmp(REFUsol.Frame.serNo, _last.serNo) != 0)
-        MqttSettings.publish(subtopic + "serNo", REFUsol.Frame.serNo);
-    if (!config.REFUsol.UpdatesOnly || strcmp(REFUsol.Frame.firmware, _last.firmware) != 0)
-        MqttSettings.publish(subtopic + "firmware", REFUsol.Frame.firmware);
+    if (!config.REFUsol.UpdatesOnly || strcmp(frame.serNo, last.serNo) != 0)
+        MqttSettings.publish(subtopic + "serNo", frame.serNo);
+    if (!config.REFUsol.UpdatesOnly || strcmp(frame.firmware, last.firmware) != 0)
+        MqttSettings.publish(subtopic + "firmware", frame.firmware);
     MQTTpublish(currentStateOfOperation);
     MQTTpublish(error);
     MQTTpublish(status);
@@ -82,8 +95,6 @@ void MqttHandleREFUsolClass::loop()
     MQTTpublish(temperatureTopLeft);
     MQTTpublish(temperatureBottomRight);
     MQTTpublish(temperatureLeft);
-
-    _lastPublish = millis();
 }
 
 #endif
@@ -7,6 +7,7 @@
 #include "MessageOutput.h"
 
 MqttSettingsClass::MqttSettingsClass()
+    : _queueTask(20 * TASK_MILLISECOND, TASK_FOREVER, std::bind(&MqttSettingsClass::processQueue, this))
 {
 }
 
@@ -29,6 +30,8 @@ void MqttSettingsClass::NetworkEvent(network_event event)
 void MqttSettingsClass::onMqttConnect(const bool sessionPresent)
 {
     MessageOutput.println("Connected to MQTT.");
+    _cacheGeneration++;
+
     auto const& cMqtt = Configuration.get().Mqtt;
     publish(cMqtt.Lwt.Topic, cMqtt.Lwt.Value_Online);
 
@@ -159,6 +162,7 @@ void MqttSettingsClass::performDisconnect()
 void MqttSettingsClass::performReconnect()
 {
     performDisconnect();
+    _cacheGeneration++;
 
     createMqttClientObject();
 
@@ -199,20 +203,330 @@ void MqttSettingsClass::publish(const String& subtopic, const String& payload)
     publishGeneric(topic, value, Configuration.get().Mqtt.Retain, 0);
 }
 
-void MqttSettingsClass::publishGeneric(const String& topic, const String& payload, const bool retain, const uint8_t qos)
+bool MqttSettingsClass::publishGeneric(const String& topic, const String& payload, const bool retain, const uint8_t qos, const bool coalesce)
+{
+    auto const& cMqtt = Configuration.get().Mqtt;
+    if (!cMqtt.Enabled) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(_queueLock);
+
+    const uint32_t topicHash = hash(topic.c_str());
+
+    if (coalesce) {
+        auto it = _outboxTopics.find(topicHash);
+        if (it != _outboxTopics.end() && it->second->topic == topic) {
+            // only the latest value of a topic is of interest. the message
+            // keeps its position in the queue.
+            OutboxEntry_t& entry = *it->second;
+            const uint8_t entryQos = std::max(entry.qos, qos);
+            const size_t oldSize = entrySize(entry);
+            const size_t newSize = oldSize - entry.payload.length() + payload.length();
+
+            // the larger payload does not fit, the update is dropped like a
+            // new message would be and the queued payload is kept
+            if (newSize > oldSize
+                    && (newSize > cMqtt.QueueBudget || !makeRoom(newSize - oldSize, entryQos, &entry))) {
+                if (entryQos == 0) {
+                    _droppedQos0++;
+                } else {
+                    _droppedQos12++;
+                }
+                return false;
+            }
+
+            entry.payload = payload;
+            entry.retain = retain;
+            entry.qos = entryQos;
+            _outboxBytes = _outboxBytes - oldSize + newSize;
+            _outboxPeakBytes = std::max(_outboxPeakBytes, _outboxBytes);
+            _coalesced++;
+            return true;
+        }
+    }
+
+    OutboxEntry_t entry = { topic, payload, topicHash, qos, retain, coalesce };
+
+    // nothing is waiting, no need to queue the message
+    if (_outbox.empty() && sendEntry(entry)) {
+        return true;
+    }
+
+    const size_t size = entrySize(entry);
+    if (!makeRoom(size, qos)) {
+        if (qos == 0) {
+            _droppedQos0++;
+        } else {
+            _droppedQos12++;
+        }
+        return false;
+    }
+
+    _outbox.push_back(std::move(entry));
+    if (coalesce) {
+        _outboxTopics[topicHash] = std::prev(_outbox.end());
+    }
+
+    _outboxBytes += size;
+    _outboxPeakBytes = std::max(_outboxPeakBytes, _outboxBytes);
+    return true;
+}
+
+size_t MqttSettingsClass::entrySize(const OutboxEntry_t& entry)
+{
+    // includes a rough estimate of the list node and heap overhead
+    return sizeof(OutboxEntry_t) + entry.topic.length() + entry.payload.length() + 32;
+}
+
+// drops queued messages until size more bytes fit into the budget, oldest
+// first. QoS 0 messages which are not retained are dropped first, then the
+// retained ones (e.g. the Home Assistant discovery). messages with QoS 1 or 2
+// are only dropped in favour of another one with QoS 1 or 2.
+bool MqttSettingsClass::makeRoom(size_t size, uint8_t qos, const OutboxEntry_t* keep)
+{
+    const size_t budget = Configuration.get().Mqtt.QueueBudget;
+    if (size > budget) {
+        return false;
+    }
+
+    auto drop = [&](auto droppable, uint32_t& dropped) {
+        for (auto it = _outbox.begin(); it != _outbox.end() && _outboxBytes + size > budget;) {
+            if (&*it != keep && droppable(*it)) {
+                it = removeEntry(it);
+                dropped++;
+            } else {
+                ++it;
+            }
+        }
+        return _outboxBytes + size <= budget;
+    };
+
+    if (drop([](const OutboxEntry_t& entry) { return entry.qos == 0 && !entry.retain; }, _droppedQos0)) {
+        return true;
+    }
+
+    if (drop([](const OutboxEntry_t& entry) { return entry.qos == 0; }, _droppedQos0)) {
+        return true;
+    }
+
+    if (qos == 0) {
+        return false;
+    }
+
+    return drop([](const OutboxEntry_t&) { return true; }, _droppedQos12);
+}
+
+MqttSettingsClass::Outbox::iterator MqttSettingsClass::removeEntry(Outbox::iterator it)
+{
+    if (it->coalesce) {
+        auto pos = _outboxTopics.find(it->topicHash);
+        if (pos != _outboxTopics.end() && pos->second == it) {
+            _outboxTopics.erase(pos);
+        }
+    }
+
+    _outboxBytes -= entrySize(*it);
+    return _outbox.erase(it);
+}
+
+bool MqttSettingsClass::sendEntry(const OutboxEntry_t& entry)
 {
     std::lock_guard<std::mutex> lock(_clientLock);
-    if (_mqttClient == nullptr) {
+    if (_mqttClient == nullptr || !_mqttClient->connected()) {
+        return false;
+    }
+
+    if (_mqttClient->queueSize() >= _clientQueueLimit) {
+        return false;
+    }
+
+    return _mqttClient->publish(entry.topic.c_str(), entry.qos, entry.retain, entry.payload.c_str()) != 0;
+}
+
+void MqttSettingsClass::processQueue()
+{
+    std::lock_guard<std::mutex> lock(_queueLock);
+
+    if (!Configuration.get().Mqtt.Enabled) {
+        _outbox.clear();
+        _outboxTopics.clear();
+        _outboxBytes = 0;
+        return;
+    }
+
+    while (!_outbox.empty() && sendEntry(_outbox.front())) {
+        removeEntry(_outbox.begin());
+    }
+}
+
+MqttSettingsClass::QueueStats_t MqttSettingsClass::getQueueStats()
+{
+    std::lock_guard<std::mutex> lock(_queueLock);
+    return { _outbox.size(), _outboxBytes, _outboxPeakBytes, _coalesced, _droppedQos0, _droppedQos12 };
+}
+
+uint32_t MqttSettingsClass::hash(const char* str)
+{
+    // FNV-1a
+    uint32_t h = 2166136261UL;
+    while (*str) {
+        h ^= static_cast<uint8_t>(*str++);
+        h *= 16777619UL;
+    }
+    return h;
+}
+
+static bool isJsonNumber(const String& value)
+{
+    const char* str = value.c_str();
+    if (!isdigit(str[0]) && !(str[0] == '-' && isdigit(str[1]))) {
+        return false;
+    }
+
+    char* end;
+    strtod(str, &end);
+    return *end == '\0' && end[-1] != '.';
+}
+
+void MqttSettingsClass::removeDevice(const String& device)
+{
+    std::lock_guard<std::mutex> lock(_removedDevicesLock);
+    _removedDevices.push_back(device);
+}
+
+void MqttSettingsClass::beginDevicePublish(const String& device)
+{
+    {
+        std::lock_guard<std::mutex> lock(_removedDevicesLock);
+        for (auto const& removed : _removedDevices) {
+            _deviceCaches.erase(removed);
+        }
+        _removedDevices.clear();
+    }
+
+    auto const& cMqtt = Configuration.get().Mqtt;
+    auto& cache = _deviceCaches[device];
+    const uint32_t generation = _cacheGeneration;
+
+    if (cache.generation != generation) {
+        // new connection or changed base topic, publish everything again
+        cache.topic = getPrefix() + device + "/";
+        cache.generation = generation;
+        cache.valueHashes.clear();
+        cache.lastRefresh = millis();
+        _deviceRefresh = true;
+    } else if (cMqtt.RefreshInterval == 0 || millis() - cache.lastRefresh >= cMqtt.RefreshInterval * 1000) {
+        cache.lastRefresh = millis();
+        _deviceRefresh = true;
+    } else {
+        _deviceRefresh = false;
+    }
+
+    if (!cMqtt.JsonPayload) {
+        cache.json.reset();
+    } else if (cache.json == nullptr) {
+        cache.json = std::make_unique<JsonDocument>();
+        _deviceRefresh = true;
+    }
+
+#ifdef USE_HASS
+    _deviceIndividualTopics = !cMqtt.JsonPayload || cMqtt.Hass.Enabled;
+#else
+    _deviceIndividualTopics = !cMqtt.JsonPayload;
+#endif
+
+    _currentDevice = &cache;
+    _deviceChanged = false;
+}
+
+void MqttSettingsClass::publishDeviceValue(const String& subtopic, const String& payload)
+{
+    if (_currentDevice == nullptr) {
         return;
     }
-    _mqttClient->publish(topic.c_str(), qos, retain, payload.c_str());
+
+    String value = payload;
+    value.trim();
+
+    const uint32_t valueHash = hash(value.c_str());
+    auto& lastHash = _currentDevice->valueHashes[hash(subtopic.c_str())];
+    const bool changed = (lastHash != valueHash);
+    _deviceChanged |= changed;
+
+    bool published = true;
+    if (_deviceIndividualTopics && (changed || _deviceRefresh)) {
+        _deviceTopic = _currentDevice->topic;
+        _deviceTopic += subtopic;
+        published = publishGeneric(_deviceTopic, value, Configuration.get().Mqtt.Retain, 0);
+    }
+
+    // a value which was dropped is published again by the next call
+    if (published) {
+        lastHash = valueHash;
+    }
+
+    if (_currentDevice->json == nullptr) {
+        return;
+    }
+
+    // "radio/rssi" is stored as {"radio":{"rssi":...}}
+    JsonObject obj = _currentDevice->json->as<JsonObject>();
+    if (obj.isNull()) {
+        obj = _currentDevice->json->to<JsonObject>();
+    }
+
+    int start = 0;
+    int slash;
+    while ((slash = subtopic.indexOf('/', start)) >= 0) {
+        const String key = subtopic.substring(start, slash);
+        JsonObject child = obj[key].as<JsonObject>();
+        if (child.isNull()) {
+            child = obj[key].to<JsonObject>();
+        }
+        obj = child;
+        start = slash + 1;
+    }
+
+    const String key = subtopic.substring(start);
+    if (isJsonNumber(value)) {
+        obj[key] = serialized(value);
+    } else {
+        obj[key] = value;
+    }
+}
+
+void MqttSettingsClass::endDevicePublish()
+{
+    if (_currentDevice == nullptr) {
+        return;
+    }
+
+    if (_currentDevice->json != nullptr && (_deviceChanged || _deviceRefresh || _currentDevice->jsonPending)) {
+        String buffer;
+        serializeJson(*_currentDevice->json, buffer);
+
+        _deviceTopic = _currentDevice->topic;
+        _deviceTopic += "json";
+        _currentDevice->jsonPending = !publishGeneric(_deviceTopic, buffer, Configuration.get().Mqtt.Retain, 0);
+    }
+
+    _currentDevice = nullptr;
 }
 
-void MqttSettingsClass::init()
+bool MqttSettingsClass::isDeviceRefreshDue() const
+{
+    return _deviceRefresh;
+}
+
+void MqttSettingsClass::init(Scheduler& scheduler)
 {
     using std::placeholders::_1;
     NetworkSettings.onEvent(std::bind(&MqttSettingsClass::NetworkEvent, this, _1));
 
+    scheduler.addTask(_queueTask);
+    _queueTask.enable();
+
     createMqttClientObject();
 }
 
@@ -17,6 +17,7 @@
 #include "inverters/HMS_4CH.h"
 #include "PinMapping.h"
 #include "SunPosition.h"
+#include <algorithm>
 #include <cmath>
 #include <ctime>
 #include <frozen/map.h>
@@ -137,13 +138,76 @@ bool PowerLimiterClass::shutdown(PowerLimiterClass::Status status)
 
     _shutdownPending = true;
 
-    _oTargetPowerState = false;
+    for (auto& mi : _inverters) { mi.oTargetPowerState = false; }
 
     // needed if MosFETs to control DC power of inverter between battery and inverter
     // added by skippermeister
     _switchMosFetOffTimer = millis();
 
-    return updateInverter();
+    return updateInverters();
+}
+
+/**
+ * keeps the list of managed inverters in line with the configuration. the
+ * primary inverter is always the first entry. returns false if the DPL had to
+ * shut down because the configured set of inverters is invalid or changed.
+ */
+bool PowerLimiterClass::syncManagedInverters()
+{
+    auto const& cPL = Configuration.get().PowerLimiter;
+
+    std::vector<ManagedInverter_t> configured;
+
+    auto primary = Hoymiles.getInverterBySerial(cPL.InverterId);
+    if (primary == nullptr) {
+        // in case of (newly) broken configuration, shut down
+        // the last inverters we worked with (if any)
+        shutdown(Status::InverterInvalid);
+        return false;
+    }
+
+    auto addInverter = [&configured](std::shared_ptr<InverterAbstract> inverter, bool solarPowered) {
+        ManagedInverter_t mi;
+        mi.inverter = inverter;
+        mi.solarPowered = solarPowered;
+        configured.push_back(std::move(mi));
+    };
+
+    addInverter(primary, cPL.IsInverterSolarPowered);
+
+    for (uint8_t i = 0; i < POWERLIMITER_MAX_ADDITIONAL_INVERTERS; i++) {
+        auto const& cInv = cPL.AdditionalInverters[i];
+        if (cInv.Serial == 0 || cInv.Serial == cPL.InverterId) { continue; }
+
+        // the battery thresholds are evaluated using the primary inverter,
+        // so battery-powered inverters can only join a battery-powered one.
+        if (!cInv.IsSolarPowered && cPL.IsInverterSolarPowered) { continue; }
+
+        auto inv = Hoymiles.getInverterBySerial(cInv.Serial);
+        if (inv == nullptr) { continue; }
+
+        addInverter(inv, cInv.IsSolarPowered);
+    }
+
+    if (_inverters.empty()) {
+        _inverters = std::move(configured);
+        return true;
+    }
+
+    bool changed = _inverters.size() != configured.size();
+    for (size_t i = 0; !changed && i < configured.size(); i++) {
+        changed = _inverters[i].inverter->serial() != configured[i].inverter->serial()
+            || _inverters[i].solarPowered != configured[i].solarPowered;
+    }
+
+    // if the DPL is supposed to manage other inverters now, we first shut
+    // down the previous ones. then we pick up the new set of inverters.
+    if (changed) {
+        shutdown(Status::InverterChanged);
+        return false;
+    }
+
+    return true;
 }
 
 void PowerLimiterClass::loop()
@@ -161,7 +225,7 @@ void PowerLimiterClass::loop()
 
     // take care that the last requested power
     // limit and power state are actually reached
-    if (updateInverter()) { return; }
+    if (updateInverters()) { return; }
 
     if (_shutdownPending) {
         // controll MosFets between battery and inverter
@@ -176,6 +240,10 @@ void PowerLimiterClass::loop()
             }
         }
         _shutdownPending = false;
+        for (auto& mi : _inverters) {
+            mi.inverter->setPollPriority(false);
+        }
+        _inverters.clear();
         _inverter = nullptr;
     }
 
@@ -203,33 +271,10 @@ void PowerLimiterClass::loop()
         return;
     }
 
-    std::shared_ptr<InverterAbstract> currentInverter = Hoymiles.getInverterBySerial(config.PowerLimiter.InverterId);
-
-/*
-    // always done in module read configuration file
-    // removed by skippermeister
-    if (currentInverter == nullptr && config.PowerLimiter.InverterId < INV_MAX_COUNT) {
-        // we previously had an index saved as InverterId. fall back to the
-        // respective positional lookup if InverterId is not a known serial.
-        currentInverter = Hoymiles.getInverterByPos(config.PowerLimiter.InverterId);
-    }
-*/
-    // in case of (newly) broken configuration, shut down
-    // the last inverter we worked with (if any)
-    if (currentInverter == nullptr) {
-        shutdown(Status::InverterInvalid);
-        return;
-    }
-
-    // if the DPL is supposed to manage another inverter now, we first
-    // shut down the previous one, if any. then we pick up the new one.
-    if (_inverter != nullptr && _inverter->serial() != currentInverter->serial()) {
-        shutdown(Status::InverterChanged);
-        return;
-    }
+    if (!syncManagedInverters()) { return; }
 
     // update our pointer as the configuration might have changed
-    _inverter = currentInverter;
+    _inverter = _inverters.front().inverter;
 
     // manage MosFets between batterie and inverter
     // added by skippermeister
@@ -253,29 +298,76 @@ void PowerLimiterClass::loop()
         return announceStatus(Status::InverterDevInfoPending);
     }
 
+    // additional inverters take part in the load distribution only while
+    // they satisfy the same prerequisites. the primary one does at this point.
+    for (auto& mi : _inverters) {
+        mi.eligible = mi.inverter->isReachable()
+            && mi.inverter->getEnableCommands()
+            && mi.inverter->DevInfo()->getMaxPower() > 0;
+    }
+
     if (Mode::UnconditionalFullSolarPassthrough == _mode) {
         // handle this mode of operation separately
-        return unconditionalSolarPassthrough(_inverter);
+        return unconditionalSolarPassthrough();
     }
 
-    // concerns both power limits and start/stop/restart commands and is
-    // only updated if a respective response was received from the inverter
-    auto lastUpdateCmd = std::max(
-        _inverter->SystemConfigPara()->getLastUpdateCommand(),
-        _inverter->PowerCommand()->getLastUpdateCommand());
+    uint32_t latestStatsMillis = 0;
+    for (auto& mi : _inverters) {
+        if (!mi.eligible) { continue; }
 
-    // we need inverter stats younger than the last update command
-    if (_oInverterStatsMillis.has_value() && lastUpdateCmd > *_oInverterStatsMillis) {
-        _oInverterStatsMillis = std::nullopt;
-    }
+        // concerns both power limits and start/stop/restart commands and is
+        // only updated if a respective response was received from the inverter
+        auto lastUpdateCmd = std::max(
+            mi.inverter->SystemConfigPara()->getLastUpdateCommand(),
+            mi.inverter->PowerCommand()->getLastUpdateCommand());
 
-    if (!_oInverterStatsMillis.has_value()) {
-        auto lastStats = _inverter->Statistics()->getLastUpdate();
-        if (lastStats <= lastUpdateCmd) {
-            return announceStatus(Status::InverterStatsPending);
+        // we need inverter stats younger than the last update command
+        if (mi.oInverterStatsMillis.has_value() && lastUpdateCmd > *mi.oInverterStatsMillis) {
+            mi.oInverterStatsMillis = std::nullopt;
         }
 
-        _oInverterStatsMillis = lastStats;
+        if (!mi.oInverterStatsMillis.has_value()) {
+            auto lastStats = mi.inverter->Statistics()->getLastUpdate();
+            if (lastStats <= lastUpdateCmd) {
+                // the calculation is based on the primary inverter, whoever
+                // sent the last command to it
+                if (mi.inverter == _inverter) {
+                    return announceStatus(Status::InverterStatsPending);
+                }
+
+                // secondary inverters are only waited for after a command of
+                // ours, e.g., not after a restart, and not forever
+                if (!mi.oCommandSentMillis.has_value()) { continue; }
+
+                if (millis() - *mi.oCommandSentMillis < _secondaryStatsTimeoutMs) {
+                    return announceStatus(Status::InverterStatsPending);
+                }
+
+                MessageOutput.printf("%s%s: no statistics from inverter %s after its last command, not waiting any longer\r\n",
+                    TAG, __FUNCTION__, mi.inverter->name());
+                mi.oCommandSentMillis = std::nullopt;
+                mi.oTrace = std::nullopt;
+                mi.inverter->setPollPriority(false);
+                continue;
+            }
+
+            mi.oInverterStatsMillis = lastStats;
+            mi.oCommandSentMillis = std::nullopt;
+            mi.inverter->setPollPriority(false);
+
+            // these are the first statistics produced with the new limit
+            if (mi.oTrace.has_value() && mi.oTrace->acknowledgedMillis != 0) {
+                mi.oTrace->statisticsMillis = lastStats;
+                PowerLimiterLatency.addCycle(*mi.oTrace);
+
+                if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s%s: control cycle of inverter %s completed after %u ms\r\n",
+                    TAG, __FUNCTION__, mi.inverter->name(), mi.oTrace->statisticsMillis - mi.oTrace->meterMillis);
+
+                mi.oTrace = std::nullopt;
+            }
+        }
+
+        latestStatsMillis = std::max(latestStatsMillis, *mi.oInverterStatsMillis);
     }
 
     // if the power meter is being used, i.e., if its data is valid, we want to
@@ -285,7 +377,7 @@ void PowerLimiterClass::loop()
     // arrives. this can be the case for readings provided by networked meter
     // readers, where a packet needs to travel through the network for some
     // time after the actual measurement was done by the reader.
-    if (PowerMeter.isDataValid() && (PowerMeter.getLastUpdate() - *_oInverterStatsMillis) <= 2000) {
+    if (PowerMeter.isDataValid() && (PowerMeter.getLastUpdate() - latestStatsMillis) <= 2000) {
         return announceStatus(Status::PowerMeterPending);
     }
 
@@ -295,12 +387,14 @@ void PowerLimiterClass::loop()
         return announceStatus(Status::Stable);
     }
 
-    if (_verboseLogging) MessageOutput.printf("%s ******************* ENTER **********************\r\n", TAG);
+    if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s ******************* ENTER **********************\r\n", TAG);
 
     // Check if next inverter restart time is reached
     if ((_nextInverterRestart > 1) && (_nextInverterRestart <= millis())) {
         MessageOutput.printf("%s%s: send inverter restart\r\n", TAG, __FUNCTION__);
-        _inverter->sendRestartControlRequest();
+        for (auto& mi : _inverters) {
+            if (!mi.solarPowered) { mi.inverter->sendRestartControlRequest(); }
+        }
         calcNextInverterRestart();
     }
 
@@ -329,12 +423,12 @@ void PowerLimiterClass::loop()
         }
 
         if (isStopThresholdReached()) {
-            if (_verboseLogging) MessageOutput.printf("%s%s: Stop threshold reached (discharging not allowed)\r\n", TAG, __FUNCTION__);
+            if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s%s: Stop threshold reached (discharging not allowed)\r\n", TAG, __FUNCTION__);
             return false;
         }
 
         if (isStartThresholdReached()) {
-            if (_verboseLogging) MessageOutput.printf("%s%s: Start threshold reached (discharging allowed)\r\n", TAG, __FUNCTION__);
+            if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s%s: Start threshold reached (discharging allowed)\r\n", TAG, __FUNCTION__);
             return true;
         }
 
@@ -343,7 +437,7 @@ void PowerLimiterClass::loop()
             !_batteryDischargeEnabled)
         {
             _nighttimeDischarging = true;
-            if (_verboseLogging) MessageOutput.printf("%s%s: Solar passthroug is enabled and use battery always at night\r\n", TAG, __FUNCTION__);
+            if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s%s: Solar passthroug is enabled and use battery always at night\r\n", TAG, __FUNCTION__);
             return true;
         }
 
@@ -377,7 +471,7 @@ void PowerLimiterClass::loop()
     }
 
     // Calculate and set Power Limit (NOTE: might reset _inverter to nullptr!)
-    bool limitUpdated = calcPowerLimit(_inverter, getSolarPower(), getBatteryDischargeLimit(), _batteryDischargeEnabled);
+    bool limitUpdated = calcPowerLimit(getSolarPower(), getBatteryDischargeLimit(), _batteryDischargeEnabled);
 
     _lastCalculation = millis();
 
@@ -463,16 +557,22 @@ int32_t PowerLimiterClass::inverterPowerDcToAc(std::shared_ptr<InverterAbstract>
  * i.e., all solar power (and only solar power) is fed to the AC side,
  * independent from the power meter reading.
  */
-void PowerLimiterClass::unconditionalSolarPassthrough(std::shared_ptr<InverterAbstract> inverter)
+void PowerLimiterClass::unconditionalSolarPassthrough()
 {
     if ((millis() - _lastCalculation) < _calculationBackoffMs) { return; }
     _lastCalculation = millis();
 
     auto const& config = Configuration.get();
 
+    for (auto& mi : _inverters) {
+        if (mi.eligible && mi.solarPowered) {
+            setNewPowerLimit(mi, config.PowerLimiter.UpperPowerLimit);
+        }
+    }
+
     if (config.PowerLimiter.IsInverterSolarPowered) {
         _calculationBackoffMs = 10 * 1000;
-        setNewPowerLimit(inverter, config.PowerLimiter.UpperPowerLimit);
+        updateInverters();
         announceStatus(Status::UnconditionalSolarPassthrough);
         return;
     }
@@ -484,46 +584,69 @@ void PowerLimiterClass::unconditionalSolarPassthrough(std::shared_ptr<InverterAb
 
     _calculationBackoffMs = 1 * 1000;
     int32_t solarPower = VictronMppt.getPowerOutputWatts();
-    setNewPowerLimit(inverter, inverterPowerDcToAc(inverter, solarPower));
+    distributeBatteryPowered(inverterPowerDcToAc(_inverter, solarPower));
+    updateInverters();
     announceStatus(Status::UnconditionalSolarPassthrough);
 }
 
 uint8_t PowerLimiterClass::getPowerLimiterState()
 {
-    if (_inverter == nullptr || !_inverter->isReachable()) {
+    auto inverter = _inverter;
+    if (inverter == nullptr || !inverter->isReachable()) {
         return PL_UI_STATE_INACTIVE;
     }
 
-    if (_inverter->isProducing() && _batteryDischargeEnabled) {
+    if (_inverterProducing && _batteryDischargeEnabled) {
         return PL_UI_STATE_USE_SOLAR_AND_BATTERY;
     }
 
-    if (_inverter->isProducing() && !_batteryDischargeEnabled) {
+    if (_inverterProducing && !_batteryDischargeEnabled) {
         return PL_UI_STATE_USE_SOLAR_ONLY;
     }
 
-    if (!_inverter->isProducing()) {
+    if (!_inverterProducing) {
         return PL_UI_STATE_CHARGING;
     }
 
     return PL_UI_STATE_INACTIVE;
 }
 
-// Logic table ("PowerMeter value" can be "base load setting" as a fallback)
+bool PowerLimiterClass::isBatteryPoweredInverter(uint64_t serial) const
+{
+    auto const& cPL = Configuration.get().PowerLimiter;
+
+    if (serial == cPL.InverterId) { return !cPL.IsInverterSolarPowered; }
+
+    // see syncManagedInverters()
+    if (cPL.IsInverterSolarPowered) { return false; }
+
+    for (uint8_t i = 0; i < POWERLIMITER_MAX_ADDITIONAL_INVERTERS; i++) {
+        if (cPL.AdditionalInverters[i].Serial == serial) {
+            return !cPL.AdditionalInverters[i].IsSolarPowered;
+        }
+    }
+
+    return false;
+}
+
+// Logic table ("PowerMeter value" can be "base load setting" as a fallback).
+// the table applies to the battery-powered inverters, with solar-powered
+// inverters (if any) having covered part of the "PowerMeter value" already.
 // | Case # | batteryPower | solarPower     | batteryLimit   | useFullSolarPassthrough | Resulting inverter limit                               |
 // | 1      | false        |  < 20 W        | doesn't matter | doesn't matter          | 0 (inverter off)                                       |
 // | 2      | false        | >= 20 W        | doesn't matter | doesn't matter          | min(PowerMeter value, solarPower)                      |
 // | 3      | true         | fully passed   | applied        | false                   | min(PowerMeter value  batteryLimit+solarPower)         |
 // | 4      | true         | fully passed   | doesn't matter | true                    | max(PowerMeter value, solarPower)                      |
 
-bool PowerLimiterClass::calcPowerLimit(std::shared_ptr<InverterAbstract> inverter, int32_t solarPowerDC, int32_t batteryPowerLimitDC, bool batteryPower)
+bool PowerLimiterClass::calcPowerLimit(int32_t solarPowerDC, int32_t batteryPowerLimitDC, bool batteryPower)
 {
     if (_verboseLogging)
-        MessageOutput.printf("%s%s: battery use %s, solar power (DC): %d W, battery limit (DC): %d W\r\n",
+        MessageOutput.printf(LogLevel::Verbose, "%s%s: battery use %s, solar power (DC): %d W, battery limit (DC): %d W\r\n",
                 TAG, __FUNCTION__,
                 (batteryPower?"allowed":"prevented"), solarPowerDC, batteryPowerLimitDC);
     // Case 1:
-    if (solarPowerDC <= 0 && !batteryPower) {
+    bool noEnergy = solarPowerDC <= 0 && !batteryPower;
+    if (noEnergy && !hasSolarPoweredInverters()) {
         return shutdown(Status::NoEnergy);
     }
 
@@ -553,10 +676,14 @@ bool PowerLimiterClass::calcPowerLimit(std::shared_ptr<InverterAbstract> inverte
 
     // We don't use FLD_PAC from the statistics, because that data might be too
     // old and unreliable. TODO(schlimmchen): is this comment outdated?
-    auto inverterOutput = static_cast<int32_t>(inverter->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_PAC));
+    int32_t inverterOutput = 0;
+    for (auto const& mi : _inverters) {
+        if (!mi.eligible) { continue; }
+        inverterOutput += static_cast<int32_t>(mi.inverter->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_PAC));
+    }
 
-    auto batteryPowerLimitAC = inverterPowerDcToAc(inverter, batteryPowerLimitDC);
-    auto solarPowerAC = inverterPowerDcToAc(inverter, solarPowerDC);
+    auto batteryPowerLimitAC = inverterPowerDcToAc(_inverter, batteryPowerLimitDC);
+    auto solarPowerAC = inverterPowerDcToAc(_inverter, solarPowerDC);
 
     auto const& config = Configuration.get();
     auto targetConsumption = config.PowerLimiter.TargetPowerConsumption;
@@ -587,15 +714,29 @@ bool PowerLimiterClass::calcPowerLimit(std::shared_ptr<InverterAbstract> inverte
         newPowerLimit = meterValue;
 
         if (meterIncludesInv) {
-            // If the inverter is wired behind the power meter, i.e., if its
-            // output is part of the power meter measurement, the produced
-            // power of this inverter has to be taken into account.
+            // If the inverters are wired behind the power meter, i.e., if
+            // their output is part of the power meter measurement, the
+            // produced power of all managed inverters has to be taken into
+            // account.
             newPowerLimit += inverterOutput;
         }
 
         newPowerLimit -= targetConsumption;
     }
 
+    // solar-powered inverters produce for free, so they cover as much of the
+    // demand as the sun allows. the battery-powered ones take the remainder.
+    auto solarCovered = distributeSolarPowered(std::min(newPowerLimit, config.PowerLimiter.UpperPowerLimit));
+    if (config.PowerLimiter.IsInverterSolarPowered) { return updateInverters(); }
+
+    if (noEnergy) { return shutdownBatteryPowered(Status::NoEnergy); }
+
+    newPowerLimit -= solarCovered;
+    auto upperLimit = config.PowerLimiter.UpperPowerLimit - solarCovered;
+
+    if (_verboseLogging && solarCovered > 0)
+        MessageOutput.printf("%s%s: solar-powered inverters cover %d W, remaining: %d W\r\n", TAG, __FUNCTION__, solarCovered, newPowerLimit);
+
     // Case 2:
     if (!batteryPower) {
         newPowerLimit = std::min(newPowerLimit, solarPowerAC);
@@ -603,9 +744,10 @@ bool PowerLimiterClass::calcPowerLimit(std::shared_ptr<InverterAbstract> inverte
         // do not drain the battery. use as much power as needed to match the
         // household consumption, but not more than the available solar power.
         if (_verboseLogging)
-            MessageOutput.printf("%s%s: limited to solar power: %d W\r\n", TAG, __FUNCTION__, newPowerLimit);
+            MessageOutput.printf(LogLevel::Verbose, "%s%s: limited to solar power: %d W\r\n", TAG, __FUNCTION__, newPowerLimit);
 
-        return setNewPowerLimit(inverter, newPowerLimit);
+        distributeBatteryPowered(std::min(newPowerLimit, upperLimit));
+        return updateInverters();
     } else { // on batteryPower
         // Apply battery-provided discharge power limit.
         if (newPowerLimit > batteryPowerLimitAC + solarPowerAC) {
@@ -622,12 +764,13 @@ bool PowerLimiterClass::calcPowerLimit(std::shared_ptr<InverterAbstract> inverte
     if (useFullSolarPassthrough()) {
         newPowerLimit = std::max(newPowerLimit, solarPowerAC);
 
-        if (_verboseLogging) MessageOutput.printf("%s%s: full solar-passthrough active: %d W\r\n", TAG, __FUNCTION__, newPowerLimit);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s%s: full solar-passthrough active: %d W\r\n", TAG, __FUNCTION__, newPowerLimit);
 
-        return setNewPowerLimit(inverter, newPowerLimit);
+        distributeBatteryPowered(std::min(newPowerLimit, upperLimit));
+        return updateInverters();
     }
 
-    if (_verboseLogging) MessageOutput.printf("%s%s: match household consumption with limit of %d W\r\n", TAG, __FUNCTION__, newPowerLimit);
+    if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s%s: match household consumption with limit of %d W\r\n", TAG, __FUNCTION__, newPowerLimit);
 
 #ifdef USE_SURPLUSPOWER
     // use surplus power if active
@@ -636,7 +779,271 @@ bool PowerLimiterClass::calcPowerLimit(std::shared_ptr<InverterAbstract> inverte
 #endif
 
     // Case 3:
-    return setNewPowerLimit(inverter, newPowerLimit);
+    distributeBatteryPowered(std::min(newPowerLimit, upperLimit));
+    return updateInverters();
+}
+
+bool PowerLimiterClass::hasSolarPoweredInverters() const
+{
+    return std::any_of(_inverters.begin(), _inverters.end(),
+        [](ManagedInverter_t const& mi) { return mi.eligible && mi.solarPowered; });
+}
+
+/**
+ * switches off all battery-powered inverters. this is a regular shutdown of
+ * the DPL, unless solar-powered inverters are managed as well, which shall
+ * keep following the power meter.
+ */
+bool PowerLimiterClass::shutdownBatteryPowered(Status status)
+{
+    if (!hasSolarPoweredInverters()) { return shutdown(status); }
+
+    announceStatus(status);
+
+    for (auto& mi : _inverters) {
+        if (mi.solarPowered) { continue; }
+        mi.oTargetPowerState = false;
+    }
+
+    return updateInverters();
+}
+
+/**
+ * estimates the AC power an inverter is able to deliver. this is its max
+ * power, unless a solar-powered inverter produces less than its current limit
+ * allows, in which case it is bound by the available sunlight.
+ */
+int32_t PowerLimiterClass::getAvailablePower(ManagedInverter_t const& mi)
+{
+    auto maxPower = static_cast<int32_t>(mi.inverter->DevInfo()->getMaxPower());
+    if (!mi.solarPowered) { return maxPower; }
+
+    if (!mi.inverter->isProducing()) { return 0; }
+
+    auto currentLimit = static_cast<int32_t>(mi.inverter->SystemConfigPara()->getLimitPercent() * maxPower / 100);
+    auto output = static_cast<int32_t>(mi.inverter->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_PAC));
+    if (output < currentLimit * 9 / 10) { return output; }
+
+    return maxPower;
+}
+
+/**
+ * hands the demand to the solar-powered inverters. returns the AC power they
+ * are expected to produce, which is less than the demand if the sun is the
+ * limiting factor.
+ */
+int32_t PowerLimiterClass::distributeSolarPowered(int32_t demand)
+{
+    std::vector<ManagedInverter_t*> group;
+    for (auto& mi : _inverters) {
+        if (mi.eligible && mi.solarPowered) { group.push_back(&mi); }
+    }
+
+    return splitPowerLimit(group, std::max<int32_t>(demand, 0));
+}
+
+/**
+ * selects the battery-powered inverters to use for the given demand and splits
+ * the demand among them. inverters are rather inefficient while running at a
+ * small fraction of their max power, so we use as few inverters as possible,
+ * preferring the ones which respond quickly to new limits.
+ */
+void PowerLimiterClass::distributeBatteryPowered(int32_t demand)
+{
+    auto const& config = Configuration.get();
+    auto lowerLimit = config.PowerLimiter.LowerPowerLimit;
+
+    std::vector<ManagedInverter_t*> group;
+    for (auto& mi : _inverters) {
+        if (mi.eligible && !mi.solarPowered) { group.push_back(&mi); }
+    }
+
+    if (group.empty()) { return; }
+
+    if (demand < lowerLimit) {
+        shutdownBatteryPowered(Status::CalculatedLimitBelowMinLimit);
+        return;
+    }
+
+    // the primary inverter stays in front if latencies are equal (unknown)
+    std::stable_sort(group.begin(), group.end(),
+        [](ManagedInverter_t const* a, ManagedInverter_t const* b) {
+            return a->latencyMillis < b->latencyMillis;
+        });
+
+    std::vector<ManagedInverter_t*> active;
+    int32_t capacity = 0;
+    for (auto* mi : group) {
+        auto maxPower = static_cast<int32_t>(mi->inverter->DevInfo()->getMaxPower());
+
+        // another inverter is needed if the ones selected so far cannot cover
+        // the demand. an inverter which is producing already keeps running
+        // until the others would be loaded by less than 80 %, such that
+        // inverters are not switched on and off over and over again.
+        bool needed = capacity < demand;
+        bool keep = mi->inverter->isProducing() && demand * 10 > capacity * 8;
+        bool aboveMin = demand * maxPower / (capacity + maxPower) >= lowerLimit;
+
+        if (!active.empty() && !((needed || keep) && aboveMin)) {
+            if (_verboseLogging && mi->inverter->isProducing())
+                MessageOutput.printf("%s%s: inverter %s not needed for %d W\r\n", TAG, __FUNCTION__, mi->inverter->name(), demand);
+            mi->oTargetPowerState = false;
+            mi->lastRequestedPowerLimit = 0;
+            continue;
+        }
+
+        active.push_back(mi);
+        capacity += maxPower;
+    }
+
+    splitPowerLimit(active, demand);
+}
+
+/**
+ * splits the target power among the given group of inverters proportional to
+ * their max power, such that all of them run at the same relative load.
+ * solar-powered inverters which cannot reach their share due to too little
+ * sunlight contribute what they produce, and the others make up for it.
+ *
+ * the inverter with the lowest latency regulates the remainder, while the
+ * limits of slower inverters are only updated on larger deviations from their
+ * share. otherwise all inverters would have to settle before the next power
+ * meter reading is evaluated, and the slowest one would dictate the pace.
+ *
+ * returns the AC power the group is expected to deliver.
+ */
+int32_t PowerLimiterClass::splitPowerLimit(std::vector<ManagedInverter_t*>& group, int32_t target)
+{
+    if (group.empty()) { return 0; }
+
+    auto const& config = Configuration.get();
+    auto lowerLimit = config.PowerLimiter.LowerPowerLimit;
+    auto hysteresis = config.PowerLimiter.TargetPowerConsumptionHysteresis;
+
+    size_t count = group.size();
+    std::vector<int32_t> maxPower(count), available(count), current(count), shares(count, 0);
+    std::vector<bool> sunLimited(count, false);
+
+    for (size_t i = 0; i < count; i++) {
+        maxPower[i] = group[i]->inverter->DevInfo()->getMaxPower();
+        available[i] = getAvailablePower(*group[i]);
+        current[i] = static_cast<int32_t>(group[i]->inverter->SystemConfigPara()->getLimitPercent() * maxPower[i] / 100);
+    }
+
+    // inverters which cannot deliver their share keep it as limit, while the
+    // demand they cannot cover is spread among the remaining inverters.
+    int32_t remaining = target;
+    for (bool settled = false; !settled; ) {
+        settled = true;
+
+        int32_t weights = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (!sunLimited[i]) { weights += maxPower[i]; }
+        }
+
+        if (weights == 0) { break; }
+
+        for (size_t i = 0; i < count; i++) {
+            if (sunLimited[i]) { continue; }
+            shares[i] = remaining * maxPower[i] / weights;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            if (sunLimited[i] || shares[i] <= available[i]) { continue; }
+            sunLimited[i] = true;
+            remaining -= available[i];
+            settled = false;
+        }
+    }
+
+    size_t regulator = 0;
+    for (size_t i = 1; i < count; i++) {
+        if (sunLimited[regulator] && !sunLimited[i]) { regulator = i; continue; }
+        if (sunLimited[i]) { continue; }
+        if (group[i]->latencyMillis < group[regulator]->latencyMillis) { regulator = i; }
+    }
+
+    std::vector<int32_t> limits(shares);
+    std::vector<bool> held(count, false);
+    int32_t residual = target;
+    for (size_t i = 0; i < count; i++) {
+        if (i == regulator) { continue; }
+
+        auto const& mi = *group[i];
+        uint32_t latencyRatio = mi.latencyMillis / std::max<uint32_t>(1, group[regulator]->latencyMillis);
+        int32_t tolerance = std::max<int32_t>(hysteresis, maxPower[i] / 50) * std::clamp<uint32_t>(latencyRatio, 1, 4);
+
+        if (mi.inverter->isProducing() && std::abs(shares[i] - current[i]) <= tolerance) {
+            limits[i] = current[i];
+            held[i] = true;
+        }
+
+        residual -= std::min(limits[i], available[i]);
+    }
+
+    // the regulator cannot make up for the inverters we would like to leave
+    // alone, so all of them are updated to their share this time.
+    int32_t regulatorMin = group[regulator]->solarPowered ? 0 : lowerLimit;
+    if (residual < regulatorMin || residual > available[regulator]) {
+        limits = shares;
+        std::fill(held.begin(), held.end(), false);
+    } else {
+        limits[regulator] = residual;
+    }
+
+    int32_t covered = 0;
+    for (size_t i = 0; i < count; i++) {
+        auto& mi = *group[i];
+
+        if (_verboseLogging && count > 1)
+            MessageOutput.printf("%s%s: inverter %s: share %d W, limit %d W%s, available %d W, latency %u ms%s\r\n",
+                TAG, __FUNCTION__, mi.inverter->name(), shares[i], limits[i],
+                (held[i] ? " (kept)" : ""), available[i], mi.latencyMillis,
+                (i == regulator ? ", regulating" : ""));
+
+        if (held[i]) {
+            mi.oTargetPowerState = true;
+        } else {
+            setNewPowerLimit(mi, limits[i]);
+        }
+
+        covered += std::min(limits[i], available[i]);
+    }
+
+    return covered;
+}
+
+/**
+ * drives the state transitions of all managed inverters. returns true if a
+ * change to the state of any of them was requested or is pending.
+ */
+bool PowerLimiterClass::updateInverters()
+{
+    bool pending = false;
+    int32_t requested = 0;
+    uint8_t timeouts = 0;
+    bool producing = false;
+
+    for (auto& mi : _inverters) {
+        if (updateInverter(mi)) { pending = true; }
+
+        // fresh statistics shorten the control loop, but only an inverter
+        // with a command in flight needs them. polling all managed inverters
+        // with priority would starve the others on the same radio.
+        mi.inverter->setPollPriority(mi.oTargetPowerState.has_value()
+            || mi.oTargetPowerLimitWatts.has_value()
+            || mi.oCommandSentMillis.has_value());
+
+        requested += mi.lastRequestedPowerLimit;
+        timeouts = std::max(timeouts, mi.updateTimeouts);
+        producing = producing || mi.inverter->isProducing();
+    }
+
+    _lastRequestedPowerLimit = requested;
+    _inverterUpdateTimeouts = timeouts;
+    _inverterProducing = producing;
+
+    return pending;
 }
 
 /**
@@ -644,30 +1051,28 @@ bool PowerLimiterClass::calcPowerLimit(std::shared_ptr<InverterAbstract> inverte
  * change to its state was requested or is pending. this function only requests
  * one change (limit value or production on/off) at a time.
  */
-bool PowerLimiterClass::updateInverter()
+bool PowerLimiterClass::updateInverter(ManagedInverter_t& mi)
 {
-    auto reset = [this]() -> bool {
-        _oTargetPowerState = std::nullopt;
-        _oTargetPowerLimitWatts = std::nullopt;
-        _oUpdateStartMillis = std::nullopt;
+    auto reset = [&mi]() -> bool {
+        mi.oTargetPowerState = std::nullopt;
+        mi.oTargetPowerLimitWatts = std::nullopt;
+        mi.oUpdateStartMillis = std::nullopt;
         return false;
     };
 
-    if (nullptr == _inverter) { return reset(); }
-
-    // do not reset _inverterUpdateTimeouts below if no state change requested
-    if (!_oTargetPowerState.has_value() && !_oTargetPowerLimitWatts.has_value()) {
+    // do not reset mi.updateTimeouts below if no state change requested
+    if (!mi.oTargetPowerState.has_value() && !mi.oTargetPowerLimitWatts.has_value()) {
         return reset();
     }
 
-    if (!_oUpdateStartMillis.has_value()) { _oUpdateStartMillis = millis(); }
+    if (!mi.oUpdateStartMillis.has_value()) { mi.oUpdateStartMillis = millis(); }
 
-    if ((millis() - *_oUpdateStartMillis) > 30 * 1000) {
-        ++_inverterUpdateTimeouts;
-        if (_verboseLogging) MessageOutput.printf("%s%s: timeout (%d in succession), state transition pending: %s, limit pending: %s\r\n", TAG, __FUNCTION__,
-            _inverterUpdateTimeouts,
-            (_oTargetPowerState.has_value()?"yes":"no"),
-            (_oTargetPowerLimitWatts.has_value()?"yes":"no"));
+    if ((millis() - *mi.oUpdateStartMillis) > 30 * 1000) {
+        ++mi.updateTimeouts;
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s%s: timeout (%d in succession), state transition pending: %s, limit pending: %s\r\n", TAG, __FUNCTION__,
+            mi.updateTimeouts,
+            (mi.oTargetPowerState.has_value()?"yes":"no"),
+            (mi.oTargetPowerLimitWatts.has_value()?"yes":"no"));
 
         // NOTE that this is not always 5 minutes, since this counts timeouts,
         // not absolute time. after any timeout, an update cycle ends. a new
@@ -675,101 +1080,113 @@ bool PowerLimiterClass::updateInverter()
         // turn is only started if the DPL did calculate a new limit, which in
         // turn does not happen while the inverter is unreachable, no matter
         // how long (a whole night) that might be.
-        if (_inverterUpdateTimeouts >= 10) {
+        if (mi.updateTimeouts >= 10) {
             MessageOutput.printf("%s%s: issuing inverter restart command after update timed out repeatedly\r\n", TAG, __FUNCTION__);
-            _inverter->sendRestartControlRequest();
+            mi.inverter->sendRestartControlRequest();
         }
 
-        if (_inverterUpdateTimeouts >= 20) {
+        if (mi.updateTimeouts >= 20) {
             MessageOutput.printf("%s%s: restarting system since inverter is unresponsive\r\n", TAG, __FUNCTION__);
             RestartHelper.triggerRestart();
         }
 
+        mi.oTrace = std::nullopt;
+        mi.oCommandSentMillis = std::nullopt;
         return reset();
     }
 
     auto constexpr halfOfAllMillis = std::numeric_limits<uint32_t>::max() / 2;
 
-    auto switchPowerState = [this](bool transitionOn) -> bool {
+    auto switchPowerState = [this, &mi](bool transitionOn) -> bool {
         // no power state transition requested at all
-        if (!_oTargetPowerState.has_value()) { return false; }
+        if (!mi.oTargetPowerState.has_value()) { return false; }
 
         // the transition that may be started is not the one which is requested
-        if (transitionOn != *_oTargetPowerState) { return false; }
+        if (transitionOn != *mi.oTargetPowerState) { return false; }
 
         // wait for pending power command(s) to complete
-        auto lastPowerCommandState = _inverter->PowerCommand()->getLastPowerCommandSuccess();
+        auto lastPowerCommandState = mi.inverter->PowerCommand()->getLastPowerCommandSuccess();
         if (CMD_PENDING == lastPowerCommandState) {
             announceStatus(Status::InverterPowerCmdPending);
             return true;
         }
 
         // we need to wait for statistics that are more recent than the last
-        // power update command to reliably use _inverter->isProducing()
-        auto lastPowerCommandMillis = _inverter->PowerCommand()->getLastUpdateCommand();
-        auto lastStatisticsMillis = _inverter->Statistics()->getLastUpdate();
+        // power update command to reliably use mi.inverter->isProducing()
+        auto lastPowerCommandMillis = mi.inverter->PowerCommand()->getLastUpdateCommand();
+        auto lastStatisticsMillis = mi.inverter->Statistics()->getLastUpdate();
         if ((lastStatisticsMillis - lastPowerCommandMillis) > halfOfAllMillis) { return true; }
 
-        if (_inverter->isProducing() != *_oTargetPowerState) {
-            MessageOutput.printf("%s%s: %s inverter...\r\n", TAG, __FUNCTION__, ((*_oTargetPowerState)?"Starting":"Stopping"));
-            _inverter->sendPowerControlRequest(*_oTargetPowerState);
+        if (mi.inverter->isProducing() != *mi.oTargetPowerState) {
+            MessageOutput.printf("%s%s: %s inverter...\r\n", TAG, __FUNCTION__, ((*mi.oTargetPowerState)?"Starting":"Stopping"));
+            mi.inverter->sendPowerControlRequest(*mi.oTargetPowerState);
+            if (!mi.oCommandSentMillis.has_value()) { mi.oCommandSentMillis = millis(); }
             return true;
         }
 
-        _oTargetPowerState = std::nullopt; // target power state reached
+        mi.oTargetPowerState = std::nullopt; // target power state reached
         return false;
     };
 
     // we use a lambda function here to be able to use return statements,
     // which allows to avoid if-else-indentions and improves code readability
-    auto updateLimit = [this]() -> bool {
+    auto updateLimit = [this, &mi]() -> bool {
         // no limit update requested at all
-        if (!_oTargetPowerLimitWatts.has_value()) { return false; }
+        if (!mi.oTargetPowerLimitWatts.has_value()) { return false; }
 
         // wait for pending limit command(s) to complete
-        auto lastLimitCommandState = _inverter->SystemConfigPara()->getLastLimitCommandSuccess();
+        auto lastLimitCommandState = mi.inverter->SystemConfigPara()->getLastLimitCommandSuccess();
         if (CMD_PENDING == lastLimitCommandState) {
             announceStatus(Status::InverterLimitPending);
             return true;
         }
 
-        auto maxPower = _inverter->DevInfo()->getMaxPower();
-        auto newRelativeLimit = static_cast<float>(*_oTargetPowerLimitWatts * 100) / maxPower;
+        auto maxPower = mi.inverter->DevInfo()->getMaxPower();
+        auto newRelativeLimit = static_cast<float>(*mi.oTargetPowerLimitWatts * 100) / maxPower;
 
         // if no limit command is pending, the SystemConfigPara does report the
         // current limit, as the answer by the inverter to a limit command is
         // the canonical source that updates the known current limit.
-        auto currentRelativeLimit = _inverter->SystemConfigPara()->getLimitPercent();
+        auto currentRelativeLimit = mi.inverter->SystemConfigPara()->getLimitPercent();
 
         // we assume having exclusive control over the inverter. if the last
         // limit command was successful and sent after we started the last
         // update cycle, we should assume *our* requested limit was set.
-        uint32_t lastLimitCommandMillis = _inverter->SystemConfigPara()->getLastUpdateCommand();
-        if ((lastLimitCommandMillis - *_oUpdateStartMillis) < halfOfAllMillis && CMD_OK == lastLimitCommandState) {
-            if (_verboseLogging) MessageOutput.printf("%s%s: actual limit is %.1f %% (%.0f W respectively), effective %d ms after update started, requested were %.1f %%\r\n",
+        uint32_t lastLimitCommandMillis = mi.inverter->SystemConfigPara()->getLastUpdateCommand();
+        if ((lastLimitCommandMillis - *mi.oUpdateStartMillis) < halfOfAllMillis && CMD_OK == lastLimitCommandState) {
+            if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s%s: actual limit is %.1f %% (%.0f W respectively), effective %d ms after update started, requested were %.1f %%\r\n",
                 TAG, __FUNCTION__,
                 currentRelativeLimit,
                 (currentRelativeLimit * maxPower / 100),
-                (lastLimitCommandMillis - *_oUpdateStartMillis),
+                (lastLimitCommandMillis - *mi.oUpdateStartMillis),
                 newRelativeLimit);
 
+            // smoothed latency, used to pick the inverter which regulates
+            uint32_t latency = lastLimitCommandMillis - *mi.oUpdateStartMillis;
+            mi.latencyMillis = (mi.latencyMillis == 0) ? latency : (mi.latencyMillis * 3 + latency) / 4;
+
+            if (mi.oTrace.has_value()) { mi.oTrace->acknowledgedMillis = lastLimitCommandMillis; }
+
             if (std::abs(newRelativeLimit - currentRelativeLimit) > 2.0) {
-                if (_verboseLogging) MessageOutput.printf("%s%s: NOTE: expected limit of %.1f %% and actual limit of %.1f %% mismatch by more than 2 %%, "
+                if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s%s: NOTE: expected limit of %.1f %% and actual limit of %.1f %% mismatch by more than 2 %%, "
                                      "is the DPL in exclusive control over the inverter?\r\n",
                                         TAG, __FUNCTION__,
                                         newRelativeLimit, currentRelativeLimit);
             }
 
-            _oTargetPowerLimitWatts = std::nullopt;
+            mi.oTargetPowerLimitWatts = std::nullopt;
             return false;
         }
 
-        if (_verboseLogging) MessageOutput.printf("%s%s: sending limit of %.1f %% (%.0f W respectively), max output is %d W\r\n", TAG, __FUNCTION__,
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s%s: sending limit of %.1f %% (%.0f W respectively), max output is %d W\r\n", TAG, __FUNCTION__,
                 newRelativeLimit, (newRelativeLimit * maxPower / 100), maxPower);
 
-        _inverter->sendActivePowerControlRequest(static_cast<float>(newRelativeLimit), PowerLimitControlType::RelativNonPersistent);
+        mi.inverter->sendActivePowerControlRequest(static_cast<float>(newRelativeLimit), PowerLimitControlType::RelativNonPersistent);
 
-        _lastRequestedPowerLimit = *_oTargetPowerLimitWatts;
+        if (mi.oTrace.has_value() && mi.oTrace->sentMillis == 0) { mi.oTrace->sentMillis = millis(); }
+        if (!mi.oCommandSentMillis.has_value()) { mi.oCommandSentMillis = millis(); }
+
+        mi.lastRequestedPowerLimit = *mi.oTargetPowerLimitWatts;
         return true;
     };
 
@@ -782,7 +1199,7 @@ bool PowerLimiterClass::updateInverter()
     // enable power production only after setting the desired limit
     if (switchPowerState(true)) { return true; }
 
-    _inverterUpdateTimeouts = 0;
+    mi.updateTimeouts = 0;
 
     return reset();
 }
@@ -798,8 +1215,10 @@ bool PowerLimiterClass::updateInverter()
  * refactoring. currently it only works for inverters that provide one MPPT for
  * each input.
  */
-int32_t PowerLimiterClass::scalePowerLimit(std::shared_ptr<InverterAbstract> inverter, int32_t newLimit, int32_t currentLimitWatts)
+int32_t PowerLimiterClass::scalePowerLimit(ManagedInverter_t& mi, int32_t newLimit, int32_t currentLimitWatts)
 {
+    auto inverter = mi.inverter;
+
     // prevent scaling if inverter is not producing, as input channels are not
     // producing energy and hence are detected as not-producing, causing
     // unreasonable scaling.
@@ -825,7 +1244,7 @@ int32_t PowerLimiterClass::scalePowerLimit(std::shared_ptr<InverterAbstract> inv
 
     auto const& config = Configuration.get();
     auto allowOverscaling = config.PowerLimiter.UseOverscalingToCompensateShading;
-    auto isInverterSolarPowered = config.PowerLimiter.IsInverterSolarPowered;
+    auto isInverterSolarPowered = mi.solarPowered;
 
     // overscalling allows us to compensate for shaded panels by increasing the
     // total power limit, if the inverter is solar powered.
@@ -836,7 +1255,7 @@ int32_t PowerLimiterClass::scalePowerLimit(std::shared_ptr<InverterAbstract> inv
         // 98% of the expected power is good enough
         auto expectedAcPowerPerChannel = (currentLimitWatts / dcTotalChnls) * 0.98;
 
-        if (_verboseLogging) MessageOutput.printf("%s%s: expected AC power per channel %f W\r\n",
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s%s: expected AC power per channel %f W\r\n",
                     TAG, __FUNCTION__, expectedAcPowerPerChannel);
 
         size_t dcShadedChnls = 0;
@@ -850,7 +1269,7 @@ int32_t PowerLimiterClass::scalePowerLimit(std::shared_ptr<InverterAbstract> inv
                 shadedChannelACPowerSum += channelPowerAC;
             }
 
-            if (_verboseLogging) MessageOutput.printf("%s%s: ch %d AC power %f W\r\n",
+            if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s%s: ch %d AC power %f W\r\n",
                 TAG, __FUNCTION__, c, channelPowerAC);
         }
 
@@ -864,7 +1283,7 @@ int32_t PowerLimiterClass::scalePowerLimit(std::shared_ptr<InverterAbstract> inv
             // - currentLimit >= newLimit
             // - we get the expected AC power or less and
             if (currentLimitWatts >= newLimit && inverterOutputAC <= newLimit) {
-                if (_verboseLogging) MessageOutput.printf("%s%s: all channels are shaded, keeping the current limit of %d W\r\n",
+                if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s%s: all channels are shaded, keeping the current limit of %d W\r\n",
                     TAG, __FUNCTION__, currentLimitWatts);
 
                 return currentLimitWatts;
@@ -879,7 +1298,7 @@ int32_t PowerLimiterClass::scalePowerLimit(std::shared_ptr<InverterAbstract> inv
 
         if (overScaledLimit <= newLimit) { return newLimit; }
 
-        if (_verboseLogging) MessageOutput.printf("%s%s: %d/%d channels are shaded, scaling %d W\r\n",
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s%s: %d/%d channels are shaded, scaling %d W\r\n",
             TAG, __FUNCTION__, dcShadedChnls, dcTotalChnls, overScaledLimit);
 
         return overScaledLimit;
@@ -895,34 +1314,36 @@ int32_t PowerLimiterClass::scalePowerLimit(std::shared_ptr<InverterAbstract> inv
     if (dcProdChnls == 0 || dcProdChnls == dcTotalChnls) { return newLimit; }
 
     auto scaled = static_cast<int32_t>(newLimit * static_cast<float>(dcTotalChnls) / dcProdChnls);
-    if (_verboseLogging) MessageOutput.printf("%s%s: %d/%d channels are producing, scaling from %d to %d W\r\n",
+    if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s%s: %d/%d channels are producing, scaling from %d to %d W\r\n",
         TAG, __FUNCTION__, dcProdChnls, dcTotalChnls, newLimit, scaled);
     return scaled;
 }
 
 /**
  * enforces limits on the requested power limit, after scaling the power limit
- * to the ratio of total and producing inverter channels. commits the sanitized
- * power limit. returns true if an inverter update was committed, false
- * otherwise.
+ * to the ratio of total and producing inverter channels. stores the sanitized
+ * power limit as target of the inverter, which is committed by
+ * updateInverters().
  */
-bool PowerLimiterClass::setNewPowerLimit(std::shared_ptr<InverterAbstract> inverter, int32_t newPowerLimit)
+void PowerLimiterClass::setNewPowerLimit(ManagedInverter_t& mi, int32_t newPowerLimit)
 {
+    auto inverter = mi.inverter;
+
     auto const& config = Configuration.get();
     auto lowerLimit = config.PowerLimiter.LowerPowerLimit;
     auto upperLimit = config.PowerLimiter.UpperPowerLimit;
     auto hysteresis = config.PowerLimiter.TargetPowerConsumptionHysteresis;
 
-    if (_verboseLogging) MessageOutput.printf("%s%s: input limit: %d W, min limit: %d W, max limit: %d W, hysteresis: %d W\r\n",
+    if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s%s: input limit: %d W, min limit: %d W, max limit: %d W, hysteresis: %d W\r\n",
             TAG, __FUNCTION__,
             newPowerLimit, lowerLimit, upperLimit, hysteresis);
 
+    // battery-powered inverters are switched off by distributeBatteryPowered()
+    // rather than being asked for a limit below the minimum limit.
     if (newPowerLimit < lowerLimit) {
-        if (!config.PowerLimiter.IsInverterSolarPowered) {
-            return shutdown(Status::CalculatedLimitBelowMinLimit);
+        if (mi.solarPowered) {
+            MessageOutput.printf("%s%s: keep solar-powered inverter running at min limit\r\n", TAG, __FUNCTION__);
         }
-
-        MessageOutput.printf("%s%s: keep solar-powered inverter running at min limit\r\n", TAG, __FUNCTION__);
         newPowerLimit = lowerLimit;
     }
 
@@ -936,23 +1357,30 @@ bool PowerLimiterClass::setNewPowerLimit(std::shared_ptr<InverterAbstract> inver
     float currentLimitPercent = inverter->SystemConfigPara()->getLimitPercent();
     auto currentLimitAbs = static_cast<int32_t>(currentLimitPercent * maxPower / 100);
 
-    effPowerLimit = scalePowerLimit(inverter, effPowerLimit, currentLimitAbs);
+    effPowerLimit = scalePowerLimit(mi, effPowerLimit, currentLimitAbs);
 
     effPowerLimit = std::min<int32_t>(effPowerLimit, maxPower);
 
     auto diff = std::abs(currentLimitAbs - effPowerLimit);
 
-    if (_verboseLogging) MessageOutput.printf("%s%s: inverter max: %d W, inverter %s producing, requesting: %d W, reported: %d W, diff: %d W\r\n",
+    if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s%s: inverter max: %d W, inverter %s producing, requesting: %d W, reported: %d W, diff: %d W\r\n",
             TAG, __FUNCTION__,
             maxPower, (inverter->isProducing()?"is":"is NOT"),
             effPowerLimit, currentLimitAbs, diff);
 
     if (diff > hysteresis) {
-        _oTargetPowerLimitWatts = effPowerLimit;
+        mi.oTargetPowerLimitWatts = effPowerLimit;
+
+        PowerLimiterLatencyClass::Cycle_t cycle;
+        cycle.serial = inverter->serial();
+        cycle.limit = effPowerLimit;
+        cycle.calculatedMillis = millis();
+        // without a valid power meter reading, the base load was used
+        cycle.meterMillis = PowerMeter.isDataValid() ? PowerMeter.getLastUpdate() : cycle.calculatedMillis;
+        mi.oTrace = cycle;
     }
 
-    _oTargetPowerState = true;
-    return updateInverter();
+    mi.oTargetPowerState = true;
 }
 
 int32_t PowerLimiterClass::getSolarPower()
@@ -1007,8 +1435,13 @@ float PowerLimiterClass::getLoadCorrectedVoltage()
 
     auto const& config = Configuration.get();
 
-    float acPower = _inverter->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_PAC);
-    if (_verboseLogging) MessageOutput.printf("%s%s: acPower %.1f\r\n", TAG, __FUNCTION__, acPower);
+    // all battery-powered inverters draw their power from the battery
+    float acPower = 0;
+    for (auto const& mi : _inverters) {
+        if (mi.solarPowered && mi.inverter != _inverter) { continue; }
+        acPower += mi.inverter->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_PAC);
+    }
+    if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s%s: acPower %.1f\r\n", TAG, __FUNCTION__, acPower);
     float dcVoltage = getBatteryVoltage();
 
     if (dcVoltage <= 0.0) {
@@ -1109,10 +1542,10 @@ void PowerLimiterClass::calcNextInverterRestart()
         _nextInverterRestart *= 60000;
         _nextInverterRestart += millis();
     } else {
-        if (_verboseLogging) MessageOutput.printf("%s%s: getLocalTime not successful, no calculation\r\n", TAG, __FUNCTION__);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s%s: getLocalTime not successful, no calculation\r\n", TAG, __FUNCTION__);
         _nextInverterRestart = 0;
     }
-    if (_verboseLogging) MessageOutput.printf("%s%s: _nextInverterRestart @ %d millis\r\n", TAG, __FUNCTION__, _nextInverterRestart);
+    if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s%s: _nextInverterRestart @ %d millis\r\n", TAG, __FUNCTION__, _nextInverterRestart);
 }
 
 bool PowerLimiterClass::useFullSolarPassthrough()
@@ -1206,7 +1639,7 @@ bool PowerLimiterClass::manageBatteryDCpowerSwitch()
 /*
                 if (!isStopThresholdReached() && !isStartThresholdReached() && cPL.Enabled != _lastDCState) {
                     if (_verboseLogging)
-                        MessageOutput.printf("%s%s: initial condition (discharging allowed)\r\n", TAG, __FUNCTION__);
+                        MessageOutput.printf(LogLevel::Verbose, "%s%s: initial condition (discharging allowed)\r\n", TAG, __FUNCTION__);
                     _batteryDischargeEnabled = true;
                     //                    _lastDCState = true;
                 }
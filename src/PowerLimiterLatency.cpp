@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2024 Thomas Basler and others
+ */
+#include "PowerLimiterLatency.h"
+#include <algorithm>
+
+PowerLimiterLatencyClass PowerLimiterLatency;
+
+void PowerLimiterLatencyClass::addCycle(Cycle_t const& cycle)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _cycles[_next] = cycle;
+    _next = (_next + 1) % _capacity;
+    _count = std::min(_count + 1, _capacity);
+    ++_totalCycles;
+}
+
+void PowerLimiterLatencyClass::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _next = 0;
+    _count = 0;
+    _totalCycles = 0;
+}
+
+size_t PowerLimiterLatencyClass::getCycleCount() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _count;
+}
+
+char const* PowerLimiterLatencyClass::getStageName(Stage stage)
+{
+    switch (stage) {
+    case Stage::Calculation: return "calculation";
+    case Stage::Dispatch: return "dispatch";
+    case Stage::Radio: return "radio";
+    case Stage::Statistics: return "statistics";
+    case Stage::Total: return "total";
+    default: break;
+    }
+
+    return "unknown";
+}
+
+uint32_t PowerLimiterLatencyClass::getDuration(Cycle_t const& cycle, Stage stage)
+{
+    switch (stage) {
+    case Stage::Calculation: return cycle.calculatedMillis - cycle.meterMillis;
+    case Stage::Dispatch: return cycle.sentMillis - cycle.calculatedMillis;
+    case Stage::Radio: return cycle.acknowledgedMillis - cycle.sentMillis;
+    case Stage::Statistics: return cycle.statisticsMillis - cycle.acknowledgedMillis;
+    case Stage::Total: return cycle.statisticsMillis - cycle.meterMillis;
+    default: break;
+    }
+
+    return 0;
+}
+
+// the caller must hold _mutex
+size_t PowerLimiterLatencyClass::getSortedDurations(Stage stage, std::array<uint32_t, _capacity>& durations) const
+{
+    for (size_t i = 0; i < _count; ++i) {
+        durations[i] = getDuration(_cycles[i], stage);
+    }
+
+    std::sort(durations.begin(), durations.begin() + _count);
+
+    return _count;
+}
+
+// nearest-rank method, durations must be sorted
+uint32_t PowerLimiterLatencyClass::getPercentile(std::array<uint32_t, _capacity> const& durations, size_t count, size_t percent)
+{
+    size_t rank = (percent * count + 99) / 100;
+    return durations[std::max<size_t>(rank, 1) - 1];
+}
+
+std::optional<PowerLimiterLatencyClass::Percentiles_t> PowerLimiterLatencyClass::getPercentiles(Stage stage) const
+{
+    std::array<uint32_t, _capacity> durations;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    size_t count = getSortedDurations(stage, durations);
+    if (count == 0) { return std::nullopt; }
+
+    return Percentiles_t {
+        getPercentile(durations, count, 50),
+        getPercentile(durations, count, 90),
+        getPercentile(durations, count, 99),
+        durations[count - 1]
+    };
+}
+
+void PowerLimiterLatencyClass::toJson(JsonObject& root) const
+{
+    // upper bounds (ms) of the histogram buckets. the counts are not
+    // cumulative, the last bucket counts all durations above the last bound.
+    static constexpr std::array<uint32_t, 8> bounds = { 250, 500, 1000, 2000, 4000, 8000, 16000, 32000 };
+
+    std::array<uint32_t, _capacity> durations;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    root["cycles"] = _count;
+    root["total_cycles"] = _totalCycles;
+
+    auto stages = root["stages"].to<JsonObject>();
+
+    for (uint8_t s = 0; s < static_cast<uint8_t>(Stage::Count); ++s) {
+        auto stage = static_cast<Stage>(s);
+        size_t count = getSortedDurations(stage, durations);
+        if (count == 0) { continue; }
+
+        auto obj = stages[getStageName(stage)].to<JsonObject>();
+        obj["p50"] = getPercentile(durations, count, 50);
+        obj["p90"] = getPercentile(durations, count, 90);
+        obj["p99"] = getPercentile(durations, count, 99);
+        obj["max"] = durations[count - 1];
+
+        auto histogram = obj["histogram"].to<JsonArray>();
+        size_t i = 0;
+        for (auto bound : bounds) {
+            uint32_t bucket = 0;
+            for (; i < count && durations[i] <= bound; ++i) { ++bucket; }
+
+            auto entry = histogram.add<JsonObject>();
+            entry["le"] = bound;
+            entry["count"] = bucket;
+        }
+
+        auto entry = histogram.add<JsonObject>();
+        entry["le"] = "+Inf";
+        entry["count"] = count - i;
+    }
+}
@@ -1,9 +1,7 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
-#include "Utils.h"
 #include "PowerMeterHttpJson.h"
 #include "MessageOutput.h"
 #include <WiFiClientSecure.h>
-#include <ArduinoJson.h>
 #include "mbedtls/sha256.h"
 #include <base64.h>
 #include <ESPmDNS.h>
@@ -11,6 +9,7 @@
 #include "NetworkSettings.h"
 
 static constexpr char TAG[] = "[PowerMeterHttpJson]";
+static constexpr uint32_t TaskStackSize = 3072;
 
 PowerMeterHttpJson::~PowerMeterHttpJson()
 {
@@ -26,10 +25,22 @@ PowerMeterHttpJson::~PowerMeterHttpJson()
         while (!_taskDone) { delay(10); }
         _taskHandle = nullptr;
     }
+
+    // only now, the polling task may have waited for the workers
+    _stopWorkers = true;
+
+    for (auto& worker : _workers) {
+        if (worker.handle == nullptr) { continue; }
+        xTaskNotifyGive(worker.handle);
+        while (!worker.done) { delay(10); }
+        worker.handle = nullptr;
+    }
 }
 
 bool PowerMeterHttpJson::init()
 {
+    _groupCount = 0; // nothing is polled unless initialization succeeds
+
     for (uint8_t i = 0; i < POWERMETER_HTTP_JSON_MAX_VALUES; i++) {
         auto const& valueConfig = _cfg.Values[i];
 
@@ -37,6 +48,7 @@ bool PowerMeterHttpJson::init()
 
         if (i == 0 || (_cfg.IndividualRequests && valueConfig.Enabled)) {
             _httpGetters[i] = std::make_unique<HttpGetter>(valueConfig.HttpRequest);
+            _httpGetters[i]->enableKeepAlive();
         }
 
         if (!_httpGetters[i]) { continue; }
@@ -52,6 +64,53 @@ bool PowerMeterHttpJson::init()
         return false;
     }
 
+    // values without their own request are read from the first response
+    for (uint8_t i = 0; i < POWERMETER_HTTP_JSON_MAX_VALUES; i++) {
+        auto const& valueConfig = _cfg.Values[i];
+        if (!valueConfig.Enabled) { continue; }
+
+        _sources[i] = _httpGetters[i] ? i : 0;
+
+        auto& scanner = _scanners[_sources[i]];
+        _paths[i] = scanner.getPathCount();
+        if (scanner.addPath(valueConfig.JsonPath)) { continue; }
+
+        MessageOutput.printf("%s JSON path of value %d is nested too deeply\r\n", TAG, i + 1);
+        return false;
+    }
+
+    for (uint8_t i = 0; i < POWERMETER_HTTP_JSON_MAX_VALUES; i++) {
+        // a getter serving no enabled value is never polled
+        if (!_httpGetters[i] || _scanners[i].getPathCount() == 0) { continue; }
+
+        _groups[i] = _groupCount;
+
+        for (uint8_t j = 0; j < i; j++) {
+            if (!_httpGetters[j] || _scanners[j].getPathCount() == 0) { continue; }
+            if (!_httpGetters[j]->sameServer(*_httpGetters[i])) { continue; }
+
+            _httpGetters[i]->shareConnection(*_httpGetters[j]);
+            _groups[i] = _groups[j];
+            break;
+        }
+
+        if (_groups[i] == _groupCount) { _groupCount++; }
+    }
+
+    for (uint8_t group = 1; group < _groupCount; group++) {
+        auto& worker = _workers[group];
+        if (worker.handle != nullptr) { continue; }
+
+        worker.instance = this;
+        worker.group = group;
+        worker.done = false;
+
+        // the group is polled by the caller of poll() instead
+        if (xTaskCreate(PowerMeterHttpJson::groupWorkerHelper, "PM:HTTP+JSON", TaskStackSize, &worker, 1/*prio*/, &worker.handle) != pdPASS) {
+            worker.handle = nullptr;
+        }
+    }
+
     return true;
 }
 
@@ -65,8 +124,7 @@ void PowerMeterHttpJson::loop()
     _stopPolling = false;
     lock.unlock();
 
-    uint32_t constexpr stackSize = 3072;
-    if (!xTaskCreate(PowerMeterHttpJson::pollingLoopHelper, "PM:HTTP+JSON", stackSize, this, 1/*prio*/, &_taskHandle))
+    if (!xTaskCreate(PowerMeterHttpJson::pollingLoopHelper, "PM:HTTP+JSON", TaskStackSize, this, 1/*prio*/, &_taskHandle))
         MessageOutput.printf("%s error: creating PowerMeter Task\r\n", TAG);
 }
 
@@ -107,58 +165,117 @@ void PowerMeterHttpJson::pollingLoop()
             continue;
         }
 
-        if (_verboseLogging) MessageOutput.printf("%s New total: %.2fW\r\n", TAG, getPowerTotal());
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s New total: %.2fW\r\n", TAG, getPowerTotal());
 
         gotUpdate();
     }
 }
 
-PowerMeterHttpJson::poll_result_t PowerMeterHttpJson::poll()
+void PowerMeterHttpJson::groupWorkerHelper(void* context)
 {
-    power_values_t cache;
-    JsonDocument jsonResponse;
+    auto pWorker = static_cast<GroupWorker_t*>(context);
+    pWorker->instance->groupWorkerLoop(pWorker->group);
+    pWorker->done = true;
+    vTaskDelete(nullptr);
+}
+
+void PowerMeterHttpJson::groupWorkerLoop(uint8_t group)
+{
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (_stopWorkers) { return; }
+
+        pollGroup(group);
+        xTaskNotifyGive(_pollCaller);
+    }
+}
 
+void PowerMeterHttpJson::pollGroup(uint8_t group)
+{
+    for (uint8_t g = 0; g < POWERMETER_HTTP_JSON_MAX_VALUES; g++) {
+        auto const& upGetter = _httpGetters[g];
+        if (!upGetter || _scanners[g].getPathCount() == 0 || _groups[g] != group) { continue; }
+
+        auto& scanner = _scanners[g];
+        scanner.reset();
+
+        String error;
+        auto res = upGetter->performGetRequest();
+        if (!res) {
+            error = upGetter->getErrorText();
+        } else {
+            int written = res.writeToStream(scanner);
+            if (written < 0) {
+                error = "Unable to read server response: " + HTTPClient::errorToString(written);
+            } else if (scanner.getError() != nullptr) {
+                error = String("Unable to parse server response as JSON: ") + scanner.getError();
+            }
+        }
+
+        for (uint8_t i = 0; i < POWERMETER_HTTP_JSON_MAX_VALUES; i++) {
+            if (!_cfg.Values[i].Enabled || _sources[i] != g) { continue; }
+
+            if (!error.isEmpty()) {
+                _pollErrors[i] = error;
+                continue;
+            }
+
+            if (scanner.getValue(_paths[i], _polledValues[i], _pollErrors[i])) {
+                _pollErrors[i].clear();
+            }
+        }
+    }
+}
+
+PowerMeterHttpJson::poll_result_t PowerMeterHttpJson::poll()
+{
     auto prefixedError = [](uint8_t idx, char const* err) -> String {
         String res("Value ");
         res.reserve(strlen(err) + 16);
         return res + String(idx + 1) + ": " + err;
     };
 
-    for (uint8_t i = 0; i < POWERMETER_HTTP_JSON_MAX_VALUES; i++) {
-        auto const& cfg = _cfg.Values[i];
+    // only replaced for values served by an initialized getter
+    _polledValues = {};
+    for (auto& error : _pollErrors) { error = "HTTP getter not initialized"; }
 
-        if (!cfg.Enabled) {
-            cache[i] = 0.0;
+    _pollCaller = xTaskGetCurrentTaskHandle();
+    size_t running = 0;
+
+    for (uint8_t group = 1; group < _groupCount; group++) {
+        auto const& worker = _workers[group];
+
+        if (worker.handle == nullptr) {
+            pollGroup(group);
             continue;
         }
 
-        auto const& upGetter = _httpGetters[i];
+        xTaskNotifyGive(worker.handle);
+        running++;
+    }
 
-        if (upGetter) {
-            auto res = upGetter->performGetRequest();
-            if (!res) {
-                return prefixedError(i, upGetter->getErrorText());
-            }
+    if (_groupCount > 0) { pollGroup(0); }
 
-            auto pStream = res.getStream();
-            if (!pStream) {
-                return prefixedError(i, "Programmer error: HTTP request yields no stream");
-            }
+    for (size_t i = 0; i < running; i++) {
+        ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+    }
 
-            const DeserializationError error = deserializeJson(jsonResponse, *pStream);
-            if (error) {
-                String msg("Unable to parse server response as JSON: ");
-                return prefixedError(i, String(msg + error.c_str()).c_str());
-            }
+    power_values_t cache;
+
+    for (uint8_t i = 0; i < POWERMETER_HTTP_JSON_MAX_VALUES; i++) {
+        auto const& cfg = _cfg.Values[i];
+
+        if (!cfg.Enabled) {
+            cache[i] = 0.0;
+            continue;
         }
 
-        auto pathResolutionResult = Utils::getJsonValueByPath<float>(jsonResponse, cfg.JsonPath);
-        if (!pathResolutionResult.second.isEmpty()) {
-            return prefixedError(i, pathResolutionResult.second.c_str());
+        if (!_pollErrors[i].isEmpty()) {
+            return prefixedError(i, _pollErrors[i].c_str());
         }
 
         // this value is supposed to be in Watts and positive if energy is consumed
-        cache[i] = pathResolutionResult.first;
+        cache[i] = _polledValues[i];
 
         switch (cfg.PowerUnit) {
             case Unit_t::MilliWatts:
@@ -92,7 +92,7 @@ void PowerMeterHttpSml::pollingLoop()
         }
 
         if (_verboseLogging)
-            MessageOutput.printf("%s New total: %.2fW\r\n", TAG, getPowerTotal());
+            MessageOutput.printf(LogLevel::Verbose, "%s New total: %.2fW\r\n", TAG, getPowerTotal());
 
         gotUpdate();
     }
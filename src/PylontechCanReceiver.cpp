@@ -12,7 +12,8 @@
 
 bool PylontechCanReceiver::init()
 {
-    return _initialized = BatteryCanReceiver::init("Pylontech");
+    return _initialized = BatteryCanReceiver::init("Pylontech",
+            CanIoClass::exactStandardIds({ 0x351, 0x355, 0x356, 0x359, 0x35C, 0x35E }));
 }
 
 void PylontechCanReceiver::onMessage(twai_message_t rx_message)
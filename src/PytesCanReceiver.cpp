@@ -26,7 +26,12 @@ static uint32_t popCount(uint32_t val) {
 
 bool PytesCanReceiver::init()
 {
-    return _initialized = BatteryCanReceiver::init("Pytes");
+    return _initialized = BatteryCanReceiver::init("Pytes",
+            CanIoClass::exactStandardIds({
+                0x351, 0x355, 0x356, 0x35A, 0x35E, 0x35F, 0x360,
+                0x372, 0x373, 0x374, 0x375, 0x376, 0x377, 0x378, 0x379, 0x380, 0x381,
+                0x400, 0x401, 0x402, 0x403, 0x404, 0x405, 0x406, 0x408, 0x409, 0x40A,
+                0x40B, 0x40D, 0x41E }));
 }
 
 void PytesCanReceiver::onMessage(twai_message_t rx_message)
@@ -21,9 +21,57 @@ static constexpr char TAG[] = "[REFUsol]";
 
 REFUsolRS485ReceiverClass REFUsol;
 
+namespace {
+
+struct PollEntry_t {
+    uint16_t PNU;
+    uint16_t IND;
+    uint8_t rate; // multiple of the poll interval, 0: once after (re)connecting
+    char const* name;
+};
+
+// the values which matter for the power limiter first. all due entries of
+// all inverters are queued at once and sent back to back.
+constexpr PollEntry_t PollTable[] = {
+    { 1107, 0, 1, "DC power" },
+    { 1106, 0, 1, "AC power" },
+    { 1105, 0, 1, "DC current" },
+    { 1104, 0, 1, "DC voltage" },
+    { 1124, 0, 1, "AC current" },
+    { 1123, 0, 4, "AC voltage" },
+    { 1121, 0, 4, "AC voltage L1" },
+    { 1121, 1, 4, "AC voltage L2" },
+    { 1121, 2, 4, "AC voltage L3" },
+    { 1141, 0, 4, "AC current L1" },
+    { 1141, 1, 4, "AC current L2" },
+    { 1141, 2, 4, "AC current L3" },
+    { 1122, 0, 4, "frequency L1" },
+    { 1122, 1, 4, "frequency L2" },
+    { 1122, 2, 4, "frequency L3" },
+    { 501, 0, 4, "actual status" },
+    { 500, 0, 4, "error code" },
+    { 1150, 0, 12, "yield today" },
+    { 1153, 0, 12, "yield month" },
+    { 1154, 0, 12, "yield year" },
+    { 1151, 0, 12, "yield total" },
+    { 1162, 0, 12, "PV limit" },
+    { 92, 1, 12, "temperature sensor 1" },
+    { 92, 2, 12, "temperature sensor 2" },
+    { 92, 3, 12, "temperature sensor 3" },
+    { 92, 4, 12, "temperature sensor 4" },
+    { 1152, 0, 60, "total operating hours" },
+    { 1155, 0, 0, "PV peak" },
+    { 51, 0, 0, "device specific offset" },
+    { 1165, 0, 0, "plant specific offset" },
+    { 1164, 0, 0, "option cos phi" }, // requests the parameters of the option
+};
+
+constexpr size_t PollTableSize = sizeof(PollTable) / sizeof(PollTable[0]);
+
+} // namespace
+
 REFUsolRS485ReceiverClass::REFUsolRS485ReceiverClass()
     : _loopTask(TASK_IMMEDIATE, TASK_FOREVER, std::bind(&REFUsolRS485ReceiverClass::loop, this))
-    , _lastPoll(0)
 {
 }
 
@@ -32,17 +80,24 @@ void REFUsolRS485ReceiverClass::init(Scheduler& scheduler)
     MessageOutput.print("Initialize REFUsol Inverter... ");
 
     scheduler.addTask(_loopTask);
+    _loopTask.enable();
 
-    updateSettings();
+    applySettings();
 
     MessageOutput.println("done");
 }
 
+// called by the web API on another task. the inverter list is only
+// rebuilt by the loop task, which is the one using it.
 void REFUsolRS485ReceiverClass::updateSettings(void)
+{
+    _settingsChanged = true;
+}
+
+void REFUsolRS485ReceiverClass::applySettings(void)
 {
     if (_initialized) {
         deinit();
-        _loopTask.disable();
     }
 
     auto const& cREFUsol = Configuration.get().REFUsol;
@@ -59,7 +114,22 @@ void REFUsolRS485ReceiverClass::updateSettings(void)
         return;
     }
 
-    adr = cREFUsol.USSaddress;
+    // the inverters share the bus, their addresses follow the configured one
+    size_t count = std::min<size_t>(std::max<uint8_t>(cREFUsol.USSaddressCount, 1), REFUsol_MAX_INVERTERS);
+    count = std::min<size_t>(count, 32 - cREFUsol.USSaddress);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _inverters.clear();
+        for (size_t i = 0; i < count; ++i) {
+            Inverter_t inverter {};
+            inverter.adr = cREFUsol.USSaddress + i;
+            inverter.lastRequest.assign(PollTableSize, 0);
+            _inverters.push_back(inverter);
+        }
+    }
+    _requests.clear();
+    _requestPending = false;
+    _rxLength = 0;
 
     if (!_initialized) {
         auto oHwSerialPort = SerialPortManager.allocatePort(_serialPortOwner);
@@ -73,10 +143,10 @@ void REFUsolRS485ReceiverClass::updateSettings(void)
             SERIAL_8N1,
             pin.rx, pin.tx);
         static constexpr const char *Parity[3] = {"NONE", "EVEN", "ODD"};
-        MessageOutput.printf("RS485 (Type %d) @ %u Baud with %s parity, USS adr = %u, port rx = %d, tx = %d",
+        MessageOutput.printf("RS485 (Type %d) @ %u Baud with %s parity, USS adr = %u..%u, port rx = %d, tx = %d",
             pin.rts >= 0 ? 1 : 2,
             cREFUsol.Baudrate, Parity[cREFUsol.Parity],
-            cREFUsol.USSaddress,
+            cREFUsol.USSaddress, cREFUsol.USSaddress + _inverters.size() - 1,
             pin.rx, pin.tx);
         _StartInterval = static_cast<int>((1000000.0*2*(1+8+1+1))/cREFUsol.Baudrate+0.5);
         RS485BaudRate = cREFUsol.Baudrate;
@@ -104,91 +174,40 @@ void REFUsolRS485ReceiverClass::updateSettings(void)
         }
 
         _initialized = true;
-        _allParametersRead = false;
-
-        _loopTask.enable();
 
         MessageOutput.println(" initialized successfully.");
     }
 }
 
-bool REFUsolRS485ReceiverClass::readParameters()
+// the parameters which are relevant depend on the cos phi option
+void REFUsolRS485ReceiverClass::requestCosPhiParameters(size_t inverter)
 {
-    static int8_t state=0;
-    static int8_t index=1;
-
-    if (_allParametersRead) { return false; }
-
-    if (_verboseLogging) MessageOutput.printf("%s Read basic infos and parameters ... ", TAG);
-
-    switch(state) {
-        case 0:
-            if (_verboseLogging) MessageOutput.println("get total operating hours");
-            getTotalOperatingHours(adr);
-            state++;
-            return true;
-
-        case 1:
-            if (_verboseLogging) MessageOutput.println("get PV peak");
-            getPVpeak(adr);
-            state++;
-            return true;
-
-        case 2:
-            if (_verboseLogging) MessageOutput.println("get PV limit");
-            getPVlimit(adr);
-            state++;
-            return true;
-
-        case 3:
-            if (_verboseLogging) MessageOutput.println("get device specific offset");
-            getDeviceSpecificOffset(adr);
-            state++;
-            return true;
-
-        case 4:
-            if (_verboseLogging) MessageOutput.println("get plant specific offset");
-            getPlantSpecificOffset(adr);
-            state++;
-            return true;
-
-        case 5:
-            if (_verboseLogging) MessageOutput.println("get option cos phi");
-            getOptionCosPhi(adr);
-            state++;
-            return true;
-
-        case 6:
-            switch (Frame.optionCosPhi) {
-                case 0:
-                    break;
-                case 1:
-                    if (_verboseLogging) MessageOutput.println("get fixed offset");
-                    getFixedOffset(adr);
-                    state++;
-                    return true;
-                case 2:
-                    if (_verboseLogging) MessageOutput.println("get variable offset");
-                    getVariableOffset(adr);
-                    state++;
-                    return true;
-                case 3:
-                    if (_verboseLogging) MessageOutput.printf("get cos phi(P=%d%%)\r\n", (index-1)*10);
-                    getCosPhi(adr, index++);
-                    if (index>11) state++;
-                    return true;
-                case 4:
-                    if (_verboseLogging) MessageOutput.println("get cos phi");
-                    getCosPhi(adr, 0);
-                    state++;
-                    return true;
-                default:;
-            }
-            break;
+    auto& frame = _inverters[inverter].frame;
+    uint8_t i = static_cast<uint8_t>(inverter);
 
-        default:;
+    switch (frame.optionCosPhi) {
+    case 1:
+        _requests.push_back({ i, 1166, 0 }); // fixed offset
+        break;
+    case 2:
+        _requests.push_back({ i, 1167, 0 }); // variable offset
+        break;
+    case 3:
+        for (uint16_t ind = 0; ind <= 10; ++ind) {
+            _requests.push_back({ i, 1168, ind }); // cos phi at P = ind * 10%
+        }
+        break;
+    case 4:
+        _requests.push_back({ i, 1169, 0 }); // cos phi
+        break;
+    default:;
     }
 
+    updateEffectiveCosPhi(frame);
+}
+
+void REFUsolRS485ReceiverClass::updateEffectiveCosPhi(REFUsolStruct& Frame)
+{
     Frame.effectivCosPhi = NaN;
     switch (Frame.optionCosPhi) {
     case 0:
@@ -215,14 +234,8 @@ bool REFUsolRS485ReceiverClass::readParameters()
     }
 
     if (_verboseLogging) {
-        if (Frame.optionCosPhi > NaN) MessageOutput.printf("Effektive Cos Phi : %.2f°\r\n", Frame.effectivCosPhi);
+        if (Frame.effectivCosPhi > NaN) MessageOutput.printf("Effektive Cos Phi : %.2f°\r\n", Frame.effectivCosPhi);
     }
-
-    state=0;
-    index=1;
-    _allParametersRead = true;
-
-    return true;
 }
 
 void REFUsolRS485ReceiverClass::deinit(void)
@@ -244,193 +257,99 @@ void REFUsolRS485ReceiverClass::deinit(void)
 
 void REFUsolRS485ReceiverClass::loop()
 {
-    if (!Configuration.get().REFUsol.Enabled) {
-        deinit();
-        return;
-    }
+    if (_settingsChanged.exchange(false)) { applySettings(); }
+
+    if (!_initialized) { return; }
+
+    if (_requestPending) {
+        switch (receiveTelegram()) {
+        case Receive::Complete: {
+            auto& inverter = _inverters[_request.inverter];
+            if ((rTelegram.ADR & 0b00011111) != inverter.adr) {
+                MessageOutput.printf("%s response from USS adr %u, expected %u\r\n", TAG,
+                    rTelegram.ADR & 0b00011111, inverter.adr);
+            } else {
+                std::lock_guard<std::mutex> lock(_mutex);
+                inverter.lastUpdate = millis();
+                parse(inverter);
+            }
+            if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s Round trip %lu ms\r\n", TAG, millis() - _requestMillis);
+            finishRequest();
+            break;
+        }
 
-    if (!_initialized) {
-        updateSettings();
-        return;
-    }
+        case Receive::Error:
+            finishRequest();
+            break;
 
-    uint32_t t_start = millis();
+        case Receive::Pending:
+            // first character within the maximum response time, the following ones without gap
+            if (_rxLength == 0 ? (millis() - _requestMillis > MaximumResponseTime)
+                               : (millis() - _rxMillis > _interCharacterTimeout)) {
+                if (_verboseLogging) DebugNoResponse(_request.PNU);
+                // parameters of an inverter not responding are read again later
+                if (_rxLength == 0) _inverters[_request.inverter].parametersRead = false;
+                finishRequest();
+            }
+            break;
+        }
 
-    if (_upSerial->available()) {
-        parse();
+        if (_requestPending) { return; }
     }
 
-    if ((millis() - getLastUpdate()) < Configuration.get().REFUsol.PollInterval * 1000) {
-        return;
-    }
+    if (_requests.empty()) schedule();
 
-    if (readParameters()) {
-        setLastUpdate();
-        return;
-    }
+    sendNext();
+}
 
-    static int state = 0;
-    static int state2 = 0;
-    switch (state) {
-    case 0:
-    case 5:
-        if (_verboseLogging) MessageOutput.printf("%s get ", TAG);
-        switch (state2) {
-            case 0:
-                if (_verboseLogging) MessageOutput.println("DC power");
-                getDCpower(adr);
-                state2++;
-                break;
-            case 1:
-                if (_verboseLogging)MessageOutput.println("DC current");
-                getDCcurrent(adr);
-                state2++;
-                break;
-            case 2:
-                if (_verboseLogging)MessageOutput.println("DC voltage");
-                getDCvoltage(adr);
-                state2++;
-                break;
-            case 3:
-                if (_verboseLogging)MessageOutput.println("AC power");
-                getACpower(adr);
-                state2=0;
-                state++;
-        }
-        break;
+// queues all poll table entries which are due, for every inverter
+void REFUsolRS485ReceiverClass::schedule(void)
+{
+    uint32_t interval = Configuration.get().REFUsol.PollInterval * 1000;
+    uint32_t now = millis();
 
-    case 1:
-    case 6:
-        if (_verboseLogging) MessageOutput.printf("%s get AC voltage index: %d\r\n", TAG, state2);
-        switch (state2) {
-            case 0:
-                getACvoltage(adr, 0);
-                state2++;
-                break;
-            case 1:
-                getACvoltage(adr, 1);
-                state2++;
-                break;
-            case 2:
-                getACvoltage(adr, 2);
-                state2++;
-                break;
-            case 3:
-                getACvoltage(adr, 3);
-                state2=0;
-                state++;
-        }
-        break;
+    for (size_t i = 0; i < _inverters.size(); ++i) {
+        auto& inverter = _inverters[i];
 
-    case 2:
-    case 7:
-        if (_verboseLogging) MessageOutput.printf("%s get AC current index: %d\r\n", TAG, state2);
-        switch (state2) {
-            case 0:
-                getACcurrent(adr, 0);
-                state2++;
-                break;
-            case 1:
-                getACcurrent(adr, 1);
-                state2++;
-                break;
-            case 2:
-                getACcurrent(adr, 2);
-                state2++;
-                break;
-            case 3:
-                getACcurrent(adr, 3);
-                state2=0;
-                state++;
-        }
-        break;
+        for (size_t e = 0; e < PollTableSize; ++e) {
+            auto const& entry = PollTable[e];
 
-    case 3:
-    case 8:
-        if (_verboseLogging) MessageOutput.printf("%s get phase frequency index: %d\r\n", TAG, state2);
-        switch (state2) {
-            case 0:
-                getACfrequency(adr, 1);
-                state2++;
-                break;
-            case 1:
-                getACfrequency(adr, 2);
-                state2++;
-                break;
-            case 2:
-                getACfrequency(adr, 3);
-                state2=0;
-                state++;
-        }
-        break;
+            if (entry.rate == 0) {
+                if (inverter.parametersRead) continue;
+            } else if (inverter.lastRequest[e] != 0 && now - inverter.lastRequest[e] < entry.rate * interval) {
+                continue;
+            }
 
-    case 4:
-    case 9:
-        if (_verboseLogging) MessageOutput.printf("%s get yield solar power ", TAG);
-        switch (state2) {
-            case 0:
-                if (_verboseLogging) MessageOutput.println("today");
-                getYieldDay(adr);
-                state2++;
-                break;
-            case 1:
-                if (_verboseLogging) MessageOutput.println("month");
-                getYieldMonth(adr);
-                state2++;
-                break;
-            case 2:
-                if (_verboseLogging) MessageOutput.println("year");
-                getYieldYear(adr);
-                state2++;
-                break;
-            case 3:
-                if (_verboseLogging) MessageOutput.println("total");
-                getYieldTotal(adr);
-                state2=0;
-                state++;
+            if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s adr %u get %s\r\n", TAG, inverter.adr, entry.name);
+            _requests.push_back({ static_cast<uint8_t>(i), entry.PNU, entry.IND });
+            inverter.lastRequest[e] = now;
         }
-        break;
 
-    case 10:
-        if (_verboseLogging) MessageOutput.printf("%s get temperature sensor index: %d\r\n", TAG, state2);
-        switch (state2) {
-            case 0:
-                getTemperatursensor(adr, 1);
-                state2++;
-                break;
-            case 1:
-                getTemperatursensor(adr, 2);
-                state2++;
-                break;
-            case 2:
-                getTemperatursensor(adr, 3);
-                state2++;
-                break;
-            case 3:
-                getTemperatursensor(adr, 4);
-                state2=0;
-                state++;
-        }
-        break;
-    case 11:
-        if (_verboseLogging) MessageOutput.printf("%s get error code\r\n", TAG);
-        getFehlercode(adr);
-        state++;
-        break;
-    case 12:
-        if (_verboseLogging) MessageOutput.printf("%s get actual status\r\n", TAG);
-        getActualStatus(adr);
-        state++;
-        break;
-    case 13:
-        if (_verboseLogging) MessageOutput.printf("%s get total operating hours\r\n", TAG);
-        getTotalOperatingHours(adr);
-        state=0;
+        inverter.parametersRead = true;
     }
+}
 
-    setLastUpdate();
+void REFUsolRS485ReceiverClass::sendNext(void)
+{
+    if (_requests.empty()) return;
 
-    MessageOutput.printf("%s Round trip %lu ms\r\n", TAG, millis() - t_start);
+    _request = _requests.front();
+    _requests.pop_front();
+
+    // whatever is still buffered can not be the response to this request
+    while (_upSerial->available()) _upSerial->read();
+    _rxLength = 0;
+
+    computeTelegram(_inverters[_request.inverter].adr, false, RequestPWE, _request.PNU, _request.IND);
+
+    _requestPending = true;
+    _requestMillis = millis();
+}
+
+void REFUsolRS485ReceiverClass::finishRequest(void)
+{
+    _requestPending = false;
+    _rxLength = 0;
 }
 
 void REFUsolRS485ReceiverClass::debugRawTelegram(TELEGRAM_t* t, uint8_t len)
@@ -646,72 +565,46 @@ void REFUsolRS485ReceiverClass::sendTelegram(void)
     if (_rtsPin >= 0) digitalWrite(_rtsPin, LOW);
 }
 
-uint8_t REFUsolRS485ReceiverClass::receiveTelegram(void)
+// assembles the response from the characters received so far, without waiting
+REFUsolRS485ReceiverClass::Receive REFUsolRS485ReceiverClass::receiveTelegram(void)
 {
-    uint16_t idx = 0;
-    uint32_t TimeOut;
-    bool error = false;
+    while (_upSerial->available()) {
+        uint8_t c = _upSerial->read();
+        _rxMillis = millis();
 
-    uint32_t t1 = millis(); // maximum response time 20ms timeout for first character
-    while (1) {
-        if (_upSerial->available())
-            break;
-        if (millis() - t1 > MaximumResponseTime)
-            return idx;
-    }
-    idx++;
-    rTelegram.STX = _upSerial->read();
+        if (_rxLength == 0 && c != 0x02) continue; // wait for STX
 
-    t1 = millis(); // 10ms timeout for third character
-    while (1) {
-        if (_upSerial->available())
-            break;
-        if (millis() - t1 > 10)
-            return idx;
-    }
-    idx++;
-    rTelegram.LGE = _upSerial->read();
-    if (rTelegram.LGE < 3) {
-        MessageOutput.printf("%s ERROR: receive buffer, LGE too small %d\r\n", TAG, rTelegram.LGE);
-        error = true;
-        goto exitReceive;
-    }
-    if (rTelegram.LGE > 254) {
-        MessageOutput.printf("%s ERROR: receive buffer, LGE too large %d\r\n", TAG, rTelegram.LGE);
-        error = true;
-        goto exitReceive;
-    }
+        rTelegram.buffer[_rxLength++] = c;
 
-    t1 = millis(); // 10ms timeout for second character
-    while (1) {
-        if (_upSerial->available())
-            break;
-        if (millis() - t1 > 10)
-            return idx;
-    }
-    idx++;
-    rTelegram.ADR = _upSerial->read();
-
-    TimeOut = static_cast<uint32_t>((1 + 8 + 1 + 1) * 1000.0 / RS485BaudRate * rTelegram.LGE) + 20;
-    t1 = millis(); // 0.625ms * LGE timeout for remaining character
-    while (1) {
-        if (_upSerial->available())
-            rTelegram.buffer[idx++] = _upSerial->read();
-        if (millis() - t1 > TimeOut)
-            break;
-        if (idx > 255) {
-            MessageOutput.printf("%s ERROR: framesize, receive buffer overrun\r\n", TAG);
-            error = true;
-            break;
+        if (_rxLength == 2) {
+            if (rTelegram.LGE < 3) {
+                MessageOutput.printf("%s ERROR: receive buffer, LGE too small %d\r\n", TAG, rTelegram.LGE);
+                return Receive::Error;
+            }
+            if (rTelegram.LGE > 254) {
+                MessageOutput.printf("%s ERROR: receive buffer, LGE too large %d\r\n", TAG, rTelegram.LGE);
+                return Receive::Error;
+            }
+        }
+
+        // STX and LGE are not counted by LGE
+        if (_rxLength < 2 || _rxLength < rTelegram.LGE + 2) continue;
+
+        debugRawTelegram(&rTelegram, _rxLength);
+
+        uint8_t bcc = 0;
+        for (int i = 0; i < rTelegram.LGE + 1; i++) {
+            bcc ^= rTelegram.buffer[i];
         }
-        if (error) {
+        if (bcc != rTelegram.buffer[rTelegram.LGE + 1]) {
+            MessageOutput.printf("%s ERROR: BCC mismatch\r\n", TAG);
+            return Receive::Error;
         }
-    }
 
-exitReceive:;
-    debugRawTelegram(&rTelegram, idx);
+        return Receive::Complete;
+    }
 
-    return idx;
+    return Receive::Pending;
 }
 
 void REFUsolRS485ReceiverClass::DebugNoResponse(uint16_t p)
@@ -719,7 +612,7 @@ void REFUsolRS485ReceiverClass::DebugNoResponse(uint16_t p)
     MessageOutput.printf("%s D%d: timeout, no response from REFUSOL\n", TAG, p);
 }
 
-void REFUsolRS485ReceiverClass::parse(void)
+void REFUsolRS485ReceiverClass::parse(Inverter_t& inverter)
 {
 // Aktueller Zustand
 static constexpr char const *StringActualStatus[8] = {
@@ -733,10 +626,7 @@ static constexpr char const *StringActualStatus[8] = {
   "Disturbance"
 };
 
-    if (!receiveTelegram()) {
-        // DebugNoResponse(p);
-        return;
-    }
+    REFUsolStruct& Frame = inverter.frame;
 
     uint16_t PNU = 0;
     PNU = (rTelegram.PKE.H & 0xF) << 8;
@@ -749,37 +639,37 @@ static constexpr char const *StringActualStatus[8] = {
     switch (PNU) {
     case 1104:
         Frame.dcVoltage = PWE2Float(0.1);
-        if (_verboseLogging) MessageOutput.printf("%s DC voltage: %.1f V\r\n", TAG, Frame.dcVoltage);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s DC voltage: %.1f V\r\n", TAG, Frame.dcVoltage);
         break;
     case 1105:
         Frame.dcCurrent = PWE2Float(0.1);
-        if (_verboseLogging) MessageOutput.printf("%s DC current: %.1f V\r\n", TAG, Frame.dcCurrent);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s DC current: %.1f V\r\n", TAG, Frame.dcCurrent);
         break;
     case 1106:
         Frame.acPower = PWE2Float(0.1);
-        if (_verboseLogging) MessageOutput.printf("%s AC power: %.0f W\r\n", TAG, Frame.acPower);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s AC power: %.0f W\r\n", TAG, Frame.acPower);
         break;
     case 1107:
         Frame.dcPower = PWE2Float(0.1);
-        if (_verboseLogging) MessageOutput.printf("%s DC power: %.0f W\r\n", TAG, Frame.dcPower);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s DC power: %.0f W\r\n", TAG, Frame.dcPower);
         break;
     case 1123:
         Frame.acVoltage = PWE2Float(0.1);
-        if (_verboseLogging) MessageOutput.printf("%s L1-L3 voltage (eff): %.1f V\r\n", TAG, Frame.acVoltage);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s L1-L3 voltage (eff): %.1f V\r\n", TAG, Frame.acVoltage);
         break;
     case 1121:
         switch (IND.W) {
         case 0:
             Frame.acVoltageL1 = PWE2Float(0.1);
-            if (_verboseLogging) MessageOutput.printf("%s L1 voltage: %.1f V\r\n", TAG, Frame.acVoltageL1);
+            if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s L1 voltage: %.1f V\r\n", TAG, Frame.acVoltageL1);
             break;
         case 1:
             Frame.acVoltageL2 = PWE2Float(0.1);
-            if (_verboseLogging) MessageOutput.printf("%s L2 voltage: %.1f V\r\n", TAG, Frame.acVoltageL2);
+            if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s L2 voltage: %.1f V\r\n", TAG, Frame.acVoltageL2);
             break;
         case 2:
             Frame.acVoltageL3 = PWE2Float(0.1);
-            if (_verboseLogging) MessageOutput.printf("%s L3 voltage: %.1f V\r\n", TAG, Frame.acVoltageL3);
+            if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s L3 voltage: %.1f V\r\n", TAG, Frame.acVoltageL3);
             break;
         default:;
             MessageOutput.printf("%s undefined AC voltage index: %d\r\n", TAG, IND.W);
@@ -787,39 +677,39 @@ static constexpr char const *StringActualStatus[8] = {
         break;
     case 1124:
         Frame.acCurrent = PWE2Float(0.1);
-        if (_verboseLogging) MessageOutput.printf("%s L1-L3 sum current: %.1f A\r\n", TAG, Frame.acCurrent);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s L1-L3 sum current: %.1f A\r\n", TAG, Frame.acCurrent);
         break;
     case 1141:
         switch (IND.W) {
         case 0:
             Frame.acCurrentL1 = PWE2Float(0.1);
-            if (_verboseLogging) MessageOutput.printf("%s L1 current: %.1f A\r\n", TAG, Frame.acCurrentL1);
+            if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s L1 current: %.1f A\r\n", TAG, Frame.acCurrentL1);
             break;
         case 1:
             Frame.acCurrentL2 = PWE2Float(0.1);
-            if (_verboseLogging) MessageOutput.printf("%s L2 current: %.1f A\r\n", TAG, Frame.acCurrentL2);
+            if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s L2 current: %.1f A\r\n", TAG, Frame.acCurrentL2);
             break;
         case 2:
             Frame.acCurrentL3 = PWE2Float(0.1);
-            if (_verboseLogging) MessageOutput.printf("%s L3 current: %.1f A\r\n", TAG, Frame.acCurrentL3);
+            if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s L3 current: %.1f A\r\n", TAG, Frame.acCurrentL3);
             break;
         default:;
-            if (_verboseLogging) MessageOutput.printf("%s undefined AC current index: %d\r\n", TAG, IND.W);
+            if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s undefined AC current index: %d\r\n", TAG, IND.W);
         }
         break;
     case 1122:
         switch (IND.W) {
         case 0:
             Frame.freqL1 = PWE2Float(0.01);
-            if (_verboseLogging) MessageOutput.printf("%s L1: %.2f Hz\r\n", TAG, Frame.freqL1);
+            if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s L1: %.2f Hz\r\n", TAG, Frame.freqL1);
             break;
         case 1:
             Frame.freqL2 = PWE2Float(0.01);
-            if (_verboseLogging) MessageOutput.printf("%s L2: %.2f Hz\r\n", TAG, Frame.freqL2);
+            if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s L2: %.2f Hz\r\n", TAG, Frame.freqL2);
             break;
         case 2:
             Frame.freqL3 = PWE2Float(0.01);
-            if (_verboseLogging) MessageOutput.printf("%s L3: %.2f Hz\r\n", TAG, Frame.freqL3);
+            if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s L3: %.2f Hz\r\n", TAG, Frame.freqL3);
             break;
         default:;
             MessageOutput.printf("%s undefined frequency index: %d\r\n", TAG, IND.W);
@@ -827,87 +717,91 @@ static constexpr char const *StringActualStatus[8] = {
         break;
     case 1150:
         Frame.YieldDay = PWE2Float(0.1);
-        if (_verboseLogging) MessageOutput.printf("%s Yield today: %.1f W\r\n", TAG, Frame.YieldDay);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s Yield today: %.1f W\r\n", TAG, Frame.YieldDay);
         break;
     case 1151:
         Frame.YieldTotal = PWE2Float(0.1);
-        if (_verboseLogging) MessageOutput.printf("%s Yield total: %.3f kWh\r\n", TAG, Frame.YieldTotal);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s Yield total: %.3f kWh\r\n", TAG, Frame.YieldTotal);
         break;
     case 1152:
         Frame.totalOperatingHours = PWE2Uint32();
-        if (_verboseLogging) MessageOutput.printf("%s Total operating hours: %u:%u\r\n", TAG, Frame.totalOperatingHours/60, Frame.totalOperatingHours%60);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s Total operating hours: %u:%u\r\n", TAG, Frame.totalOperatingHours/60, Frame.totalOperatingHours%60);
         break;
     case 1153:
         Frame.YieldMonth = PWE2Float(0.1);
-        if (_verboseLogging) MessageOutput.printf("%s Yield actual month: %.3f kWh\r\n", TAG, Frame.YieldMonth);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s Yield actual month: %.3f kWh\r\n", TAG, Frame.YieldMonth);
         break;
     case 1154:
         Frame.YieldYear = PWE2Float(0.1);
-        if (_verboseLogging) MessageOutput.printf("%s Yield actual year: %.3f kWh\r\n", TAG, Frame.YieldYear);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s Yield actual year: %.3f kWh\r\n", TAG, Frame.YieldYear);
         break;
     case 1155:
         Frame.pvPeak = PWE2Float(0.1);
-        if (_verboseLogging) MessageOutput.printf("%s PV peak: %.3f kW\r\n", TAG, Frame.pvPeak);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s PV peak: %.3f kW\r\n", TAG, Frame.pvPeak);
         break;
     case 1162:
         Frame.pvLimit = PWE2Float(0.1);
-        if (_verboseLogging) MessageOutput.printf("%s PV limited: %.1f%%\r\n", TAG, Frame.pvLimit);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s PV limited: %.1f%%\r\n", TAG, Frame.pvLimit);
         break;
     case 51:
         Frame.deviceSpecificOffset = PWE2Float(0.01);
-        if (_verboseLogging) MessageOutput.printf("%s Device specific offset: %.2f°\r\n", TAG, Frame.deviceSpecificOffset);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s Device specific offset: %.2f°\r\n", TAG, Frame.deviceSpecificOffset);
         break;
     case 1164:
         Frame.optionCosPhi = PWE2Uint32();
-        if (_verboseLogging) MessageOutput.printf("%s Option Cos Phi: %d\r\n", TAG, Frame.optionCosPhi);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s Option Cos Phi: %d\r\n", TAG, Frame.optionCosPhi);
+        requestCosPhiParameters(&inverter - _inverters.data());
         break;
     case 1165:
         Frame.plantSpecificOffset = PWE2Float(0.01);
-        if (_verboseLogging) MessageOutput.printf("%s Plant specfic offset: %.2f°\r\n", TAG, Frame.plantSpecificOffset);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s Plant specfic offset: %.2f°\r\n", TAG, Frame.plantSpecificOffset);
         break;
     case 1166:
         Frame.fixedOffset = PWE2Float(0.01);
-        if (_verboseLogging) MessageOutput.printf("%s Fixed offset: %.2f°\r\n", TAG, Frame.fixedOffset);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s Fixed offset: %.2f°\r\n", TAG, Frame.fixedOffset);
+        updateEffectiveCosPhi(Frame);
         break;
     case 1167:
         Frame.variableOffset = PWE2Float(0.01);
-        if (_verboseLogging) MessageOutput.printf("%s Variable offset: %.2f°\r\n", TAG, Frame.variableOffset);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s Variable offset: %.2f°\r\n", TAG, Frame.variableOffset);
+        updateEffectiveCosPhi(Frame);
         break;
     case 1168:
         if (IND.W <= 10) {
             Frame.cosPhiPvPeak[IND.W] = PWE2Float(0.01);
-            if (_verboseLogging) MessageOutput.printf("%s PW peak Cos Phi[%d]: %.2f°\r\n", TAG, IND.W, Frame.cosPhiPvPeak[IND.W]);
+            if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s PW peak Cos Phi[%d]: %.2f°\r\n", TAG, IND.W, Frame.cosPhiPvPeak[IND.W]);
         } else {
             MessageOutput.printf("%s Cos Phi of PV peak index out of range: %d\r\n", TAG, IND.W);
         }
-
+        if (IND.W == 0) updateEffectiveCosPhi(Frame);
         break;
     case 1169:
         Frame.cosPhi = PWE2Float(0.01);
-        if (_verboseLogging) MessageOutput.printf("%s Cos Phi: %.2f°\r\n", TAG, Frame.cosPhi);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s Cos Phi: %.2f°\r\n", TAG, Frame.cosPhi);
+        updateEffectiveCosPhi(Frame);
         break;
     case 1193:
         Frame.temperatureExtern = PWE2Float(0.1);
-        if (_verboseLogging) MessageOutput.printf("%s Temperatur extern Sensor %.1f°C\r\n", TAG, Frame.temperatureExtern);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s Temperatur extern Sensor %.1f°C\r\n", TAG, Frame.temperatureExtern);
         break;
     case 92:
-        if (_verboseLogging) MessageOutput.printf("%s Temperature ", TAG);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s Temperature ", TAG);
         switch (IND.W) {
         case 0:
             Frame.temperatureRight = PWE2Float(0.1);
-            if (_verboseLogging) MessageOutput.printf("heat sink right %.1f°C\r\n", Frame.temperatureRight);
+            if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "heat sink right %.1f°C\r\n", Frame.temperatureRight);
             break;
         case 1:
             Frame.temperatureTopLeft = PWE2Float(0.1);
-            if (_verboseLogging) MessageOutput.printf("device internal upper left: %.1f°C\r\n", Frame.temperatureTopLeft);
+            if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "device internal upper left: %.1f°C\r\n", Frame.temperatureTopLeft);
             break;
         case 2:
             Frame.temperatureBottomRight = PWE2Float(0.1);
-            if (_verboseLogging) MessageOutput.printf("device internal bottom right: %.1f°C\r\n", Frame.temperatureBottomRight);
+            if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "device internal bottom right: %.1f°C\r\n", Frame.temperatureBottomRight);
             break;
         case 3:
             Frame.temperatureLeft = PWE2Float(0.1);
-            if (_verboseLogging) MessageOutput.printf("heat sink left: %.1f°C\r\n", Frame.temperatureLeft);
+            if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "heat sink left: %.1f°C\r\n", Frame.temperatureLeft);
             break;
         default:;
             MessageOutput.printf("\r\n%s undefined sensor index: %d\r\n", TAG, IND.W);
@@ -915,214 +809,68 @@ static constexpr char const *StringActualStatus[8] = {
         break;
     case 500:
         Frame.error = PWE2Uint32();
-        if (_verboseLogging) MessageOutput.printf("%s Device Error: 0x%06X\r\n", TAG, Frame.error);
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s Device Error: 0x%06X\r\n", TAG, Frame.error);
         break;
     case 501:
         Frame.status = PWE2Uint32();
-        if (_verboseLogging) MessageOutput.printf("%s Actual Status: %d - %s\r\n", TAG,
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s Actual Status: %d - %s\r\n", TAG,
             Frame.status,
             (Frame.status <= 7) ? StringActualStatus[Frame.status] : "unkown status");
         break;
     case 2000:
-        if (_verboseLogging) MessageOutput.printf("%s actual Password: %d\r\n", TAG, PWE2Uint32());
+        if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s actual Password: %d\r\n", TAG, PWE2Uint32());
         break;
     default:;
         MessageOutput.printf("%s undefined PNU: %d\r\n", TAG, PNU);
     }
 }
 
-void REFUsolRS485ReceiverClass::getDCvoltage(uint8_t adr)
-{
-    computeTelegram(adr, false, RequestPWE, 1104, 0);
-}
-
-void REFUsolRS485ReceiverClass::getDCcurrent(uint8_t adr)
-{
-    computeTelegram(adr, false, RequestPWE, 1105, 0);
-}
-
-void REFUsolRS485ReceiverClass::getACpower(uint8_t adr)
-{
-    computeTelegram(adr, false, RequestPWE, 1106, 0);
-}
-
-void REFUsolRS485ReceiverClass::getDCpower(uint8_t adr)
-{
-    computeTelegram(adr, false, RequestPWE, 1107, 0);
-}
-
-/*
- * ind  0 : Voltage effective
- * ind  1 : Voltage peak of L1
- * ind  2 : Voltage peak of L2
- * ind  3 : Voltage peak of L3
- */
-void REFUsolRS485ReceiverClass::getACvoltage(uint8_t adr, uint16_t ind)
+bool REFUsolRS485ReceiverClass::isFresh(uint32_t lastUpdate) const
 {
-    if (ind == 0) {
-        computeTelegram(adr, false, RequestPWE, 1123, 0);
-    } else {
-        if (ind > 3) ind = 3;
-        computeTelegram(adr, false, RequestPWE, 1121, ind - 1);
-    }
+    return (millis() - lastUpdate) / 1000 <= Configuration.get().REFUsol.PollInterval * 5;
 }
 
-/*
- * ind  0 : Current Sum of L1, L2, L3
- * ind  1 : Current of L1
- * ind  2 : Current of L2
- * ind  3 : Current of L3
- */
-void REFUsolRS485ReceiverClass::getACcurrent(uint8_t adr, uint16_t ind)
+bool REFUsolRS485ReceiverClass::isDataValid(size_t inverter)
 {
-    if (ind == 0) {
-        computeTelegram(adr, false, RequestPWE, 1124, 0);
-    } else {
-        if (ind > 3) ind = 3;
-        computeTelegram(adr, false, RequestPWE, 1141, ind - 1);
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (inverter >= _inverters.size()) {
+        return false;
     }
+    return isFresh(_inverters[inverter].lastUpdate);
 }
 
-/*
- * ind  1 : Frequency of L1
- * ind  2 : Frequency of L2
- * ind  3 : Frequency of L3
- */
-void REFUsolRS485ReceiverClass::getACfrequency(uint8_t adr, uint16_t ind)
-{
-    if (ind < 1) ind = 1;
-    if (ind > 3) ind = 3;
-    computeTelegram(adr, false, RequestPWE, 1122, ind - 1);
-}
-
-void REFUsolRS485ReceiverClass::getYieldDay(uint8_t adr)
-{
-    computeTelegram(adr, false, RequestPWE, 1150, 0);
-}
-
-void REFUsolRS485ReceiverClass::getTotalOperatingHours(uint8_t adr)
-{
-    computeTelegram(adr, false, RequestPWE, 1152, 0);
-}
-
-void REFUsolRS485ReceiverClass::getYieldMonth(uint8_t adr)
-{
-    computeTelegram(adr, false, RequestPWE, 1153, 0);
-}
-
-void REFUsolRS485ReceiverClass::getYieldYear(uint8_t adr)
-{
-    computeTelegram(adr, false, RequestPWE, 1154, 0);
-}
-
-void REFUsolRS485ReceiverClass::getYieldTotal(uint8_t adr)
-{
-    computeTelegram(adr, false, RequestPWE, 1151, 0);
-}
-
-void REFUsolRS485ReceiverClass::getPVpeak(uint8_t adr)
-{
-    computeTelegram(adr, false, RequestPWE, 1155, 0);
-}
-
-// get power limit value in 0.1%
-void REFUsolRS485ReceiverClass::getPVlimit(uint8_t adr)
-{
-    computeTelegram(adr, false, RequestPWE, 1162, 0);
-}
-
-// get Device specific angle Cos Phi in 0.01°, defult is 0.07°
-void REFUsolRS485ReceiverClass::getDeviceSpecificOffset(uint8_t adr)
-{
-    computeTelegram(adr, false, RequestPWE, 51, 0);
-}
-
-// get Plant specific angle Cos Phi in 0.01°, default is 0.0°
-void REFUsolRS485ReceiverClass::getPlantSpecificOffset(uint8_t adr)
-{
-    computeTelegram(adr, false, RequestPWE, 1165, 0);
-}
-
-// get fixed angle Cos Phi in 0.01°, default is 0.0°
-void REFUsolRS485ReceiverClass::getFixedOffset(uint8_t adr)
-{
-    computeTelegram(adr, false, RequestPWE, 1166, 0);
-}
-
-// get variable angle Cos Phi in 0.01°, default is 0.0°
-void REFUsolRS485ReceiverClass::getVariableOffset(uint8_t adr)
-{
-    computeTelegram(adr, false, RequestPWE, 1167, 0);
-}
-
-void REFUsolRS485ReceiverClass::getOptionCosPhi(uint8_t adr)
+size_t REFUsolRS485ReceiverClass::getInverterCount() const
 {
-    computeTelegram(adr, false, RequestPWE, 1164, 0);
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _inverters.size();
 }
 
-// get Cos Phi in 0.01°
-void REFUsolRS485ReceiverClass::getCosPhi(uint8_t adr, uint16_t ind)
+REFUsolStruct REFUsolRS485ReceiverClass::getFrame(size_t inverter) const
 {
-    if (ind == 0) {
-        computeTelegram(adr, false, RequestPWE, 1169, 0);
-    } else {
-        if (ind > 11) ind = 11;
-        computeTelegram(adr, false, RequestPWE, 1168, ind - 1);
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (inverter >= _inverters.size()) {
+        return {};
     }
+    return _inverters[inverter].frame;
 }
 
-/*
- * ind  0 : external Temp Sensor
- * ind  1 : Temp Sensor left
- * ind  2 : Temp Sensor upper left
- * ind  3 : Temp Sensor bootom right
- * ind  4 : Temp Sensor right
- */
-void REFUsolRS485ReceiverClass::getTemperatursensor(uint8_t adr, uint16_t ind)
+uint32_t REFUsolRS485ReceiverClass::getLastUpdate(size_t inverter)
 {
-    if (ind == 0) {
-        computeTelegram(adr, false, RequestPWE, 1193, 0);
-    } else {
-        if (ind > 4) ind = 4;
-        computeTelegram(adr, false, RequestPWE, 92, ind);
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (inverter >= _inverters.size()) {
+        return 0;
     }
-}
-
-void REFUsolRS485ReceiverClass::getFehlercode(uint8_t adr)
-{
-    computeTelegram(adr, false, RequestPWE, 500, 0);
-}
-
-void REFUsolRS485ReceiverClass::getActualStatus(uint8_t adr)
-{
-    computeTelegram(adr, false, RequestPWE, 501, 0);
-}
-
-void REFUsolRS485ReceiverClass::getPassword(uint8_t adr)
-{
-    computeTelegram(adr, false, RequestPWE, 2000, 0);
-}
-
-bool REFUsolRS485ReceiverClass::isDataValid()
-{
-    if ((millis() - getLastUpdate()) / 1000 > Configuration.get().REFUsol.PollInterval * 5) {
-        return false;
-    }
-    return true;
+    return _inverters[inverter].lastUpdate;
 }
 
 uint32_t REFUsolRS485ReceiverClass::getLastUpdate()
 {
-    return _lastPoll;
-}
-
-/*
- * setLastUpdate
- * This function is called every time a new ve.direct frame was read.
- */
-void REFUsolRS485ReceiverClass::setLastUpdate()
-{
-    _lastPoll = millis();
+    std::lock_guard<std::mutex> lock(_mutex);
+    uint32_t lastUpdate = 0;
+    for (auto const& inverter : _inverters) {
+        lastUpdate = std::max(lastUpdate, inverter.lastUpdate);
+    }
+    return lastUpdate;
 }
 
 template <typename T>
@@ -1165,11 +913,22 @@ void addDcValue(JsonVariant& root, std::string const& name,
     jsonValue["d"] = precision;
 }
 
-void REFUsolRS485ReceiverClass::generateJsonResponse(JsonVariant& root)
+void REFUsolRS485ReceiverClass::generateJsonResponse(JsonVariant& root, size_t inverter)
 {
+    // the JSON is built from a copy, the loop task keeps updating the frame
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (inverter >= _inverters.size()) {
+        return;
+    }
+    uint8_t const adr = _inverters[inverter].adr;
+    uint32_t const lastUpdate = _inverters[inverter].lastUpdate;
+    REFUsolStruct const Frame = _inverters[inverter].frame;
+    lock.unlock();
+
     // device info
-    root["data_age"] = (millis() - getLastUpdate()) / 1000;
-    root["age_critical"] = !isDataValid();
+    root["data_age"] = (millis() - lastUpdate) / 1000;
+    root["age_critical"] = !isFresh(lastUpdate);
+    root["uss_address"] = adr;
     root["PID"] = "REFUsol 008K";
     root["serNo"] = Frame.serNo;
     root["firmware"] = Frame.firmware;
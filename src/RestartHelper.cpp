@@ -4,6 +4,7 @@
  */
 #include "RestartHelper.h"
 #include "Display_Graphic.h"
+#include "EnergyHistory.h"
 #include "Led_Single.h"
 #include "Led_Strip.h"
 #include <Esp.h>
@@ -24,6 +25,7 @@ void RestartHelperClass::triggerRestart()
 void RestartHelperClass::loop()
 {
     if (_rebootTask.isFirstIteration()) {
+        EnergyHistory.flush();
 #ifdef USE_LED_SINGLE
         LedSingle.turnAllOff();
 #endif
@@ -10,7 +10,8 @@
 bool SBSCanReceiver::init()
 {
     _stats->_chargeVoltage =58.4;
-    return _initialized =  BatteryCanReceiver::init("SBS");
+    return _initialized =  BatteryCanReceiver::init("SBS",
+            CanIoClass::exactStandardIds({ 0x610, 0x630, 0x640, 0x650, 0x660, 0x670 }));
 }
 
 void SBSCanReceiver::onMessage(twai_message_t rx_message)
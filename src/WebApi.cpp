@@ -7,6 +7,7 @@
 #include "MessageOutput.h"
 #include "defaults.h"
 #include <AsyncJson.h>
+#include <algorithm>
 
 WebApiClass::WebApiClass()
     : _server(HTTP_PORT)
@@ -24,6 +25,7 @@ void WebApiClass::init(Scheduler& scheduler)
     _webApiEventlog.init(_server, scheduler);
     _webApiFirmware.init(_server, scheduler);
     _webApiGridprofile.init(_server, scheduler);
+    _webApiHistory.init(_server, scheduler);
     _webApiInverter.init(_server, scheduler);
     _webApiLimit.init(_server, scheduler);
     _webApiMaintenance.init(_server, scheduler);
@@ -177,4 +179,97 @@ bool WebApiClass::sendJsonResponse(AsyncWebServerRequest* request, AsyncJsonResp
     return ret_val;
 }
 
+void WebApiClass::sendJsonStream(AsyncWebServerRequest* request, const char* endpoint, JsonStreamGenerator generator)
+{
+    try {
+        auto state = std::make_shared<JsonStreamState_t>();
+        state->endpoint = endpoint;
+        state->generator = std::move(generator);
+        state->startMicros = micros();
+        state->startFreeHeap = state->minFreeHeap = ESP.getFreeHeap();
+
+        auto response = request->beginChunkedResponse("application/json",
+            [this, state](uint8_t* buffer, size_t maxLen, size_t) -> size_t {
+                return fillJsonStream(*state, buffer, maxLen);
+            });
+
+        request->send(response);
+
+    } catch (const std::bad_alloc& bad_alloc) {
+        MessageOutput.printf("Calling %s temporarily out of resources. Reason: \"%s\".\r\n", endpoint, bad_alloc.what());
+        sendTooManyRequests(request);
+    }
+}
+
+size_t WebApiClass::fillJsonStream(JsonStreamState_t& state, uint8_t* buffer, size_t maxLen)
+{
+    size_t written = 0;
+    String& pending = state.writer.buffer();
+
+    while (written < maxLen) {
+        if (state.offset < pending.length()) {
+            size_t len = std::min(pending.length() - state.offset, maxLen - written);
+            memcpy(buffer + written, pending.c_str() + state.offset, len);
+            written += len;
+            state.offset += len;
+            continue;
+        }
+
+        pending.clear();
+        state.offset = 0;
+
+        if (state.done) { break; }
+
+        try {
+            state.done = !state.generator(state.writer, state.step++);
+        } catch (const std::bad_alloc& bad_alloc) {
+            // the header is already sent, all we can do is to stop
+            MessageOutput.printf("Calling %s temporarily out of resources. Reason: \"%s\".\r\n", state.endpoint, bad_alloc.what());
+            pending.clear();
+            state.done = true;
+        }
+
+        state.minFreeHeap = std::min(state.minFreeHeap, ESP.getFreeHeap());
+    }
+
+    state.bytes += written;
+
+    if (written == 0 && state.done && !state.recorded) {
+        state.recorded = true;
+        recordStreamProfile(state);
+    }
+
+    return written;
+}
+
+void WebApiClass::recordStreamProfile(JsonStreamState_t const& state)
+{
+    uint32_t duration = micros() - state.startMicros;
+    uint32_t heap = state.startFreeHeap - state.minFreeHeap;
+
+    std::lock_guard<std::mutex> lock(_streamProfilesMutex);
+
+    auto it = std::find_if(_streamProfiles.begin(), _streamProfiles.end(),
+        [&state](StreamProfile_t const& profile) { return strcmp(profile.endpoint, state.endpoint) == 0; });
+
+    if (it == _streamProfiles.end()) {
+        _streamProfiles.push_back({ state.endpoint, 0, 0, 0, 0, 0, 0, 0 });
+        it = std::prev(_streamProfiles.end());
+    }
+
+    it->requests++;
+    it->lastBytes = state.bytes;
+    it->maxBytes = std::max(it->maxBytes, state.bytes);
+    it->lastMicros = duration;
+    it->maxMicros = std::max(it->maxMicros, duration);
+    it->lastHeap = heap;
+    it->maxHeap = std::max(it->maxHeap, heap);
+}
+
+std::vector<WebApiClass::StreamProfile_t> WebApiClass::getStreamProfiles()
+{
+    std::lock_guard<std::mutex> lock(_streamProfilesMutex);
+    return _streamProfiles;
+}
+
 WebApiClass WebApi;
@@ -37,6 +37,7 @@ void WebApiREFUsolClass::onREFUsolStatus(AsyncWebServerRequest* request)
     root["pollinterval"] = cREFUsol.PollInterval;
     root["updatesonly"] = cREFUsol.UpdatesOnly;
     root["uss_address"] = cREFUsol.USSaddress;
+    root["uss_address_count"] = cREFUsol.USSaddressCount;
     root["baudrate"] = cREFUsol.Baudrate;
     root["parity"] = cREFUsol.Parity;
     root["verbose_logging"] = cREFUsol.VerboseLogging;
@@ -95,11 +96,23 @@ void WebApiREFUsolClass::onREFUsolAdminPost(AsyncWebServerRequest* request)
         return;
     }
 
+    uint8_t addressCount = root["uss_address_count"] | 1;
+    if (addressCount < 1 || addressCount > REFUsol_MAX_INVERTERS
+            || root["uss_address"].as<uint8_t>() + addressCount - 1 > 31) {
+        retMsg["message"] = "Number of inverters must be a number between 1 and 8, their USS addresses must not exceed 31!";
+        retMsg["code"] = WebApiError::GenericRangeError;
+        retMsg["param"]["min"] = 1;
+        retMsg["param"]["max"] = std::min(REFUsol_MAX_INVERTERS, 32 - root["uss_address"].as<uint8_t>());
+        WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+        return;
+    }
+
     auto& cREFUsol = Configuration.get().REFUsol;
     cREFUsol.Enabled = root["enabled"];
     cREFUsol.UpdatesOnly = root["updatesonly"];
     cREFUsol.PollInterval = root["pollinterval"].as<uint32_t>();
     cREFUsol.USSaddress = root["uss_address"].as<uint8_t>();
+    cREFUsol.USSaddressCount = addressCount;
     cREFUsol.Baudrate = root["baudrate"].as<uint16_t>();
     cREFUsol.Parity = root["parity"].as<REFUsol_CONFIG_T::Parity_t>();
     cREFUsol.VerboseLogging = root["verbose_logging"];
@@ -4,6 +4,8 @@
  */
 #include "WebApi_config.h"
 #include "Configuration.h"
+#include "EnergyHistory.h"
+#include "EventArchive.h"
 #include "RestartHelper.h"
 #include "Utils.h"
 #include "WebApi.h"
@@ -37,7 +39,7 @@ void WebApiConfigClass::onConfigGet(AsyncWebServerRequest* request)
     String requestFile = CONFIG_FILENAME;
     if (request->hasParam("file")) {
         String name = "/" + request->getParam("file")->value();
-        if (LittleFS.exists(name)) {
+        if (name == CONFIG_FILENAME || LittleFS.exists(name)) {
             requestFile = name;
         } else {
             request->send(404);
@@ -45,7 +47,21 @@ void WebApiConfigClass::onConfigGet(AsyncWebServerRequest* request)
         }
     }
 
-    request->send(LittleFS, requestFile, String(), true);
+    if (requestFile != CONFIG_FILENAME) {
+        request->send(LittleFS, requestFile, String(), true);
+        return;
+    }
+
+    // the configuration is stored in binary sections, the json file is
+    // generated for the download
+    AsyncResponseStream* response = request->beginResponseStream("application/json");
+    response->addHeader("Content-Disposition", "attachment; filename=\"" + requestFile.substring(1) + "\"");
+    if (!Configuration.exportJson(*response)) {
+        delete response;
+        request->send(500);
+        return;
+    }
+    request->send(response);
 }
 
 void WebApiConfigClass::onConfigDelete(AsyncWebServerRequest* request)
@@ -82,6 +98,9 @@ void WebApiConfigClass::onConfigDelete(AsyncWebServerRequest* request)
 
     WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
 
+    EnergyHistory.reset();
+    EventArchive.reset();
+    Configuration.erase();
     Utils::removeAllFiles();
     RestartHelper.triggerRestart();
 }
@@ -96,10 +115,16 @@ void WebApiConfigClass::onConfigListGet(AsyncWebServerRequest* request)
     auto& root = response->getRoot();
     auto data = root["configs"].to<JsonArray>();
 
+    // generated on download, only present as a file until it is imported
+    if (!LittleFS.exists(CONFIG_FILENAME)) {
+        data.add<JsonObject>()["name"] = String(CONFIG_FILENAME).substring(1);
+    }
+
     File rootfs = LittleFS.open("/");
     File file = rootfs.openNextFile();
     while (file) {
         if (file.isDirectory()) {
+            file = rootfs.openNextFile();
             continue;
         }
         JsonObject obj = data.add<JsonObject>();
@@ -3,15 +3,48 @@
  * Copyright (C) 2022-2024 Thomas Basler and others
  */
 #include "WebApi_eventlog.h"
+#include "EventArchive.h"
 #include "WebApi.h"
 #include <AsyncJson.h>
 #include <Hoymiles.h>
 
+namespace {
+
+constexpr char const* ArchiveLink = "/api/eventlog/archive";
+constexpr size_t EventsPerStep = 16;
+constexpr size_t DefaultPageSize = 50;
+constexpr size_t MaxPageSize = 200;
+
+AlarmMessageLocale_t getLocaleParam(AsyncWebServerRequest* request)
+{
+    AlarmMessageLocale_t locale = AlarmMessageLocale_t::EN;
+    if (request->hasParam("locale")) {
+        String s = request->getParam("locale")->value();
+        s.toLowerCase();
+        if (s == "de") {
+            locale = AlarmMessageLocale_t::DE;
+        }
+        if (s == "fr") {
+            locale = AlarmMessageLocale_t::FR;
+        }
+    }
+    return locale;
+}
+
+uint32_t getNumberParam(AsyncWebServerRequest* request, char const* name, uint32_t fallback)
+{
+    if (!request->hasParam(name)) { return fallback; }
+    return strtoul(request->getParam(name)->value().c_str(), nullptr, 10);
+}
+
+} // namespace
+
 void WebApiEventlogClass::init(AsyncWebServer& server, Scheduler& scheduler)
 {
     using std::placeholders::_1;
 
     server.on("/api/eventlog/status", HTTP_GET, std::bind(&WebApiEventlogClass::onEventlogStatus, this, _1));
+    server.on(ArchiveLink, HTTP_GET, std::bind(&WebApiEventlogClass::onEventlogArchive, this, _1));
 }
 
 void WebApiEventlogClass::onEventlogStatus(AsyncWebServerRequest* request)
@@ -23,18 +56,7 @@ void WebApiEventlogClass::onEventlogStatus(AsyncWebServerRequest* request)
     AsyncJsonResponse* response = new AsyncJsonResponse();
     auto& root = response->getRoot();
     auto serial = WebApi.parseSerialFromRequest(request);
-
-    AlarmMessageLocale_t locale = AlarmMessageLocale_t::EN;
-    if (request->hasParam("locale")) {
-        String s = request->getParam("locale")->value();
-        s.toLowerCase();
-        if (s == "de") {
-            locale = AlarmMessageLocale_t::DE;
-        }
-        if (s == "fr") {
-            locale = AlarmMessageLocale_t::FR;
-        }
-    }
+    auto locale = getLocaleParam(request);
 
     auto inv = Hoymiles.getInverterBySerial(serial);
 
@@ -59,3 +81,65 @@ void WebApiEventlogClass::onEventlogStatus(AsyncWebServerRequest* request)
 
     WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
 }
+
+// /api/eventlog/archive?inv=<serial>&page=0&size=50[&id=<message id>][&from=<unix time>][&to=<unix time>][&active=1]
+void WebApiEventlogClass::onEventlogArchive(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentialsReadonly(request)) {
+        return;
+    }
+
+    auto serial = WebApi.parseSerialFromRequest(request);
+    if (serial == 0) {
+        return request->send(400, "text/plain", "inv invalid");
+    }
+
+    auto locale = getLocaleParam(request);
+
+    EventArchiveClass::Filter_t filter;
+    filter.from = getNumberParam(request, "from", 0);
+    filter.to = getNumberParam(request, "to", UINT32_MAX);
+    filter.activeOnly = getNumberParam(request, "active", 0) != 0;
+    if (request->hasParam("id")) {
+        filter.messageId = getNumberParam(request, "id", 0);
+    }
+
+    size_t size = getNumberParam(request, "size", DefaultPageSize);
+    if (size == 0 || size > MaxPageSize) {
+        return request->send(400, "text/plain", "size invalid");
+    }
+    size_t page = getNumberParam(request, "page", 0);
+
+    size_t offset = page * size;
+    size_t sent = 0;
+    std::vector<EventArchiveClass::Event_t> events;
+
+    // the texts are looked up while streaming, the archive only keeps the ids
+    WebApi.sendJsonStream(request, ArchiveLink, [=](JsonStreamWriter& writer, size_t step) mutable -> bool {
+        size_t total = EventArchive.query(serial, filter, offset + sent, std::min(EventsPerStep, size - sent), events);
+
+        if (step == 0) {
+            writer.beginObject();
+            writer.add("page", page);
+            writer.add("size", size);
+            writer.add("total", total);
+            writer.beginArray("events");
+        }
+
+        for (auto const& event : events) {
+            writer.beginObject();
+            writer.add("message_id", event.messageId);
+            writer.add("message", AlarmLogParser::getMessage(event.messageId, event.messageType, locale));
+            writer.add("start_time", event.startTime);
+            writer.add("end_time", event.endTime);
+            writer.endObject();
+        }
+        sent += events.size();
+
+        if (events.size() == EventsPerStep && sent < size) { return true; }
+
+        writer.endArray();
+        writer.endObject();
+        return false;
+    });
+}
@@ -89,6 +89,9 @@ void WebApiFirmwareClass::onFirmwareUpdateUpload(AsyncWebServerRequest* request,
             Update.printError(Serial);
             return request->send(400, "text/plain", "Could not end OTA");
         }
+
+        // the new firmware imports the json file, its binary sections may differ
+        Configuration.writeJson();
     } else {
         return;
     }
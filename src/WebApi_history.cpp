@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "WebApi_history.h"
+#include "EnergyHistory.h"
+#include "WebApi.h"
+#include <ctime>
+
+namespace {
+
+constexpr char const* HttpLink = "/api/history/data";
+constexpr size_t EntriesPerStep = 16;
+
+// range returned if the request does not name one
+constexpr std::array<uint32_t, EnergyHistoryClass::TierCount> DefaultSpans = {
+    86400, // minute: one day
+    7 * 86400, // hour: one week
+    365 * 86400, // day: one year
+    UINT32_MAX // month: everything
+};
+
+uint32_t getTimeParam(AsyncWebServerRequest* request, char const* name, uint32_t fallback)
+{
+    if (!request->hasParam(name)) { return fallback; }
+    return strtoul(request->getParam(name)->value().c_str(), nullptr, 10);
+}
+
+} // namespace
+
+void WebApiHistoryClass::init(AsyncWebServer& server, Scheduler& scheduler)
+{
+    using std::placeholders::_1;
+
+    server.on(HttpLink, HTTP_GET, std::bind(&WebApiHistoryClass::onHistoryData, this, _1));
+}
+
+// /api/history/data?tier=hour&from=<unix time>&to=<unix time>
+void WebApiHistoryClass::onHistoryData(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentialsReadonly(request)) {
+        return;
+    }
+
+    auto tier = EnergyHistoryClass::Tier::Hour;
+    if (request->hasParam("tier")
+            && !EnergyHistoryClass::getTierByName(request->getParam("tier")->value().c_str(), tier)) {
+        return request->send(400, "text/plain", "tier invalid");
+    }
+
+    uint32_t span = DefaultSpans[static_cast<size_t>(tier)];
+    uint32_t to = getTimeParam(request, "to", time(nullptr) + 1);
+    uint32_t from = getTimeParam(request, "from", (to > span) ? to - span : 0);
+
+    EnergyHistoryClass::Cursor_t cursor = { tier, from, to };
+    std::vector<EnergyHistoryClass::Entry_t> entries;
+
+    // a few records per step, the query continues where the last one stopped
+    WebApi.sendJsonStream(request, HttpLink, [cursor, entries](JsonStreamWriter& writer, size_t step) mutable -> bool {
+        if (step == 0) {
+            writer.beginObject();
+            writer.add("tier", EnergyHistoryClass::getTierName(cursor.tier));
+            writer.add("from", cursor.from);
+            writer.add("to", cursor.to);
+
+            writer.beginArray("fields");
+            writer.add(nullptr, "time");
+            writer.add(nullptr, "battery_soc");
+            writer.add(nullptr, "battery_power");
+            for (uint8_t c = 0; c < EnergyHistoryClass::ChannelCount; ++c) {
+                writer.add(nullptr, EnergyHistoryClass::getChannelName(c));
+            }
+            writer.endArray();
+
+            writer.beginArray("records");
+            return true;
+        }
+
+        size_t count = EnergyHistory.read(cursor, entries, EntriesPerStep);
+
+        for (auto const& entry : entries) {
+            bool battery = entry.valid & EnergyHistoryClass::BatteryValid;
+
+            writer.beginArray();
+            writer.add(nullptr, entry.time);
+
+            if (battery && entry.soc != EnergyHistoryClass::SocUnknown) {
+                writer.add(nullptr, entry.soc);
+            } else {
+                writer.addNull(nullptr);
+            }
+
+            if (battery) {
+                writer.add(nullptr, entry.batteryPower);
+            } else {
+                writer.addNull(nullptr);
+            }
+
+            for (uint8_t c = 0; c < EnergyHistoryClass::ChannelCount; ++c) {
+                if (entry.valid & (1 << c)) {
+                    writer.add(nullptr, entry.energy[c]);
+                } else {
+                    writer.addNull(nullptr);
+                }
+            }
+
+            writer.endArray();
+        }
+
+        if (count == EntriesPerStep) { return true; }
+
+        writer.endArray();
+        writer.endObject();
+        return false;
+    });
+}
@@ -4,7 +4,9 @@
  */
 #include "WebApi_inverter.h"
 #include "Configuration.h"
+#include "EventArchive.h"
 #include "MqttHandleHass.h"
+#include "MqttSettings.h"
 #include "SunPosition.h"
 #include "WebApi.h"
 #include "WebApi_errors.h"
@@ -148,6 +150,7 @@ void WebApiInverterClass::onInverterAdd(AsyncWebServerRequest* request)
         for (uint8_t c = 0; c < INV_MAX_CHAN_COUNT; c++) {
             inv->Statistics()->setStringMaxPower(c, inverter->channel[c].MaxChannelPower);
         }
+        inv->notifyStatisticsUpdate();
     }
 
 #ifdef USE_HASS
@@ -246,8 +249,13 @@ void WebApiInverterClass::onInverterEdit(AsyncWebServerRequest* request)
 
     std::shared_ptr<InverterAbstract> inv = Hoymiles.getInverterBySerial(old_serial);
 
+    if (new_serial != old_serial) {
+        EventArchive.remove(old_serial);
+    }
+
     if (inv != nullptr && new_serial != old_serial) {
         // Valid inverter exists but serial changed --> remove it and insert new one
+        MqttSettings.removeDevice(inv->serialString());
         Hoymiles.removeInverterBySerial(old_serial);
         inv = Hoymiles.addInverter(inverter.Name, inverter.Serial);
     } else if (inv != nullptr && new_serial == old_serial) {
@@ -270,6 +278,8 @@ void WebApiInverterClass::onInverterEdit(AsyncWebServerRequest* request)
             inv->Statistics()->setStringMaxPower(c, inverter.channel[c].MaxChannelPower);
             inv->Statistics()->setChannelFieldOffset(TYPE_DC, static_cast<ChannelNum_t>(c), FLD_YT, inverter.channel[c].YieldTotalOffset);
         }
+        // the totals depend on Poll_Enable_Day/Night and the string max power
+        inv->notifyStatisticsUpdate();
     }
 
 #ifdef USE_HASS
@@ -308,7 +318,13 @@ void WebApiInverterClass::onInverterDelete(AsyncWebServerRequest* request)
     uint8_t inverter_id = root["id"].as<uint8_t>();
     INVERTER_CONFIG_T& inverter = Configuration.get().Inverter[inverter_id];
 
+    auto inv = Hoymiles.getInverterBySerial(inverter.Serial);
+    if (inv != nullptr) {
+        MqttSettings.removeDevice(inv->serialString());
+    }
+
     Hoymiles.removeInverterBySerial(inverter.Serial);
+    EventArchive.remove(inverter.Serial);
 
     Configuration.deleteInverterById(inverter_id);
 
@@ -55,6 +55,9 @@ void WebApiMqttClass::onMqttStatus(AsyncWebServerRequest* request)
     root["client_cert_info"] = getTlsCertInfo(cMqtt.Tls.ClientCert);
     root["lwt_topic"] = String(cMqtt.Topic) + cMqtt.Lwt.Topic;
     root["publish_interval"] = cMqtt.PublishInterval;
+    root["refresh_interval"] = cMqtt.RefreshInterval;
+    root["json_payload"] = cMqtt.JsonPayload;
+    root["queue_budget"] = cMqtt.QueueBudget;
     root["clean_session"] = cMqtt.CleanSession;
 #ifdef USE_HASS
     root["hass_enabled"] = cMqtt.Hass.Enabled;
@@ -65,6 +68,14 @@ void WebApiMqttClass::onMqttStatus(AsyncWebServerRequest* request)
 #endif
     root["verbose_logging"] = MqttSettings.getVerboseLogging();
 
+    auto const queue = MqttSettings.getQueueStats();
+    root["queue_messages"] = queue.messages;
+    root["queue_bytes"] = queue.bytes;
+    root["queue_peak_bytes"] = queue.peakBytes;
+    root["queue_coalesced"] = queue.coalesced;
+    root["queue_dropped_qos0"] = queue.droppedQos0;
+    root["queue_dropped_qos12"] = queue.droppedQos12;
+
     WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
 }
 
@@ -97,6 +108,9 @@ void WebApiMqttClass::onMqttAdminGet(AsyncWebServerRequest* request)
     root["lwt_offline"] = cMqtt.Lwt.Value_Offline;
     root["lwt_qos"] = cMqtt.Lwt.Qos;
     root["publish_interval"] = cMqtt.PublishInterval;
+    root["refresh_interval"] = cMqtt.RefreshInterval;
+    root["json_payload"] = cMqtt.JsonPayload;
+    root["queue_budget"] = cMqtt.QueueBudget;
     root["clean_session"] = cMqtt.CleanSession;
 #ifdef USE_HASS
     root["hass_enabled"] = cMqtt.Hass.Enabled;
@@ -274,6 +288,26 @@ void WebApiMqttClass::onMqttAdminPost(AsyncWebServerRequest* request)
             return;
         }
 
+        // optional, older web applications do not send these settings
+        if (root["refresh_interval"].is<uint32_t>() && root["refresh_interval"].as<uint32_t>() > 86400) {
+            retMsg["message"] = "Refresh interval must be a number between 0 and 86400!";
+            retMsg["code"] = WebApiError::MqttRefreshInterval;
+            retMsg["param"]["min"] = 0;
+            retMsg["param"]["max"] = 86400;
+            WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+            return;
+        }
+
+        if (root["queue_budget"].is<uint32_t>()
+                && (root["queue_budget"].as<uint32_t>() < 2048 || root["queue_budget"].as<uint32_t>() > 262144)) {
+            retMsg["message"] = "Queue budget must be a number between 2048 and 262144!";
+            retMsg["code"] = WebApiError::MqttQueueBudget;
+            retMsg["param"]["min"] = 2048;
+            retMsg["param"]["max"] = 262144;
+            WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+            return;
+        }
+
 #ifdef USE_HASS
         if (root["hass_enabled"].as<bool>()) {
             if (root["hass_topic"].as<String>().length() > MQTT_MAX_TOPIC_STRLEN) {
@@ -313,6 +347,9 @@ void WebApiMqttClass::onMqttAdminPost(AsyncWebServerRequest* request)
     strlcpy(cMqtt.Lwt.Value_Offline, root["lwt_offline"].as<String>().c_str(), sizeof(cMqtt.Lwt.Value_Offline));
     cMqtt.Lwt.Qos = root["lwt_qos"].as<uint8_t>();
     cMqtt.PublishInterval = root["publish_interval"].as<uint32_t>();
+    cMqtt.RefreshInterval = root["refresh_interval"] | cMqtt.RefreshInterval;
+    cMqtt.JsonPayload = root["json_payload"] | cMqtt.JsonPayload;
+    cMqtt.QueueBudget = root["queue_budget"] | cMqtt.QueueBudget;
     cMqtt.CleanSession = root["clean_session"];
 #ifdef USE_HASS
     cMqtt.Hass.Enabled = root["hass_enabled"];
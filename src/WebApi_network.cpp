@@ -4,11 +4,13 @@
  */
 #include "WebApi_network.h"
 #include "Configuration.h"
+#include "MessageOutput.h"
 #include "NetworkSettings.h"
 #include "WebApi.h"
 #include "WebApi_errors.h"
 #include "helper.h"
 #include <AsyncJson.h>
+#include <algorithm>
 
 void WebApiNetworkClass::init(AsyncWebServer& server, Scheduler& scheduler)
 {
@@ -70,6 +72,7 @@ void WebApiNetworkClass::onNetworkAdminGet(AsyncWebServerRequest* request)
     root["password"] = config.WiFi.Password;
     root["aptimeout"] = config.WiFi.ApTimeout;
     root["mdnsenabled"] = config.Mdns.Enabled;
+    root["loglevel"] = config.Logging.Level;
 
 #ifdef USE_SYSLOG
     root["syslogenabled"] = config.Syslog.Enabled;
@@ -224,6 +227,8 @@ void WebApiNetworkClass::onNetworkAdminPost(AsyncWebServerRequest* request)
     config.WiFi.Dhcp = root["dhcp"] | true;
     config.WiFi.ApTimeout = root["aptimeout"].as<uint32_t>();
     config.Mdns.Enabled = root["mdnsenabled"] | false;
+    config.Logging.Level = std::min<uint8_t>(root["loglevel"] | config.Logging.Level,
+            static_cast<uint8_t>(MessageOutputClass::Level::Verbose));
 
 #ifdef USE_SYSLOG
     config.Syslog.Enabled = root["syslogenabled"];
@@ -245,6 +250,8 @@ void WebApiNetworkClass::onNetworkAdminPost(AsyncWebServerRequest* request)
 
     WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
 
+    MessageOutput.setLevel(static_cast<MessageOutputClass::Level>(config.Logging.Level));
+
     NetworkSettings.enableAdminMode();
     NetworkSettings.applyConfig();
 }
@@ -10,6 +10,7 @@
 #include "MqttHandlePowerLimiterHass.h"
 #include "MqttHandleVedirectHass.h"
 #include "PowerLimiter.h"
+#include "PowerLimiterLatency.h"
 #include "WebApi.h"
 #include "helper.h"
 #include "WebApi_errors.h"
@@ -22,6 +23,8 @@ void WebApiPowerLimiterClass::init(AsyncWebServer& server, Scheduler& scheduler)
     server.on("/api/powerlimiter/config", HTTP_GET, std::bind(&WebApiPowerLimiterClass::onAdminGet, this, _1));
     server.on("/api/powerlimiter/config", HTTP_POST, std::bind(&WebApiPowerLimiterClass::onAdminPost, this, _1));
     server.on("/api/powerlimiter/metadata", HTTP_GET, std::bind(&WebApiPowerLimiterClass::onMetaData, this, _1));
+    server.on("/api/powerlimiter/latency", HTTP_GET, std::bind(&WebApiPowerLimiterClass::onLatencyGet, this, _1));
+    server.on("/api/powerlimiter/latency/reset", HTTP_POST, std::bind(&WebApiPowerLimiterClass::onLatencyReset, this, _1));
 }
 
 void WebApiPowerLimiterClass::onStatus(AsyncWebServerRequest* request)
@@ -168,3 +171,30 @@ void WebApiPowerLimiterClass::onAdminPost(AsyncWebServerRequest* request)
     MqttHandlePowerLimiterHass.forceUpdate();
 #endif
 }
+
+void WebApiPowerLimiterClass::onLatencyGet(AsyncWebServerRequest* request)
+{
+    AsyncJsonResponse* response = new AsyncJsonResponse();
+    auto root = response->getRoot().as<JsonObject>();
+
+    PowerLimiterLatency.toJson(root);
+
+    WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+}
+
+void WebApiPowerLimiterClass::onLatencyReset(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentials(request)) {
+        return;
+    }
+
+    PowerLimiterLatency.clear();
+
+    AsyncJsonResponse* response = new AsyncJsonResponse();
+    auto& retMsg = response->getRoot();
+    retMsg["type"] = "success";
+    retMsg["message"] = "Latency statistics cleared!";
+    retMsg["code"] = WebApiError::GenericSuccess;
+
+    WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+}
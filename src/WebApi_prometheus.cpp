@@ -1,4 +1,3 @@
-
 // SPDX-License-Identifier: GPL-2.0-or-later
 /*
  * Copyright (C) 2022-2024 Thomas Basler and others
@@ -6,13 +5,23 @@
 #ifdef USE_PROMETHEUS
 
 #include "WebApi_prometheus.h"
+#include "Battery.h"
 #include "Configuration.h"
+#include "Huawei_can.h"
+#include "MeanWell_can.h"
 #include "MessageOutput.h"
 #include "NetworkSettings.h"
+#include "PowerLimiter.h"
+#include "PowerMeter.h"
+#include "VictronMppt.h"
 #include "WebApi.h"
 #include <Hoymiles.h>
+#include <cstdarg>
 #include "__compiled_constants.h"
 
+// HELP and TYPE lines are plain string literals and therefore stay in flash
+#define METRIC_HEADER(name, help, type) "# HELP " name " " help "\n# TYPE " name " " type "\n"
+
 void WebApiPrometheusClass::init(AsyncWebServer& server, Scheduler& scheduler)
 {
     using std::placeholders::_1;
@@ -27,159 +36,531 @@ void WebApiPrometheusClass::onPrometheusMetricsGet(AsyncWebServerRequest* reques
     }
 
     try {
-        auto stream = request->beginResponseStream("text/plain; charset=utf-8", 4096 * INV_MAX_COUNT); // TODO(helge) check if this calculation is correct
+        auto state = std::make_shared<MetricsState_t>();
 
-        stream->print("# HELP opendtu_build Build info\n");
-        stream->print("# TYPE opendtu_build gauge\n");
-        stream->printf("opendtu_build{name=\"%s\",id=\"%s\",version=\"%d.%d.%d\"} 1\n",
-            NetworkSettings.getHostname().c_str(), __COMPILED_GIT_HASH__, CONFIG_VERSION >> 24 & 0xff, CONFIG_VERSION >> 16 & 0xff, CONFIG_VERSION >> 8 & 0xff);
+        auto response = request->beginChunkedResponse("text/plain; charset=utf-8",
+            [this, state](uint8_t* buffer, size_t maxLen, size_t) -> size_t {
+                return fillResponse(*state, buffer, maxLen);
+            });
+
+        response->addHeader("Cache-Control", "no-cache");
+        request->send(response);
+
+    } catch (std::bad_alloc& bad_alloc) {
+        MessageOutput.printf("Calling /api/prometheus/metrics has temporarily run out of resources. Reason: \"%s\".\r\n", bad_alloc.what());
 
-        stream->print("# HELP opendtu_platform Platform info\n");
-        stream->print("# TYPE opendtu_platform gauge\n");
-        stream->printf("opendtu_platform{arch=\"%s\",mac=\"%s\"} 1\n", ESP.getChipModel(), NetworkSettings.macAddress().c_str());
+        WebApi.sendTooManyRequests(request);
+    }
+}
+
+size_t WebApiPrometheusClass::fillResponse(MetricsState_t& state, uint8_t* buffer, size_t maxLen)
+{
+    size_t written = 0;
+
+    while (written < maxLen) {
+        if (state.pendingLength == 0) {
+            if (state.lineQueued) {
+                state.pending = state.line;
+                state.pendingLength = state.lineLength;
+                state.lineQueued = false;
+                continue;
+            }
 
-        stream->print("# HELP opendtu_uptime Uptime in seconds\n");
-        stream->print("# TYPE opendtu_uptime counter\n");
-        stream->printf("opendtu_uptime %lld\n", esp_timer_get_time() / 1000000);
+            if (!generateNext(state)) {
+                break;
+            }
+            continue;
+        }
 
-        stream->print("# HELP opendtu_heap_size System memory size\n");
-        stream->print("# TYPE opendtu_heap_size gauge\n");
-        stream->printf("opendtu_heap_size %" PRIu32 "\n", ESP.getHeapSize());
+        size_t len = std::min(state.pendingLength, maxLen - written);
+        memcpy(buffer + written, state.pending, len);
+        written += len;
+        state.pending += len;
+        state.pendingLength -= len;
+    }
 
-        stream->print("# HELP opendtu_free_heap_size System free memory\n");
-        stream->print("# TYPE opendtu_free_heap_size gauge\n");
-        stream->printf("opendtu_free_heap_size %" PRIu32 "\n", ESP.getFreeHeap());
+    // returning 0 finishes the chunked response
+    return written;
+}
 
-        stream->print("# HELP opendtu_biggest_heap_block Biggest free heap block\n");
-        stream->print("# TYPE opendtu_biggest_heap_block gauge\n");
-        stream->printf("opendtu_biggest_heap_block %" PRIu32 "\n", ESP.getMaxAllocHeap());
+bool WebApiPrometheusClass::emit(MetricsState_t& state, const char* header, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(state.line, sizeof(state.line), format, args);
+    va_end(args);
 
-        stream->print("# HELP opendtu_heap_min_free Minimum free memory since boot\n");
-        stream->print("# TYPE opendtu_heap_min_free gauge\n");
-        stream->printf("opendtu_heap_min_free %" PRIu32 "\n", ESP.getMinFreeHeap());
+    state.lineLength = std::min(static_cast<size_t>(std::max(len, 0)), sizeof(state.line) - 1);
 
-        stream->print("# HELP wifi_rssi WiFi RSSI\n");
-        stream->print("# TYPE wifi_rssi gauge\n");
-        stream->printf("wifi_rssi %" PRId8 "\n", WiFi.RSSI());
+    if (header != nullptr) {
+        state.pending = header;
+        state.pendingLength = strlen(header);
+        state.lineQueued = true;
+    } else {
+        state.pending = state.line;
+        state.pendingLength = state.lineLength;
+        state.lineQueued = false;
+    }
+    return true;
+}
 
-        stream->print("# HELP wifi_station WiFi Station info\n");
-        stream->print("# TYPE wifi_station gauge\n");
-        stream->printf("wifi_station{bssid=\"%s\"} 1\n", WiFi.BSSIDstr().c_str());
+void WebApiPrometheusClass::nextSection(MetricsState_t& state, Section_t section)
+{
+    state.section = section;
+    state.step = 0;
+    state.index = 0;
+    state.type = 0;
+    state.channel = 0;
+    state.field = 0;
+}
 
-        for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
-            auto inv = Hoymiles.getInverterByPos(i);
+bool WebApiPrometheusClass::generateNext(MetricsState_t& state)
+{
+    while (state.section != Section_t::Done) {
+        bool emitted = false;
 
-            String serial = inv->serialString();
-            const char* name = inv->name();
-            if (i == 0) {
-                stream->print("# HELP opendtu_last_update last update from inverter in s\n");
-                stream->print("# TYPE opendtu_last_update gauge\n");
-            }
-            stream->printf("opendtu_last_update{serial=\"%s\",unit=\"%" PRIu8 "\",name=\"%s\"} %" PRIu32 "\n",
-                serial.c_str(), i, name, inv->Statistics()->getLastUpdate() / 1000);
+        switch (state.section) {
+        case Section_t::System:
+            emitted = generateSystem(state);
+            break;
+        case Section_t::Inverters:
+            emitted = generateInverter(state);
+            break;
+        case Section_t::Battery:
+            emitted = generateBattery(state);
+            break;
+        case Section_t::Mppt:
+            emitted = generateMppt(state);
+            break;
+        case Section_t::PowerMeter:
+            emitted = generatePowerMeter(state);
+            break;
+        case Section_t::Charger:
+            emitted = generateCharger(state);
+            break;
+        case Section_t::PowerLimiter:
+            emitted = generatePowerLimiter(state);
+            break;
+        default:
+            state.section = Section_t::Done;
+            break;
+        }
 
-            if (i == 0) {
-                stream->print("# HELP opendtu_inverter_limit_relative current relative limit of the inverter\n");
-                stream->print("# TYPE opendtu_inverter_limit_relative gauge\n");
-            }
-            stream->printf("opendtu_inverter_limit_relative{serial=\"%s\",unit=\"%" PRIu8 "\",name=\"%s\"} %f\n",
-                serial.c_str(), i, name, inv->SystemConfigPara()->getLimitPercent() / 100.0);
-
-            if (inv->DevInfo()->getMaxPower() > 0) {
-                if (i == 0) {
-                    stream->print("# HELP opendtu_inverter_limit_absolute current relative limit of the inverter\n");
-                    stream->print("# TYPE opendtu_inverter_limit_absolute gauge\n");
-                }
-                stream->printf("opendtu_inverter_limit_absolute{serial=\"%s\",unit=\"%" PRIu8 "\",name=\"%s\"} %f\n",
-                    serial.c_str(), i, name, inv->SystemConfigPara()->getLimitPercent() * inv->DevInfo()->getMaxPower() / 100.0);
+        if (emitted) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool WebApiPrometheusClass::generateSystem(MetricsState_t& state)
+{
+    switch (state.step++) {
+    case 0:
+        return emit(state, METRIC_HEADER("opendtu_build", "Build info", "gauge"),
+            "opendtu_build{name=\"%s\",id=\"%s\",version=\"%d.%d.%d\"} 1\n",
+            NetworkSettings.getHostname().c_str(), __COMPILED_GIT_HASH__, CONFIG_VERSION >> 24 & 0xff, CONFIG_VERSION >> 16 & 0xff, CONFIG_VERSION >> 8 & 0xff);
+    case 1:
+        return emit(state, METRIC_HEADER("opendtu_platform", "Platform info", "gauge"),
+            "opendtu_platform{arch=\"%s\",mac=\"%s\"} 1\n", ESP.getChipModel(), NetworkSettings.macAddress().c_str());
+    case 2:
+        return emit(state, METRIC_HEADER("opendtu_uptime", "Uptime in seconds", "counter"),
+            "opendtu_uptime %lld\n", esp_timer_get_time() / 1000000);
+    case 3:
+        return emit(state, METRIC_HEADER("opendtu_heap_size", "System memory size", "gauge"),
+            "opendtu_heap_size %" PRIu32 "\n", ESP.getHeapSize());
+    case 4:
+        return emit(state, METRIC_HEADER("opendtu_free_heap_size", "System free memory", "gauge"),
+            "opendtu_free_heap_size %" PRIu32 "\n", ESP.getFreeHeap());
+    case 5:
+        return emit(state, METRIC_HEADER("opendtu_biggest_heap_block", "Biggest free heap block", "gauge"),
+            "opendtu_biggest_heap_block %" PRIu32 "\n", ESP.getMaxAllocHeap());
+    case 6:
+        return emit(state, METRIC_HEADER("opendtu_heap_min_free", "Minimum free memory since boot", "gauge"),
+            "opendtu_heap_min_free %" PRIu32 "\n", ESP.getMinFreeHeap());
+    case 7:
+        return emit(state, METRIC_HEADER("wifi_rssi", "WiFi RSSI", "gauge"),
+            "wifi_rssi %" PRId8 "\n", WiFi.RSSI());
+    case 8:
+        return emit(state, METRIC_HEADER("wifi_station", "WiFi Station info", "gauge"),
+            "wifi_station{bssid=\"%s\"} 1\n", WiFi.BSSIDstr().c_str());
+    default:
+        nextSection(state, Section_t::Inverters);
+        return false;
+    }
+}
+
+bool WebApiPrometheusClass::generateInverter(MetricsState_t& state)
+{
+    const uint8_t i = state.index;
+    auto inv = (i < Hoymiles.getNumInverters()) ? Hoymiles.getInverterByPos(i) : nullptr;
+    if (inv == nullptr) {
+        nextSection(state, Section_t::Battery);
+        return false;
+    }
+
+    auto nextInverter = [&state]() {
+        state.index++;
+        state.step = 0;
+        state.type = 0;
+        state.channel = 0;
+        state.field = 0;
+    };
+
+    switch (state.step) {
+    case 0:
+        state.step++;
+        return emit(state, (i == 0) ? METRIC_HEADER("opendtu_last_update", "last update from inverter in s", "gauge") : nullptr,
+            "opendtu_last_update{serial=\"%s\",unit=\"%" PRIu8 "\",name=\"%s\"} %" PRIu32 "\n",
+            inv->serialString().c_str(), i, inv->name(), inv->Statistics()->getLastUpdate() / 1000);
+    case 1:
+        state.step++;
+        return emit(state, (i == 0) ? METRIC_HEADER("opendtu_inverter_limit_relative", "current relative limit of the inverter", "gauge") : nullptr,
+            "opendtu_inverter_limit_relative{serial=\"%s\",unit=\"%" PRIu8 "\",name=\"%s\"} %f\n",
+            inv->serialString().c_str(), i, inv->name(), inv->SystemConfigPara()->getLimitPercent() / 100.0);
+    case 2:
+        state.step++;
+        if (inv->DevInfo()->getMaxPower() > 0) {
+            return emit(state, (i == 0) ? METRIC_HEADER("opendtu_inverter_limit_absolute", "current relative limit of the inverter", "gauge") : nullptr,
+                "opendtu_inverter_limit_absolute{serial=\"%s\",unit=\"%" PRIu8 "\",name=\"%s\"} %f\n",
+                inv->serialString().c_str(), i, inv->name(), inv->SystemConfigPara()->getLimitPercent() * inv->DevInfo()->getMaxPower() / 100.0);
+        }
+        return false;
+    default:
+        break;
+    }
+
+    // Loop all channels if Statistics have been updated at least once since DTU boot
+    auto stats = inv->Statistics();
+    if (stats->getLastUpdate() == 0) {
+        nextInverter();
+        return false;
+    }
+
+    constexpr uint8_t panelItems = 3;
+    constexpr uint8_t fieldCount = sizeof(_publishFields) / sizeof(_publishFields[0]);
+
+    while (state.type <= TYPE_INV) {
+        const auto t = static_cast<ChannelType_t>(state.type);
+        const auto c = static_cast<ChannelNum_t>(state.channel);
+
+        if (c >= CH_CNT) {
+            state.type++;
+            state.channel = 0;
+            state.field = 0;
+            continue;
+        }
+
+        if (!stats->hasChannel(t, c) || state.field >= panelItems + fieldCount) {
+            state.channel++;
+            state.field = 0;
+            continue;
+        }
+
+        const uint8_t item = state.field++;
+        if (item < panelItems) {
+            if (addPanelInfo(state, i, inv, t, c, item)) {
+                return true;
             }
+            continue;
+        }
 
-            // Loop all channels if Statistics have been updated at least once since DTU boot
-            if (inv->Statistics()->getLastUpdate() > 0) {
-                for (auto& t : inv->Statistics()->getChannelTypes()) {
-                    for (auto& c : inv->Statistics()->getChannelsByType(t)) {
-                        addPanelInfo(stream, serial, i, inv, t, c);
-                        for (uint8_t f = 0; f < sizeof(_publishFields) / sizeof(_publishFields[0]); f++) {
-                            if (t == TYPE_INV && _publishFields[f].field == FLD_PDC) {
-                                addField(stream, serial, i, inv, t, c, _publishFields[f].field, _metricTypes[_publishFields[f].type], "PowerDC");
-                            } else {
-                                addField(stream, serial, i, inv, t, c, _publishFields[f].field, _metricTypes[_publishFields[f].type]);
-                            }
-                        }
-                    }
-                }
+        const auto& f = _publishFields[item - panelItems];
+        if (t == TYPE_INV && f.field == FLD_PDC) {
+            if (addField(state, i, inv, t, c, f.field, _metricTypes[f.type], "PowerDC")) {
+                return true;
             }
+        } else if (addField(state, i, inv, t, c, f.field, _metricTypes[f.type])) {
+            return true;
         }
-        stream->addHeader("Cache-Control", "no-cache");
-        request->send(stream);
+    }
 
-    } catch (std::bad_alloc& bad_alloc) {
-        MessageOutput.printf("Calling /api/prometheus/metrics has temporarily run out of resources. Reason: \"%s\".\r\n", bad_alloc.what());
+    nextInverter();
+    return false;
+}
 
-        WebApi.sendTooManyRequests(request);
+bool WebApiPrometheusClass::addField(MetricsState_t& state, const uint8_t idx, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, const char* metricName, const char* channelName)
+{
+    auto stats = inv->Statistics();
+    if (!stats->hasChannelFieldValue(type, channel, fieldId)) {
+        return false;
     }
+
+    const char* chanName = (channelName == nullptr) ? stats->getChannelFieldName(type, channel, fieldId) : channelName;
+    const char* serial = inv->serialString().c_str();
+    const int digits = stats->getChannelFieldDigits(type, channel, fieldId);
+    const float value = stats->getChannelFieldValue(type, channel, fieldId);
+
+    // the header depends on the unit of the field, so it is formatted together with the value
+    if (idx == 0 && type == TYPE_AC && channel == 0) {
+        return emit(state, nullptr,
+            "# HELP opendtu_%s in %s\n# TYPE opendtu_%s %s\n"
+            "opendtu_%s{serial=\"%s\",unit=\"%" PRIu8 "\",name=\"%s\",type=\"%s\",channel=\"%d\"} %.*f\n",
+            chanName, stats->getChannelFieldUnit(type, channel, fieldId), chanName, metricName,
+            chanName, serial, idx, inv->name(), stats->getChannelTypeName(type), channel, digits, value);
+    }
+
+    return emit(state, nullptr,
+        "opendtu_%s{serial=\"%s\",unit=\"%" PRIu8 "\",name=\"%s\",type=\"%s\",channel=\"%d\"} %.*f\n",
+        chanName, serial, idx, inv->name(), stats->getChannelTypeName(type), channel, digits, value);
 }
 
-void WebApiPrometheusClass::addField(AsyncResponseStream* stream, const String& serial, const uint8_t idx, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, const char* metricName, const char* channelName)
+bool WebApiPrometheusClass::addPanelInfo(MetricsState_t& state, const uint8_t idx, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const uint8_t item)
 {
-    if (inv->Statistics()->hasChannelFieldValue(type, channel, fieldId)) {
-        const char* chanName = (channelName == nullptr) ? inv->Statistics()->getChannelFieldName(type, channel, fieldId) : channelName;
-        if (idx == 0 && type == TYPE_AC && channel == 0) {
-            stream->printf("# HELP opendtu_%s in %s\n", chanName, inv->Statistics()->getChannelFieldUnit(type, channel, fieldId));
-            stream->printf("# TYPE opendtu_%s %s\n", chanName, metricName);
-        }
-        stream->printf("opendtu_%s{serial=\"%s\",unit=\"%" PRIu8 "\",name=\"%s\",type=\"%s\",channel=\"%d\"} %s\n",
-            chanName,
-            serial.c_str(),
+    if (type != TYPE_DC) {
+        return false;
+    }
+
+    auto const& config = Configuration.get();
+
+    const bool printHelp = (idx == 0 && channel == 0);
+    const char* serial = inv->serialString().c_str();
+
+    switch (item) {
+    case 0:
+        return emit(state, printHelp ? METRIC_HEADER("opendtu_PanelInfo", "panel information", "gauge") : nullptr,
+            "opendtu_PanelInfo{serial=\"%s\",unit=\"%" PRIu8 "\",name=\"%s\",channel=\"%d\",panelname=\"%s\"} 1\n",
+            serial,
+            idx,
+            inv->name(),
+            channel,
+            config.Inverter[idx].channel[channel].Name);
+    case 1:
+        return emit(state, printHelp ? METRIC_HEADER("opendtu_MaxPower", "panel maximum output power", "gauge") : nullptr,
+            "opendtu_MaxPower{serial=\"%s\",unit=\"%d\",name=\"%s\",channel=\"%d\"} %d\n",
+            serial,
+            idx,
+            inv->name(),
+            channel,
+            config.Inverter[idx].channel[channel].MaxChannelPower);
+    case 2:
+        return emit(state, printHelp ? METRIC_HEADER("opendtu_YieldTotalOffset", "panel yield offset (for used inverters)", "gauge") : nullptr,
+            "opendtu_YieldTotalOffset{serial=\"%s\",unit=\"%" PRIu8 "\",name=\"%s\",channel=\"%d\"} %f\n",
+            serial,
             idx,
             inv->name(),
-            inv->Statistics()->getChannelTypeName(type),
             channel,
-            inv->Statistics()->getChannelFieldValueString(type, channel, fieldId).c_str());
+            config.Inverter[idx].channel[channel].YieldTotalOffset);
+    default:
+        return false;
     }
 }
 
-void WebApiPrometheusClass::addPanelInfo(AsyncResponseStream* stream, const String& serial, const uint8_t idx, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel)
+bool WebApiPrometheusClass::generateBattery(MetricsState_t& state)
 {
-    if (type != TYPE_DC) {
-        return;
+    if (!Configuration.get().Battery.Enabled) {
+        nextSection(state, Section_t::Mppt);
+        return false;
     }
 
-    auto const& config = Configuration.get();
+    auto spStats = Battery.getStats();
 
-    const bool printHelp = (idx == 0 && channel == 0);
-    if (printHelp) {
-        stream->print("# HELP opendtu_PanelInfo panel information\n");
-        stream->print("# TYPE opendtu_PanelInfo gauge\n");
-    }
-    stream->printf("opendtu_PanelInfo{serial=\"%s\",unit=\"%" PRIu8 "\",name=\"%s\",channel=\"%d\",panelname=\"%s\"} 1\n",
-        serial.c_str(),
-        idx,
-        inv->name(),
-        channel,
-        config.Inverter[idx].channel[channel].Name);
-
-    if (printHelp) {
-        stream->print("# HELP opendtu_MaxPower panel maximum output power\n");
-        stream->print("# TYPE opendtu_MaxPower gauge\n");
-    }
-    stream->printf("opendtu_MaxPower{serial=\"%s\",unit=\"%d\",name=\"%s\",channel=\"%d\"} %d\n",
-        serial.c_str(),
-        idx,
-        inv->name(),
-        channel,
-        config.Inverter[idx].channel[channel].MaxChannelPower);
-
-    if (printHelp) {
-        stream->print("# HELP opendtu_YieldTotalOffset panel yield offset (for used inverters)\n");
-        stream->print("# TYPE opendtu_YieldTotalOffset gauge\n");
-    }
-    stream->printf("opendtu_YieldTotalOffset{serial=\"%s\",unit=\"%" PRIu8 "\",name=\"%s\",channel=\"%d\"} %f\n",
-        serial.c_str(),
-        idx,
-        inv->name(),
-        channel,
-        config.Inverter[idx].channel[channel].YieldTotalOffset);
+    switch (state.step++) {
+    case 0:
+        if (!spStats->isSoCValid()) { return false; }
+        return emit(state, METRIC_HEADER("opendtu_battery_soc", "battery state of charge in %", "gauge"),
+            "opendtu_battery_soc %.*f\n", spStats->getSoCPrecision(), spStats->getSoC());
+    case 1:
+        if (!spStats->isVoltageValid()) { return false; }
+        return emit(state, METRIC_HEADER("opendtu_battery_voltage", "battery voltage in V", "gauge"),
+            "opendtu_battery_voltage %.2f\n", spStats->getVoltage());
+    case 2:
+        if (!spStats->isCurrentValid()) { return false; }
+        return emit(state, METRIC_HEADER("opendtu_battery_current", "battery charge current in A", "gauge"),
+            "opendtu_battery_current %.*f\n", spStats->getChargeCurrentPrecision(), spStats->getChargeCurrent());
+    case 3:
+        if (!spStats->isVoltageValid() || !spStats->isCurrentValid()) { return false; }
+        return emit(state, METRIC_HEADER("opendtu_battery_power", "battery charge power in W", "gauge"),
+            "opendtu_battery_power %.1f\n", spStats->getVoltage() * spStats->getChargeCurrent());
+    case 4:
+        return emit(state, METRIC_HEADER("opendtu_battery_temperature", "battery temperature in °C", "gauge"),
+            "opendtu_battery_temperature %.1f\n", spStats->getTemperature());
+    case 5:
+        if (!spStats->isDischargeCurrentLimitValid()) { return false; }
+        return emit(state, METRIC_HEADER("opendtu_battery_discharge_current_limit", "battery discharge current limit in A", "gauge"),
+            "opendtu_battery_discharge_current_limit %.1f\n", spStats->getDischargeCurrentLimit());
+    case 6:
+        return emit(state, METRIC_HEADER("opendtu_battery_data_age", "age of the battery data in s", "gauge"),
+            "opendtu_battery_data_age %" PRIu32 "\n", spStats->getAgeSeconds());
+    default:
+        nextSection(state, Section_t::Mppt);
+        return false;
+    }
+}
+
+bool WebApiPrometheusClass::generateMppt(MetricsState_t& state)
+{
+    if (!Configuration.get().Vedirect.Enabled || state.index >= VictronMppt.controllerAmount()) {
+        nextSection(state, Section_t::PowerMeter);
+        return false;
+    }
+
+    const uint8_t i = state.index;
+    auto optMpptData = VictronMppt.getData(i);
+    if (!optMpptData.has_value() || !VictronMppt.isDataValid(i)) {
+        state.index++;
+        state.step = 0;
+        return false;
+    }
+
+    auto const& mpptData = *optMpptData;
+    const char* serial = mpptData.serialNr_SER;
+
+    switch (state.step++) {
+    case 0:
+        return emit(state, (i == 0) ? METRIC_HEADER("opendtu_mppt_battery_voltage", "MPPT battery voltage in V", "gauge") : nullptr,
+            "opendtu_mppt_battery_voltage{serial=\"%s\",unit=\"%" PRIu8 "\"} %.3f\n",
+            serial, i, mpptData.batteryVoltage_V_mV / 1000.0);
+    case 1:
+        return emit(state, (i == 0) ? METRIC_HEADER("opendtu_mppt_battery_current", "MPPT battery current in A", "gauge") : nullptr,
+            "opendtu_mppt_battery_current{serial=\"%s\",unit=\"%" PRIu8 "\"} %.3f\n",
+            serial, i, mpptData.batteryCurrent_I_mA / 1000.0);
+    case 2:
+        return emit(state, (i == 0) ? METRIC_HEADER("opendtu_mppt_battery_power", "MPPT battery output power in W", "gauge") : nullptr,
+            "opendtu_mppt_battery_power{serial=\"%s\",unit=\"%" PRIu8 "\"} %" PRId16 "\n",
+            serial, i, mpptData.batteryOutputPower_W);
+    case 3:
+        return emit(state, (i == 0) ? METRIC_HEADER("opendtu_mppt_panel_voltage", "MPPT panel voltage in V", "gauge") : nullptr,
+            "opendtu_mppt_panel_voltage{serial=\"%s\",unit=\"%" PRIu8 "\"} %.3f\n",
+            serial, i, mpptData.panelVoltage_VPV_mV / 1000.0);
+    case 4:
+        return emit(state, (i == 0) ? METRIC_HEADER("opendtu_mppt_panel_power", "MPPT panel power in W", "gauge") : nullptr,
+            "opendtu_mppt_panel_power{serial=\"%s\",unit=\"%" PRIu8 "\"} %" PRIu16 "\n",
+            serial, i, mpptData.panelPower_PPV_W);
+    case 5:
+        return emit(state, (i == 0) ? METRIC_HEADER("opendtu_mppt_yield_day", "MPPT yield today in Wh", "counter") : nullptr,
+            "opendtu_mppt_yield_day{serial=\"%s\",unit=\"%" PRIu8 "\"} %" PRIu32 "\n",
+            serial, i, mpptData.yieldToday_H20_Wh);
+    case 6:
+        return emit(state, (i == 0) ? METRIC_HEADER("opendtu_mppt_yield_total", "MPPT yield total in Wh", "counter") : nullptr,
+            "opendtu_mppt_yield_total{serial=\"%s\",unit=\"%" PRIu8 "\"} %" PRIu32 "\n",
+            serial, i, mpptData.yieldTotal_H19_Wh);
+    case 7:
+        return emit(state, (i == 0) ? METRIC_HEADER("opendtu_mppt_state_of_operation", "MPPT state of operation", "gauge") : nullptr,
+            "opendtu_mppt_state_of_operation{serial=\"%s\",unit=\"%" PRIu8 "\"} %" PRIu8 "\n",
+            serial, i, mpptData.currentState_CS);
+    case 8:
+        return emit(state, (i == 0) ? METRIC_HEADER("opendtu_mppt_data_age", "age of the MPPT data in s", "gauge") : nullptr,
+            "opendtu_mppt_data_age{serial=\"%s\",unit=\"%" PRIu8 "\"} %" PRIu32 "\n",
+            serial, i, VictronMppt.getDataAgeMillis(i) / 1000);
+    default:
+        state.index++;
+        state.step = 0;
+        return false;
+    }
+}
+
+bool WebApiPrometheusClass::generatePowerMeter(MetricsState_t& state)
+{
+    if (!Configuration.get().PowerMeter.Enabled) {
+        nextSection(state, Section_t::Charger);
+        return false;
+    }
+
+    switch (state.step++) {
+    case 0:
+        return emit(state, METRIC_HEADER("opendtu_powermeter_grid_power", "grid power in W", "gauge"),
+            "opendtu_powermeter_grid_power %.1f\n", PowerMeter.getPowerTotal());
+    case 1:
+        return emit(state, METRIC_HEADER("opendtu_powermeter_house_power", "house power in W", "gauge"),
+            "opendtu_powermeter_house_power %.1f\n", PowerMeter.getHousePower());
+    case 2:
+        return emit(state, METRIC_HEADER("opendtu_powermeter_data_valid", "power meter data is valid", "gauge"),
+            "opendtu_powermeter_data_valid %d\n", PowerMeter.isDataValid() ? 1 : 0);
+    case 3:
+        return emit(state, METRIC_HEADER("opendtu_powermeter_data_age", "age of the power meter data in s", "gauge"),
+            "opendtu_powermeter_data_age %" PRIu32 "\n", static_cast<uint32_t>((millis() - PowerMeter.getLastUpdate()) / 1000));
+    default:
+        nextSection(state, Section_t::Charger);
+        return false;
+    }
+}
+
+bool WebApiPrometheusClass::generateCharger(MetricsState_t& state)
+{
+#if defined(USE_CHARGER_HUAWEI)
+    const bool enabled = Configuration.get().Huawei.Enabled;
+    const RectifierParameters_t* rp = HuaweiCan.get();
+    const float inputPower = rp->input_power;
+    const float outputPower = rp->output_power;
+    const float outputVoltage = rp->output_voltage;
+    const float outputCurrent = rp->output_current;
+    const float efficiency = rp->efficiency;
+    const float temperature = rp->output_temp;
+    const uint32_t lastUpdate = HuaweiCan.getLastUpdate();
+#elif defined(USE_CHARGER_MEANWELL)
+    const bool enabled = Configuration.get().MeanWell.Enabled;
+    const float inputPower = MeanWellCan._rp.inputPower;
+    const float outputPower = MeanWellCan._rp.outputPower;
+    const float outputVoltage = MeanWellCan._rp.outputVoltage;
+    const float outputCurrent = MeanWellCan._rp.outputCurrent;
+    const float efficiency = MeanWellCan._rp.efficiency;
+    const float temperature = MeanWellCan._rp.internalTemperature;
+    const uint32_t lastUpdate = MeanWellCan.getLastUpdate();
+#else
+    const bool enabled = false;
+    const float inputPower = 0, outputPower = 0, outputVoltage = 0, outputCurrent = 0, efficiency = 0, temperature = 0;
+    const uint32_t lastUpdate = 0;
+#endif
+
+    if (!enabled) {
+        nextSection(state, Section_t::PowerLimiter);
+        return false;
+    }
+
+    switch (state.step++) {
+    case 0:
+        return emit(state, METRIC_HEADER("opendtu_charger_input_power", "charger input power in W", "gauge"),
+            "opendtu_charger_input_power %.2f\n", inputPower);
+    case 1:
+        return emit(state, METRIC_HEADER("opendtu_charger_output_power", "charger output power in W", "gauge"),
+            "opendtu_charger_output_power %.2f\n", outputPower);
+    case 2:
+        return emit(state, METRIC_HEADER("opendtu_charger_output_voltage", "charger output voltage in V", "gauge"),
+            "opendtu_charger_output_voltage %.2f\n", outputVoltage);
+    case 3:
+        return emit(state, METRIC_HEADER("opendtu_charger_output_current", "charger output current in A", "gauge"),
+            "opendtu_charger_output_current %.2f\n", outputCurrent);
+    case 4:
+        return emit(state, METRIC_HEADER("opendtu_charger_efficiency", "charger efficiency in %", "gauge"),
+            "opendtu_charger_efficiency %.1f\n", efficiency);
+    case 5:
+        return emit(state, METRIC_HEADER("opendtu_charger_temperature", "charger temperature in °C", "gauge"),
+            "opendtu_charger_temperature %.1f\n", temperature);
+    case 6:
+        return emit(state, METRIC_HEADER("opendtu_charger_data_age", "age of the charger data in s", "gauge"),
+            "opendtu_charger_data_age %" PRIu32 "\n", static_cast<uint32_t>((millis() - lastUpdate) / 1000));
+    default:
+        nextSection(state, Section_t::PowerLimiter);
+        return false;
+    }
+}
+
+bool WebApiPrometheusClass::generatePowerLimiter(MetricsState_t& state)
+{
+    if (!Configuration.get().PowerLimiter.Enabled) {
+        nextSection(state, Section_t::Done);
+        return false;
+    }
+
+    switch (state.step++) {
+    case 0:
+        return emit(state, METRIC_HEADER("opendtu_powerlimiter_limit", "last power limit requested by the power limiter in W", "gauge"),
+            "opendtu_powerlimiter_limit %" PRId32 "\n", PowerLimiter.getLastRequestedPowerLimit());
+    case 1:
+        return emit(state, METRIC_HEADER("opendtu_powerlimiter_mode", "power limiter mode", "gauge"),
+            "opendtu_powerlimiter_mode %u\n", static_cast<unsigned>(PowerLimiter.getMode()));
+    case 2:
+        return emit(state, METRIC_HEADER("opendtu_powerlimiter_state", "power limiter state", "gauge"),
+            "opendtu_powerlimiter_state %" PRIu8 "\n", PowerLimiter.getPowerLimiterState());
+    case 3:
+        return emit(state, METRIC_HEADER("opendtu_powerlimiter_inverter_update_timeouts", "inverter updates timed out in a row", "gauge"),
+            "opendtu_powerlimiter_inverter_update_timeouts %" PRIu8 "\n", PowerLimiter.getInverterUpdateTimeouts());
+    default:
+        nextSection(state, Section_t::Done);
+        return false;
+    }
 }
 
 #endif
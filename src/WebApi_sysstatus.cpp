@@ -71,6 +71,19 @@ void WebApiSysstatusClass::onSystemStatus(AsyncWebServerRequest* request)
         task["priority"] = uxTaskPriorityGet(handle);
     }
 
+    JsonArray streams = root["json_streams"].to<JsonArray>();
+    for (auto const& profile : WebApi.getStreamProfiles()) {
+        JsonObject stream = streams.add<JsonObject>();
+        stream["endpoint"] = profile.endpoint;
+        stream["requests"] = profile.requests;
+        stream["bytes_last"] = profile.lastBytes;
+        stream["bytes_max"] = profile.maxBytes;
+        stream["time_us_last"] = profile.lastMicros;
+        stream["time_us_max"] = profile.maxMicros;
+        stream["heap_last"] = profile.lastHeap;
+        stream["heap_max"] = profile.maxHeap;
+    }
+
     String reason;
     reason = ResetReason::get_reset_reason_verbose(0);
     root["resetreason_0"] = reason;
@@ -132,32 +132,31 @@ void WebApiWsBatteryLiveClass::onLivedataStatus(AsyncWebServerRequest* request)
         return;
     }
 
-    try {
+    // the battery providers fill documents, only the one of the current
+    // step is kept in RAM
+    WebApi.sendJsonStream(request, HttpLink, [this](JsonStreamWriter& writer, size_t step) -> bool {
         std::lock_guard<std::mutex> lock(_mutex);
-        AsyncJsonResponse* response = new AsyncJsonResponse();
-        auto& root = response->getRoot();
+        JsonDocument root;
+        JsonVariant var = root;
 
-        generateCommonJsonResponse(root);
+        if (step == 0) {
+            generateCommonJsonResponse(var);
 
-        JsonArray packsArray = root["packs"].to<JsonArray>();
-        for (uint8_t i = 0; i < Battery.getStats()->get_number_of_packs(); i++) {
-//        for (uint8_t i=0; i<MAX_BATTERIES; i++) {
-            JsonObject packObject = packsArray.add<JsonObject>();
-            Battery.getStats()->generatePackCommonJsonResponse(packObject, i);
+            writer.beginObject();
+            writer.addMembers(root.as<JsonObjectConst>());
+            writer.beginArray("packs");
+            return true;
         }
 
-        /*
-                String buffer;
-                serializeJsonPretty(root, buffer);
-                Serial.println(buffer);
-        */
-        WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
-
-    } catch (std::bad_alloc& bad_alloc) {
-        MessageOutput.printf("Calling %s temporarily out of resources. Reason: \"%s\".\r\n", HttpLink, bad_alloc.what());
-        WebApi.sendTooManyRequests(request);
-    } catch (const std::exception& exc) {
-        MessageOutput.printf("Unknown exception in %s. Reason: \"%s\".\r\n", HttpLink, exc.what());
-        WebApi.sendTooManyRequests(request);
-    }
+        if (step <= Battery.getStats()->get_number_of_packs()) {
+            JsonObject packObject = root.to<JsonObject>();
+            Battery.getStats()->generatePackCommonJsonResponse(packObject, step - 1);
+            writer.add(nullptr, root.as<JsonVariantConst>());
+            return true;
+        }
+
+        writer.endArray();
+        writer.endObject();
+        return false;
+    });
 }
@@ -69,126 +69,190 @@ void WebApiWsLiveClass::wsCleanupTaskCb()
     _ws.cleanupClients();
 }
 
-void WebApiWsLiveClass::generateOnBatteryJsonResponse(JsonVariant& root, bool all)
+// writes the sections of the on-battery components as members of the
+// current object
+void WebApiWsLiveClass::generateOnBatteryJson(JsonStreamWriter& writer, bool all)
 {
     auto const& config = Configuration.get();
     auto constexpr halfOfAllMillis = std::numeric_limits<uint32_t>::max() / 2;
 
     auto victronAge = VictronMppt.getDataAgeMillis();
     if (all || (victronAge > 0 && (millis() - _lastPublishVictron) > victronAge)) {
-        auto vedirectObj = root["vedirect"].to<JsonObject>();
-        vedirectObj["enabled"] = config.Vedirect.Enabled;
+        writer.beginObject("vedirect");
+        writer.add("enabled", config.Vedirect.Enabled);
 
         if (config.Vedirect.Enabled) {
-            auto totalVeObj = vedirectObj["total"].to<JsonObject>();
-
-            addTotalField(totalVeObj, "Power", VictronMppt.getPanelPowerWatts(), "W", 1);
-            addTotalField(totalVeObj, "YieldDay", VictronMppt.getYieldDay() * 1000, "Wh", 0);
-            addTotalField(totalVeObj, "YieldTotal", VictronMppt.getYieldTotal(), "kWh", 2);
+            writer.beginObject("total");
+            writer.addValue("Power", VictronMppt.getPanelPowerWatts(), "W", 1);
+            writer.addValue("YieldDay", VictronMppt.getYieldDay() * 1000, "Wh", 0);
+            writer.addValue("YieldTotal", VictronMppt.getYieldTotal(), "kWh", 2);
+            writer.endObject();
         }
 
+        writer.endObject();
+
         if (!all) { _lastPublishVictron = millis(); }
     }
 
 #ifdef USE_CHARGER_HUAWEI
     if (all || (HuaweiCan.getLastUpdate() - _lastPublishCharger) < halfOfAllMillis) {
-        auto chargerObj = root["charger"].to<JsonObject>();
-        chargerObj["enabled"] = config.Huawei.Enabled;
-        chargerObj["type"] = "huawei";
+        writer.beginObject("charger");
+        writer.add("enabled", config.Huawei.Enabled);
+        writer.add("type", "huawei");
 
         if (config.Huawei.Enabled) {
             const RectifierParameters_t* rp = HuaweiCan.get();
-            addTotalField(chargerObj, "Power", rp->input_power, "W", 2);
+            writer.addValue("Power", rp->input_power, "W", 2);
         }
 #endif
 #ifdef USE_CHARGER_MEANWELL
     if (all || (MeanWellCan.getLastUpdate() - _lastPublishCharger) < halfOfAllMillis) {
-        auto chargerObj = root["charger"].to<JsonObject>();
-        chargerObj["enabled"] = config.MeanWell.Enabled;
-        chargerObj["type"] = "meanwell";
+        writer.beginObject("charger");
+        writer.add("enabled", config.MeanWell.Enabled);
+        writer.add("type", "meanwell");
 
         if (config.MeanWell.Enabled) {
-            addTotalField(chargerObj, "Power", MeanWellCan._rp.inputPower, "W", 2);
+            writer.addValue("Power", MeanWellCan._rp.inputPower, "W", 2);
         }
 #endif
 
+        writer.endObject();
+
         if (!all) { _lastPublishCharger = millis(); }
     }
 
     auto spStats = Battery.getStats();
     if (all || spStats->updateAvailable(_lastPublishBattery)) {
-        auto batteryObj = root["battery"].to<JsonObject>();
-        batteryObj["enabled"] = config.Battery.Enabled;
+        writer.beginObject("battery");
+        writer.add("enabled", config.Battery.Enabled);
 
         if (config.Battery.Enabled) {
             if (spStats->isSoCValid()) {
-                addTotalField(batteryObj, "soc", spStats->getSoC(), "%", spStats->getSoCPrecision());
+                writer.addValue("soc", spStats->getSoC(), "%", spStats->getSoCPrecision());
             }
 
             if (spStats->isVoltageValid()) {
-                addTotalField(batteryObj, "voltage", spStats->getVoltage(), "V", 2);
+                writer.addValue("voltage", spStats->getVoltage(), "V", 2);
             }
 
             if (spStats->isCurrentValid()) {
-                addTotalField(batteryObj, "current", spStats->getChargeCurrent(), "A", spStats->getChargeCurrentPrecision());
+                writer.addValue("current", spStats->getChargeCurrent(), "A", spStats->getChargeCurrentPrecision());
             }
 
             if (spStats->isVoltageValid() && spStats->isCurrentValid()) {
-                addTotalField(batteryObj, "power", spStats->getVoltage() * spStats->getChargeCurrent(), "W", 1);
+                writer.addValue("power", spStats->getVoltage() * spStats->getChargeCurrent(), "W", 1);
             }
         }
 
+        writer.endObject();
+
         if (!all) { _lastPublishBattery = millis(); }
     }
 
     if (all || (PowerMeter.getLastUpdate() - _lastPublishPowerMeter) < halfOfAllMillis) {
-        auto powerMeterObj = root["power_meter"].to<JsonObject>();
-        powerMeterObj["enabled"] = config.PowerMeter.Enabled;
+        writer.beginObject("power_meter");
+        writer.add("enabled", config.PowerMeter.Enabled);
 
         if (config.PowerMeter.Enabled) {
-            addTotalField(powerMeterObj, "GridPower", PowerMeter.getPowerTotal(), "W", 1);
-            addTotalField(powerMeterObj, "HousePower", PowerMeter.getHousePower(), "W", 1);
+            writer.addValue("GridPower", PowerMeter.getPowerTotal(), "W", 1);
+            writer.addValue("HousePower", PowerMeter.getHousePower(), "W", 1);
         }
 
+        writer.endObject();
+
         if (!all) { _lastPublishPowerMeter = millis(); }
     }
 
 #if defined(USE_REFUsol_INVERTER)
-    auto refusolObj = root["refusol"].to<JsonObject>();
-    refusolObj["enabled"] = config.REFUsol.Enabled;
-    auto totalREFUsolObj = refusolObj["total"].to<JsonObject>();
+    writer.beginObject("refusol");
+    writer.add("enabled", config.REFUsol.Enabled);
+    writer.beginObject("total");
 
     if (config.REFUsol.Enabled) {
-        addTotalField(totalREFUsolObj, "Power", REFUsol.Frame.acPower, "W", 1);
-        addTotalField(totalREFUsolObj, "YieldDay", REFUsol.Frame.YieldDay * 1000, "kWh", 3);
-        addTotalField(totalREFUsolObj, "YieldTotal", REFUsol.Frame.YieldTotal, "kWh", 3);
+        float acPower = 0, yieldDay = 0, yieldTotal = 0;
+        for (size_t i = 0; i < REFUsol.getInverterCount(); ++i) {
+            auto const& frame = REFUsol.getFrame(i);
+            acPower += frame.acPower;
+            yieldDay += frame.YieldDay;
+            yieldTotal += frame.YieldTotal;
+        }
+        writer.addValue("Power", acPower, "W", 1);
+        writer.addValue("YieldDay", yieldDay * 1000, "kWh", 3);
+        writer.addValue("YieldTotal", yieldTotal, "kWh", 3);
     }
+
+    writer.endObject();
+    writer.endObject();
 #endif
 
     if (all || (millis() - _lastPublishHours) > 10 * 1000) { // update every 10 seconds
         // Daten visualisieren #168
-        addHourPower(root, Datastore.getHourlyPowerData(), "Wh", Datastore.getTotalAcYieldTotalDigits());
+        addHourPower(writer, Datastore.getHourlyPowerData(), "Wh", Datastore.getTotalAcYieldTotalDigits());
         _lastPublishHours = millis();
     }
 }
 
+namespace {
+
+// calls f(name, value) for every member of an object written by a
+// JsonStreamWriter, which does not emit whitespace. the values are the
+// serialized text, so the sections are compared without parsing them.
+template<typename F>
+void forEachMember(const String& object, F&& f)
+{
+    const char* text = object.c_str();
+    size_t length = object.length();
+    if (length < 2 || text[0] != '{') { return; }
+
+    size_t i = 1;
+    while (i < length && text[i] == '"') {
+        size_t keyEnd = i + 1;
+        while (keyEnd < length && text[keyEnd] != '"') {
+            keyEnd += (text[keyEnd] == '\\') ? 2 : 1;
+        }
+        String name = object.substring(i + 1, keyEnd);
+
+        size_t valueStart = keyEnd + 2; // skip '"' and ':'
+        size_t depth = 0;
+        bool inString = false;
+        for (i = valueStart; i < length; i++) {
+            char c = text[i];
+            if (inString) {
+                if (c == '\\') { i++; }
+                else if (c == '"') { inString = false; }
+                continue;
+            }
+            if (c == '"') { inString = true; }
+            else if (c == '{' || c == '[') { depth++; }
+            else if (c == '}' || c == ']') {
+                if (depth == 0) { break; }
+                depth--;
+            } else if (c == ',' && depth == 0) { break; }
+        }
+
+        f(name, object.substring(valueStart, i));
+
+        if (i < length && text[i] == ',') { i++; }
+    }
+}
+
+} // namespace
+
 void WebApiWsLiveClass::sendOnBatteryStats()
 {
-    JsonDocument root;
-    JsonVariant var = root;
+    JsonStreamWriter writer;
 
     bool all = (millis() - _lastPublishOnBatteryFull) > 10 * 1000;
     if (all) { _lastPublishOnBatteryFull = millis(); }
-    generateOnBatteryJsonResponse(var, all);
-
-    if (root.isNull()) { return; }
 
-    if (Utils::checkJsonAlloc(root, __FUNCTION__, __LINE__)) {
-       String buffer;
-        serializeJson(root, buffer);
+    writer.beginObject();
+    generateOnBatteryJson(writer, all);
+    writer.endObject();
 
-        _ws.textAll(buffer);
-    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    forEachMember(writer.buffer(), [this](const String& name, String&& full) {
+        updateSection(name, std::move(full), false);
+    });
 }
 
 void WebApiWsLiveClass::sendDataTaskCb()
@@ -201,6 +265,7 @@ void WebApiWsLiveClass::sendDataTaskCb()
     sendOnBatteryStats();
 
     // Loop all inverters
+    bool invertersUpdated = false;
     for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
         auto inv = Hoymiles.getInverterByPos(i);
         if (inv == nullptr) {
@@ -216,44 +281,206 @@ void WebApiWsLiveClass::sendDataTaskCb()
 
         try {
             std::lock_guard<std::mutex> lock(_mutex);
-            JsonDocument root;
-            JsonVariant var = root;
-
-            auto invArray = var["inverters"].to<JsonArray>();
-            auto invObject = invArray.add<JsonObject>();
+            JsonStreamWriter writer;
 
-            generateCommonJsonResponse(var);
-            generateInverterCommonJsonResponse(invObject, inv);
-            generateInverterChannelJsonResponse(invObject, inv);
+            writer.beginObject();
+            generateInverterCommonJson(writer, inv);
+            generateInverterChannelJson(writer, inv);
+            writer.endObject();
 
-            if (!Utils::checkJsonAlloc(root, __FUNCTION__, __LINE__)) {
-                continue;
+            if (updateSection(inv->serialString(), std::move(writer.buffer()), true)) {
+                invertersUpdated = true;
             }
 
-            String buffer;
-            serializeJson(root, buffer);
-            // Serial.println(buffer);
-            _ws.textAll(buffer);
-
         } catch (const std::bad_alloc& bad_alloc) {
             MessageOutput.printf("Calling %s temporarily out of resources. Reason: \"%s\".\r\n", HttpLink, bad_alloc.what());
         } catch (const std::exception& exc) {
             MessageOutput.printf("Unknown exception in %s. Reason: \"%s\".\r\n", HttpLink, exc.what());
         }
     }
+
+    if (invertersUpdated) {
+        JsonStreamWriter total;
+        total.beginObject();
+        generateTotalJson(total);
+        total.endObject();
+
+        JsonStreamWriter hints;
+        hints.beginObject();
+        generateHintsJson(hints);
+        hints.endObject();
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _total = std::move(total.buffer());
+        _hints = std::move(hints.buffer());
+    }
+
+    sendSectionsToClients();
+}
+
+// Adds all values of current which differ from previous to delta, removed
+// keys are added as null. Returns true if at least one value was added.
+bool WebApiWsLiveClass::addDelta(JsonObjectConst previous, JsonObjectConst current, JsonObject delta)
+{
+    bool changed = false;
+
+    // the livedata never contains null values, so null marks a removed key
+    for (JsonPairConst kv : previous) {
+        if (current[kv.key()].isNull()) {
+            delta[kv.key()] = nullptr;
+            changed = true;
+        }
+    }
+
+    for (JsonPairConst kv : current) {
+        JsonVariantConst previousValue = previous[kv.key()];
+
+        if (kv.value().is<JsonObjectConst>() && previousValue.is<JsonObjectConst>()) {
+            JsonObject subDelta = delta[kv.key()].to<JsonObject>();
+            if (addDelta(previousValue.as<JsonObjectConst>(), kv.value().as<JsonObjectConst>(), subDelta)) {
+                changed = true;
+            } else {
+                delta.remove(kv.key());
+            }
+        } else if (previousValue != kv.value()) {
+            delta[kv.key()] = kv.value();
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+// Must be called with _mutex held. Returns true if the content changed.
+bool WebApiWsLiveClass::updateSection(const String& name, String&& full, bool calcDelta)
+{
+    auto& sections = calcDelta ? _inverterSections : _onBatterySections;
+    auto& section = sections[name];
+
+    // the streamed text is compared, unchanged sections are not parsed
+    if (section.version > 0 && full == section.full) {
+        return false;
+    }
+
+    section.delta.clear();
+
+    // the documents only exist while the delta is calculated
+    if (calcDelta && section.version > 0 && hasDeltaClients()) {
+        JsonDocument previous;
+        JsonDocument current;
+        if (deserializeJson(previous, section.full) == DeserializationError::Ok
+            && deserializeJson(current, full) == DeserializationError::Ok) {
+            JsonDocument delta;
+            addDelta(previous.as<JsonObjectConst>(), current.as<JsonObjectConst>(), delta.to<JsonObject>());
+            // the serial is required by the clients to find the inverter
+            delta["serial"] = current["serial"];
+            serializeJson(delta, section.delta);
+        }
+    }
+
+    section.full = std::move(full);
+    section.version++;
+    return true;
+}
+
+// Must be called with _mutex held.
+bool WebApiWsLiveClass::hasDeltaClients() const
+{
+    for (auto const& [id, client] : _clients) {
+        if (client.delta) { return true; }
+    }
+    return false;
+}
+
+bool WebApiWsLiveClass::isSubscribed(const Client_t& client, const String& name, bool isInverter)
+{
+    if (client.subscriptions.empty()) {
+        return true;
+    }
+
+    for (auto& subscription : client.subscriptions) {
+        if (subscription == name || (isInverter && subscription == "inverters")) {
+            return true;
+        }
+    }
+    return false;
 }
 
-void WebApiWsLiveClass::generateCommonJsonResponse(JsonVariant& root)
+void WebApiWsLiveClass::sendSectionsToClients()
 {
-    auto totalObj = root["total"].to<JsonObject>();;
-    addTotalField(totalObj, "Power", Datastore.getTotalAcPowerEnabled(), "W", Datastore.getTotalAcPowerDigits());
-    addTotalField(totalObj, "YieldDay", Datastore.getTotalAcYieldDayEnabled(), "Wh", Datastore.getTotalAcYieldDayDigits());
-    addTotalField(totalObj, "YieldTotal", Datastore.getTotalAcYieldTotalEnabled(), "kWh", Datastore.getTotalAcYieldTotalDigits());
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // remove sections of inverters which do not exist anymore
+    for (auto it = _inverterSections.begin(); it != _inverterSections.end();) {
+        bool found = false;
+        for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
+            auto inv = Hoymiles.getInverterByPos(i);
+            if (inv != nullptr && inv->serialString() == it->first) {
+                found = true;
+                break;
+            }
+        }
+        it = found ? std::next(it) : _inverterSections.erase(it);
+    }
+
+    for (auto& [id, client] : _clients) {
+        if (!_ws.availableForWrite(id)) {
+            // client is behind, it gets the full sections later on
+            continue;
+        }
+
+        String message;
+        for (auto& [name, section] : _onBatterySections) {
+            auto& version = client.versions[name];
+            if (version == section.version || !isSubscribed(client, name, false)) {
+                continue;
+            }
+            message += message.isEmpty() ? "{" : ",";
+            message += "\"" + name + "\":" + section.full;
+            version = section.version;
+        }
+        if (!message.isEmpty()) {
+            message += "}";
+            _ws.text(id, message);
+        }
 
-    JsonObject hintObj = root["hints"].to<JsonObject>();
+        if (_total.isEmpty()) {
+            continue;
+        }
+
+        for (auto& [name, section] : _inverterSections) {
+            auto& version = client.versions[name];
+            if (version == section.version || !isSubscribed(client, name, true)) {
+                continue;
+            }
+
+            const bool useDelta = client.delta && version + 1 == section.version && !section.delta.isEmpty();
+
+            message = "{\"inverters\":[";
+            message += useDelta ? section.delta : section.full;
+            message += "],\"total\":" + _total + ",\"hints\":" + _hints;
+            if (client.delta) {
+                message += useDelta ? ",\"delta\":true" : ",\"delta\":false";
+            }
+            message += "}";
+            _ws.text(id, message);
+            version = section.version;
+        }
+    }
+}
+
+void WebApiWsLiveClass::generateTotalJson(JsonStreamWriter& writer)
+{
+    writer.addValue("Power", Datastore.getTotalAcPowerEnabled(), "W", Datastore.getTotalAcPowerDigits());
+    writer.addValue("YieldDay", Datastore.getTotalAcYieldDayEnabled(), "Wh", Datastore.getTotalAcYieldDayDigits());
+    writer.addValue("YieldTotal", Datastore.getTotalAcYieldTotalEnabled(), "kWh", Datastore.getTotalAcYieldTotalDigits());
+}
+
+void WebApiWsLiveClass::generateHintsJson(JsonStreamWriter& writer)
+{
     struct tm timeinfo;
-    hintObj["time_sync"] = !getLocalTime(&timeinfo, 5);
-    hintObj["radio_problem"] =
+    writer.add("time_sync", !getLocalTime(&timeinfo, 5));
+    writer.add("radio_problem",
 #ifdef USE_RADIO_NRF
             ( Hoymiles.getRadioNrf()->isInitialized() &&
             ( !Hoymiles.getRadioNrf()->isConnected() || !Hoymiles.getRadioNrf()->isPVariant())
@@ -265,131 +492,178 @@ void WebApiWsLiveClass::generateCommonJsonResponse(JsonVariant& root)
 #ifdef USE_RADIO_CMT
             ( Hoymiles.getRadioCmt()->isInitialized() && !Hoymiles.getRadioCmt()->isConnected() )
 #endif
-        ;
+        );
 
-    hintObj["default_password"] = strcmp(Configuration.get().Security.Password, ACCESS_POINT_PASSWORD) == 0;
+    writer.add("default_password", strcmp(Configuration.get().Security.Password, ACCESS_POINT_PASSWORD) == 0);
 }
 
-void WebApiWsLiveClass::generateInverterCommonJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv)
+void WebApiWsLiveClass::generateInverterCommonJson(JsonStreamWriter& writer, std::shared_ptr<InverterAbstract> inv)
 {
     const INVERTER_CONFIG_T* inv_cfg = Configuration.getInverterConfig(inv->serial());
     if (inv_cfg == nullptr) {
         return;
     }
 
-    root["serial"] = inv->serialString();
-    root["name"] = inv->name();
-    root["order"] = inv_cfg->Order;
-    root["data_age"] = (millis() - inv->Statistics()->getLastUpdate()) / 1000;
-    root["poll_enabled"] = inv->getEnablePolling();
-    root["reachable"] = inv->isReachable();
-    root["producing"] = inv->isProducing();
-    root["limit_relative"] = inv->SystemConfigPara()->getLimitPercent();
+    writer.add("serial", inv->serialString());
+    writer.add("name", inv->name());
+    writer.add("order", inv_cfg->Order);
+    writer.add("data_age", (millis() - inv->Statistics()->getLastUpdate()) / 1000);
+    writer.add("poll_enabled", inv->getEnablePolling());
+    writer.add("reachable", inv->isReachable());
+    writer.add("producing", inv->isProducing());
+    writer.add("limit_relative", inv->SystemConfigPara()->getLimitPercent());
     if (inv->DevInfo()->getMaxPower() > 0) {
-        root["limit_absolute"] = inv->SystemConfigPara()->getLimitPercent() * inv->DevInfo()->getMaxPower() / 100.0;
+        writer.add("limit_absolute", inv->SystemConfigPara()->getLimitPercent() * inv->DevInfo()->getMaxPower() / 100.0f);
     } else {
-        root["limit_absolute"] = -1;
-    }
-    root["radio_stats"]["tx_request"] = inv->RadioStats.TxRequestData;
-    root["radio_stats"]["tx_re_request"] = inv->RadioStats.TxReRequestFragment;
-    root["radio_stats"]["rx_success"] = inv->RadioStats.RxSuccess;
-    root["radio_stats"]["rx_fail_nothing"] = inv->RadioStats.RxFailNoAnswer;
-    root["radio_stats"]["rx_fail_partial"] = inv->RadioStats.RxFailPartialAnswer;
-    root["radio_stats"]["rx_fail_corrupt"] = inv->RadioStats.RxFailCorruptData;
-    root["radio_stats"]["rssi"] = inv->getLastRssi();
+        writer.add("limit_absolute", -1);
+    }
+    writer.beginObject("radio_stats");
+    writer.add("tx_request", inv->RadioStats.TxRequestData);
+    writer.add("tx_re_request", inv->RadioStats.TxReRequestFragment);
+    writer.add("rx_success", inv->RadioStats.RxSuccess);
+    writer.add("rx_fail_nothing", inv->RadioStats.RxFailNoAnswer);
+    writer.add("rx_fail_partial", inv->RadioStats.RxFailPartialAnswer);
+    writer.add("rx_fail_corrupt", inv->RadioStats.RxFailCorruptData);
+    writer.add("rssi", inv->getLastRssi());
+    writer.endObject();
 }
 
-void WebApiWsLiveClass::generateInverterChannelJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv)
+void WebApiWsLiveClass::generateInverterChannelJson(JsonStreamWriter& writer, std::shared_ptr<InverterAbstract> inv)
 {
     const INVERTER_CONFIG_T* inv_cfg = Configuration.getInverterConfig(inv->serial());
     if (inv_cfg == nullptr) {
         return;
     }
 
+    auto stats = inv->Statistics();
+
     // Loop all channels
-    for (auto& t : inv->Statistics()->getChannelTypes()) {
-        auto chanTypeObj = root[inv->Statistics()->getChannelTypeName(t)].to<JsonObject>();
-        for (auto& c : inv->Statistics()->getChannelsByType(t)) {
+    for (auto& t : stats->getChannelTypes()) {
+        writer.beginObject(stats->getChannelTypeName(t));
+
+        for (auto& c : stats->getChannelsByType(t)) {
+            writer.beginObject(String(static_cast<uint8_t>(c)).c_str());
+
             if (t == TYPE_DC) {
-                chanTypeObj[String(static_cast<uint8_t>(c))]["name"]["u"] = inv_cfg->channel[c].Name;
+                writer.beginObject("name");
+                writer.add("u", inv_cfg->channel[c].Name);
+                writer.endObject();
             }
-            addField(chanTypeObj, inv, t, c, FLD_PAC);
-            addField(chanTypeObj, inv, t, c, FLD_UAC);
-            addField(chanTypeObj, inv, t, c, FLD_IAC);
+            addField(writer, inv, t, c, FLD_PAC);
+            addField(writer, inv, t, c, FLD_UAC);
+            addField(writer, inv, t, c, FLD_IAC);
             if (t == TYPE_INV) {
-                addField(chanTypeObj, inv, t, c, FLD_PDC, "Power DC");
+                addField(writer, inv, t, c, FLD_PDC, "Power DC");
             } else {
-                addField(chanTypeObj, inv, t, c, FLD_PDC);
+                addField(writer, inv, t, c, FLD_PDC);
             }
-            addField(chanTypeObj, inv, t, c, FLD_UDC);
-            addField(chanTypeObj, inv, t, c, FLD_IDC);
-            addField(chanTypeObj, inv, t, c, FLD_YD);
-            addField(chanTypeObj, inv, t, c, FLD_YT);
-            addField(chanTypeObj, inv, t, c, FLD_F);
-            addField(chanTypeObj, inv, t, c, FLD_T);
-            addField(chanTypeObj, inv, t, c, FLD_PF);
-            addField(chanTypeObj, inv, t, c, FLD_Q);
-            addField(chanTypeObj, inv, t, c, FLD_EFF);
-            if (t == TYPE_DC && inv->Statistics()->getStringMaxPower(c) > 0) {
-                addField(chanTypeObj, inv, t, c, FLD_IRR);
-                chanTypeObj[String(c)][inv->Statistics()->getChannelFieldName(t, c, FLD_IRR)]["max"] = inv->Statistics()->getStringMaxPower(c);
+            addField(writer, inv, t, c, FLD_UDC);
+            addField(writer, inv, t, c, FLD_IDC);
+            addField(writer, inv, t, c, FLD_YD);
+            addField(writer, inv, t, c, FLD_YT);
+            addField(writer, inv, t, c, FLD_F);
+            addField(writer, inv, t, c, FLD_T);
+            addField(writer, inv, t, c, FLD_PF);
+            addField(writer, inv, t, c, FLD_Q);
+            addField(writer, inv, t, c, FLD_EFF);
+            if (t == TYPE_DC && stats->getStringMaxPower(c) > 0 && stats->hasChannelFieldValue(t, c, FLD_IRR)) {
+                writer.beginObject(stats->getChannelFieldName(t, c, FLD_IRR));
+                writer.add("v", stats->getChannelFieldValue(t, c, FLD_IRR));
+                writer.add("u", stats->getChannelFieldUnit(t, c, FLD_IRR));
+                writer.add("d", stats->getChannelFieldDigits(t, c, FLD_IRR));
+                writer.add("max", stats->getStringMaxPower(c));
+                writer.endObject();
             }
+
+            writer.endObject();
         }
+
+        writer.endObject();
     }
 
-    if (inv->Statistics()->hasChannelFieldValue(TYPE_INV, CH0, FLD_EVT_LOG)) {
-        root["events"] = inv->EventLog()->getEntryCount();
+    if (stats->hasChannelFieldValue(TYPE_INV, CH0, FLD_EVT_LOG)) {
+        writer.add("events", inv->EventLog()->getEntryCount());
     } else {
-        root["events"] = -1;
+        writer.add("events", -1);
     }
 }
 
-void WebApiWsLiveClass::addField(JsonObject& root, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, String topic)
+void WebApiWsLiveClass::addField(JsonStreamWriter& writer, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, const char* topic)
 {
-    if (inv->Statistics()->hasChannelFieldValue(type, channel, fieldId)) {
-        String chanName;
-        if (topic == "") {
-            chanName = inv->Statistics()->getChannelFieldName(type, channel, fieldId);
-        } else {
-            chanName = topic;
-        }
-        String chanNum;
-        chanNum = channel;
-        root[chanNum][chanName]["v"] = inv->Statistics()->getChannelFieldValue(type, channel, fieldId);
-        root[chanNum][chanName]["u"] = inv->Statistics()->getChannelFieldUnit(type, channel, fieldId);
-        root[chanNum][chanName]["d"] = inv->Statistics()->getChannelFieldDigits(type, channel, fieldId);
+    auto stats = inv->Statistics();
+    if (!stats->hasChannelFieldValue(type, channel, fieldId)) {
+        return;
     }
-}
 
-void WebApiWsLiveClass::addTotalField(JsonObject& root, const String& name, const float value, const String& unit, const uint8_t digits)
-{
-    root[name]["v"] = value;
-    root[name]["u"] = unit;
-    root[name]["d"] = digits;
+    writer.beginObject(topic != nullptr ? topic : stats->getChannelFieldName(type, channel, fieldId));
+    writer.add("v", stats->getChannelFieldValue(type, channel, fieldId));
+    writer.add("u", stats->getChannelFieldUnit(type, channel, fieldId));
+    writer.add("d", stats->getChannelFieldDigits(type, channel, fieldId));
+    writer.endObject();
 }
 
 // Daten visualisieren #168
-void WebApiWsLiveClass::addHourPower(JsonVariant& root, std::array<float, 24> values, const String& unit, const uint8_t digits)
+void WebApiWsLiveClass::addHourPower(JsonStreamWriter& writer, std::array<float, 24> values, const char* unit, const uint8_t digits)
 {
-    auto hours = root["hours"].to<JsonObject>();
-    auto valuesArray = hours["values"].to<JsonArray>();
+    writer.beginObject("hours");
+    writer.beginArray("values");
 
     for (float value : values) {
         if (value < 0.0)
             value = 0.0;
-        valuesArray.add(static_cast<uint16_t>(value));
+        writer.add(nullptr, static_cast<uint16_t>(value));
     }
 
-    hours["u"] = unit;
-    hours["d"] = digits;
+    writer.endArray();
+    writer.add("u", unit);
+    writer.add("d", digits);
+    writer.endObject();
 }
 
 void WebApiWsLiveClass::onWebsocketEvent(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len)
 {
     if (type == WS_EVT_CONNECT) {
         MessageOutput.printf("Websocket: [%s][%u] connect\r\n", server->url(), client->id());
+        std::lock_guard<std::mutex> lock(_mutex);
+        _clients[client->id()] = Client_t();
     } else if (type == WS_EVT_DISCONNECT) {
         MessageOutput.printf("Websocket: [%s][%u] disconnect\r\n", server->url(), client->id());
+        std::lock_guard<std::mutex> lock(_mutex);
+        _clients.erase(client->id());
+    } else if (type == WS_EVT_DATA) {
+        auto info = static_cast<AwsFrameInfo*>(arg);
+        // only complete, unfragmented text frames are supported
+        if (info->final && info->index == 0 && info->len == len && info->opcode == WS_TEXT) {
+            onWebsocketSubscribe(client, data, len);
+        }
+    }
+}
+
+// Clients may send {"subscribe":["inverters"|"<serial>"|"battery"|...],"delta":true}
+// to receive only a subset of the sections and only changed values afterwards.
+// Every subscription starts with a full snapshot.
+void WebApiWsLiveClass::onWebsocketSubscribe(AsyncWebSocketClient* client, const uint8_t* data, size_t len)
+{
+    if (len == 0 || data[0] != '{') {
+        return; // e.g. the "ping" of the web application
+    }
+
+    JsonDocument doc;
+    if (deserializeJson(doc, data, len) != DeserializationError::Ok) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _clients.find(client->id());
+    if (it == _clients.end()) {
+        return;
+    }
+
+    auto& c = it->second;
+    c = Client_t();
+    c.delta = doc["delta"] | false;
+    for (JsonVariantConst subscription : doc["subscribe"].as<JsonArrayConst>()) {
+        c.subscriptions.push_back(subscription.as<String>());
     }
 }
 
@@ -399,44 +673,53 @@ void WebApiWsLiveClass::onLivedataStatus(AsyncWebServerRequest* request)
         return;
     }
 
-    try {
+    auto serial = WebApi.parseSerialFromRequest(request);
+
+    // one inverter per step, the inverters may change in between
+    WebApi.sendJsonStream(request, HttpLink, [this, serial](JsonStreamWriter& writer, size_t step) -> bool {
         std::lock_guard<std::mutex> lock(_mutex);
-        AsyncJsonResponse* response = new AsyncJsonResponse();
-        auto& root = response->getRoot();
-        auto invArray = root["inverters"].to<JsonArray>();
-        auto serial = WebApi.parseSerialFromRequest(request);
 
-        if (serial > 0) {
-            auto inv = Hoymiles.getInverterBySerial(serial);
-            if (inv != nullptr) {
-                JsonObject invObject = invArray.add<JsonObject>();
-                generateInverterCommonJsonResponse(invObject, inv);
-                generateInverterChannelJsonResponse(invObject, inv);
-            }
-        } else {
-            // Loop all inverters
-            for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
-                auto inv = Hoymiles.getInverterByPos(i);
-                if (inv == nullptr) {
-                    continue;
+        if (step == 0) {
+            writer.beginObject();
+            writer.beginArray("inverters");
+
+            if (serial > 0) {
+                auto inv = Hoymiles.getInverterBySerial(serial);
+                if (inv != nullptr) {
+                    writer.beginObject();
+                    generateInverterCommonJson(writer, inv);
+                    generateInverterChannelJson(writer, inv);
+                    writer.endObject();
                 }
+            }
+
+            return true;
+        }
 
-                JsonObject invObject = invArray.add<JsonObject>();
-                generateInverterCommonJsonResponse(invObject, inv);
+        size_t inverters = (serial > 0) ? 0 : Hoymiles.getNumInverters();
+        if (step <= inverters) {
+            auto inv = Hoymiles.getInverterByPos(step - 1);
+            if (inv != nullptr) {
+                writer.beginObject();
+                generateInverterCommonJson(writer, inv);
+                writer.endObject();
             }
+            return true;
         }
 
-        generateCommonJsonResponse(root);
+        writer.endArray();
 
-        generateOnBatteryJsonResponse(root, true);
+        writer.beginObject("total");
+        generateTotalJson(writer);
+        writer.endObject();
 
-        WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+        writer.beginObject("hints");
+        generateHintsJson(writer);
+        writer.endObject();
 
-    } catch (const std::bad_alloc& bad_alloc) {
-        MessageOutput.printf("Calling %s temporarily out of resources. Reason: \"%s\".\r\n", HttpLink, bad_alloc.what());
-        WebApi.sendTooManyRequests(request);
-    } catch (const std::exception& exc) {
-        MessageOutput.printf("Unknown exception in %s. Reason: \"%s\".\r\n", HttpLink, exc.what());
-        WebApi.sendTooManyRequests(request);
-    }
+        generateOnBatteryJson(writer, true);
+
+        writer.endObject();
+        return false;
+    });
 }
@@ -98,17 +98,13 @@ void WebApiWsVedirectLiveClass::sendDataTaskCb()
     if (fullUpdate || updateAvailable) {
         try {
             std::lock_guard<std::mutex> lock(_mutex);
-            JsonDocument root;
-            JsonVariant var = root;
+            JsonStreamWriter writer;
 
-            generateCommonJsonResponse(var, fullUpdate);
+            writer.beginObject();
+            generateCommonJson(writer, fullUpdate);
+            writer.endObject();
 
-            if (Utils::checkJsonAlloc(root, __FUNCTION__, __LINE__)) {
-                String buffer;
-                serializeJson(root, buffer);
-
-                _ws.textAll(buffer);
-            }
+            _ws.textAll(writer.buffer());
 
         } catch (std::bad_alloc& bad_alloc) {
             MessageOutput.printf("Calling %s temporarily out of resources. Reason: \"%s\".\r\n", HttpLink, bad_alloc.what());
@@ -123,105 +119,118 @@ void WebApiWsVedirectLiveClass::sendDataTaskCb()
     }
 }
 
-template <typename T>
-void addValue(const JsonObject& root, std::string const& name,
-    T&& value, std::string const& unit, uint8_t precision)
-{
-    auto jsonValue = root[name];
-    jsonValue["v"] = value;
-    jsonValue["u"] = unit;
-    jsonValue["d"] = precision;
-}
-
-void WebApiWsVedirectLiveClass::generateCommonJsonResponse(JsonVariant& root, bool fullUpdate)
+// writes the members of the current object
+void WebApiWsVedirectLiveClass::generateCommonJson(JsonStreamWriter& writer, bool fullUpdate)
 {
-    const JsonObject &array = root["vedirect"]["instances"].to<JsonObject>();
-    root["vedirect"]["full_update"] = fullUpdate;
+    writer.beginObject("vedirect");
+    writer.beginObject("instances");
 
     for (size_t idx = 0; idx < VictronMppt.controllerAmount(); ++idx) {
-        auto optMpptData = VictronMppt.getData(idx);
-        if (!optMpptData.has_value()) { continue; }
-
         if (!fullUpdate && !hasUpdate(idx)) { continue; }
 
-        String serial(optMpptData->serialNr_SER);
-        if (serial.isEmpty()) { continue; } // serial required as index
-
-        const JsonObject &nested = array[serial].to<JsonObject>();
-        nested["data_age_ms"] = VictronMppt.getDataAgeMillis(idx);
-        populateJson(nested, *optMpptData);
+        generateInstanceJson(writer, idx);
     }
 
+    writer.endObject();
+    writer.add("full_update", fullUpdate);
+    writer.endObject();
+
     _lastPublish = millis();
 
-    // power limiter state
-    root["dpl"]["PLSTATE"] = (Configuration.get().PowerLimiter.Enabled) ? PowerLimiter.getPowerLimiterState() : -1;
-    root["dpl"]["PLLIMIT"] = PowerLimiter.getLastRequestedPowerLimit();
+    generateDplJson(writer);
+}
+
+void WebApiWsVedirectLiveClass::generateInstanceJson(JsonStreamWriter& writer, size_t idx)
+{
+    auto optMpptData = VictronMppt.getData(idx);
+    if (!optMpptData.has_value()) { return; }
+
+    if (optMpptData->serialNr_SER[0] == '\0') { return; } // serial required as index
+
+    writer.beginObject(optMpptData->serialNr_SER);
+    writer.add("data_age_ms", VictronMppt.getDataAgeMillis(idx));
+    populateJson(writer, *optMpptData);
+    writer.endObject();
+}
+
+// power limiter state
+void WebApiWsVedirectLiveClass::generateDplJson(JsonStreamWriter& writer)
+{
+    writer.beginObject("dpl");
+    writer.add("PLSTATE", (Configuration.get().PowerLimiter.Enabled) ? PowerLimiter.getPowerLimiterState() : -1);
+    writer.add("PLLIMIT", PowerLimiter.getLastRequestedPowerLimit());
+    writer.endObject();
 }
 
-void WebApiWsVedirectLiveClass::populateJson(const JsonObject &root, const VeDirectMpptController::data_t &mpptData) {
+void WebApiWsVedirectLiveClass::populateJson(JsonStreamWriter& writer, const VeDirectMpptController::data_t &mpptData) {
     // device info
-    root["product_id"] = mpptData.getPidAsString();
-    root["firmware_version"] = mpptData.getFwVersionFormatted();
+    writer.add("product_id", mpptData.getPidAsString().data());
+    writer.add("firmware_version", mpptData.getFwVersionFormatted());
 
-    const JsonObject values = root["values"].to<JsonObject>();
+    writer.beginObject("values");
 
-    const JsonObject device = values["device"].to<JsonObject>();
+    writer.beginObject("device");
     if (mpptData.hasLoad || mpptData.Capabilities.second & (1<<0)) {  // Load output present ?
-        device["LOAD"] = mpptData.loadOutputState_LOAD ? "ON" : "OFF";
+        writer.add("LOAD", mpptData.loadOutputState_LOAD ? "ON" : "OFF");
         if (mpptData.hasLoad || mpptData.Capabilities.second & (1<<12) ) // Load current IL in Text protocol
-            addValue(device, "IL", mpptData.loadCurrent_IL_mA/1000.0, "A", 2);
+            writer.addValue("IL", mpptData.loadCurrent_IL_mA/1000.0, "A", 2);
         else if (mpptData.LoadCurrent.first > 0)
-            addValue(device, "IL", mpptData.LoadCurrent.second / 1000.0, "A", 2);
+            writer.addValue("IL", mpptData.LoadCurrent.second / 1000.0, "A", 2);
         if (mpptData.LoadOutputVoltage.first > 0)
-            addValue(device, "LoadOutputVoltage", mpptData.LoadOutputVoltage.second / 1000.0, "V", 2);
+            writer.addValue("LoadOutputVoltage", mpptData.LoadOutputVoltage.second / 1000.0, "V", 2);
     }
-    device["CS"]   = mpptData.getCsAsString();
-    device["MPPT"] = mpptData.getMpptAsString();
-    device["OR"]   = mpptData.getOrAsString();
-    device["ERR"]  = mpptData.getErrAsString();
-    addValue(device, "HSDS", mpptData.daySequenceNr_HSDS, "d", 0);
+    writer.add("CS", mpptData.getCsAsString().data());
+    writer.add("MPPT", mpptData.getMpptAsString().data());
+    writer.add("OR", mpptData.getOrAsString().data());
+    writer.add("ERR", mpptData.getErrAsString().data());
+    writer.addValue("HSDS", mpptData.daySequenceNr_HSDS, "d", 0);
     if (mpptData.ChargerMaximumCurrent.first > 0)
-        addValue(device, "ChargerMaxCurrent", mpptData.ChargerMaximumCurrent.second / 1000.0, "A", 1);
+        writer.addValue("ChargerMaxCurrent", mpptData.ChargerMaximumCurrent.second / 1000.0, "A", 1);
     if (mpptData.VoltageSettingsRange.first > 0) {
-        device["VoltageSettingsRange"] = String(mpptData.VoltageSettingsRange.second & 0xFF)
-                + " - "
-                + String(mpptData.VoltageSettingsRange.second >> 8) + String(" V");
+        char range[24];
+        snprintf(range, sizeof(range), "%u - %u V",
+                mpptData.VoltageSettingsRange.second & 0xFF, mpptData.VoltageSettingsRange.second >> 8);
+        writer.add("VoltageSettingsRange", range);
 //        addValue(device, "VoltageSettingsMin", mpptData.VoltageSettingsRange.second & 0xFF, "V", 0);
 //        addValue(device, "VoltageSettingsMax", mpptData.VoltageSettingsRange.second >> 8, "V", 0);
     }
     if (mpptData.MpptTemperatureMilliCelsius.first > 0)
-        addValue(device, "MpptTemperature", mpptData.MpptTemperatureMilliCelsius.second / 1000.0, "°C", 1);
+        writer.addValue("MpptTemperature", mpptData.MpptTemperatureMilliCelsius.second / 1000.0, "°C", 1);
+    writer.endObject();
 
     // battery info
-    const JsonObject output = values["output"].to<JsonObject>();
-    addValue(output, "P", mpptData.batteryOutputPower_W, "W", 0);
-    addValue(output, "V", mpptData.batteryVoltage_V_mV/1000.0, "V", 2);
-    addValue(output, "I", mpptData.batteryCurrent_I_mA/1000.0, "A", 2);
-    addValue(output, "E", mpptData.mpptEfficiency_Percent, "%", 1);
+    writer.beginObject("output");
+    writer.addValue("P", mpptData.batteryOutputPower_W, "W", 0);
+    writer.addValue("V", mpptData.batteryVoltage_V_mV/1000.0, "V", 2);
+    writer.addValue("I", mpptData.batteryCurrent_I_mA/1000.0, "A", 2);
+    writer.addValue("E", mpptData.mpptEfficiency_Percent, "%", 1);
     if (mpptData.BatteryType.first > 0)
-        output["BatteryType"]   = mpptData.getBatteryTypeAsString();
+        writer.add("BatteryType", mpptData.getBatteryTypeAsString().data());
     if (mpptData.BatteryAbsorptionMilliVolt.first > 0)
-        addValue(output, "BatteryAbsorptionVoltage", mpptData.BatteryAbsorptionMilliVolt.second / 1000.0, "V", 2);
+        writer.addValue("BatteryAbsorptionVoltage", mpptData.BatteryAbsorptionMilliVolt.second / 1000.0, "V", 2);
     if (mpptData.BatteryFloatMilliVolt.first > 0)
-        addValue(output, "BatteryFloatVoltage", mpptData.BatteryFloatMilliVolt.second / 1000.0, "V", 2);
+        writer.addValue("BatteryFloatVoltage", mpptData.BatteryFloatMilliVolt.second / 1000.0, "V", 2);
     if (mpptData.BatteryMaximumCurrent.first > 0)
-        addValue(output, "BatteryMaxCurrent", mpptData.BatteryMaximumCurrent.second / 1000.0, "A", 1);
+        writer.addValue("BatteryMaxCurrent", mpptData.BatteryMaximumCurrent.second / 1000.0, "A", 1);
     if (mpptData.SmartBatterySenseTemperatureMilliCelsius.first > 0)
-        addValue(output, "BatteryTemperature", mpptData.SmartBatterySenseTemperatureMilliCelsius.second / 1000.0, "°C", 1);
+        writer.addValue("BatteryTemperature", mpptData.SmartBatterySenseTemperatureMilliCelsius.second / 1000.0, "°C", 1);
+    writer.endObject();
 
     // panel info
-    const JsonObject input = values["input"].to<JsonObject>();
+    writer.beginObject("input");
     if (mpptData.NetworkTotalDcInputPowerMilliWatts.first > 0)
-        addValue(input, "NetworkPower", mpptData.NetworkTotalDcInputPowerMilliWatts.second / 1000.0, "W", 0);
-    addValue(input, "PPV", mpptData.panelPower_PPV_W, "W", 0);
-    addValue(input, "VPV", mpptData.panelVoltage_VPV_mV/1000.0, "V", 2);
-    addValue(input, "IPV", mpptData.panelCurrent_mA/1000.0, "A", 2);
-    addValue(input, "YieldToday", mpptData.yieldToday_H20_Wh/1000.0, "kWh", 2);
-    addValue(input, "YieldYesterday", mpptData.yieldYesterday_H22_Wh/1000.0, "kWh", 2);
-    addValue(input, "YieldTotal", mpptData.yieldTotal_H19_Wh/1000.0, "kWh", 2);
-    addValue(input, "MaximumPowerToday", mpptData.maxPowerToday_H21_W, "W", 0);
-    addValue(input, "MaximumPowerYesterday", mpptData.maxPowerYesterday_H23_W, "W", 0);
+        writer.addValue("NetworkPower", mpptData.NetworkTotalDcInputPowerMilliWatts.second / 1000.0, "W", 0);
+    writer.addValue("PPV", mpptData.panelPower_PPV_W, "W", 0);
+    writer.addValue("VPV", mpptData.panelVoltage_VPV_mV/1000.0, "V", 2);
+    writer.addValue("IPV", mpptData.panelCurrent_mA/1000.0, "A", 2);
+    writer.addValue("YieldToday", mpptData.yieldToday_H20_Wh/1000.0, "kWh", 2);
+    writer.addValue("YieldYesterday", mpptData.yieldYesterday_H22_Wh/1000.0, "kWh", 2);
+    writer.addValue("YieldTotal", mpptData.yieldTotal_H19_Wh/1000.0, "kWh", 2);
+    writer.addValue("MaximumPowerToday", mpptData.maxPowerToday_H21_W, "W", 0);
+    writer.addValue("MaximumPowerYesterday", mpptData.maxPowerYesterday_H23_W, "W", 0);
+    writer.endObject();
+
+    writer.endObject();
 }
 
 void WebApiWsVedirectLiveClass::onWebsocketEvent(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len)
@@ -238,20 +247,30 @@ void WebApiWsVedirectLiveClass::onLivedataStatus(AsyncWebServerRequest* request)
     if (!WebApi.checkCredentialsReadonly(request)) {
         return;
     }
-    try {
+
+    // one charge controller per step
+    WebApi.sendJsonStream(request, HttpLink, [this](JsonStreamWriter& writer, size_t step) -> bool {
         std::lock_guard<std::mutex> lock(_mutex);
-        AsyncJsonResponse* response = new AsyncJsonResponse();
-        auto& root = response->getRoot();
 
-        generateCommonJsonResponse(root, true/*fullUpdate*/);
+        if (step == 0) {
+            writer.beginObject();
+            writer.beginObject("vedirect");
+            writer.beginObject("instances");
+            return true;
+        }
 
-        WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+        if (step <= VictronMppt.controllerAmount()) {
+            generateInstanceJson(writer, step - 1);
+            return true;
+        }
 
-    } catch (std::bad_alloc& bad_alloc) {
-        MessageOutput.printf("Calling %s temporarily out of resources. Reason: \"%s\".\r\n", HttpLink, bad_alloc.what());
-        WebApi.sendTooManyRequests(request);
-    } catch (const std::exception& exc) {
-        MessageOutput.printf("Unknown exception in %s. Reason: \"%s\".\r\n", HttpLink, exc.what());
-        WebApi.sendTooManyRequests(request);
-    }
+        writer.endObject();
+        writer.add("full_update", true);
+        writer.endObject();
+
+        generateDplJson(writer);
+
+        writer.endObject();
+        return false;
+    });
 }
@@ -192,7 +192,7 @@ void ZendureBattery::loop()
 
         // republish settings - just to be sure
         if (!_topicWrite.isEmpty() && !_payloadSettings.isEmpty()){
-            MqttSettings.publishGeneric(_topicWrite, _payloadSettings, false, 0);
+            MqttSettings.publishGeneric(_topicWrite, _payloadSettings, false, 0, false);
         }
     }
 }
@@ -209,7 +209,7 @@ uint16_t ZendureBattery::setOutputLimit(uint16_t limit)
             uint16_t remain = (limit % 30U) / 15U;
             limit = 30 * base + 30 * remain;
         }
-        MqttSettings.publishGeneric(_topicWrite, "{\"properties\": {\"" ZENDURE_REPORT_OUTPUT_LIMIT "\": " + String(limit) + "} }", false, 0);
+        MqttSettings.publishGeneric(_topicWrite, "{\"properties\": {\"" ZENDURE_REPORT_OUTPUT_LIMIT "\": " + String(limit) + "} }", false, 0, false);
     }
 
     return limit;
@@ -231,13 +231,13 @@ void ZeroExportClass::loop()
         return;
     }
 
-    // if (_verboseLogging) MessageOutput.printf("%s ******************* ENTER **********************\r\n", TAG);
+    // if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s ******************* ENTER **********************\r\n", TAG);
 
     int16_t newPowerLimit = pid_Regler();
 
     bool limitUpdated = setNewPowerLimit(_inverter, newPowerLimit);
 
-    // if (_verboseLogging) MessageOutput.printf("%s ******************* Leaving *******************\r\n", TAG);
+    // if (_verboseLogging) MessageOutput.printf(LogLevel::Verbose, "%s ******************* Leaving *******************\r\n", TAG);
 
     if (!limitUpdated) {
         // increase polling backoff if system seems to be stable
@@ -262,7 +262,7 @@ bool ZeroExportClass::setNewPowerLimit(std::shared_ptr<InverterAbstract> inverte
     if (diff < cZeroExport.PowerHysteresis) {
 
         if (_verboseLogging)
-            MessageOutput.printf("%s reusing old limit: %d %%, diff: %d %%, hysteresis: %d %%\r\n", TAG,
+            MessageOutput.printf(LogLevel::Verbose, "%s reusing old limit: %d %%, diff: %d %%, hysteresis: %d %%\r\n", TAG,
                 _lastRequestedPowerLimit, diff, cZeroExport.PowerHysteresis);
 
         return false;
@@ -279,7 +279,7 @@ void ZeroExportClass::commitPowerLimit(std::shared_ptr<InverterAbstract> inverte
     // setting the power limit is less important.
     if (!enablePowerProduction && inverter->isProducing()) {
         if (_verboseLogging)
-            MessageOutput.printf("%s Stopping inverter...", TAG);
+            MessageOutput.printf(LogLevel::Verbose, "%s Stopping inverter...", TAG);
         inverter->sendPowerControlRequest(false);
     }
 
@@ -291,7 +291,7 @@ void ZeroExportClass::commitPowerLimit(std::shared_ptr<InverterAbstract> inverte
     // such that an older, greater limit will not cause power spikes.
     if (enablePowerProduction && !inverter->isProducing()) {
         if (_verboseLogging)
-            MessageOutput.printf("%s Starting up inverter...", TAG);
+            MessageOutput.printf(LogLevel::Verbose, "%s Starting up inverter...", TAG);
         inverter->sendPowerControlRequest(true);
     }
 }
@@ -6,6 +6,8 @@
 #include "Configuration.h"
 #include "Datastore.h"
 #include "Display_Graphic.h"
+#include "EnergyHistory.h"
+#include "EventArchive.h"
 #include "InverterSettings.h"
 #include "Led_Single.h"
 #include "Led_Strip.h"
@@ -70,7 +72,7 @@ void setup()
         yield();
 #endif
 
-    MessageOutput.init(scheduler);
+    MessageOutput.init();
     MessageOutput.println("\r\nStarting OpenDTU-onBattery");
 
     // Initialize file system
@@ -104,6 +106,8 @@ void setup()
     }
     MessageOutput.println("done");
 
+    MessageOutput.setLevel(static_cast<MessageOutputClass::Level>(config.Logging.Level));
+
     PinMapping.init(String(config.Dev_PinMapping)); // Load PinMapping
 
     SerialPortManager.init();
@@ -119,7 +123,7 @@ void setup()
 
     // Initialize MqTT
     MessageOutput.print("Initialize MqTT... ");
-    MqttSettings.init();
+    MqttSettings.init(scheduler);
     MqttHandleDtu.init(scheduler);
     MqttHandleInverter.init(scheduler);
     MqttHandleInverterTotal.init(scheduler);
@@ -197,6 +201,9 @@ void setup()
 
     Battery.init(scheduler);
 
+    EnergyHistory.init(scheduler);
+    EventArchive.init(scheduler);
+
 #ifdef USE_ModbusDTU
     ModbusDtu.init(scheduler);
 #endif
@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+// the parts of the Arduino core used by the code under test in the native env
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+typedef bool boolean;
+
+inline uint32_t millis()
+{
+    static auto const start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+}
+
+#if defined(__GLIBC__) && (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38)
+inline size_t strlcpy(char* dst, char const* src, size_t size)
+{
+    size_t length = strlen(src);
+    if (size > 0) {
+        size_t copy = (length < size) ? length : size - 1;
+        memcpy(dst, src, copy);
+        dst[copy] = '\0';
+    }
+    return length;
+}
+#endif
+
+typedef void* SemaphoreHandle_t;
+
+class String : public std::string {
+public:
+    String() = default;
+    String(std::string const& other) : std::string(other) { }
+    String(char const* text) : std::string(text) { }
+    explicit String(char c) : std::string(1, c) { }
+};
+
+class Print {
+public:
+    virtual ~Print() = default;
+    virtual size_t write(uint8_t c) = 0;
+
+    virtual size_t write(uint8_t const* buffer, size_t size)
+    {
+        size_t n = 0;
+        while (size-- > 0) { n += write(*buffer++); }
+        return n;
+    }
+
+    size_t print(char const* text) { return write(reinterpret_cast<uint8_t const*>(text), strlen(text)); }
+    size_t println(char const* text) { return print(text) + print("\r\n"); }
+
+    size_t printf(char const* format, ...) __attribute__((format(printf, 2, 3)))
+    {
+        char buffer[256];
+        va_list args;
+        va_start(args, format);
+        int length = vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        if (length < 0) { return 0; }
+        return write(reinterpret_cast<uint8_t const*>(buffer),
+                std::min<size_t>(length, sizeof(buffer) - 1));
+    }
+};
+
+#define SERIAL_8N1 0x800001c
+
+// the bytes received by a UART are provided by the test through rx()
+class HardwareSerial : public Print {
+public:
+    explicit HardwareSerial(uint8_t port) : _port(port) { }
+
+    static std::string& rx(uint8_t port)
+    {
+        static std::array<std::string, 3> data;
+        return data.at(port);
+    }
+
+    void setRxBufferSize(size_t) { }
+    void begin(unsigned long, uint32_t, int8_t, int8_t) { }
+    void end() { }
+    void flush() { }
+
+    int available() { return rx(_port).size() - _read; }
+
+    int read()
+    {
+        if (available() <= 0) { return -1; }
+        return static_cast<uint8_t>(rx(_port)[_read++]);
+    }
+
+    size_t write(uint8_t) override { return 1; }
+    size_t write(char const* buffer, size_t size) { return Print::write(reinterpret_cast<uint8_t const*>(buffer), size); }
+    using Print::write;
+    int availableForWrite() { return 128; }
+
+private:
+    uint8_t _port;
+    size_t _read = 0;
+};
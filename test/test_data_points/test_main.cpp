@@ -0,0 +1,257 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <unity.h>
+#include <JbdBmsDataPoints.h>
+#include <JkBmsDataPoints.h>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+// the container as it was before the data points were indexed by label:
+// one unordered_map node and three strings per data point, the value text is
+// formatted by every add().
+namespace Legacy {
+
+template<typename... V>
+class DataPoint {
+    template<typename, typename L, template<L> class>
+    friend class DataPointContainer;
+
+    public:
+        using tValue = std::variant<V...>;
+
+        DataPoint() = delete;
+
+        DataPoint(std::string const& strLabel, std::string const& strValue,
+                std::string const& strUnit, tValue value, uint32_t timestamp)
+            : _strLabel(strLabel)
+            , _strValue(strValue)
+            , _strUnit(strUnit)
+            , _value(std::move(value))
+            , _timestamp(timestamp) { }
+
+        std::string const& getLabelText() const { return _strLabel; }
+        std::string const& getValueText() const { return _strValue; }
+        std::string const& getUnitText() const { return _strUnit; }
+
+        bool operator==(DataPoint const& other) const {
+            return _value == other._value;
+        }
+
+    private:
+        std::string _strLabel;
+        std::string _strValue;
+        std::string _strUnit;
+        tValue _value;
+        uint32_t _timestamp;
+};
+
+template<typename DataPoint, typename Label, template<Label> class Traits>
+class DataPointContainer {
+    public:
+        template<Label L>
+        void add(typename Traits<L>::type val) {
+            std::string strValue = dataPointValueToStr(val);
+            _dataPoints.emplace(L, DataPoint(Traits<L>::name, strValue,
+                        Traits<L>::unit, typename DataPoint::tValue(std::move(val)), millis()));
+        }
+
+        template<Label L>
+        std::optional<typename Traits<L>::type> get() const {
+            auto it = _dataPoints.find(L);
+            if (it == _dataPoints.end()) { return std::nullopt; }
+            return std::get<typename Traits<L>::type>(it->second._value);
+        }
+
+        using tMap = std::unordered_map<Label, DataPoint const>;
+        typename tMap::const_iterator cbegin() const { return _dataPoints.cbegin(); }
+        typename tMap::const_iterator cend() const { return _dataPoints.cend(); }
+
+        void updateFrom(DataPointContainer const& source)
+        {
+            for (auto iter = source.cbegin(); iter != source.cend(); ++iter) {
+                auto pos = _dataPoints.find(iter->first);
+
+                if (pos != _dataPoints.end()) {
+                    if (pos->second == iter->second) { continue; }
+                    _dataPoints.erase(pos);
+                }
+                _dataPoints.insert(*iter);
+            }
+        }
+
+    private:
+        tMap _dataPoints;
+};
+
+} // namespace Legacy
+
+// the labels are not contiguous, only some values of First..Last have traits
+template<typename Label, template<Label> class Traits, Label L, typename = void>
+struct HasTraits : std::false_type { };
+
+template<typename Label, template<Label> class Traits, Label L>
+struct HasTraits<Label, Traits, L, std::void_t<typename Traits<L>::type>> : std::true_type { };
+
+template<typename T>
+static T sample(uint32_t seed)
+{
+    if constexpr (std::is_same_v<T, bool>) {
+        return (seed & 1) != 0;
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        return "11.XW_S11.26_" + std::to_string(seed % 10);
+    } else if constexpr (std::is_same_v<T, tCellVoltages>) {
+        tCellVoltages cells;
+        for (uint8_t i = 1; i <= 16; ++i) { cells[i] = 3300 + (seed + i) % 25; }
+        return cells;
+    } else {
+        return static_cast<T>(seed % 1000);
+    }
+}
+
+// adds a value for every label between First and Last which has traits,
+// like a message which reports all data points of the BMS.
+template<typename Label, template<Label> class Traits, Label First, typename Container, size_t... I>
+static void fill(Container& container, uint32_t seed, std::index_sequence<I...>)
+{
+    auto add = [&](auto label) {
+        constexpr Label L = decltype(label)::value;
+        if constexpr (HasTraits<Label, Traits, L>::value) {
+            container.template add<L>(sample<typename Traits<L>::type>(seed + static_cast<uint32_t>(L)));
+        }
+    };
+
+    (add(std::integral_constant<Label, static_cast<Label>(static_cast<size_t>(First) + I)>{}), ...);
+}
+
+template<typename Label, template<Label> class Traits, Label First, Label Last, typename Container>
+static void fill(Container& container, uint32_t seed)
+{
+    constexpr size_t count = static_cast<size_t>(Last) - static_cast<size_t>(First) + 1;
+    fill<Label, Traits, First>(container, seed, std::make_index_sequence<count>{});
+}
+
+using tTexts = std::map<std::string, std::pair<std::string, std::string>>;
+
+template<typename Container>
+static tTexts texts(Container const& container)
+{
+    tTexts result;
+    for (auto iter = container.cbegin(); iter != container.cend(); ++iter) {
+        auto const& dp = iter->second;
+        result[dp.getLabelText()] = { dp.getValueText(), dp.getUnitText() };
+    }
+    return result;
+}
+
+template<typename Container, typename Label, template<Label> class Traits, Label First, Label Last>
+static double nsPerMessage(size_t messages, size_t& textLength)
+{
+    Container stats;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < messages; ++i) {
+        // settings rarely change, so most values repeat in every message
+        Container message;
+        fill<Label, Traits, First, Last>(message, i / 4);
+        stats.updateFrom(message);
+
+        // the web UI and MQTT read all data points about once per message
+        if (i % 8 == 0) {
+            for (auto iter = stats.cbegin(); iter != stats.cend(); ++iter) {
+                textLength += iter->second.getValueText().size();
+            }
+        }
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    return elapsed / messages;
+}
+
+template<typename Current, typename Old, typename Label, template<Label> class Traits, Label First, Label Last>
+static void compare(char const* name)
+{
+    Current current;
+    Old old;
+
+    fill<Label, Traits, First, Last>(current, 1);
+    fill<Label, Traits, First, Last>(old, 1);
+    TEST_ASSERT_TRUE(texts(current) == texts(old));
+
+    // update with different values, both must report the new ones
+    Current currentUpdate;
+    Old oldUpdate;
+    fill<Label, Traits, First, Last>(currentUpdate, 2);
+    fill<Label, Traits, First, Last>(oldUpdate, 2);
+    current.updateFrom(currentUpdate);
+    old.updateFrom(oldUpdate);
+    TEST_ASSERT_TRUE(texts(current) == texts(old));
+    TEST_ASSERT_TRUE(texts(current) == texts(currentUpdate));
+
+    constexpr size_t messages = 5000;
+    size_t oldTextLength = 0;
+    size_t currentTextLength = 0;
+    double oldNs = nsPerMessage<Old, Label, Traits, First, Last>(messages, oldTextLength);
+    double currentNs = nsPerMessage<Current, Label, Traits, First, Last>(messages, currentTextLength);
+    TEST_ASSERT_EQUAL(oldTextLength, currentTextLength);
+
+    char message[128];
+    snprintf(message, sizeof(message), "%s: unordered_map %.0f ns, array %.0f ns per message (%.1fx)",
+            name, oldNs, currentNs, oldNs / currentNs);
+    TEST_MESSAGE(message);
+}
+
+using JkLegacyDataPoint = Legacy::DataPoint<bool, uint8_t, uint16_t, uint32_t,
+      int16_t, int32_t, std::string, JkBms::tCells>;
+using JbdLegacyDataPoint = Legacy::DataPoint<bool, uint8_t, uint16_t, uint32_t,
+      int16_t, int32_t, std::string, JbdBms::tCells>;
+
+void setUp() { }
+
+void tearDown() { }
+
+static void test_jk_bms_data_points()
+{
+    using Label = JkBms::DataPointLabel;
+
+    compare<JkBms::DataPointContainer,
+        Legacy::DataPointContainer<JkLegacyDataPoint, Label, JkBms::DataPointLabelTraits>,
+        Label, JkBms::DataPointLabelTraits, Label::CellsMilliVolt, Label::ProtocolVersion>("JK BMS");
+}
+
+static void test_jbd_bms_data_points()
+{
+    using Label = JbdBms::DataPointLabel;
+
+    compare<JbdBms::DataPointContainer,
+        Legacy::DataPointContainer<JbdLegacyDataPoint, Label, JbdBms::DataPointLabelTraits>,
+        Label, JbdBms::DataPointLabelTraits, Label::CellsMilliVolt, Label::ActualBatteryCapacityAmpHours>("JBD BMS");
+}
+
+static void test_missing_data_point()
+{
+    JkBms::DataPointContainer container;
+
+    TEST_ASSERT_FALSE(container.get<JkBms::DataPointLabel::BatterySoCPercent>().has_value());
+    TEST_ASSERT_NULL(container.getDataPointFor<JkBms::DataPointLabel::BatterySoCPercent>());
+    TEST_ASSERT_TRUE(container.cbegin() == container.cend());
+
+    container.add<JkBms::DataPointLabel::BatterySoCPercent>(static_cast<uint8_t>(87));
+    TEST_ASSERT_EQUAL(87, *container.get<JkBms::DataPointLabel::BatterySoCPercent>());
+    TEST_ASSERT_EQUAL_STRING("BatterySoCPercent", container.cbegin()->second.getLabelText());
+    TEST_ASSERT_EQUAL_STRING("87", container.cbegin()->second.getValueText().c_str());
+    TEST_ASSERT_EQUAL_STRING("%", container.cbegin()->second.getUnitText());
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_missing_data_point);
+    RUN_TEST(test_jk_bms_data_points);
+    RUN_TEST(test_jbd_bms_data_points);
+    return UNITY_END();
+}
@@ -0,0 +1,224 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <unity.h>
+#include <BatteryRS485FrameDecoder.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+using Result = BatteryRS485FrameDecoder::Result;
+
+// get analog values of module 2 and the responses of the battery to the
+// analog value and alarm info requests
+static std::string const analogRequest = "~20024642E00202FD33\r";
+static std::string const analogResponse = "~20024600C06E00020F0CEE0CF00CED0CEF0CEE0CEC0CF00CF10CEE0CED0CEF0CEE0CF00CEE0CED050B820B880B850B870B86FFD8C1F2908802C350007BE425\r";
+static std::string const alarmResponse = "~20024600F03E00020F00000000000000000000000000000005000000000000000000000000F1C7\r";
+
+static BatteryRS485FrameDecoder decoder;
+
+void setUp()
+{
+    decoder.reset();
+}
+
+void tearDown() { }
+
+// feeds the frame and returns the result of the last character. every other
+// character must leave the decoder waiting for more.
+static Result feed(std::string const& frame)
+{
+    for (size_t i = 0; i + 1 < frame.size(); ++i) {
+        Result result = decoder.feed(frame[i]);
+        if (result != Result::Pending) { return result; }
+    }
+
+    return decoder.feed(frame.back());
+}
+
+static void test_request_frame()
+{
+    TEST_ASSERT_TRUE(feed(analogRequest) == Result::Complete);
+
+    format_t const* frame = decoder.getFrame();
+    TEST_ASSERT_EQUAL_HEX8(0x20, frame->ver);
+    TEST_ASSERT_EQUAL_HEX8(0x02, frame->adr);
+    TEST_ASSERT_EQUAL_HEX8(0x46, frame->cid1);
+    TEST_ASSERT_EQUAL_HEX8(0x42, frame->cid2);
+    TEST_ASSERT_EQUAL_HEX16(0xE002, frame->infolength);
+    TEST_ASSERT_EQUAL_HEX8(0x02, frame->info[0]);
+    TEST_ASSERT_EQUAL(analogRequest.size(), decoder.getLength());
+}
+
+static void test_analog_response_frame()
+{
+    TEST_ASSERT_TRUE(feed(analogResponse) == Result::Complete);
+
+    format_t const* frame = decoder.getFrame();
+    TEST_ASSERT_EQUAL_HEX8(0x00, frame->cid2);
+    TEST_ASSERT_EQUAL(110, frame->infolength & 0x0FFF);
+    TEST_ASSERT_EQUAL_HEX8(0x02, frame->info[1]); // module
+    TEST_ASSERT_EQUAL(15, frame->info[2]); // number of cells
+    TEST_ASSERT_EQUAL(3310, (frame->info[3] << 8) | frame->info[4]);
+    TEST_ASSERT_EQUAL(3309, (frame->info[31] << 8) | frame->info[32]);
+    TEST_ASSERT_EQUAL(analogResponse.size(), decoder.getLength());
+}
+
+static void test_consecutive_frames()
+{
+    TEST_ASSERT_TRUE(feed(analogRequest) == Result::Complete);
+    TEST_ASSERT_TRUE(feed(alarmResponse) == Result::Complete);
+    TEST_ASSERT_EQUAL(62, decoder.getFrame()->infolength & 0x0FFF);
+    TEST_ASSERT_TRUE(feed(analogResponse) == Result::Complete);
+}
+
+static void test_noise_outside_of_frame()
+{
+    for (char c : std::string("\xFF\x00 garbage\r\n", 12)) {
+        TEST_ASSERT_TRUE(decoder.feed(c) == Result::Ignored);
+    }
+
+    TEST_ASSERT_TRUE(feed(analogRequest) == Result::Complete);
+}
+
+static void test_lowercase_hex()
+{
+    std::string frame = analogRequest;
+    frame.replace(frame.size() - 5, 4, "fd33");
+
+    TEST_ASSERT_TRUE(feed(frame) == Result::Complete);
+}
+
+static void test_checksum_error()
+{
+    std::string frame = analogResponse;
+    frame[frame.size() - 2] = '6';
+
+    TEST_ASSERT_TRUE(feed(frame) == Result::Error);
+    TEST_ASSERT_EQUAL_STRING("frame checksum error", decoder.getError());
+}
+
+static void test_corrupted_data()
+{
+    std::string frame = analogResponse;
+    frame[20] = (frame[20] == '0') ? '1' : '0';
+
+    TEST_ASSERT_TRUE(feed(frame) == Result::Error);
+    TEST_ASSERT_EQUAL_STRING("frame checksum error", decoder.getError());
+}
+
+static void test_lenid_checksum_error()
+{
+    std::string frame = analogRequest;
+    frame[9] = 'F'; // LCHKSUM
+
+    TEST_ASSERT_TRUE(feed(frame) == Result::Error);
+    TEST_ASSERT_EQUAL_STRING("LENID checksum error", decoder.getError());
+}
+
+static void test_odd_lenid()
+{
+    // LENID 0x003 with a valid LCHKSUM
+    TEST_ASSERT_TRUE(feed("~20024642D003020FD33\r") == Result::Error);
+    TEST_ASSERT_EQUAL_STRING("odd LENID", decoder.getError());
+}
+
+static void test_lenid_too_long()
+{
+    // LENID 0x200 announces 256 info bytes, no room left for the checksum
+    TEST_ASSERT_TRUE(feed("~20024642E200") == Result::Error);
+    TEST_ASSERT_EQUAL_STRING("frame too long", decoder.getError());
+}
+
+static void test_truncated_frame()
+{
+    std::string frame = analogResponse;
+    frame.erase(40, 4);
+
+    TEST_ASSERT_TRUE(feed(frame) == Result::Error);
+    TEST_ASSERT_EQUAL_STRING("frame length does not match LENID", decoder.getError());
+}
+
+static void test_truncated_header()
+{
+    TEST_ASSERT_TRUE(feed("~200246\r") == Result::Error);
+    TEST_ASSERT_EQUAL_STRING("frame length does not match LENID", decoder.getError());
+}
+
+static void test_overlong_frame()
+{
+    std::string frame = analogResponse;
+    frame.insert(40, "0000");
+
+    TEST_ASSERT_TRUE(feed(frame) == Result::Error);
+    TEST_ASSERT_EQUAL_STRING("frame longer than LENID", decoder.getError());
+}
+
+static void test_invalid_character()
+{
+    std::string frame = analogResponse;
+    frame[30] = 'G';
+
+    TEST_ASSERT_TRUE(feed(frame) == Result::Error);
+    TEST_ASSERT_EQUAL_STRING("invalid character", decoder.getError());
+}
+
+static void test_soi_restarts_frame()
+{
+    // a frame interrupted by the SOI of the next one is dropped silently
+    std::string frame = analogResponse.substr(0, 50) + analogResponse;
+
+    TEST_ASSERT_TRUE(feed(frame) == Result::Complete);
+    TEST_ASSERT_EQUAL(analogResponse.size(), decoder.getLength());
+}
+
+static void test_recovers_after_error()
+{
+    std::string frame = analogResponse;
+    frame[frame.size() - 2] = '6';
+
+    TEST_ASSERT_TRUE(feed(frame) == Result::Error);
+    TEST_ASSERT_TRUE(feed(analogResponse) == Result::Complete);
+}
+
+static void benchmark_throughput()
+{
+    constexpr size_t iterations = 20000;
+    size_t complete = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        for (char c : analogResponse) {
+            if (decoder.feed(c) == Result::Complete) { ++complete; }
+        }
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    TEST_ASSERT_EQUAL(iterations, complete);
+
+    char message[96];
+    snprintf(message, sizeof(message), "%.1f MB/s, %.0f ns per frame",
+            iterations * analogResponse.size() / elapsed / 1e6, elapsed / iterations * 1e9);
+    TEST_MESSAGE(message);
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_request_frame);
+    RUN_TEST(test_analog_response_frame);
+    RUN_TEST(test_consecutive_frames);
+    RUN_TEST(test_noise_outside_of_frame);
+    RUN_TEST(test_lowercase_hex);
+    RUN_TEST(test_checksum_error);
+    RUN_TEST(test_corrupted_data);
+    RUN_TEST(test_lenid_checksum_error);
+    RUN_TEST(test_odd_lenid);
+    RUN_TEST(test_lenid_too_long);
+    RUN_TEST(test_truncated_frame);
+    RUN_TEST(test_truncated_header);
+    RUN_TEST(test_overlong_frame);
+    RUN_TEST(test_invalid_character);
+    RUN_TEST(test_soi_restarts_frame);
+    RUN_TEST(test_recovers_after_error);
+    RUN_TEST(benchmark_throughput);
+    return UNITY_END();
+}
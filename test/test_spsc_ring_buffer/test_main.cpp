@@ -0,0 +1,181 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <unity.h>
+#include <SpscRingBuffer.h>
+#include <ThreadSafeQueue.h>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+// same layout as fragment_t of the Hoymiles library, which is queued by the
+// radio receive interrupts
+struct Fragment_t {
+    uint8_t mainCmd;
+    uint8_t fragment[32];
+    uint8_t len;
+    uint8_t channel;
+    int8_t rssi;
+    bool wasReceived;
+};
+
+static constexpr size_t capacity = 30;
+
+void setUp() { }
+
+void tearDown() { }
+
+static void test_fifo_order()
+{
+    SpscRingBuffer<int, 4> buffer;
+
+    TEST_ASSERT_TRUE(buffer.empty());
+    TEST_ASSERT_FALSE(buffer.pop().has_value());
+
+    // wrap around several times
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 3; ++i) { TEST_ASSERT_TRUE(buffer.push(round * 10 + i)); }
+        TEST_ASSERT_EQUAL(3, buffer.size());
+        TEST_ASSERT_EQUAL(round * 10, buffer.front());
+
+        for (int i = 0; i < 3; ++i) {
+            int value = -1;
+            TEST_ASSERT_TRUE(buffer.try_pop(value));
+            TEST_ASSERT_EQUAL(round * 10 + i, value);
+        }
+        TEST_ASSERT_TRUE(buffer.empty());
+    }
+}
+
+static void test_full()
+{
+    SpscRingBuffer<int, 4> buffer;
+
+    for (int i = 0; i < 4; ++i) { TEST_ASSERT_TRUE(buffer.push(i)); }
+    TEST_ASSERT_TRUE(buffer.full());
+    TEST_ASSERT_EQUAL(4, buffer.size());
+
+    // the new item is dropped, the queued ones are kept
+    TEST_ASSERT_FALSE(buffer.push(4));
+    TEST_ASSERT_EQUAL(0, *buffer.pop());
+    TEST_ASSERT_TRUE(buffer.push(4));
+    TEST_ASSERT_EQUAL(4, buffer.size());
+}
+
+static void test_clear()
+{
+    SpscRingBuffer<int, 4> buffer;
+
+    buffer.push(1);
+    buffer.push(2);
+    buffer.clear();
+
+    TEST_ASSERT_TRUE(buffer.empty());
+    TEST_ASSERT_EQUAL(0, buffer.size());
+    TEST_ASSERT_TRUE(buffer.push(3));
+    TEST_ASSERT_EQUAL(3, *buffer.pop());
+}
+
+static void test_concurrent_producer()
+{
+    constexpr int items = 20000;
+    SpscRingBuffer<int, capacity> buffer;
+
+    std::thread producer([&buffer]() {
+        for (int i = 0; i < items; ++i) {
+            while (!buffer.push(i)) { std::this_thread::yield(); }
+        }
+    });
+
+    int expected = 0;
+    bool ordered = true;
+    while (expected < items) {
+        int value;
+        if (!buffer.try_pop(value)) { continue; }
+        ordered = ordered && (value == expected);
+        ++expected;
+    }
+    producer.join();
+
+    TEST_ASSERT_TRUE(ordered);
+    TEST_ASSERT_TRUE(buffer.empty());
+}
+
+// time of one push() and pop() of a fragment, with and without a concurrent
+// producer thread
+template<typename Queue, typename Push>
+static double nsPerFragment(Push push, bool concurrent)
+{
+    size_t const fragments = concurrent ? 100000 : 1000000;
+    Queue queue;
+    Fragment_t fragment = {};
+    size_t received = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    if (concurrent) {
+        std::thread producer([&]() {
+            for (size_t i = 0; i < fragments; ++i) {
+                fragment.len = i;
+                while (!push(queue, fragment)) { std::this_thread::yield(); }
+            }
+        });
+
+        while (received < fragments) {
+            if (queue.pop().has_value()) { ++received; }
+        }
+        producer.join();
+    } else {
+        for (size_t i = 0; i < fragments; ++i) {
+            push(queue, fragment);
+            if (queue.pop().has_value()) { ++received; }
+        }
+    }
+
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return (received == fragments) ? elapsed / fragments : -1;
+}
+
+static void benchmark(bool concurrent)
+{
+    using Spsc = SpscRingBuffer<Fragment_t, capacity>;
+    using Locked = ThreadSafeQueue<Fragment_t>;
+
+    double spsc = nsPerFragment<Spsc>([](Spsc& q, Fragment_t const& f) { return q.push(f); }, concurrent);
+    // the mutex queue never runs full, it grows instead
+    double locked = nsPerFragment<Locked>([](Locked& q, Fragment_t const& f) { q.push(f); return true; }, concurrent);
+
+    TEST_ASSERT_TRUE(spsc > 0);
+    TEST_ASSERT_TRUE(locked > 0);
+
+    char message[128];
+    snprintf(message, sizeof(message), "%s: ThreadSafeQueue %.1f ns, SpscRingBuffer %.1f ns per fragment",
+            concurrent ? "two threads" : "one thread", locked, spsc);
+    TEST_MESSAGE(message);
+}
+
+static void benchmark_one_thread()
+{
+    benchmark(false);
+}
+
+static void benchmark_two_threads()
+{
+    // with a single core the waiting thread only runs once the time slice
+    // of the other one ended, which measures the scheduler instead
+    if (std::thread::hardware_concurrency() < 2) {
+        TEST_IGNORE_MESSAGE("needs at least two cores");
+    }
+
+    benchmark(true);
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_fifo_order);
+    RUN_TEST(test_full);
+    RUN_TEST(test_clear);
+    RUN_TEST(test_concurrent_producer);
+    RUN_TEST(benchmark_one_thread);
+    RUN_TEST(benchmark_two_threads);
+    return UNITY_END();
+}
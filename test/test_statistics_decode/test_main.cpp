@@ -0,0 +1,336 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <unity.h>
+#include <StatisticsParser.h>
+#include <chrono>
+#include <cstdio>
+#include <list>
+#include <vector>
+
+// StatisticsParser itself needs the complete Hoymiles library. the test
+// reproduces its two ways to get a field value on the byte assignment of the
+// HMS-1600/1800/2000-4T: the former linear search which decoded the payload
+// on every access, and the index table with the values decoded once per
+// payload.
+
+// from inverters/HMS_4CH.cpp
+static const byteAssign_t byteAssignment[] = {
+    { TYPE_DC, CH0, FLD_UDC, UNIT_V, 2, 2, 10, false, 1 },
+    { TYPE_DC, CH0, FLD_IDC, UNIT_A, 6, 2, 100, false, 2 },
+    { TYPE_DC, CH0, FLD_PDC, UNIT_W, 10, 2, 10, false, 1 },
+    { TYPE_DC, CH0, FLD_YD, UNIT_WH, 22, 2, 1, false, 0 },
+    { TYPE_DC, CH0, FLD_YT, UNIT_KWH, 14, 4, 1000, false, 3 },
+    { TYPE_DC, CH0, FLD_IRR, UNIT_PCT, CALC_CH_IRR, CH0, CMD_CALC, false, 3 },
+
+    { TYPE_DC, CH1, FLD_UDC, UNIT_V, 4, 2, 10, false, 1 },
+    { TYPE_DC, CH1, FLD_IDC, UNIT_A, 8, 2, 100, false, 2 },
+    { TYPE_DC, CH1, FLD_PDC, UNIT_W, 12, 2, 10, false, 1 },
+    { TYPE_DC, CH1, FLD_YD, UNIT_WH, 24, 2, 1, false, 0 },
+    { TYPE_DC, CH1, FLD_YT, UNIT_KWH, 18, 4, 1000, false, 3 },
+    { TYPE_DC, CH1, FLD_IRR, UNIT_PCT, CALC_CH_IRR, CH1, CMD_CALC, false, 3 },
+
+    { TYPE_DC, CH2, FLD_UDC, UNIT_V, 26, 2, 10, false, 1 },
+    { TYPE_DC, CH2, FLD_IDC, UNIT_A, 30, 2, 100, false, 2 },
+    { TYPE_DC, CH2, FLD_PDC, UNIT_W, 34, 2, 10, false, 1 },
+    { TYPE_DC, CH2, FLD_YD, UNIT_WH, 46, 2, 1, false, 0 },
+    { TYPE_DC, CH2, FLD_YT, UNIT_KWH, 38, 4, 1000, false, 3 },
+    { TYPE_DC, CH2, FLD_IRR, UNIT_PCT, CALC_CH_IRR, CH2, CMD_CALC, false, 3 },
+
+    { TYPE_DC, CH3, FLD_UDC, UNIT_V, 28, 2, 10, false, 1 },
+    { TYPE_DC, CH3, FLD_IDC, UNIT_A, 32, 2, 100, false, 2 },
+    { TYPE_DC, CH3, FLD_PDC, UNIT_W, 36, 2, 10, false, 1 },
+    { TYPE_DC, CH3, FLD_YD, UNIT_WH, 48, 2, 1, false, 0 },
+    { TYPE_DC, CH3, FLD_YT, UNIT_KWH, 42, 4, 1000, false, 3 },
+    { TYPE_DC, CH3, FLD_IRR, UNIT_PCT, CALC_CH_IRR, CH3, CMD_CALC, false, 3 },
+
+    { TYPE_AC, CH0, FLD_UAC, UNIT_V, 50, 2, 10, false, 1 },
+    { TYPE_AC, CH0, FLD_IAC, UNIT_A, 58, 2, 100, false, 2 },
+    { TYPE_AC, CH0, FLD_PAC, UNIT_W, 54, 2, 10, false, 1 },
+    { TYPE_AC, CH0, FLD_Q, UNIT_VAR, 56, 2, 10, true, 1 },
+    { TYPE_AC, CH0, FLD_F, UNIT_HZ, 52, 2, 100, false, 2 },
+    { TYPE_AC, CH0, FLD_PF, UNIT_NONE, 60, 2, 1000, false, 3 },
+
+    { TYPE_INV, CH0, FLD_T, UNIT_C, 62, 2, 10, true, 1 },
+    { TYPE_INV, CH0, FLD_EVT_LOG, UNIT_NONE, 64, 2, 1, false, 0 },
+
+    { TYPE_INV, CH0, FLD_YD, UNIT_WH, CALC_TOTAL_YD, 0, CMD_CALC, false, 0 },
+    { TYPE_INV, CH0, FLD_YT, UNIT_KWH, CALC_TOTAL_YT, 0, CMD_CALC, false, 3 },
+    { TYPE_INV, CH0, FLD_PDC, UNIT_W, CALC_TOTAL_PDC, 0, CMD_CALC, false, 1 },
+    { TYPE_INV, CH0, FLD_EFF, UNIT_PCT, CALC_TOTAL_EFF, 0, CMD_CALC, false, 3 }
+};
+
+static constexpr uint8_t assignmentCount = sizeof(byteAssignment) / sizeof(byteAssignment[0]);
+
+// the calculated fields of StatisticsParser.cpp, for both decoders
+template<typename Decoder>
+struct Calculations {
+    static float totalOf(Decoder& d, ChannelType_t type, FieldId_t fieldId)
+    {
+        float sum = 0;
+        for (auto& channel : d.getChannelsByType(type)) {
+            sum += d.getChannelFieldValue(type, channel, fieldId);
+        }
+        return sum;
+    }
+
+    static float calculate(Decoder& d, uint8_t funcId, uint8_t arg0)
+    {
+        switch (funcId) {
+        case CALC_TOTAL_YT: return totalOf(d, TYPE_DC, FLD_YT);
+        case CALC_TOTAL_YD: return totalOf(d, TYPE_DC, FLD_YD);
+        case CALC_CH_UDC: return d.getChannelFieldValue(TYPE_DC, static_cast<ChannelNum_t>(arg0), FLD_UDC);
+        case CALC_TOTAL_PDC: return totalOf(d, TYPE_DC, FLD_PDC);
+        case CALC_TOTAL_EFF: {
+            float dcPower = totalOf(d, TYPE_DC, FLD_PDC);
+            if (dcPower > 0) { return totalOf(d, TYPE_AC, FLD_PAC) / dcPower * 100.0f; }
+            return 0;
+        }
+        case CALC_CH_IRR:
+            if (d.getStringMaxPower(arg0) > 0) {
+                return d.getChannelFieldValue(TYPE_DC, static_cast<ChannelNum_t>(arg0), FLD_PDC) / d.getStringMaxPower(arg0) * 100.0f;
+            }
+            return 0;
+        case CALC_TOTAL_IAC:
+            return d.getChannelFieldValue(TYPE_AC, CH0, FLD_IAC_1)
+                + d.getChannelFieldValue(TYPE_AC, CH0, FLD_IAC_2)
+                + d.getChannelFieldValue(TYPE_AC, CH0, FLD_IAC_3);
+        }
+        return 0;
+    }
+};
+
+class DecoderBase {
+public:
+    void setPayload(uint8_t const* payload, uint8_t length)
+    {
+        memcpy(_payload, payload, length);
+        _length = length;
+    }
+
+    void setOffset(ChannelType_t type, ChannelNum_t channel, FieldId_t fieldId, float offset)
+    {
+        _settings.push_back({ type, channel, fieldId, offset });
+    }
+
+    uint16_t getStringMaxPower(uint8_t channel) const { return _stringMaxPower[channel]; }
+    void setStringMaxPower(uint8_t channel, uint16_t power) { _stringMaxPower[channel] = power; }
+
+    std::list<ChannelNum_t> getChannelsByType(ChannelType_t type) const
+    {
+        std::list<ChannelNum_t> l;
+        for (auto const& pos : byteAssignment) {
+            if (pos.type == type) { l.push_back(pos.ch); }
+        }
+        l.unique();
+        return l;
+    }
+
+protected:
+    float decode(byteAssign_t const& pos)
+    {
+        uint32_t val = 0;
+        for (uint8_t ptr = pos.start; ptr != pos.start + pos.num; ++ptr) {
+            val = (val << 8) | _payload[ptr];
+        }
+
+        float result;
+        if (pos.isSigned && pos.num == 2) {
+            result = static_cast<float>(static_cast<int16_t>(val));
+        } else if (pos.isSigned && pos.num == 4) {
+            result = static_cast<float>(static_cast<int32_t>(val));
+        } else {
+            result = static_cast<float>(val);
+        }
+        result /= static_cast<float>(pos.div);
+
+        for (auto const& setting : _settings) {
+            if (setting.type == pos.type && setting.ch == pos.ch && setting.fieldId == pos.fieldId) {
+                if (_length > 0) { result += setting.offset; }
+                break;
+            }
+        }
+        return result;
+    }
+
+    uint8_t _payload[STATISTIC_PACKET_SIZE] = {};
+    uint8_t _length = 0;
+    uint16_t _stringMaxPower[CH_CNT] = {};
+    std::list<fieldSettings_t> _settings;
+};
+
+// searches the assignment and decodes the bytes on every access
+class LinearDecoder : public DecoderBase {
+public:
+    void update() { }
+
+    float getChannelFieldValue(ChannelType_t type, ChannelNum_t channel, FieldId_t fieldId)
+    {
+        for (auto const& pos : byteAssignment) {
+            if (pos.type != type || pos.ch != channel || pos.fieldId != fieldId) { continue; }
+            if (pos.div == CMD_CALC) { return Calculations<LinearDecoder>::calculate(*this, pos.start, pos.num); }
+            return decode(pos);
+        }
+        return 0;
+    }
+};
+
+// looks up the index of the assignment and returns the value decoded by
+// update(), which runs whenever the payload or a setting changed
+class CachedDecoder : public DecoderBase {
+public:
+    CachedDecoder()
+    {
+        memset(_index, 0xff, sizeof(_index));
+        for (uint8_t i = 0; i < assignmentCount; ++i) {
+            auto const& pos = byteAssignment[i];
+            if (_index[pos.type][pos.ch][pos.fieldId] == 0xff) { _index[pos.type][pos.ch][pos.fieldId] = i; }
+        }
+        _values.assign(assignmentCount, 0);
+    }
+
+    void update()
+    {
+        for (uint8_t i = 0; i < assignmentCount; ++i) {
+            if (byteAssignment[i].div != CMD_CALC) { _values[i] = decode(byteAssignment[i]); }
+        }
+        for (uint8_t i = 0; i < assignmentCount; ++i) {
+            auto const& pos = byteAssignment[i];
+            if (pos.div == CMD_CALC) { _values[i] = Calculations<CachedDecoder>::calculate(*this, pos.start, pos.num); }
+        }
+    }
+
+    float getChannelFieldValue(ChannelType_t type, ChannelNum_t channel, FieldId_t fieldId)
+    {
+        uint8_t index = _index[type][channel][fieldId];
+        if (index == 0xff) { return 0; }
+        return _values[index];
+    }
+
+private:
+    uint8_t _index[TYPE_INV + 1][CH_CNT][FLD_IAC_3 + 1];
+    std::vector<float> _values;
+};
+
+// statistics of a HMS-1800-4T producing 1.3 kW, values as the inverter sends
+// them (scaled by the divisor of the field)
+static void makePayload(uint8_t* payload, uint32_t variation)
+{
+    auto put = [payload](uint8_t start, uint8_t num, uint32_t value) {
+        for (int i = num - 1; i >= 0; --i) {
+            payload[start + i] = value & 0xff;
+            value >>= 8;
+        }
+    };
+
+    memset(payload, 0, STATISTIC_PACKET_SIZE);
+    static uint8_t const udc[] = { 2, 4, 26, 28 };
+    static uint8_t const idc[] = { 6, 8, 30, 32 };
+    static uint8_t const pdc[] = { 10, 12, 34, 36 };
+    static uint8_t const yd[] = { 22, 24, 46, 48 };
+    static uint8_t const yt[] = { 14, 18, 38, 42 };
+    for (uint8_t ch = 0; ch < 4; ++ch) {
+        put(udc[ch], 2, 351 + ch * 7 + variation % 5); // 35.1 V
+        put(idc[ch], 2, 925 + ch * 31); // 9.25 A
+        put(pdc[ch], 2, 3246 + ch * 101 + variation % 11); // 324.6 W
+        put(yd[ch], 2, 1873 + ch * 97 + variation / 10);
+        put(yt[ch], 4, 2381542 + ch * 11003);
+    }
+    put(50, 2, 2318); // 231.8 V
+    put(52, 2, 4999); // 49.99 Hz
+    put(54, 2, 13095 + variation % 23); // 1309.5 W
+    put(56, 2, static_cast<uint16_t>(-12)); // -1.2 var
+    put(58, 2, 565); // 5.65 A
+    put(60, 2, 998);
+    put(62, 2, 412); // 41.2 °C
+    put(64, 2, 3);
+}
+
+void setUp() { }
+
+void tearDown() { }
+
+template<typename Decoder>
+static void prepare(Decoder& decoder, uint32_t variation)
+{
+    uint8_t payload[STATISTIC_PACKET_SIZE];
+    makePayload(payload, variation);
+    decoder.setPayload(payload, 66);
+    decoder.update();
+}
+
+template<typename Decoder>
+static void configure(Decoder& decoder)
+{
+    for (uint8_t ch = 0; ch < 4; ++ch) { decoder.setStringMaxPower(ch, 440); }
+    decoder.setOffset(TYPE_DC, CH1, FLD_YD, 125);
+}
+
+static void test_decoders_agree()
+{
+    LinearDecoder linear;
+    CachedDecoder cached;
+    configure(linear);
+    configure(cached);
+    prepare(linear, 7);
+    prepare(cached, 7);
+
+    for (auto const& pos : byteAssignment) {
+        float expected = linear.getChannelFieldValue(pos.type, pos.ch, pos.fieldId);
+        TEST_ASSERT_FLOAT_WITHIN(1e-3, expected, cached.getChannelFieldValue(pos.type, pos.ch, pos.fieldId));
+    }
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 231.8, cached.getChannelFieldValue(TYPE_AC, CH0, FLD_UAC));
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, -1.2, cached.getChannelFieldValue(TYPE_AC, CH0, FLD_Q));
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 1970 + 125, cached.getChannelFieldValue(TYPE_DC, CH1, FLD_YD));
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 0, cached.getChannelFieldValue(TYPE_AC, CH1, FLD_UAC));
+}
+
+// one poll cycle: a new payload, all fields are read once for the web UI and
+// MQTT, the AC power a few more times by the power limiter
+template<typename Decoder>
+static double nsPerCycle(size_t cycles, float& checksum)
+{
+    Decoder decoder;
+    configure(decoder);
+
+    uint8_t payloads[16][STATISTIC_PACKET_SIZE];
+    for (uint32_t i = 0; i < 16; ++i) { makePayload(payloads[i], i); }
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t cycle = 0; cycle < cycles; ++cycle) {
+        decoder.setPayload(payloads[cycle % 16], 66);
+        decoder.update();
+
+        for (auto const& pos : byteAssignment) {
+            checksum += decoder.getChannelFieldValue(pos.type, pos.ch, pos.fieldId);
+        }
+        for (int i = 0; i < 8; ++i) {
+            checksum += decoder.getChannelFieldValue(TYPE_AC, CH0, FLD_PAC);
+        }
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / cycles;
+}
+
+static void benchmark_poll_cycle()
+{
+    constexpr size_t cycles = 20000;
+    float linearChecksum = 0;
+    float cachedChecksum = 0;
+
+    double linear = nsPerCycle<LinearDecoder>(cycles, linearChecksum);
+    double cached = nsPerCycle<CachedDecoder>(cycles, cachedChecksum);
+
+    TEST_ASSERT_FLOAT_WITHIN(linearChecksum * 1e-5, linearChecksum, cachedChecksum);
+
+    char message[128];
+    snprintf(message, sizeof(message), "linear search %.0f ns, index and cache %.0f ns per poll cycle (%.1fx)",
+            linear, cached, linear / cached);
+    TEST_MESSAGE(message);
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_decoders_agree);
+    RUN_TEST(benchmark_poll_cycle);
+    return UNITY_END();
+}
@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+// text frames in the format sent by the devices, checksums included
+
+// SmartSolar MPPT 75/15, charging with the load output switched on
+static char const mpptFrame[] =
+    "\r\nPID\t0xA053"
+    "\r\nFW\t159"
+    "\r\nSER#\tHQ2132QY2KR"
+    "\r\nV\t26850"
+    "\r\nI\t4700"
+    "\r\nVPV\t71420"
+    "\r\nPPV\t129"
+    "\r\nCS\t3"
+    "\r\nMPPT\t2"
+    "\r\nOR\t0x00000000"
+    "\r\nERR\t0"
+    "\r\nLOAD\tON"
+    "\r\nIL\t300"
+    "\r\nH19\t10521"
+    "\r\nH20\t112"
+    "\r\nH21\t478"
+    "\r\nH22\t235"
+    "\r\nH23\t612"
+    "\r\nHSDS\t287"
+    "\r\nChecksum\t8";
+
+// SmartShunt 500A, discharging. the values are sent in two blocks
+static char const shuntFrames[] =
+    "\r\nPID\t0xA389"
+    "\r\nV\t26412"
+    "\r\nVS\t13209"
+    "\r\nI\t-6521"
+    "\r\nP\t-172"
+    "\r\nCE\t-49811"
+    "\r\nSOC\t819"
+    "\r\nTTG\t5233"
+    "\r\nAlarm\tOFF"
+    "\r\nRelay\tOFF"
+    "\r\nAR\t0"
+    "\r\nBMV\tSmartShunt 500A/50mV"
+    "\r\nFW\t0416"
+    "\r\nSER#\tHQ2205PXM7T"
+    "\r\nMON\t0"
+    "\r\nChecksum\t\xED"
+    "\r\nH1\t-171225"
+    "\r\nH2\t-49811"
+    "\r\nH3\t-82137"
+    "\r\nH4\t118"
+    "\r\nH5\t0"
+    "\r\nH6\t-10785012"
+    "\r\nH7\t20131"
+    "\r\nH8\t28816"
+    "\r\nH9\t81842"
+    "\r\nH10\t47"
+    "\r\nH11\t0"
+    "\r\nH12\t0"
+    "\r\nH15\t-20"
+    "\r\nH16\t13901"
+    "\r\nH17\t19231"
+    "\r\nH18\t23562"
+    "\r\nChecksum\t\xD7";
@@ -0,0 +1,198 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <unity.h>
+#include <VeDirectMpptController.h>
+#include <VeDirectShuntController.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include "frames.h"
+
+class LogCapture : public Print {
+public:
+    size_t write(uint8_t c) override
+    {
+        text += static_cast<char>(c);
+        return 1;
+    }
+
+    std::string text;
+};
+
+static constexpr uint8_t port = 1;
+static LogCapture logOutput;
+
+void setUp()
+{
+    HardwareSerial::rx(port).clear();
+    logOutput.text.clear();
+}
+
+void tearDown() { }
+
+// lets the controller read the bytes as if they were received by its UART
+template<typename Controller>
+static void receive(Controller& controller, std::string const& bytes)
+{
+    HardwareSerial::rx(port) += bytes;
+    controller.loop();
+}
+
+static void test_mppt_frame()
+{
+    VeDirectMpptController mppt;
+    mppt.init(16, -1, &logOutput, false, port);
+
+    receive(mppt, mpptFrame);
+    TEST_ASSERT_TRUE(mppt.isDataValid());
+    TEST_ASSERT_TRUE(logOutput.text.empty());
+
+    auto const& data = mppt.getData();
+    TEST_ASSERT_EQUAL_HEX16(0xA053, data.productID_PID);
+    TEST_ASSERT_EQUAL_STRING("HQ2132QY2KR", data.serialNr_SER);
+    TEST_ASSERT_EQUAL_STRING("159", data.firmwareVer_FW);
+    TEST_ASSERT_EQUAL(26850, data.batteryVoltage_V_mV);
+    TEST_ASSERT_EQUAL(4700, data.batteryCurrent_I_mA);
+    TEST_ASSERT_EQUAL(71420, data.panelVoltage_VPV_mV);
+    TEST_ASSERT_EQUAL(129, data.panelPower_PPV_W);
+    TEST_ASSERT_EQUAL(3, data.currentState_CS);
+    TEST_ASSERT_EQUAL(2, data.stateOfTracker_MPPT);
+    TEST_ASSERT_EQUAL(0, data.offReason_OR);
+    TEST_ASSERT_EQUAL(0, data.errorCode_ERR);
+    TEST_ASSERT_TRUE(data.hasLoad);
+    TEST_ASSERT_TRUE(data.loadOutputState_LOAD);
+    TEST_ASSERT_EQUAL(300, data.loadCurrent_IL_mA);
+    TEST_ASSERT_EQUAL(105210, data.yieldTotal_H19_Wh);
+    TEST_ASSERT_EQUAL(1120, data.yieldToday_H20_Wh);
+    TEST_ASSERT_EQUAL(478, data.maxPowerToday_H21_W);
+    TEST_ASSERT_EQUAL(2350, data.yieldYesterday_H22_Wh);
+    TEST_ASSERT_EQUAL(612, data.maxPowerYesterday_H23_W);
+    TEST_ASSERT_EQUAL(287, data.daySequenceNr_HSDS);
+
+    // calculated once the frame was found to be valid
+    TEST_ASSERT_EQUAL(126, data.batteryOutputPower_W);
+    TEST_ASSERT_EQUAL(1806, data.panelCurrent_mA);
+}
+
+static void test_shunt_frames()
+{
+    VeDirectShuntController shunt;
+    shunt.init(16, -1, &logOutput, false, port);
+
+    receive(shunt, shuntFrames);
+    TEST_ASSERT_TRUE(shunt.isDataValid());
+    TEST_ASSERT_TRUE(logOutput.text.empty());
+
+    auto const& data = shunt.getData();
+    TEST_ASSERT_EQUAL_HEX16(0xA389, data.productID_PID);
+    TEST_ASSERT_EQUAL_STRING("HQ2205PXM7T", data.serialNr_SER);
+    TEST_ASSERT_EQUAL_STRING("0416", data.firmwareVer_FW);
+    TEST_ASSERT_EQUAL(26412, data.batteryVoltage_V_mV);
+    TEST_ASSERT_EQUAL(-6521, data.batteryCurrent_I_mA);
+    TEST_ASSERT_EQUAL(-172, data.P);
+    TEST_ASSERT_EQUAL(-49811, data.CE);
+    TEST_ASSERT_EQUAL(819, data.SOC);
+    TEST_ASSERT_EQUAL(5233, data.TTG);
+    TEST_ASSERT_FALSE(data.ALARM);
+    TEST_ASSERT_EQUAL(0, data.alarmReason_AR);
+    TEST_ASSERT_EQUAL(0, data.dcMonitorMode_MON);
+    TEST_ASSERT_EQUAL(-171225, data.H1);
+    TEST_ASSERT_EQUAL(-10785012, data.H6);
+    TEST_ASSERT_EQUAL(28816, data.H8);
+    TEST_ASSERT_EQUAL(-20, data.H15);
+    TEST_ASSERT_EQUAL(23562, data.H18);
+}
+
+static void test_fragmented_frame()
+{
+    VeDirectMpptController mppt;
+    mppt.init(16, -1, &logOutput, false, port);
+
+    std::string frame = mpptFrame;
+    for (size_t pos = 0; pos < frame.size(); pos += 7) {
+        receive(mppt, frame.substr(pos, 7));
+    }
+
+    TEST_ASSERT_TRUE(mppt.isDataValid());
+    TEST_ASSERT_EQUAL(26850, mppt.getData().batteryVoltage_V_mV);
+}
+
+static void test_checksum_error()
+{
+    VeDirectMpptController mppt;
+    mppt.init(16, -1, &logOutput, false, port);
+    receive(mppt, mpptFrame);
+    uint32_t lastUpdate = mppt.getLastUpdate();
+
+    // the values of an invalid frame must not be applied
+    std::string frame = mpptFrame;
+    frame.replace(frame.find("26850"), 5, "27850");
+    receive(mppt, frame);
+
+    TEST_ASSERT_EQUAL(26850, mppt.getData().batteryVoltage_V_mV);
+    TEST_ASSERT_EQUAL(lastUpdate, mppt.getLastUpdate());
+    TEST_ASSERT_TRUE(logOutput.text.find("invalid frame") != std::string::npos);
+
+    logOutput.text.clear();
+    receive(mppt, mpptFrame);
+    TEST_ASSERT_TRUE(logOutput.text.empty());
+}
+
+static void test_pending_text_overflow()
+{
+    VeDirectShuntController shunt;
+    shunt.init(16, -1, &logOutput, false, port);
+
+    // the text is dropped while the record is received, before the checksum
+    std::string const serial = "\r\nSER#\t" + std::string(VE_MAX_VALUE_LEN - 1, 'X');
+    receive(shunt, serial + serial + serial + "\r\n");
+
+    TEST_ASSERT_TRUE(logOutput.text.find("too much text in frame, ignoring 'SER'") != std::string::npos);
+}
+
+template<typename Controller>
+static void benchmark(char const* name, std::string const& frames, size_t frameCount)
+{
+    constexpr size_t iterations = 20000;
+
+    Controller controller;
+    controller.init(16, -1, &logOutput, false, port);
+
+    std::string& rx = HardwareSerial::rx(port);
+    rx.reserve(frames.size() * iterations);
+    for (size_t i = 0; i < iterations; ++i) { rx += frames; }
+
+    auto start = std::chrono::steady_clock::now();
+    controller.loop();
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    TEST_ASSERT_TRUE(controller.isDataValid());
+    TEST_ASSERT_TRUE(logOutput.text.empty());
+
+    char message[128];
+    snprintf(message, sizeof(message), "%s: %.1f MB/s, %.0f ns per frame", name,
+            frames.size() * iterations / elapsed / 1e6, elapsed / (iterations * frameCount) * 1e9);
+    TEST_MESSAGE(message);
+}
+
+static void benchmark_mppt()
+{
+    benchmark<VeDirectMpptController>("MPPT", mpptFrame, 1);
+}
+
+static void benchmark_shunt()
+{
+    benchmark<VeDirectShuntController>("SmartShunt", shuntFrames, 2);
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_mppt_frame);
+    RUN_TEST(test_shunt_frames);
+    RUN_TEST(test_fragmented_frame);
+    RUN_TEST(test_checksum_error);
+    RUN_TEST(test_pending_text_overflow);
+    RUN_TEST(benchmark_mppt);
+    RUN_TEST(benchmark_shunt);
+    return UNITY_END();
+}
@@ -7,6 +7,9 @@ export interface MqttConfig {
     password: string;
     topic: string;
     publish_interval: number;
+    refresh_interval: number;
+    json_payload: boolean;
+    queue_budget: number;
     clean_session: boolean;
     retain: boolean;
     tls: boolean;
@@ -6,6 +6,9 @@ export interface MqttStatus {
     username: string;
     topic: string;
     publish_interval: number;
+    refresh_interval: number;
+    json_payload: boolean;
+    queue_budget: number;
     clean_session: boolean;
     retain: boolean;
     tls: boolean;
@@ -19,4 +22,10 @@ export interface MqttStatus {
     hass_topic: string;
     hass_individualpanels: boolean;
     verbose_logging: boolean;
+    queue_messages: number;
+    queue_bytes: number;
+    queue_peak_bytes: number;
+    queue_coalesced: number;
+    queue_dropped_qos0: number;
+    queue_dropped_qos12: number;
 }
@@ -10,6 +10,7 @@ export interface NetworkConfig {
     dns2: string;
     aptimeout: number;
     mdnsenabled: boolean;
+    loglevel: number;
     syslogenabled: boolean;
     sysloghostname: string;
     syslogport: number;
@@ -19,6 +19,11 @@ export interface PowerLimiterMetaData {
     inverters: { [key: string]: PowerLimiterInverterInfo };
 }
 
+export interface PowerLimiterAdditionalInverter {
+    serial: string;
+    is_solar_powered: boolean;
+}
+
 export interface PowerLimiterConfig {
     enabled: boolean;
     updatesonly: boolean;
@@ -32,6 +37,7 @@ export interface PowerLimiterConfig {
     inverter_id: number;
     inverter_serial: string;
     inverter_channel_id: number;
+    additional_inverters: PowerLimiterAdditionalInverter[];
     target_power_consumption: number;
     target_power_consumption_hysteresis: number;
     lower_power_limit: number;
@@ -3,6 +3,7 @@ export interface REFUsolConfig {
     pollinterval: number;
     updatesonly: boolean;
     uss_address: number;
+    uss_address_count: number;
     baudrate: number;
     parity: number;
     verbose_logging: boolean;